@@ -0,0 +1,16 @@
+layout(constant_id = 0) const uint RENDER_WIDTH = 1;
+layout(constant_id = 1) const uint RENDER_HEIGHT = 1;
+
+// A-trous iteration of the pipeline. Each iteration reads ping or pong and writes the other one
+layout(constant_id = 2) const uint ATROUS_STEP_SIZE = 1;
+layout(constant_id = 3) const bool ATROUS_READ_PING = true;
+layout(constant_id = 4) const bool ATROUS_FEEDBACK = false; // Filtered color becomes the temporal history
+layout(constant_id = 5) const bool ATROUS_LAST = false; // Writes the output image
+
+#define ONE_OVER_RENDER_WIDTH (1.0 / float(RENDER_WIDTH))
+#define ONE_OVER_RENDER_HEIGHT (1.0 / float(RENDER_HEIGHT))
+
+const float MAX_RAY_DISTANCE = 100000.0;
+
+// Below this history length the variance is estimated spatially (HpmDenoiser::c_MinTemporalVarianceHistory)
+const float MIN_TEMPORAL_VARIANCE_HISTORY = 4.0;
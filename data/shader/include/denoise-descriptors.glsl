@@ -0,0 +1,44 @@
+layout(set = 0, binding = 0) uniform camMat_t
+{
+	mat4 projView;
+	mat4 invProjView;
+	mat4 prevProjView;
+} camMat;
+
+layout(set = 0, binding = 1) uniform camera_t
+{
+	vec3 pos;
+} camera;
+
+// Renderer output (rgb) and guide (x = scatter flag, y = first scatter depth)
+layout(set = 1, binding = 0, rgba32f) uniform image2D colorImage;
+
+layout(set = 1, binding = 1, rgba32f) uniform image2D guideImage;
+
+// rgb = accumulated color, a = history length
+layout(set = 1, binding = 2, rgba32f) uniform image2D historyImage;
+
+// x, y = first and second luminance moment, z = scatter probability, w = first scatter depth
+layout(set = 1, binding = 3, rgba32f) uniform image2D momentsImage;
+
+layout(set = 1, binding = 4, rgba32f) uniform image2D prevHistoryImage;
+
+layout(set = 1, binding = 5, rgba32f) uniform image2D prevMomentsImage;
+
+// rgb = color, a = luminance variance
+layout(set = 1, binding = 6, rgba32f) uniform image2D pingImage;
+
+layout(set = 1, binding = 7, rgba32f) uniform image2D pongImage;
+
+layout(set = 1, binding = 8, rgba32f) uniform image2D outputImage;
+
+layout(set = 1, binding = 9) uniform Denoiser
+{
+	vec3 prevCamPos;
+	uint temporal;
+	float maxHistory;
+	float depthTolerance;
+	float sigmaLuminance;
+	float sigmaPosition;
+	float sigmaTransmittance;
+};
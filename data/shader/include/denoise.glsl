@@ -0,0 +1,23 @@
+#include "extensions.glsl"
+#include "denoise-constants.glsl"
+#include "denoise-descriptors.glsl"
+
+float Luminance(const vec3 color)
+{
+	return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// Same primary ray as in the renderers
+vec3 GetPrimaryRayDir(const ivec2 imageCoord)
+{
+	const vec2 fragUV = vec2(float(imageCoord.x) * ONE_OVER_RENDER_WIDTH, float(imageCoord.y) * ONE_OVER_RENDER_HEIGHT);
+	const vec4 worldPos = camMat.invProjView * vec4((fragUV * 2.0) - vec2(1.0), 0.0, 1.0);
+	return normalize((worldPos.xyz / worldPos.w) - camera.pos);
+}
+
+bool IsInsideImage(const ivec2 imageCoord)
+{
+	return
+		imageCoord.x >= 0 && imageCoord.y >= 0 &&
+		imageCoord.x < int(RENDER_WIDTH) && imageCoord.y < int(RENDER_HEIGHT);
+}
@@ -10,6 +10,14 @@ layout(constant_id = 7) const float VOLUME_G = 0.7;
 
 layout(constant_id = 8) const float HDR_ENV_MAP_STRENGTH = 1.0;
 
+layout(constant_id = 9) const bool RESIDUAL_RATIO_TRACKING = false;
+layout(constant_id = 10) const bool DIR_LIGHT_TRANSMITTANCE_CACHE = false;
+layout(constant_id = 11) const bool POINT_LIGHT_TRANSMITTANCE_CACHE = false;
+
+layout(constant_id = 12) const bool ADAPTIVE_SAMPLING = false;
+
+layout(constant_id = 13) const bool EMPTY_SPACE_SKIPPING = false;
+
 const vec3 skySize = vec3(VOLUME_SIZE_X, VOLUME_SIZE_Y, VOLUME_SIZE_Z);
 const vec3 skyPos = vec3(0.0);
 
@@ -20,4 +28,10 @@ const vec3 skyPos = vec3(0.0);
 const float PI = 3.1415926535897932384626433832795028841971693993751058209749;
 
 const float MAX_RAY_DISTANCE = 100000.0;
+
+// Adaptive sampling tiles (TileScheduler::c_TileWidth / c_TileHeight). A tile is one workgroup row wide,
+// tiles at the right and bottom border may reach past the image
+const uint TILE_WIDTH = 32;
+const uint TILE_HEIGHT = 8;
+#define TILE_COUNT_X ((RENDER_WIDTH + TILE_WIDTH - 1) / TILE_WIDTH)
 const float MIN_RAY_DISTANCE = 0.125;
@@ -12,6 +12,13 @@ layout(set = 0, binding = 1) uniform camera_t
 
 layout(set = 1, binding = 0) uniform sampler3D densityTex;
 
+layout(set = 1, binding = 1) uniform sampler3D densityGrid;
+
+layout(set = 1, binding = 2) readonly buffer occupancy_t
+{
+	uint occupancyBits[];
+};
+
 layout(set = 2, binding = 0) uniform dir_light_t
 {
 	vec3 color;
@@ -21,25 +28,50 @@ layout(set = 2, binding = 0) uniform dir_light_t
 	float strength;
 } dir_light;
 
+layout(set = 2, binding = 1) uniform sampler3D dirLightTransmittance;
+
 layout(set = 3, binding = 0) uniform PointLight
 {
 	vec3 pos;
 	float strength;
 	vec3 color;
+	float transmittanceRadius;
+	vec3 transmittancePos;
 } pointLight;
 
+layout(set = 3, binding = 1) uniform sampler3D pointLightTransmittance;
+
 layout(set = 4, binding = 0) uniform sampler2D hdrEnvMap;
 
-layout(set = 4, binding = 1) uniform sampler2D hdrEnvMapInvCdfX;
+layout(set = 4, binding = 1) uniform sampler2D hdrEnvMapCdfX;
 
-layout(set = 4, binding = 2) uniform sampler1D hdrEnvMapInvCdfY;
+layout(set = 4, binding = 2) uniform sampler1D hdrEnvMapCdfY;
 
-layout(set = 5, binding = 0, rgba32f) uniform image2D outputImage;
+layout(set = 5, binding = 0, rgba32f) uniform image2DArray outputImage;
 
-layout(set = 5, binding = 1, rgba32f) uniform image2D infoImage;
+layout(set = 5, binding = 1, rgba32f) uniform image2DArray infoImage;
 
 layout(set = 5, binding = 2) uniform Renderer
 {
-	vec4 random;
+	uint frameIndex;
 	float blendFactor;
+	float adaptiveTargetRelStdError;
+	uint adaptiveMinSampleCount;
+};
+
+layout(set = 5, binding = 3, rgba32f) uniform image2DArray guideImage;
+
+// Indirect dispatch of the unconverged tiles (y = TILE_HEIGHT rows, z = 1)
+layout(set = 5, binding = 4) buffer TileList
+{
+	uint tileDispatchX;
+	uint tileDispatchY;
+	uint tileDispatchZ;
+	uint tileIndices[];
+};
+
+// Layer of the image arrays this dispatch renders. The camera of the view is bound to set 0
+layout(push_constant) uniform View
+{
+	uint viewIndex;
 };
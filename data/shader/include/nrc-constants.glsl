@@ -21,6 +21,12 @@ layout(constant_id = 17) const float VOLUME_G = 0.7;
 
 layout(constant_id = 18) const float HDR_ENV_MAP_STRENGTH = 1.0;
 
+layout(constant_id = 19) const bool PRIMARY_RAY_SPREAD_TERMINATION = false;
+layout(constant_id = 20) const bool RESIDUAL_RATIO_TRACKING = false;
+layout(constant_id = 21) const bool DIR_LIGHT_TRANSMITTANCE_CACHE = false;
+layout(constant_id = 22) const bool POINT_LIGHT_TRANSMITTANCE_CACHE = false;
+layout(constant_id = 23) const bool EMPTY_SPACE_SKIPPING = false;
+
 const vec3 skySize = vec3(VOLUME_SIZE_X, VOLUME_SIZE_Y, VOLUME_SIZE_Z);
 const vec3 skyPos = vec3(0.0);
 
@@ -35,3 +41,8 @@ const float PI = 3.1415926535897932384626433832795028841971693993751058209749;
 
 const float MAX_RAY_DISTANCE = 100000.0;
 const float MIN_RAY_DISTANCE = 0.125;
+
+const float PRIMARY_RAY_SPREAD_FACTOR = 0.01;
+
+// History length cap while the camera moves, so clamped history is replaced quickly (TemporalResolve::c_MaxMovingHistory)
+const float TEMPORAL_MAX_HISTORY = 32.0;
@@ -12,6 +12,13 @@ layout(set = 0, binding = 1) uniform camera_t
 
 layout(set = 1, binding = 0) uniform sampler3D densityTex;
 
+layout(set = 1, binding = 1) uniform sampler3D densityGrid;
+
+layout(set = 1, binding = 2) readonly buffer occupancy_t
+{
+	uint occupancyBits[];
+};
+
 layout(set = 2, binding = 0) uniform dir_light_t
 {
 	vec3 color;
@@ -21,28 +28,34 @@ layout(set = 2, binding = 0) uniform dir_light_t
 	float strength;
 } dir_light;
 
+layout(set = 2, binding = 1) uniform sampler3D dirLightTransmittance;
+
 layout(set = 3, binding = 0) uniform PointLight
 {
 	vec3 pos;
 	float strength;
 	vec3 color;
+	float transmittanceRadius;
+	vec3 transmittancePos;
 } pointLight;
 
+layout(set = 3, binding = 1) uniform sampler3D pointLightTransmittance;
+
 layout(set = 4, binding = 0) uniform sampler2D hdrEnvMap;
 
-layout(set = 4, binding = 1) uniform sampler2D hdrEnvMapInvCdfX;
+layout(set = 4, binding = 1) uniform sampler2D hdrEnvMapCdfX;
 
-layout(set = 4, binding = 2) uniform sampler1D hdrEnvMapInvCdfY;
+layout(set = 4, binding = 2) uniform sampler1D hdrEnvMapCdfY;
 
-layout(set = 5, binding = 0, rgba32f) uniform image2D outputImage;
+layout(set = 5, binding = 0, rgba32f) uniform image2DArray outputImage;
 
-layout(set = 5, binding = 1, rgba32f) uniform image2D primaryRayColorImage;
+layout(set = 5, binding = 1, rgba32f) uniform image2DArray primaryRayColorImage;
 
-layout(set = 5, binding = 2, rgba32f) uniform image2D primaryRayInfoImage;
+layout(set = 5, binding = 2, rgba32f) uniform image2DArray primaryRayInfoImage;
 
-layout(set = 5, binding = 3, rgba32f) uniform image2D nrcRayOriginImage;
+layout(set = 5, binding = 3, rgba32f) uniform image2DArray nrcRayOriginImage;
 
-layout(set = 5, binding = 4, rgba32f) uniform image2D nrcRayDirImage;
+layout(set = 5, binding = 4, rgba32f) uniform image2DArray nrcRayDirImage;
 
 struct NrcInput
 {
@@ -105,7 +118,16 @@ layout(std430, set = 5, binding = 10) buffer NrcTrainRing
 
 layout(set = 5, binding = 11) uniform Renderer
 {
-	vec4 random;
+	uint frameIndex;
 	uint showNrc;
 	float blendFactor;
+	uint reproject;
+};
+
+layout(set = 5, binding = 12, rgba32f) uniform image2DArray historyImage;
+
+// Layer of the image arrays and slice of the infer buffers this dispatch works on. The camera of the view is bound to set 0
+layout(push_constant) uniform View
+{
+	uint viewIndex;
 };
@@ -21,8 +21,76 @@ float GetTransmittance(const vec3 start, const vec3 end, const uint count)
 	return transmittance;
 }
 
+// Residual ratio tracking (Novak et al. 2014). Walks the density grid cells along the segment, applies the cell control
+// density analytically and only ratio tracks the residual density - control against the much smaller cell majorant.
+// Must match DensityGrid::ResidualRatioTrack in src/DensityGrid.cpp
+const uint RESIDUAL_MAX_DENSITY_LOOKUPS = 128;
+
+float ResidualRatioTrack(const vec3 start, const vec3 end)
+{
+	const vec3 dir = normalize(end - start);
+	vec2 tBox;
+	if (!ray_box_intersect(start, dir, tBox)) { return 1.0; }
+	const float tEnter = tBox.x;
+	const float tExit = min(tBox.y, distance(end, start));
+	if (tExit <= tEnter) { return 1.0; }
+
+	const vec3 gridOrigin = skyPos - (skySize / 2.0);
+	const vec3 cellSize = skySize * float(DENSITY_GRID_CELL_SIZE) / vec3(textureSize(densityTex, 0));
+	const ivec3 cellCount = textureSize(densityGrid, 0);
+
+	// DDA setup
+	const bvec3 parallel = equal(dir, vec3(0.0));
+	const vec3 invDir = 1.0 / mix(dir, vec3(1.0), parallel);
+	const ivec3 cellStep = ivec3(sign(dir));
+	const vec3 deltaT = mix(abs(cellSize * invDir), vec3(1e30), parallel);
+
+	ivec3 cell = clamp(ivec3(floor((start + (tEnter * dir) - gridOrigin) / cellSize)), ivec3(0), cellCount - 1);
+	vec3 nextT = (gridOrigin + (vec3(cell + max(cellStep, ivec3(0))) * cellSize) - start) * invDir;
+	nextT = mix(nextT, vec3(1e30), parallel);
+
+	// A segment enters every cell at most once, so only density lookups are capped
+	const int maxCellSteps = cellCount.x + cellCount.y + cellCount.z;
+	float transmittance = 1.0;
+	float t = tEnter;
+	uint lookupCount = 0;
+	for (int step = 0; step < maxCellSteps && t < tExit; step++)
+	{
+		const float cellExit = min(tExit, min(nextT.x, min(nextT.y, nextT.z)));
+		const vec2 cellDensity = getDensityGridCell(cell);
+		const float control = cellDensity.x;
+		const float residualMajorant = cellDensity.y;
+
+		transmittance *= exp(-control * max(cellExit - t, 0.0));
+
+		if (residualMajorant > 0.0)
+		{
+			const float invResidualMajorant = 1.0 / residualMajorant;
+			float s = t;
+			while (lookupCount < RESIDUAL_MAX_DENSITY_LOOKUPS)
+			{
+				s -= log(1.0 - RandFloat(1.0)) * invResidualMajorant;
+				if (s >= cellExit) { break; }
+				transmittance *= 1.0 - ((getDensity(start + (s * dir)) - control) * invResidualMajorant);
+				lookupCount++;
+			}
+		}
+
+		t = cellExit;
+		if (nextT.x <= nextT.y && nextT.x <= nextT.z) { cell.x += cellStep.x; nextT.x += deltaT.x; }
+		else if (nextT.y <= nextT.z) { cell.y += cellStep.y; nextT.y += deltaT.y; }
+		else { cell.z += cellStep.z; nextT.z += deltaT.z; }
+
+		if (any(lessThan(cell, ivec3(0))) || any(greaterThanEqual(cell, cellCount))) { break; }
+	}
+
+	return transmittance;
+}
+
 float RatioTrack(const vec3 start, const vec3 end)
 {
+	if (RESIDUAL_RATIO_TRACKING) { return ResidualRatioTrack(start, end); }
+
 	const float invMaxDensity = 1.0 / VOLUME_DENSITY_FACTOR;
 	//const float invMaxDensity = 1.0;
 
@@ -33,6 +101,8 @@ float RatioTrack(const vec3 start, const vec3 end)
 	
 	for (uint i = 0; i < 128; i++)
 	{
+		// Empty bricks multiply the transmittance by 1
+		if (EMPTY_SPACE_SKIPPING) { t = SkipEmptySpace(start, dir, t, tMax); }
 		t -= log(1.0 - RandFloat(1.0)) * invMaxDensity;
 		if (t >= tMax) { break; }
 		const vec3 nextSamplePoint = start + (t * dir);
@@ -42,6 +112,17 @@ float RatioTrack(const vec3 start, const vec3 end)
 	return transmittance;
 }
 
+// Density voxels per dir light transmittance cell. Must match TransmittanceGrid::c_CellSize
+const int DIR_LIGHT_TRANSMITTANCE_CELL_SIZE = 4;
+
+float GetCachedDirLightTransmittance(const vec3 pos)
+{
+	// The last cell may extend beyond the density texture, so the uvw is rescaled to the grid extent
+	const vec3 gridExtent = vec3(DIR_LIGHT_TRANSMITTANCE_CELL_SIZE * textureSize(dirLightTransmittance, 0));
+	const vec3 uvw = get_sky_uvw(pos) * vec3(textureSize(densityTex, 0)) / gridExtent;
+	return texture(dirLightTransmittance, uvw).x;
+}
+
 vec3 TraceDirLight(const vec3 pos, const vec3 dir)
 {
 	if (dir_light.strength == 0.0)
@@ -49,12 +130,37 @@ vec3 TraceDirLight(const vec3 pos, const vec3 dir)
 		return vec3(0.0);
 	}
 
-	const float transmittance = RatioTrack(pos, find_entry_exit(pos, -normalize(dir_light.dir))[1]);
+	const float transmittance = DIR_LIGHT_TRANSMITTANCE_CACHE ?
+		GetCachedDirLightTransmittance(pos) :
+		RatioTrack(pos, find_exit(pos, -normalize(dir_light.dir)));
 	const float phase = hg_phase_func(dot(dir_light.dir, -dir));
 	const vec3 dirLighting = vec3(1.0f) * transmittance * dir_light.strength * phase;
 	return dirLighting;
 }
 
+// Inverse of TransmittanceGrid::OctahedralToDir
+vec2 DirToOctahedral(const vec3 dir)
+{
+	vec2 p = dir.xy / (abs(dir.x) + abs(dir.y) + abs(dir.z));
+	if (dir.z < 0.0)
+	{
+		p = (1.0 - abs(p.yx)) * mix(vec2(-1.0), vec2(1.0), greaterThanEqual(p, vec2(0.0)));
+	}
+	return (p * 0.5) + vec2(0.5);
+}
+
+float GetCachedPointLightTransmittance(const vec3 pos)
+{
+	const vec3 offset = pos - pointLight.transmittancePos;
+	const float radius = length(offset);
+	if (radius == 0.0) { return 1.0; }
+
+	// Radial samples lie at texel centers, the first one at the light
+	const float radialSize = float(textureSize(pointLightTransmittance, 0).z);
+	const float w = ((radius / pointLight.transmittanceRadius) * (radialSize - 1.0) + 0.5) / radialSize;
+	return texture(pointLightTransmittance, vec3(DirToOctahedral(offset / radius), w)).x;
+}
+
 vec3 TracePointLight(const vec3 pos, const vec3 dir)
 {
 	if (pointLight.strength == 0.0)
@@ -62,29 +168,88 @@ vec3 TracePointLight(const vec3 pos, const vec3 dir)
 		return vec3(0.0);
 	}
 
-	const float transmittance = RatioTrack(pointLight.pos, pos);
+	const float transmittance = POINT_LIGHT_TRANSMITTANCE_CACHE ?
+		GetCachedPointLightTransmittance(pos) :
+		RatioTrack(pointLight.pos, pos);
 	const float phase = hg_phase_func(dot(normalize(pointLight.pos - pos), -dir));
 	const vec3 pointLighting = pointLight.color * pointLight.strength * transmittance * phase;
 	return pointLighting;
 }
 
-vec3 SampleHdrEnvMap(const vec2 dir)
+vec2 DirToHdrEnvMapUv(const vec3 dir)
 {
-	const vec2 invAtan = vec2(0.1591, 0.3183);
-
-	vec2 uv = dir;
-    uv *= invAtan;
-    uv += 0.5;
+	return vec2(atan(dir.z, dir.x) / (2.0 * PI), asin(clamp(dir.y, -1.0, 1.0)) / PI) + vec2(0.5);
+}
 
-	return texture(hdrEnvMap, uv).xyz * HDR_ENV_MAP_STRENGTH;
+vec3 HdrEnvMapUvToDir(const vec2 uv)
+{
+	const float phi = (uv.x - 0.5) * 2.0 * PI;
+	const float lat = (uv.y - 0.5) * PI;
+	return vec3(cos(lat) * cos(phi), sin(lat), cos(lat) * sin(phi));
 }
 
 vec3 SampleHdrEnvMap(const vec3 dir)
 {
-	vec2 phiTheta = vec2(atan(dir.z, dir.x), asin(dir.y));
-	return SampleHdrEnvMap(phiTheta);
+	return texture(hdrEnvMap, DirToHdrEnvMapUv(dir)).xyz * HDR_ENV_MAP_STRENGTH;
+}
+
+// First index whose cdf value is above xi
+uint SearchHdrEnvMapCdfY(const float xi)
+{
+	uint lo = 0;
+	uint hi = textureSize(hdrEnvMapCdfY, 0) - 1;
+	while (lo < hi)
+	{
+		const uint mid = (lo + hi) / 2;
+		if (texelFetch(hdrEnvMapCdfY, int(mid), 0).x > xi) { hi = mid; }
+		else { lo = mid + 1; }
+	}
+	return lo;
 }
 
+uint SearchHdrEnvMapCdfX(const uint y, const float xi)
+{
+	uint lo = 0;
+	uint hi = textureSize(hdrEnvMapCdfX, 0).x - 1;
+	while (lo < hi)
+	{
+		const uint mid = (lo + hi) / 2;
+		if (texelFetch(hdrEnvMapCdfX, ivec2(mid, y), 0).x > xi) { hi = mid; }
+		else { lo = mid + 1; }
+	}
+	return lo;
+}
+
+// Solid angle pdf of SampleHdrEnvMapDir. The cdfs are built from brightness * cos(latitude) per pixel
+float HdrEnvMapPdf(const vec3 dir)
+{
+	const ivec2 size = textureSize(hdrEnvMapCdfX, 0);
+	const vec2 uv = DirToHdrEnvMapUv(dir);
+	const ivec2 pixel = clamp(ivec2(uv * vec2(size)), ivec2(0), size - ivec2(1));
+
+	const float cdfY = texelFetch(hdrEnvMapCdfY, pixel.y, 0).x;
+	const float prevCdfY = pixel.y == 0 ? 0.0 : texelFetch(hdrEnvMapCdfY, pixel.y - 1, 0).x;
+	const float cdfX = texelFetch(hdrEnvMapCdfX, pixel, 0).x;
+	const float prevCdfX = pixel.x == 0 ? 0.0 : texelFetch(hdrEnvMapCdfX, pixel - ivec2(1, 0), 0).x;
+	const float pixelPdf = (cdfY - prevCdfY) * (cdfX - prevCdfX);
+
+	const float cosLat = cos((uv.y - 0.5) * PI);
+	if (cosLat <= 0.0) { return 0.0; }
+
+	return pixelPdf * float(size.x * size.y) / (2.0 * PI * PI * cosLat);
+}
+
+vec3 SampleHdrEnvMapDir()
+{
+	const ivec2 size = textureSize(hdrEnvMapCdfX, 0);
+	const uint y = SearchHdrEnvMapCdfY(RandFloat(1.0));
+	const uint x = SearchHdrEnvMapCdfX(y, RandFloat(1.0));
+	const vec2 uv = (vec2(x, y) + vec2(RandFloat(1.0), RandFloat(1.0))) / vec2(size);
+	return HdrEnvMapUvToDir(uv);
+}
+
+// Next event estimation of the env map with one sample MIS (balance heuristic) between env map importance sampling
+// and phase function sampling. Keeps the scale of the former uniform estimator (half the in-scattered radiance).
 vec3 SampleHdrEnvMap(const vec3 pos, const vec3 dir, uint sampleCount)
 {
 	if (HDR_ENV_MAP_STRENGTH == 0.0)
@@ -96,34 +261,19 @@ vec3 SampleHdrEnvMap(const vec3 pos, const vec3 dir, uint sampleCount)
 
 	for (uint i = 0; i < sampleCount; i++)
 	{
-		const vec3 randomDir = NewRayDir(dir, false);
-		const float phase = hg_phase_func(dot(randomDir, -dir));
-		const vec3 exit = find_entry_exit(pos, randomDir)[1];
-		//const float transmittance = GetTransmittance(pos, exit, 16);
-		const float transmittance = RatioTrack(pos, exit);
-		const vec3 sampleLight = SampleHdrEnvMap(randomDir) * phase * transmittance;
+		const vec3 lightDir = RandFloat(1.0) < 0.5 ? SampleHdrEnvMapDir() : NewRayDir(dir, true);
 
-		light += sampleLight;
-	}
+		// Light arrives along -lightDir and leaves along -dir
+		const float phase = hg_phase_func(dot(lightDir, dir));
+		const float phasePdf = phase / (2.0 * PI);
+		const float envPdf = HdrEnvMapPdf(lightDir);
+		const float misPdf = 0.5 * (phasePdf + envPdf);
+		if (misPdf <= 0.0) { continue; }
 
-	// Half env map importance sampled
-//	for (uint i = 0; i < sampleCount - halfSampleCount; i++)
-//	{
-//		const float thetaNorm = texture(hdrEnvMapInvCdfY, RandFloat(1.0)).x;
-//		const float phiNorm = texture(hdrEnvMapInvCdfX, vec2(RandFloat(1.0), thetaNorm)).x;
-//
-//		//const float thetaNorm = 0.458;
-//		//const float phiNorm = 0.477;
-//
-//		const vec3 randomDir = sin(thetaNorm * PI) * vec3(cos(phiNorm * 2.0 * PI), 1.0, sin(phiNorm * 2.0 * PI));
-//
-//		const float phase = hg_phase_func(dot(randomDir, -dir));
-//		const vec3 exit = find_entry_exit(pos, randomDir)[1];
-//		const float transmittance = GetTransmittance(pos, exit, 16);
-//		const vec3 sampleLight = texture(hdrEnvMap, vec2(phiNorm, thetaNorm)).xyz * hdrEnvMapData.hpmStrength * phase * transmittance;
-//
-//		light += sampleLight;
-//	}
+		const vec3 exit = find_exit(pos, lightDir);
+		const float transmittance = RatioTrack(pos, exit);
+		light += SampleHdrEnvMap(lightDir) * phase * transmittance / (4.0 * PI * misPdf);
+	}
 
 	light /= float(sampleCount);
 
@@ -138,7 +288,7 @@ vec3 TraceScene(const vec3 pos, const vec3 dir)
 
 vec3 TraceScene(const vec3 pos, const vec3 dir, const vec3 hdrEnvMapUniformDir)
 {
-	const vec3 exit = find_entry_exit(pos, hdrEnvMapUniformDir)[1];
+	const vec3 exit = find_exit(pos, hdrEnvMapUniformDir);
 	const float hdrEnvMapTransmittance = GetTransmittance(pos, exit, 16);
 	const float hdrEnvMapPhase = hg_phase_func(dot(-dir, hdrEnvMapUniformDir));
 	const vec3 hdrEnvMapLight = SampleHdrEnvMap(hdrEnvMapUniformDir) * hdrEnvMapTransmittance * hdrEnvMapPhase;
@@ -147,6 +297,23 @@ vec3 TraceScene(const vec3 pos, const vec3 dir, const vec3 hdrEnvMapUniformDir)
 	return totalLight;
 }
 
+// Russian roulette starts after RR_MIN_BOUNCES and keeps the throughput around RR_THROUGHPUT. factor already contains the
+// 0.5 per vertex weight, which plays the role of the albedo here. Survivors are divided by their survival probability
+// Mirrored by RussianRoulette::Continue in src/RussianRoulette.cpp
+const uint RR_MIN_BOUNCES = 2;
+const float RR_THROUGHPUT = 0.1;
+
+bool RussianRoulette(const uint bounce, inout float factor)
+{
+	if (bounce < RR_MIN_BOUNCES) { return true; }
+
+	const float survivalProb = min(1.0, factor / RR_THROUGHPUT);
+	if (RandFloat(1.0) >= survivalProb) { return false; }
+
+	factor /= survivalProb;
+	return true;
+}
+
 vec3 DeltaTrack(const vec3 rayOrigin, const vec3 rayDir, out bool volumeExit)
 {
 	volumeExit = false;
@@ -154,12 +321,14 @@ vec3 DeltaTrack(const vec3 rayOrigin, const vec3 rayDir, out bool volumeExit)
 	const float invMaxDensity = 1.0 / VOLUME_DENSITY_FACTOR;
 	//const float invMaxDensity = 1.0;
 
-	const vec3 exit = find_entry_exit(rayOrigin, rayDir)[1];
+	const vec3 exit = find_exit(rayOrigin, rayDir);
 	const float tMax = distance(exit, rayOrigin);
 	float t = 0.0;
 
 	for (uint i = 0; i < 128; i++)
 	{
+		// Empty bricks only produce null collisions, restarting behind them keeps the collision distribution
+		if (EMPTY_SPACE_SKIPPING) { t = SkipEmptySpace(rayOrigin, rayDir, t, tMax); }
 		t -= log(1.0 - RandFloat(1.0)) * invMaxDensity;
 		if (t >= tMax)
 		{
@@ -1,70 +1,62 @@
-/*float preRand;
-float prePreRand;
+// Counter based random numbers. Every sample is a pure function of (pixel, frame, sample, bounce, dimension),
+// so streams never cycle into each other and src/Random.cpp reproduces the exact same sequence on the host.
 
-float rand(vec2 co)
+// Hash Functions for GPU Rendering (Jarzynski and Olano 2020)
+// Known answers: pcg4d(uvec4(0)).x == 0x0F02F829u, pcg4d(uvec4(1, 2, 3, 4)).x == 0x3622CD16u
+uvec4 pcg4d(uvec4 v)
 {
-	return fract(sin(dot(co, vec2(12.9898, 78.233))) * 43758.5453);
+	v = v * 1664525u + 1013904223u;
+
+	v.x += v.y * v.w;
+	v.y += v.z * v.x;
+	v.z += v.x * v.y;
+	v.w += v.y * v.z;
+
+	v ^= v >> 16u;
+
+	v.x += v.y * v.w;
+	v.y += v.z * v.x;
+	v.z += v.x * v.y;
+	v.w += v.y * v.z;
+
+	return v;
 }
 
-float myRand()
+// Upper 24 bits to [0, 1). Exact in float, so identical on host and device
+float UintToUnitFloat(const uint x)
 {
-	float result = rand(vec2(preRand, prePreRand));
-	prePreRand = preRand;
-	preRand = result;
-	return result;
+	return float(x >> 8u) * (1.0 / 16777216.0);
 }
 
-float RandFloat(float maxVal)
-{
-	float f = myRand();
-	return f * maxVal;
-}*/
+uvec4 randomKey;
 
-// A single iteration of Bob Jenkins' One-At-A-Time hashing algorithm.
-uint hash(uint x)
+// sampleIndex separates independent paths of the same pixel and frame (e.g. different passes or spp), viewIndex
+// the layers of a multi view frame. Both share the upper half of the key, 8 bits each
+void InitRandom(const uvec2 pixel, const uint viewIndex, const uint sampleIndex)
 {
-    x += (x << 10u);
-    x ^= (x >> 6u);
-    x += (x << 3u);
-    x ^= (x >> 11u);
-    x += (x << 15u);
-    return x;
+	randomKey = uvec4((pixel.y << 16u) | (pixel.x & 0xFFFFu), frameIndex, ((viewIndex << 8u) | (sampleIndex & 0xFFu)) << 16u, 0u);
 }
 
-// Compound versions of the hashing algorithm I whipped together.
-uint hash(uvec2 v) { return hash(v.x ^ hash(v.y)); }
-uint hash(uvec3 v) { return hash(v.x ^ hash(v.y) ^ hash(v.z)); }
-uint hash(uvec4 v) { return hash(v.x ^ hash(v.y) ^ hash(v.z) ^ hash(v.w)); }
-
-// Construct a float with half-open range [0:1] using low 23 bits.
-// All zeroes yields 0.0, all ones yields the next smallest representable value below 1.0.
-float floatConstruct(uint m)
+void InitRandom(const uvec2 pixel, const uint sampleIndex)
 {
-    const uint ieeeMantissa = 0x007FFFFFu;  // binary32 mantissa bitmask
-    const uint ieeeOne = 0x3F800000u;       // 1.0 in IEEE binary32
-
-    m &= ieeeMantissa;                      // Keep only mantissa bits (fractional part)
-    m |= ieeeOne;                           // Add fractional part to 1.0
-
-    float  f = uintBitsToFloat(m);          // Range [1:2]
-    return f - 1.0;                         // Range [0:1]
+	InitRandom(pixel, 0u, sampleIndex);
 }
 
-// Pseudo-random value in half-open range [0:1].
-float random1(float x) { return floatConstruct(hash(floatBitsToUint(x))); }
-float random2(vec2  v) { return floatConstruct(hash(floatBitsToUint(v))); }
-float random3(vec3  v) { return floatConstruct(hash(floatBitsToUint(v))); }
-float random4(vec4  v) { return floatConstruct(hash(floatBitsToUint(v))); }
-
-float randomState;
+// Restarts the dimension counter so each bounce uses its own dimensions regardless of how many the previous used
+void SetRandomBounce(const uint bounce)
+{
+	randomKey.z = (randomKey.z & 0xFFFF0000u) | (bounce & 0xFFFFu);
+	randomKey.w = 0u;
+}
 
-void InitRandom(const vec2 fragUV)
+uint RandUint()
 {
-    randomState = random2(vec2(random2(fragUV), random4(random)));
+	const uint result = pcg4d(randomKey).x;
+	randomKey.w++;
+	return result;
 }
 
 float RandFloat(float maxVal)
 {
-    randomState = random1(randomState);
-    return randomState * maxVal;
+	return UintToUnitFloat(RandUint()) * maxVal;
 }
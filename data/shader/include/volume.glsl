@@ -4,28 +4,56 @@ float sky_sdf(vec3 pos)
 	return length(max(d, 0)) + min(max(d.x, max(d.y, d.z)), 0);
 }
 
-vec3[2] find_entry_exit(vec3 ro, vec3 rd)
+// Slab test against the volume bounds. Returns false if the ray misses, otherwise t = (tNear, tFar) with tNear clamped
+// to 0 for rays starting inside. Must match RayBox::Intersect in src/RayBox.cpp
+bool ray_box_intersect(const vec3 ro, const vec3 rd, out vec2 t)
+{
+	const vec3 boxMin = skyPos - (skySize / 2);
+	const vec3 boxMax = skyPos + (skySize / 2);
+
+	const bvec3 parallel = equal(rd, vec3(0.0));
+	const vec3 invRd = 1.0 / mix(rd, vec3(1.0), parallel);
+	const vec3 t0 = (boxMin - ro) * invRd;
+	const vec3 t1 = (boxMax - ro) * invRd;
+	vec3 tMin = min(t0, t1);
+	vec3 tMax = max(t0, t1);
+
+	// Axis parallel rays never cross that slab. They are unbounded inside it (including its faces) and miss outside
+	const bvec3 insideSlab = equal(clamp(ro, boxMin, boxMax), ro);
+	tMin = mix(tMin, mix(vec3(1e30), vec3(-1e30), insideSlab), parallel);
+	tMax = mix(tMax, mix(vec3(-1e30), vec3(1e30), insideSlab), parallel);
+
+	const float tNear = max(max(tMin.x, tMin.y), max(tMin.z, 0.0));
+	const float tFar = min(tMax.x, min(tMax.y, tMax.z));
+	t = vec2(tNear, tFar);
+	return tFar >= tNear;
+}
+
+// Returns false if the ray misses the volume. entry and exit are ro then, so the segment inside is empty
+bool find_entry_exit(const vec3 ro, const vec3 rd, out vec3 entry, out vec3 exit)
 {
 	// rd should be normalized
 
-	float dist;
-	do
+	vec2 t;
+	if (!ray_box_intersect(ro, rd, t))
 	{
-		dist = sky_sdf(ro);
-		ro  += dist * rd;
-	} while (dist > MIN_RAY_DISTANCE && dist < MAX_RAY_DISTANCE);
-	vec3 entry = ro;
-
-	ro += rd * length(2 * skySize);//ro += rd * MAX_RAY_DISTANCE * 2;
-	rd *= -1.0;
-	do
-	{
-		dist = sky_sdf(ro);
-		ro += dist * rd;
-	} while (dist > MIN_RAY_DISTANCE && dist < MAX_RAY_DISTANCE);
-	vec3 exit = ro;
-	
-	return vec3[2]( entry, exit );
+		entry = ro;
+		exit = ro;
+		return false;
+	}
+
+	entry = ro + (rd * t.x);
+	exit = ro + (rd * t.y);
+	return true;
+}
+
+// Point where the ray leaves the volume, ro if it misses
+vec3 find_exit(const vec3 ro, const vec3 rd)
+{
+	vec3 entry;
+	vec3 exit;
+	find_entry_exit(ro, rd, entry, exit);
+	return exit;
 }
 
 vec3 get_sky_uvw(vec3 pos)
@@ -37,3 +65,81 @@ float getDensity(vec3 pos)
 {
 	return VOLUME_DENSITY_FACTOR * texture(densityTex, get_sky_uvw(pos)).x;
 }
+
+// Voxels per density grid cell. Must match DensityGrid::c_CellSize
+const int DENSITY_GRID_CELL_SIZE = 16;
+
+// (control density, residual majorant) of a density grid cell
+vec2 getDensityGridCell(ivec3 cell)
+{
+	return VOLUME_DENSITY_FACTOR * texelFetch(densityGrid, cell, 0).xy;
+}
+
+// Occupancy bricks. Must match OccupancyGrid::c_BrickSize and OccupancyGrid::c_CoarseFactor
+const int OCCUPANCY_BRICK_SIZE = 8;
+const int OCCUPANCY_COARSE_FACTOR = 4;
+const uint OCCUPANCY_MAX_SKIP_STEPS = 64;
+
+bool IsBrickOccupied(const ivec3 brick, const ivec3 brickCount, const uint wordOffset)
+{
+	const uint index = uint(brick.x + (brickCount.x * (brick.y + (brickCount.y * brick.z))));
+	return (occupancyBits[wordOffset + (index / 32)] & (1u << (index % 32))) != 0u;
+}
+
+// Distance along the ray to the first occupied fine brick at or after t, or tMax if the rest of the ray is empty.
+// Empty cells of the coarse and fine level are left through their far faces. Must match OccupancyGrid::SkipEmptySpace
+float SkipEmptySpace(const vec3 ro, const vec3 rd, float t, float tMax)
+{
+	// Density outside the volume is 0 (clamp to black border)
+	vec2 tBox;
+	if (!ray_box_intersect(ro, rd, tBox)) { return tMax; }
+	t = max(t, tBox.x);
+	tMax = min(tMax, tBox.y);
+
+	// Traverse in voxel space, t keeps its meaning
+	const ivec3 voxelCount = textureSize(densityTex, 0);
+	const vec3 voxelScale = vec3(voxelCount) / skySize;
+	const vec3 voxelRo = (ro - skyPos + (skySize / 2.0)) * voxelScale;
+	const vec3 voxelRd = rd * voxelScale;
+	const bvec3 parallel = equal(voxelRd, vec3(0.0));
+	const vec3 invVoxelRd = 1.0 / mix(voxelRd, vec3(1.0), parallel);
+
+	const ivec3 fineCount = (voxelCount + OCCUPANCY_BRICK_SIZE - 1) / OCCUPANCY_BRICK_SIZE;
+	const ivec3 coarseCount = (fineCount + OCCUPANCY_COARSE_FACTOR - 1) / OCCUPANCY_COARSE_FACTOR;
+	const uint coarseWordOffset = uint((fineCount.x * fineCount.y * fineCount.z) + 31) / 32;
+
+	// Steps past a face by a small fraction of a voxel, which the neighbour dilation of the bricks covers
+	const vec3 absVoxelRd = abs(voxelRd);
+	const float nudge = 1e-3 / max(absVoxelRd.x, max(absVoxelRd.y, absVoxelRd.z));
+
+	for (uint i = 0; i < OCCUPANCY_MAX_SKIP_STEPS && t < tMax; i++)
+	{
+		const vec3 pos = voxelRo + (t * voxelRd);
+		const ivec3 fine = clamp(ivec3(floor(pos / float(OCCUPANCY_BRICK_SIZE))), ivec3(0), fineCount - 1);
+		const ivec3 coarse = fine / OCCUPANCY_COARSE_FACTOR;
+
+		ivec3 cell;
+		float cellSize;
+		if (!IsBrickOccupied(coarse, coarseCount, coarseWordOffset))
+		{
+			cell = coarse;
+			cellSize = float(OCCUPANCY_BRICK_SIZE * OCCUPANCY_COARSE_FACTOR);
+		}
+		else if (!IsBrickOccupied(fine, fineCount, 0))
+		{
+			cell = fine;
+			cellSize = float(OCCUPANCY_BRICK_SIZE);
+		}
+		else
+		{
+			return t;
+		}
+
+		// Leave the empty cell through its far faces
+		const vec3 farPlane = (vec3(cell) + vec3(greaterThan(voxelRd, vec3(0.0)))) * cellSize;
+		const vec3 tFar = mix((farPlane - voxelRo) * invVoxelRd, vec3(tMax), parallel);
+		t = max(t, min(tMax, min(tFar.x, min(tFar.y, tFar.z)))) + nudge;
+	}
+
+	return min(t, tMax);
+}
@@ -30,6 +30,10 @@ namespace en
 			float hdrEnvMapStrength = 0.0f;
 			float density = 0.0f;
 			bool dynamic = false;
+			bool residualRatioTracking = true;
+			bool emptySpaceSkipping = true;
+			bool dirLightTransmittanceCache = false;
+			bool pointLightTransmittanceCache = false;
 
 			HpmSceneConfig();
 			HpmSceneConfig(uint32_t id);
@@ -56,6 +60,7 @@ namespace en
 		uint32_t primaryRayLength = 0;
 		float primaryRayProb = 0.0f;
 		uint32_t trainRayLength = 0;
+		bool primaryRaySpreadTermination = false; // Optional last argument
 
 		AppConfig();
 		AppConfig(const std::vector<char*>& argv);
@@ -7,6 +7,8 @@
 #include <engine/graphics/vulkan/Texture3D.hpp>
 #include <engine/objects/VolumeData.hpp>
 #include <engine/AppConfig.hpp>
+#include <engine/util/TransmittanceGrid.hpp>
+#include <engine/util/TransmittanceCacheBuilder.hpp>
 
 namespace en
 {
@@ -25,6 +27,8 @@ namespace en
 		const std::vector<VkDescriptorSet>& GetDescriptorSets() const;
 		const VolumeData* GetVolumeData() const;
 		const HdrEnvMap* GetHdrEnvMap() const;
+		bool UsesDirLightTransmittanceCache() const;
+		bool UsesPointLightTransmittanceCache() const;
 
 	private:
 		static std::vector<VkDescriptorSetLayout> s_DescriptorSetLayout;
@@ -39,6 +43,21 @@ namespace en
 		vk::Texture3D* m_Density3DTex = nullptr;
 		VolumeData* m_VolumeData = nullptr;
 
+		// Cached light transmittance. Rebuilt in the background when the light direction or position changes
+		TransmittanceGrid* m_TransmittanceGrid = nullptr;
+
+		const bool m_DirLightTransmittanceCache = false;
+		vk::Texture3D* m_DirLightTransmittanceTex = nullptr;
+		TransmittanceCacheBuilder* m_DirLightTransmittanceBuilder = nullptr;
+
+		const bool m_PointLightTransmittanceCache = false;
+		vk::Texture3D* m_PointLightTransmittanceTex = nullptr;
+		TransmittanceCacheBuilder* m_PointLightTransmittanceBuilder = nullptr;
+
 		std::vector<VkDescriptorSet> m_DescSets;
+
+		static vk::Texture3D* CreateConstantTransmittanceTex();
+		void UpdateDirLightTransmittance();
+		void UpdatePointLightTransmittance();
 	};
 }
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <engine/graphics/Camera.hpp>
+#include <string>
+#include <vector>
+
+namespace en
+{
+	// Camera motion as keyframes over frame indices. Recording places keyframes at a fixed frame interval while the
+	// camera moves and at every change between moving and resting, so resting phases are single segments. Playback
+	// interpolates with a cubic Hermite spline in the frame index, which makes runs independent of the frame time.
+	class CameraPath
+	{
+	public:
+		static const uint32_t c_KeyframeInterval = 15;
+
+		struct Keyframe
+		{
+			uint32_t frame;
+			glm::vec3 pos;
+			glm::vec3 viewDir;
+			float fov;
+		};
+
+		void StartRecording();
+		void Record(const Camera& camera);
+		void StopRecording();
+		bool IsRecording() const;
+
+		// Loads keyframes written by Save. Returns false if the file does not exist
+		bool Load(const std::string& filePath);
+		void Save(const std::string& filePath) const;
+
+		// Moves the camera to the path position at frame. Marks the camera as changed while the path moves
+		void Apply(Camera& camera, uint32_t frame) const;
+
+		bool IsEmpty() const;
+		uint32_t GetFrameCount() const;
+		uint32_t GetSegmentCount() const;
+		uint32_t GetSegmentIndex(uint32_t frame) const;
+		bool IsSegmentMoving(uint32_t segment) const;
+
+	private:
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t keyframeCount;
+		};
+
+		static const uint32_t c_FileMagic = 0x48545043; // "CPTH"
+		static const uint32_t c_FileVersion = 1;
+
+		std::vector<Keyframe> m_Keyframes;
+		std::vector<glm::vec3> m_PosTangents;
+		std::vector<glm::vec3> m_ViewDirTangents;
+
+		bool m_Recording = false;
+		uint32_t m_RecordFrame = 0;
+		bool m_RecordMoving = false;
+
+		void AddKeyframe(const Camera& camera, uint32_t frame);
+		void CalcTangents();
+	};
+}
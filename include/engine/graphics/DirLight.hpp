@@ -1,5 +1,6 @@
 #pragma once
 #include <engine/graphics/vulkan/Buffer.hpp>
+#include <engine/graphics/vulkan/Texture3D.hpp>
 #include <glm/common.hpp>
 #include <glm/glm.hpp>
 
@@ -28,10 +29,12 @@ namespace en
 
 		float GetZenith() const;
 		float GetAzimuth() const;
+		glm::vec3 GetDir() const;
 
 		void SetZenith(float z);
 		void SetAzimuth(float a);
 		void SetColor(glm::vec3 c);
+		void SetTransmittanceTex(const vk::Texture3D* transmittanceTex);
 
 		VkDescriptorSet GetDescriptorSet() const;
 
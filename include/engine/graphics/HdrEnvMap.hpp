@@ -39,28 +39,25 @@ namespace en
 
 		VkImage m_ColorImage;
 		VkImageView m_ColorImageView;
-		VkDeviceMemory m_ColorImageMemory;
+		vk::MemoryAllocator::Allocation m_ColorImageMemory;
 		VkImageLayout m_ColorImageLayout;
 		
 		// Cdf of X given Y
 		VkImage m_CdfXImage;
 		VkImageView m_CdfXImageView;
-		VkDeviceMemory m_CdfXImageMemory;
+		vk::MemoryAllocator::Allocation m_CdfXImageMemory;
 		
 		// Cdf of Y
 		VkImage m_CdfYImage;
 		VkImageView m_CdfYImageView;
-		VkDeviceMemory m_CdfYImageMemory;
+		vk::MemoryAllocator::Allocation m_CdfYImageMemory;
 
 		VkSampler m_Sampler;
 
 		VkDescriptorSet m_DescSet;
 
-		void CreateColorImage(VkDevice device, VkQueue queue, const std::vector<float>& hdr4f);
-		void CreateCdfXImage(VkDevice device, VkQueue queue, const std::vector<float>& cdfX);
-		void CreateCdfYImage(VkDevice device, VkQueue queue, const std::vector<float>& cdfY);
-
-		void ChangeColorImageLayout(VkImageLayout layout, VkCommandBuffer commandBuffer, VkQueue queue);
-		void WriteBufferToColorImage(VkCommandBuffer commandBuffer, VkQueue queue, VkBuffer buffer);
+		void CreateColorImage(VkDevice device, const std::vector<float>& hdr4f);
+		void CreateCdfXImage(VkDevice device, const std::vector<float>& cdfX);
+		void CreateCdfYImage(VkDevice device, const std::vector<float>& cdfY);
 	};
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <engine/graphics/vulkan/Buffer.hpp>
+#include <engine/graphics/vulkan/Texture3D.hpp>
 #include <glm/glm.hpp>
 
 namespace en
@@ -18,6 +19,12 @@ namespace en
 
 		void RenderImGui();
 
+		glm::vec3 GetPos() const;
+
+		// The cache keeps its own origin, so a moved light uses the old cache until the new one is set
+		void SetTransmittanceTex(const vk::Texture3D* transmittanceTex);
+		void SetTransmittanceOrigin(const glm::vec3& pos, float radius);
+
 		VkDescriptorSet GetDescriptorSet() const;
 
 	private:
@@ -29,6 +36,8 @@ namespace en
 			glm::vec3 pos;
 			float strength;
 			glm::vec3 color;
+			float transmittanceRadius;
+			glm::vec3 transmittancePos;
 		};
 
 		UniformData m_UniformData;
@@ -5,94 +5,85 @@
 #include <engine/AppConfig.hpp>
 #include <engine/HpmScene.hpp>
 #include <engine/graphics/vulkan/CommandPool.hpp>
-#include <engine/graphics/vulkan/Shader.hpp>
 #include <engine/graphics/renderer/NrcHpmRenderer.hpp>
 #include <engine/graphics/renderer/McHpmRenderer.hpp>
+#include <engine/graphics/renderer/HpmDenoiser.hpp>
+#include <engine/util/ImageCompare.hpp>
 
 namespace en
 {
 	class Reference
 	{
 	public:
-		struct Result
+		using Result = ImageCompare::Result;
+
+		struct ViewConfig
 		{
-			float mse; // MSE of "not reference" to reference
-			float refMean; // Mean or reference image
-			float ownMean; // Mean of "not reference" image
-			float ownVar; // Variance of "not reference" image
-			uint32_t validPixelCount; // Number of valid pixels
-
-			float GetBias() const;
-			float GetRelBias() const;
-			float GetRelVar() const;
-			float GetCV() const;
+			glm::vec3 pos;
+			glm::vec3 viewDir;
+			float fov;
 		};
 
+		// Orbit views around the volume (the first one is the original (64,0,0) view), one close-up and one inside the volume
+		static std::vector<ViewConfig> GetDefaultViews(uint32_t orbitCount);
+
 		Reference(
 			uint32_t width,
 			uint32_t height,
 			const AppConfig& appConfig,
 			const HpmScene& scene,
+			const std::vector<ViewConfig>& views,
 			VkQueue queue);
 
-		Result CompareNrc(NrcHpmRenderer& renderer, const Camera* oldCamera, VkQueue queue);
-		Result CompareMc(McHpmRenderer& renderer, const Camera* oldCamera, VkQueue queue);
+		// If a denoiser is given its output is compared instead of the renderer output. Without one all views are
+		// rendered in a single submission when the renderer has enough layers
+		std::vector<Result> CompareNrc(NrcHpmRenderer& renderer, const Camera* oldCamera, VkQueue queue, HpmDenoiser* denoiser = nullptr);
+		std::vector<Result> CompareMc(McHpmRenderer& renderer, const Camera* oldCamera, VkQueue queue, HpmDenoiser* denoiser = nullptr);
 		void Destroy();
 
+		uint32_t GetViewCount() const;
+
 	private:
-		struct SpecializationData
-		{
-			uint32_t width;
-			uint32_t height;
-		};
+		// Reference accumulation stops once c_RefErrorPercentile of the volume pixels reach c_RefTargetRelStdError
+		const uint32_t c_RefMinFrames = 256;
+		const uint32_t c_RefMaxFrames = 16384;
+		const uint32_t c_RefCheckInterval = 256;
+		const float c_RefTargetRelStdError = 0.01f;
+		const float c_RefErrorPercentile = 0.99f;
+
+		// Only tiles above c_RefTargetRelStdError keep sampling after c_RefMinSampleCount samples per pixel
+		const bool c_RefAdaptiveSampling = true;
+		const uint32_t c_RefMinSampleCount = 256;
+
+		// Pixels with a higher relative standard error in the reference are excluded from comparisons
+		const float c_RefMaxPixelError = 0.05f;
 
 		uint32_t m_Width = 0;
 		uint32_t m_Height = 0;
-
-		VkDescriptorSetLayout m_DescSetLayout;
-		VkDescriptorPool m_DescPool;
-		VkDescriptorSet m_DescSet;
+		size_t m_ImageFloatCount = 0;
 
 		vk::CommandPool m_CmdPool;
-		VkCommandBuffer m_CmdBuf;
-
-		SpecializationData m_SpecData = {};
-		std::vector<VkSpecializationMapEntry> m_SpecEntries;
-		VkSpecializationInfo m_SpecInfo;
-
-		VkPipelineLayout m_PipelineLayout;
-		
-		vk::Shader m_Cmp1Shader;
-		VkPipeline m_Cmp1Pipeline = VK_NULL_HANDLE;
-
-		vk::Shader m_NormShader;
-		VkPipeline m_NormPipeline = VK_NULL_HANDLE;
-
-		vk::Shader m_Cmp2Shader;
-		VkPipeline m_Cmp2Pipeline = VK_NULL_HANDLE;
-
-		en::Camera* m_RefCamera = nullptr;
-		VkImage m_RefImage = VK_NULL_HANDLE;
-		VkDeviceMemory m_RefImageMemory = VK_NULL_HANDLE;
-		VkImageView m_RefImageView = VK_NULL_HANDLE;
-
-		vk::Buffer m_ResultStagingBuffer;
-		vk::Buffer m_ResultBuffer;
 
-		void CreateDescriptor();
-		void UpdateDescriptor(VkImageView refImageView, VkImageView cmpImageView);
+		std::vector<ViewConfig> m_Views;
+		std::vector<en::Camera*> m_RefCameras;
+		std::vector<std::vector<float>> m_RefData;
+		std::vector<std::vector<float>> m_RefErrorData;
 
-		void InitSpecInfo();
-		void CreatePipelineLayout();
-		void CreateCmp1Pipeline();
-		void CreateNormPipeline();
-		void CreateCmp2Pipeline();
+		vk::Buffer m_ReadbackBuffer;
+		float* m_ReadbackData = nullptr;
 
-		void RecordCmpCmdBuf();
+		VkDeviceSize GetImageSize() const;
+		void SubmitReadback(
+			VkQueue queue,
+			VkCommandBuffer cmdBuf,
+			const std::vector<VkImage>& images,
+			VkBuffer buffer,
+			VkDeviceSize offset,
+			uint32_t layerCount);
+		std::vector<Result> CompareReadbacks();
 
 		void CreateRefCameras();
-		void CreateRefImages(VkQueue queue);
 		void GenRefImages(const AppConfig& appConfig, const HpmScene& scene, VkQueue queue);
-		void CopyToRefImage(uint32_t imageIdx, VkImage srcImage, VkQueue queue);
+		float CalcRelStdErrorMap(const float* mean, const float* info, std::vector<float>& errorMap) const;
 	};
 }
@@ -23,6 +23,7 @@ namespace en
 		static void Shutdown();
 
 		static uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+		static VkMemoryPropertyFlags GetMemoryTypeProperties(uint32_t memoryTypeIndex);
 		static bool IsFormatSupported(VkFormat format, VkImageTiling imageTiling, VkFormatFeatureFlags featureFlags);
 		static VkFormat FindSupportedFormat(
 			const std::vector<VkFormat>& formats,
@@ -40,15 +41,37 @@ namespace en
 		static uint32_t GetGraphicsQFI();
 		static uint32_t GetComputeQFI();
 		static uint32_t GetPresentQFI();
+		static uint32_t GetTransferQFI(); // Equals the graphics QFI if the device has no dedicated transfer family
 
 		static VkDevice GetDevice();
 		static VkQueue GetGraphicsQueue();
 		static VkQueue GetComputeQueue();
 		static VkQueue GetPresentQueue();
+		static VkQueue GetTransferQueue();
 
 		static float GetTimestampPeriod();
 
+		// Pipelines are created through the process wide pipeline cache, which persists across runs in c_PipelineCachePath
+		static VkPipelineCache GetPipelineCache();
+		static VkResult CreateComputePipeline(const VkComputePipelineCreateInfo& createInfo, VkPipeline* pipeline);
+		static VkResult CreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo, VkPipeline* pipeline);
+		static void LogPipelineCreationTime();
+
 	private:
+		// Written in front of the driver data. The cache is only loaded if all fields match the current device
+		struct PipelineCacheFileHeader
+		{
+			uint32_t magic;
+			uint32_t vendorID;
+			uint32_t deviceID;
+			uint32_t driverVersion;
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+			uint64_t dataSize;
+		};
+
+		static const uint32_t c_PipelineCacheMagic = 0x43504E48; // "HNPC"
+		static const char* c_PipelineCachePath;
+
 		static vk::Instance m_Instance;
 
 		static VkSurfaceKHR m_Surface;
@@ -60,13 +83,21 @@ namespace en
 		static uint32_t m_GraphicsQFI;
 		static uint32_t m_ComputeQFI;
 		static uint32_t m_PresentQFI;
+		static uint32_t m_TransferQFI;
 
 		static VkDevice m_Device;
 		static VkQueue m_GraphicsQueue;
 		static VkQueue m_ComputeQueue;
 		static VkQueue m_PresentQueue;
+		static VkQueue m_TransferQueue;
+
+		static VkPipelineCache m_PipelineCache;
+		static uint32_t m_PipelineCount;
+		static double m_PipelineCreationTime;
 
 		static void PickPhysicalDevice();
 		static void CreateDevice();
+		static void CreatePipelineCache();
+		static void SavePipelineCache();
 	};
 }
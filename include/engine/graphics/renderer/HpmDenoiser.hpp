@@ -0,0 +1,125 @@
+#pragma once
+
+#include <engine/graphics/Camera.hpp>
+#include <engine/graphics/vulkan/Shader.hpp>
+#include <engine/graphics/vulkan/CommandPool.hpp>
+#include <engine/graphics/vulkan/Buffer.hpp>
+#include <engine/graphics/vulkan/TimestampQueryRing.hpp>
+#include <engine/util/DenoiseReference.hpp>
+#include <array>
+
+namespace en
+{
+	// Spatiotemporal denoiser (SVGF) that runs after a *HpmRenderer. It reads the renderer output and a guide image
+	// (x = scatter flag, y = first scatter depth) and writes the filtered color with the scatter probability as alpha.
+	class HpmDenoiser
+	{
+	public:
+		static const uint32_t c_AtrousIterationCount = DenoiseReference::c_AtrousIterationCount;
+		static const uint32_t c_MinTemporalVarianceHistory = DenoiseReference::c_MinTemporalVarianceHistory;
+
+		static void Init(VkDevice device);
+		static void Shutdown(VkDevice device);
+
+		HpmDenoiser(uint32_t width, uint32_t height, const Camera* camera, VkImageView colorImageView, VkImageView guideImageView);
+
+		void Denoise(VkQueue queue);
+		void Destroy();
+
+		void EvaluateTimestampQueries();
+		void RenderImGui(const char* name);
+
+		VkImage GetImage() const;
+		VkImageView GetImageView() const;
+		float GetTimeMS() const;
+
+		void SetCamera(VkQueue queue, const Camera* camera);
+
+		// Follows a render size change of the renderer, whose old image views are invalid by now
+		void SetRenderSize(VkQueue queue, uint32_t width, uint32_t height, VkImageView colorImageView, VkImageView guideImageView);
+
+	private:
+		struct SpecializationData
+		{
+			uint32_t renderWidth;
+			uint32_t renderHeight;
+			uint32_t atrousStepSize;
+			uint32_t atrousReadPing;
+			uint32_t atrousFeedback;
+			uint32_t atrousLast;
+		};
+
+		struct UniformData
+		{
+			glm::vec3 prevCamPos;
+			uint32_t temporal;
+			float maxHistory;
+			float depthTolerance;
+			float sigmaLuminance;
+			float sigmaPosition;
+			float sigmaTransmittance;
+		};
+
+		struct Image
+		{
+			VkImage image;
+			vk::MemoryAllocator::Allocation memory;
+			VkImageView view;
+		};
+
+		static VkDescriptorSetLayout s_DescSetLayout;
+		static VkDescriptorPool s_DescPool;
+
+		uint32_t m_RenderWidth;
+		uint32_t m_RenderHeight;
+
+		const Camera* m_Camera;
+		VkImageView m_ColorImageView;
+		VkImageView m_GuideImageView;
+
+		VkPipelineLayout m_PipelineLayout;
+
+		std::vector<VkSpecializationMapEntry> m_SpecMapEntries;
+
+		UniformData m_UniformData = { glm::vec3(0.0f), 1, 32.0f, 0.25f, 4.0f, 1.0f, 0.1f };
+		vk::Buffer m_UniformBuffer;
+
+		vk::Shader m_TemporalShader;
+		VkPipeline m_TemporalPipeline;
+
+		vk::Shader m_AtrousShader;
+		std::array<VkPipeline, c_AtrousIterationCount> m_AtrousPipelines;
+
+		Image m_HistoryImage;
+		Image m_MomentsImage;
+		Image m_PrevHistoryImage;
+		Image m_PrevMomentsImage;
+		Image m_PingImage;
+		Image m_PongImage;
+		Image m_OutputImage;
+
+		VkDescriptorSet m_DescSet;
+
+		vk::TimestampQueryRing m_Timestamps;
+
+		vk::CommandPool m_CommandPool;
+		std::array<VkCommandBuffer, vk::TimestampQueryRing::c_RingSize> m_DenoiseCommandBuffers;
+		VkCommandBuffer m_RandomTasksCmdBuf;
+
+		void CreatePipelineLayout(VkDevice device);
+
+		void InitSpecializationConstants();
+
+		VkPipeline CreatePipeline(VkDevice device, const vk::Shader& shader, const SpecializationData& specData);
+		void CreatePipelines(VkDevice device);
+
+		void CreateImage(VkDevice device, Image& image);
+		void DestroyImage(VkDevice device, Image& image);
+		void ClearHistory(VkQueue queue);
+
+		void AllocateAndUpdateDescriptorSet(VkDevice device);
+		void UpdateDescriptorSet(VkDevice device);
+
+		void RecordDenoiseCommandBuffer(uint32_t slot);
+	};
+}
@@ -2,6 +2,8 @@
 
 #include <engine/graphics/common.hpp>
 #include <engine/graphics/vulkan/CommandPool.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
+#include <engine/graphics/vulkan/MemoryAllocator.hpp>
 #include <engine/graphics/vulkan/Shader.hpp>
 
 namespace en
@@ -42,12 +44,12 @@ namespace en
 
 		static VkFormat m_Format;
 		static VkImage m_Image;
-		static VkDeviceMemory m_ImageMemory;
+		static vk::MemoryAllocator::Allocation m_ImageMemory;
 		static VkImageView m_ImageView;
 
 		static VkFramebuffer m_Framebuffer;
 		static vk::CommandPool* m_CommandPool;
-		static VkCommandBuffer m_CommandBuffer;
+		static std::array<VkCommandBuffer, vk::FramePacer::c_MaxFramesInFlight> m_CommandBuffers;
 
 		static void CreateImGuiDescriptorPool(VkDevice device);
 		static void CreateDescriptorSetLayout(VkDevice device);
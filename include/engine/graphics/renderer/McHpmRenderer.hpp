@@ -3,7 +3,11 @@
 #include <engine/graphics/Camera.hpp>
 #include <engine/graphics/vulkan/Shader.hpp>
 #include <engine/graphics/vulkan/CommandPool.hpp>
+#include <engine/graphics/vulkan/MemoryAllocator.hpp>
+#include <engine/graphics/vulkan/TimestampQueryRing.hpp>
+#include <engine/graphics/vulkan/ImageExporter.hpp>
 #include <engine/HpmScene.hpp>
+#include <engine/util/TileScheduler.hpp>
 
 namespace en
 {
@@ -13,22 +17,52 @@ namespace en
 		static void Init(VkDevice device);
 		static void Shutdown(VkDevice device);
 
-		McHpmRenderer(uint32_t width, uint32_t height, uint32_t pathLength, bool blend, const Camera* camera, const HpmScene& scene);
+		// With adaptive sampling only tiles above the target error are rendered (see TileScheduler).
+		// Every view renders into its own layer of the image arrays, maxViewCount is the layer count
+		// Keep it at 1 unless views are rendered together, every view costs a full set of images
+		McHpmRenderer(
+			uint32_t width,
+			uint32_t height,
+			uint32_t pathLength,
+			bool blend,
+			bool adaptiveSampling,
+			const Camera* camera,
+			const HpmScene& scene,
+			uint32_t maxViewCount = 1);
 
 		void Render(VkQueue queue);
 		void Destroy();
 
-		void ExportOutputImageToFile(VkQueue queue, const std::string& filePath) const;
+		// Queues the output image for asynchronous export, the file is written once vk::ImageExporter is idle
+		void ExportOutputImageToFile(
+			VkQueue queue,
+			const std::string& filePath,
+			vk::ImageExporter::Compression compression = vk::ImageExporter::Compression::Zip,
+			bool halfFloat = false) const;
 		void EvaluateTimestampQueries();
 		void RenderImGui();
 		float CompareReferenceMSE(VkQueue queue, const float* referenceData) const;
 
+		// Images contain all layers, image views only the first view
 		VkImage GetImage() const;
 		VkImageView GetImageView() const;
+		VkImage GetInfoImage() const;
+		VkImageView GetGuideImageView() const;
 		bool IsBlending() const;
+		float GetFrameTimeMS() const;
+		uint32_t GetViewCount() const;
+		uint32_t GetMaxViewCount() const;
 
 		void SetCamera(VkQueue queue, const Camera* camera);
+		void SetCameras(VkQueue queue, const std::vector<const Camera*>& cameras);
 		void SetBlend(bool blend);
+		void SetAdaptiveTarget(float relStdError, uint32_t minSampleCount);
+
+		// Recreates the size dependent resources, image views returned before are invalid afterwards
+		void SetRenderSize(VkQueue queue, uint32_t width, uint32_t height);
+
+		// Recreates the view dependent resources like SetRenderSize
+		void SetMaxViewCount(VkQueue queue, uint32_t maxViewCount);
 
 	private:
 		struct SpecializationData
@@ -44,25 +78,40 @@ namespace en
 			float volumeG;
 
 			float hdrEnvMapStrength;
+
+			uint32_t residualRatioTracking;
+			uint32_t dirLightTransmittanceCache;
+			uint32_t pointLightTransmittanceCache;
+
+			uint32_t adaptiveSampling;
+
+			uint32_t emptySpaceSkipping;
 		};
 
 		struct UniformData
 		{
-			glm::vec4 random;
+			uint32_t frameIndex;
 			float blendFactor;
+			float adaptiveTargetRelStdError;
+			uint32_t adaptiveMinSampleCount;
 		};
 
+		// Indirect dispatch command in front of the tile indices
+		static const VkDeviceSize c_TileListHeaderSize = 3 * sizeof(uint32_t);
+
 		static VkDescriptorSetLayout s_DescSetLayout;
 		static VkDescriptorPool s_DescPool;
 
 		uint32_t m_RenderWidth;
 		uint32_t m_RenderHeight;
 		uint32_t m_PathLength;
+		uint32_t m_MaxViewCount;
 
 		bool m_ShouldBlend = false;
 		uint32_t m_BlendIndex = 1;
+		bool m_AdaptiveSampling;
 
-		const Camera* m_Camera;
+		std::vector<const Camera*> m_Cameras;
 		const HpmScene& m_HpmScene;
 
 		VkPipelineLayout m_PipelineLayout;
@@ -71,29 +120,37 @@ namespace en
 		std::vector<VkSpecializationMapEntry> m_SpecMapEntries;
 		VkSpecializationInfo m_SpecInfo;
 
-		UniformData m_UniformData = { glm::vec4(0.0f) };
+		UniformData m_UniformData = { 0, 0.0f, 0.01f, TileScheduler::c_DefaultMinSampleCount };
 		vk::Buffer m_UniformBuffer;
+		vk::Buffer m_TileListBuffer;
 
 		vk::Shader m_RenderShader;
 		VkPipeline m_RenderPipeline;
 
+		vk::Shader m_TileShader;
+		VkPipeline m_TilePipeline;
+
 		VkImage m_OutputImage;
-		VkDeviceMemory m_OutputImageMemory;
+		vk::MemoryAllocator::Allocation m_OutputImageMemory;
 		VkImageView m_OutputImageView;
+		VkImageView m_OutputArrayView;
 
 		VkImage m_InfoImage;
-		VkDeviceMemory m_InfoImageMemory;
+		vk::MemoryAllocator::Allocation m_InfoImageMemory;
 		VkImageView m_InfoImageView;
 
+		VkImage m_GuideImage; // x = scatter flag, y = first scatter depth of the current frame
+		vk::MemoryAllocator::Allocation m_GuideImageMemory;
+		VkImageView m_GuideImageView;
+		VkImageView m_GuideArrayView;
+
 		VkDescriptorSet m_DescSet;
 
-		const uint32_t c_QueryCount = 2;
 		uint32_t m_QueryIndex = 0;
-		VkQueryPool m_QueryPool;
-		float m_TimePeriod = 0.0f;
+		vk::TimestampQueryRing m_Timestamps;
 
 		vk::CommandPool m_CommandPool;
-		VkCommandBuffer m_RenderCommandBuffer;
+		std::array<VkCommandBuffer, vk::TimestampQueryRing::c_RingSize> m_RenderCommandBuffers;
 		VkCommandBuffer m_RandomTasksCmdBuf;
 
 		void CreatePipelineLayout(VkDevice device);
@@ -101,14 +158,19 @@ namespace en
 		void InitSpecializationConstants();
 
 		void CreateRenderPipeline(VkDevice device);
+		void CreateTilePipeline(VkDevice device);
 
 		void CreateOutputImage(VkDevice device);
 		void CreateInfoImage(VkDevice device);
+		void CreateGuideImage(VkDevice device);
+		void DestroyImages(VkDevice device);
+		void ClearImages(VkQueue queue);
+		void RecreateSizeDependentResources(VkQueue queue);
 
 		void AllocateAndUpdateDescriptorSet(VkDevice device);
+		void UpdateDescriptorSet(VkDevice device);
 
-		void CreateQueryPool(VkDevice device);
-
-		void RecordRenderCommandBuffer();
+		void CmdBindView(VkCommandBuffer commandBuffer, uint32_t view) const;
+		void RecordRenderCommandBuffer(uint32_t slot);
 	};
 }
@@ -3,6 +3,9 @@
 #include <engine/graphics/Camera.hpp>
 #include <engine/graphics/vulkan/Shader.hpp>
 #include <engine/graphics/vulkan/CommandPool.hpp>
+#include <engine/graphics/vulkan/MemoryAllocator.hpp>
+#include <engine/graphics/vulkan/TimestampQueryRing.hpp>
+#include <engine/graphics/vulkan/ImageExporter.hpp>
 #include <engine/HpmScene.hpp>
 #include <cuda_runtime.h>
 
@@ -16,6 +19,9 @@ namespace en
 		static void Init(VkDevice device);
 		static void Shutdown(VkDevice device);
 
+		// Every view renders into its own layer of the image arrays, maxViewCount is the layer count.
+		// The infer buffers hold maxViewCount images, so all views are inferred by one cuda pass. Keep it at 1 unless
+		// views are rendered together, every view costs a full set of images and infer buffers
 		NrcHpmRenderer(
 			uint32_t width,
 			uint32_t height,
@@ -23,23 +29,42 @@ namespace en
 			const Camera* camera,
 			const AppConfig& appConfig,
 			const HpmScene& hpmScene,
-			NeuralRadianceCache& nrc);
+			NeuralRadianceCache& nrc,
+			uint32_t maxViewCount = 1);
 
 		void Render(VkQueue queue, bool train);
 		void Destroy();
 
-		void ExportOutputImageToFile(VkQueue queue, const std::string& filePath) const;
+		// Queues the output image for asynchronous export, the file is written once vk::ImageExporter is idle
+		void ExportOutputImageToFile(
+			VkQueue queue,
+			const std::string& filePath,
+			vk::ImageExporter::Compression compression = vk::ImageExporter::Compression::Zip,
+			bool halfFloat = false) const;
 		void EvaluateTimestampQueries();
 		void RenderImGui();
 
+		// Images contain all layers, image views only the first view
 		VkImage GetImage() const;
 		VkImageView GetImageView() const;
+		VkImageView GetGuideImageView() const;
 		bool IsBlending() const;
 		float GetFrameTimeMS() const;
+		uint32_t GetViewCount() const;
+		uint32_t GetMaxViewCount() const;
 
+		// Training only uses the first view
 		void SetCamera(VkQueue queue, const Camera* camera);
+		void SetCameras(VkQueue queue, const std::vector<const Camera*>& cameras);
 		void SetBlend(bool blend);
 
+		// Recreates the size dependent resources including the cuda mappings of the nrc buffers. The train subset keeps
+		// its pixel count and is spread over the new size. Image views returned before are invalid afterwards
+		void SetRenderSize(VkQueue queue, uint32_t width, uint32_t height);
+
+		// Recreates the view dependent resources like SetRenderSize
+		void SetMaxViewCount(VkQueue queue, uint32_t maxViewCount);
+
 	private:
 		struct SpecializationData
 		{
@@ -65,13 +90,20 @@ namespace en
 			float volumeG;
 
 			float hdrEnvMapStrength;
+
+			uint32_t primaryRaySpreadTermination;
+			uint32_t residualRatioTracking;
+			uint32_t dirLightTransmittanceCache;
+			uint32_t pointLightTransmittanceCache;
+			uint32_t emptySpaceSkipping;
 		};
 
 		struct UniformData
 		{
-			glm::vec4 random;
+			uint32_t frameIndex;
 			uint32_t showNrc;
 			float blendFactor;
+			uint32_t reproject;
 		};
 
 		static VkDescriptorSetLayout m_DescSetLayout;
@@ -79,6 +111,7 @@ namespace en
 
 		uint32_t m_RenderWidth = 0;
 		uint32_t m_RenderHeight = 0;
+		uint32_t m_MaxViewCount = 1;
 		uint32_t m_TrainWidth = 0;
 		uint32_t m_TrainHeight = 0;
 		uint32_t m_TrainXDist = 0;
@@ -88,11 +121,13 @@ namespace en
 		float m_PrimaryRayProb = 0.0f;
 		uint32_t m_TrainRingBufSize = 0;
 		uint32_t m_TrainRayLength = 0;
+		bool m_PrimaryRaySpreadTermination = false;
 
 		bool m_ShouldBlend = false;
 		uint32_t m_BlendIndex = 1;
+		bool m_TemporalReprojection = true;
 
-		const Camera* m_Camera;
+		std::vector<const Camera*> m_Cameras;
 		const HpmScene& m_HpmScene;
 		NeuralRadianceCache& m_Nrc;
 
@@ -139,7 +174,7 @@ namespace en
 		std::vector<VkSpecializationMapEntry> m_SpecMapEntries;
 		VkSpecializationInfo m_SpecInfo;
 
-		UniformData m_UniformData = { glm::vec4(0.0f), 1 };
+		UniformData m_UniformData = { 0, 1 };
 		vk::Buffer m_UniformBuffer;
 
 		vk::Shader m_ClearShader;
@@ -158,36 +193,39 @@ namespace en
 		VkPipeline m_RenderPipeline;
 
 		VkImage m_OutputImage; // rgba32f output color
-		VkDeviceMemory m_OutputImageMemory;
+		vk::MemoryAllocator::Allocation m_OutputImageMemory;
 		VkImageView m_OutputImageView;
+		VkImageView m_OutputArrayView;
 
 		VkImage m_PrimaryRayColorImage; // rgb32f primary ray output color + a32f transmittance
-		VkDeviceMemory m_PrimaryRayColorImageMemory;
+		vk::MemoryAllocator::Allocation m_PrimaryRayColorImageMemory;
 		VkImageView m_PrimaryRayColorImageView;
 
 		VkImage m_PrimaryRayInfoImage;
-		VkDeviceMemory m_PrimaryRayInfoImageMemory;
+		vk::MemoryAllocator::Allocation m_PrimaryRayInfoImageMemory;
 		VkImageView m_PrimaryRayInfoImageView;
+		VkImageView m_PrimaryRayInfoArrayView;
 
 		VkImage m_NrcRayOriginImage;
-		VkDeviceMemory m_NrcRayOriginImageMemory;
+		vk::MemoryAllocator::Allocation m_NrcRayOriginImageMemory;
 		VkImageView m_NrcRayOriginImageView;
 
 		VkImage m_NrcRayDirImage;
-		VkDeviceMemory m_NrcRayDirImageMemory;
+		vk::MemoryAllocator::Allocation m_NrcRayDirImageMemory;
 		VkImageView m_NrcRayDirImageView;
 
+		VkImage m_HistoryImage; // Last (lower layers) and current (upper layers) resolve per view (rgb color, a sample count)
+		vk::MemoryAllocator::Allocation m_HistoryImageMemory;
+		VkImageView m_HistoryImageView;
+
 		VkDescriptorSet m_DescSet;
 
-		const float c_TimestampPeriodInMS = VulkanAPI::GetTimestampPeriod() * 1e-6f;
-		const uint32_t c_QueryCount = 8;
-		std::vector<float> m_TimePeriods = std::vector<float>(c_QueryCount);
 		uint32_t m_QueryIndex = 0;
-		VkQueryPool m_QueryPool;
+		vk::TimestampQueryRing m_Timestamps;
 
 		vk::CommandPool m_CommandPool;
-		VkCommandBuffer m_PreCudaCommandBuffer;
-		VkCommandBuffer m_PostCudaCommandBuffer;
+		std::array<VkCommandBuffer, vk::TimestampQueryRing::c_RingSize> m_PreCudaCommandBuffers;
+		std::array<VkCommandBuffer, vk::TimestampQueryRing::c_RingSize> m_PostCudaCommandBuffers;
 		VkCommandBuffer m_RandomTasksCmdBuf;
 
 		void CalcTrainSubset(uint32_t trainPixelCount);
@@ -197,6 +235,7 @@ namespace en
 		void CreateNrcBuffers();
 		void CreateNrcInferFilterBuffer();
 		void CreateNrcTrainRingBuffer();
+		void DestroyNrcBuffers();
 
 		void CreatePipelineLayout(VkDevice device);
 
@@ -213,12 +252,17 @@ namespace en
 		void CreatePrimaryRayInfoImage(VkDevice device);
 		void CreateNrcRayOriginImage(VkDevice device);
 		void CreateNrcRayDirImage(VkDevice device);
+		void CreateHistoryImage(VkDevice device);
+		void DestroyImages(VkDevice device);
+		void ClearImages(VkQueue queue);
+		void RecreateSizeDependentResources(VkQueue queue);
 
 		void AllocateAndUpdateDescriptorSet(VkDevice device);
+		void UpdateDescriptorSet(VkDevice device);
 
-		void CreateQueryPool(VkDevice device);
 
-		void RecordPreCudaCommandBuffer();
-		void RecordPostCudaCommandBuffer();
+		void CmdBindView(VkCommandBuffer commandBuffer, uint32_t view) const;
+		void RecordPreCudaCommandBuffer(uint32_t slot);
+		void RecordPostCudaCommandBuffer(uint32_t slot);
 	};
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <engine/graphics/common.hpp>
 #include <engine/graphics/vulkan/Shader.hpp>
 #include <engine/graphics/vulkan/CommandPool.hpp>
+#include <engine/graphics/vulkan/MemoryAllocator.hpp>
 #include <engine/objects/Model.hpp>
 #include <engine/graphics/Camera.hpp>
 
@@ -43,12 +44,12 @@ namespace en
 
 		VkFormat m_ColorFormat;
 		VkImage m_ColorImage;
-		VkDeviceMemory m_ColorImageMemory;
+		vk::MemoryAllocator::Allocation m_ColorImageMemory;
 		VkImageView m_ColorImageView;
 
 		VkFormat m_DepthFormat;
 		VkImage m_DepthImage;
-		VkDeviceMemory m_DepthImageMemory;
+		vk::MemoryAllocator::Allocation m_DepthImageMemory;
 		VkImageView m_DepthImageView;
 
 		VkFramebuffer m_Framebuffer;
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <engine/graphics/vulkan/Shader.hpp>
+#include <engine/graphics/vulkan/CommandPool.hpp>
+#include <engine/graphics/vulkan/MemoryAllocator.hpp>
+
+namespace en
+{
+	// Spatial upsampling of a renderer output to the output size with a Catmull-Rom filter. The input size is a push
+	// constant, so a new render size only updates the descriptor set and rerecords the command buffer.
+	class Upscaler
+	{
+	public:
+		static void Init(VkDevice device);
+		static void Shutdown(VkDevice device);
+
+		Upscaler(uint32_t width, uint32_t height);
+
+		void Upscale(VkQueue queue);
+		void Destroy();
+
+		VkImage GetImage() const;
+		VkImageView GetImageView() const;
+
+		void SetInput(VkImageView imageView, uint32_t width, uint32_t height);
+
+	private:
+		struct PushConstants
+		{
+			uint32_t inputWidth;
+			uint32_t inputHeight;
+			uint32_t outputWidth;
+			uint32_t outputHeight;
+		};
+
+		static VkDescriptorSetLayout s_DescSetLayout;
+		static VkDescriptorPool s_DescPool;
+
+		PushConstants m_Sizes;
+		VkImageView m_InputImageView = VK_NULL_HANDLE;
+
+		VkPipelineLayout m_PipelineLayout;
+
+		vk::Shader m_Shader;
+		VkPipeline m_Pipeline;
+
+		VkImage m_OutputImage;
+		vk::MemoryAllocator::Allocation m_OutputImageMemory;
+		VkImageView m_OutputImageView;
+
+		VkDescriptorSet m_DescSet;
+
+		vk::CommandPool m_CommandPool;
+		VkCommandBuffer m_CommandBuffer;
+		VkCommandBuffer m_RandomTasksCmdBuf;
+
+		void CreatePipelineLayout(VkDevice device);
+		void CreatePipeline(VkDevice device);
+		void CreateOutputImage(VkDevice device);
+
+		void AllocateDescriptorSet(VkDevice device);
+		void UpdateDescriptorSet(VkDevice device);
+
+		void RecordCommandBuffer();
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <engine/graphics/VulkanAPI.hpp>
+#include <engine/graphics/vulkan/MemoryAllocator.hpp>
 
 typedef void* HANDLE;
 
@@ -9,8 +10,6 @@ namespace en::vk
 	class Buffer
 	{
 	public:
-		static void Copy(const Buffer* src, Buffer* dest, VkDeviceSize size);
-
 		Buffer(
 			VkDeviceSize size, 
 			VkMemoryPropertyFlags memoryProperties, 
@@ -18,6 +17,9 @@ namespace en::vk
 			const std::vector<uint32_t>& qfis,
 			VkExternalMemoryHandleTypeFlagBits extMemType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_FLAG_BITS_MAX_ENUM);
 
+		// Host visible staging buffer in the per frame arena. Only valid until the next MemoryAllocator::ResetFrameArena
+		static Buffer FromFrameArena(VkDeviceSize size, VkBufferUsageFlags usage);
+
 		void Destroy();
 
 		void MapMemory(VkDeviceSize offset, void** memory);
@@ -39,7 +41,7 @@ namespace en::vk
 		bool m_Mapped;
 
 		VkBuffer m_VulkanHandle;
-		VkDeviceMemory m_DeviceMemory;
+		MemoryAllocator::Allocation m_Memory;
 		VkDeviceSize m_UsedSize;
 
 #ifdef _WIN64
@@ -47,5 +49,7 @@ namespace en::vk
 #else
 		int m_Fd = 0;
 #endif
+
+		Buffer(VkDeviceSize size, VkBufferUsageFlags usage);
 	};
 }
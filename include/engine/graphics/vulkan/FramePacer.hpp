@@ -0,0 +1,52 @@
+#pragma once
+
+#include <engine/graphics/vulkan/Buffer.hpp>
+#include <array>
+
+namespace en::vk
+{
+	// Keeps up to c_MaxFramesInFlight frames queued on the device, so the host records frame N + 1 while frame N executes.
+	// Submissions made through Submit during a frame are ordered on the queue by a timeline semaphore instead of host
+	// waits. Buffer updates made through UpdateBuffer are recorded into the command buffer of the frame slot and copied
+	// on the queue before the next submission, so frames in flight never see each other's uniform data.
+	class FramePacer
+	{
+	public:
+		static const uint32_t c_MaxFramesInFlight = 2;
+
+		static void Init();
+		static void Shutdown();
+
+		// Waits until the frame that last used the returned slot has completed
+		static uint32_t BeginFrame();
+		static void EndFrame(VkQueue queue);
+
+		static bool IsFrameActive();
+		static uint32_t GetFrameSlot();
+		static bool IsPreviousFrameComplete();
+		static void WaitIdle();
+
+		// Outside of a frame these fall back to a plain vkQueueSubmit and Buffer::SetData
+		static void Submit(VkQueue queue, const VkSubmitInfo& submitInfo, VkFence fence);
+		static void UpdateBuffer(Buffer& buffer, VkDeviceSize size, const void* data, VkDeviceSize offset);
+
+	private:
+		static const VkDeviceSize c_MaxUpdateSize = 65536;
+
+		static VkSemaphore s_TimelineSemaphore;
+		static uint64_t s_TimelineValue;
+
+		static uint64_t s_FrameIndex;
+		static bool s_FrameActive;
+		static std::array<uint64_t, c_MaxFramesInFlight> s_FrameEndValues;
+
+		static VkCommandPool s_CommandPool;
+		static std::array<VkCommandBuffer, c_MaxFramesInFlight> s_UpdateCommandBuffers;
+		static bool s_UpdatesRecording;
+
+		static void SubmitUpdates(VkQueue queue);
+		static void SubmitBarrier(VkQueue queue);
+		static uint64_t Signal(VkQueue queue);
+		static void Wait(uint64_t value);
+	};
+}
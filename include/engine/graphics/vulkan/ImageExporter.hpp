@@ -0,0 +1,77 @@
+#pragma once
+
+#include <engine/graphics/vulkan/Buffer.hpp>
+#include <string>
+#include <array>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace en::vk
+{
+	// Writes RGBA32F images to EXR files without stalling the render thread. The image is copied into one of a few
+	// persistent readback buffers on the queue and the copy is tracked by a fence. Worker threads wait for the fence and
+	// encode the EXR file directly from the mapped buffer. ExportImage only blocks if every readback buffer is in use.
+	class ImageExporter
+	{
+	public:
+		enum class Compression
+		{
+			None,
+			Zip,
+			Piz
+		};
+
+		static void Init();
+		static void Shutdown();
+
+		// image must contain RGBA32F data in layout and may be changed or destroyed once the copy has completed on the queue
+		static void ExportImage(
+			VkQueue queue,
+			VkImage image,
+			VkImageLayout layout,
+			uint32_t width,
+			uint32_t height,
+			const std::string& filePath,
+			Compression compression = Compression::Zip,
+			bool halfFloat = false);
+
+		// Waits until all exported files are written
+		static void WaitIdle();
+
+	private:
+		struct Slot
+		{
+			Buffer* buffer;
+			const float* data;
+			VkDeviceSize size;
+			VkCommandBuffer commandBuffer;
+			VkFence fence;
+			bool busy;
+
+			std::string filePath;
+			uint32_t width;
+			uint32_t height;
+			Compression compression;
+			bool halfFloat;
+		};
+
+		static const uint32_t c_SlotCount = 4;
+
+		static std::mutex s_Mutex;
+		static std::condition_variable s_WorkCv;
+		static std::condition_variable s_FreeCv;
+		static bool s_Running;
+
+		static VkCommandPool s_CommandPool;
+		static std::array<Slot, c_SlotCount> s_Slots;
+		static std::deque<uint32_t> s_PendingSlots;
+		static std::vector<std::thread> s_Workers;
+
+		static void EnsureBufferSize(Slot& slot, VkDeviceSize size);
+		static void RecordCopy(Slot& slot, VkImage image, VkImageLayout layout);
+		static void WorkerLoop();
+		static void Encode(const Slot& slot);
+	};
+}
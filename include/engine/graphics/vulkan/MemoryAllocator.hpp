@@ -0,0 +1,107 @@
+#pragma once
+
+#include <engine/graphics/common.hpp>
+#include <vector>
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace en::vk
+{
+	// Pooled device memory. The default pool sub allocates power of two size classes from blocks of c_BlockSlotCount
+	// slots (at most c_MaxBlockSize), so the number of vkAllocateMemory calls stays far below maxMemoryAllocationCount
+	// while a rarely used size class only reserves a few slots. Empty blocks go back to the driver as long as their
+	// size class keeps another block with free slots. Memory exported to CUDA gets its own
+	// VkDeviceMemory in the export pool, and short lived host visible memory comes from a linear per frame arena.
+	class MemoryAllocator
+	{
+	public:
+		enum Pool
+		{
+			Default = 0,
+			Export,
+			Frame,
+			PoolCount
+		};
+
+		struct Block;
+
+		struct Allocation
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize offset = 0;
+			VkDeviceSize size = 0;
+			void* mapped = nullptr; // Host visible memory stays mapped for the whole lifetime, points to offset
+			Pool pool = Default;
+			Block* block = nullptr; // nullptr for dedicated and frame allocations
+			uint32_t slot = 0;
+		};
+
+		struct PoolStats
+		{
+			uint32_t deviceAllocationCount; // Live vkAllocateMemory allocations
+			VkDeviceSize reservedSize; // Device memory owned by the pool
+			uint32_t allocationCount; // Live allocations handed out
+			VkDeviceSize usedSize; // Requested size of the live allocations
+		};
+
+		static void Init();
+		static void Shutdown();
+
+		// linear is false for optimal tiling images, which never share a block with buffers (bufferImageGranularity)
+		static Allocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear);
+		static Allocation AllocateImage(VkImage image, VkMemoryPropertyFlags properties);
+
+		// pNext holds the VkExportMemoryAllocateInfo chain
+		static Allocation AllocateExport(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, const void* pNext);
+
+		// Host visible and coherent. Only valid until the next ResetFrameArena
+		static Allocation AllocateFrame(const VkMemoryRequirements& requirements);
+		static void ResetFrameArena();
+
+		static void Free(const Allocation& allocation);
+
+		static PoolStats GetStats(Pool pool);
+		static void LogStats();
+
+	private:
+		struct Block
+		{
+			uint64_t key; // Of s_Blocks
+			VkDeviceMemory memory;
+			void* mapped;
+			VkDeviceSize size;
+			VkDeviceSize slotSize;
+			uint32_t slotCount;
+			std::vector<uint32_t> freeSlots;
+		};
+
+		static const VkDeviceSize c_MinSlotSize = 256;
+		static const VkDeviceSize c_MaxSlotSize = 32 * 1024 * 1024;
+		static constexpr VkDeviceSize c_BlockSlotCount = 64;
+		static constexpr VkDeviceSize c_MaxBlockSize = 64 * 1024 * 1024;
+		static const VkDeviceSize c_FrameArenaSize = 64 * 1024 * 1024;
+
+		static std::mutex s_Mutex;
+		static std::map<uint64_t, std::vector<std::unique_ptr<Block>>> s_Blocks;
+		static std::array<PoolStats, PoolCount> s_Stats;
+
+		static VkDeviceMemory s_FrameMemory;
+		static void* s_FrameMapped;
+		static uint32_t s_FrameMemoryTypeIndex;
+		static VkDeviceSize s_FrameOffset;
+
+		static Allocation AllocateDedicated(VkDeviceSize size, uint32_t memoryTypeIndex, const void* pNext, Pool pool);
+
+		// Memory of a host visible type is mapped, whatever properties the caller asked for. Blocks are shared by
+		// every request that resolves to the same memory type
+		static VkDeviceMemory AllocateDeviceMemory(
+			VkDeviceSize size,
+			uint32_t memoryTypeIndex,
+			const void* pNext,
+			Pool pool,
+			void** mapped);
+		static void FreeDeviceMemory(VkDeviceMemory memory, VkDeviceSize size, Pool pool);
+	};
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace en::vk
+{
+	// In process GLSL to SPIR-V compilation through shaderc. Results are cached in c_CacheDirPath under a hash of the
+	// source, every file of its include closure, the defines and the target, so a warm cache does no compiler work.
+	class ShaderCompiler
+	{
+	public:
+		// fileName is relative to data/shader/. Defines are "NAME" or "NAME=VALUE"
+		static std::vector<char> GetSpirv(const std::string& fileName, const std::vector<std::string>& defines = {});
+
+		// Fills the cache for all shaders concurrently, so the following Shader constructors only load from it
+		static void Precompile(const std::vector<std::string>& fileNames);
+
+		// Uncached compilation of a source string. The shader stage is taken from the extension of sourceName
+		static std::vector<uint32_t> Compile(const std::string& source, const std::string& sourceName, const std::vector<std::string>& defines = {});
+
+		static void SetThreadCount(uint32_t threadCount);
+
+	private:
+		class Includer;
+
+		// Bump when compile options change in a way the key does not capture
+		static const uint32_t c_CacheVersion = 1;
+		static const char* c_CacheDirPath;
+
+		static uint32_t s_ThreadCount;
+
+		static uint64_t GetCacheKey(const std::string& filePath, const std::vector<std::string>& defines);
+		static std::string ResolveInclude(const std::string& requestingPath, const std::string& includeName);
+		static std::string ReadText(const std::string& filePath);
+	};
+}
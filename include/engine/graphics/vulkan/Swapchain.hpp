@@ -3,6 +3,7 @@
 #include <engine/graphics/common.hpp>
 #include <vector>
 #include <engine/graphics/vulkan/CommandPool.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
 
 namespace en::vk
 {
@@ -34,8 +35,8 @@ namespace en::vk
 
 		void (*m_RecordCommandBufferFunc)(VkCommandBuffer, VkImage);
 		CommandPool m_CommandPool;
-		VkSemaphore m_ImageAvailableSemaphore;
-		VkSemaphore m_RenderFinishedSemaphore;
+		std::array<VkSemaphore, FramePacer::c_MaxFramesInFlight> m_ImageAvailableSemaphores;
+		std::array<VkSemaphore, FramePacer::c_MaxFramesInFlight> m_RenderFinishedSemaphores;
 
 		void CreateSwapchain(VkDevice device, VkSurfaceFormatKHR surfaceFormat, uint32_t width, uint32_t height, VkSwapchainKHR oldSwapchain);
 		void RetreiveImages(VkDevice device);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <engine/graphics/common.hpp>
+#include <engine/graphics/vulkan/MemoryAllocator.hpp>
 #include <vector>
 #include <array>
 
@@ -38,12 +39,10 @@ namespace en::vk
 
 		VkImage m_Image;
 		VkImageView m_ImageView;
-		VkDeviceMemory m_DeviceMemory;
+		MemoryAllocator::Allocation m_DeviceMemory;
 		VkImageLayout m_ImageLayout;
 		VkSampler m_Sampler;
 
 		void LoadToDevice(const void* data, VkFilter filter, VkSamplerAddressMode addressMode);
-		void ChangeLayout(VkImageLayout layout, VkCommandBuffer commandBuffer, VkQueue queue);
-		void WriteBufferToImage(VkCommandBuffer commandBuffer, VkQueue queue, VkBuffer buffer);
 	};
 }
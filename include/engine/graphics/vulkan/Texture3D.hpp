@@ -3,6 +3,7 @@
 #include <vector>
 #include <array>
 #include <engine/graphics/common.hpp>
+#include <engine/graphics/vulkan/MemoryAllocator.hpp>
 
 namespace en::vk
 {
@@ -10,6 +11,7 @@ namespace en::vk
 	{
 	public:
 		static Texture3D FromVDB(const std::string& fileName);
+		static std::vector<std::vector<std::vector<float>>> LoadVDB(const std::string& fileName);
 
 		Texture3D(
 			const std::vector<std::vector<std::vector<float>>>& data, 
@@ -24,6 +26,9 @@ namespace en::vk
 
 		void Destroy();
 
+		// Replaces the content of a single channel texture. data must have the same size as the texture
+		void SetData(const std::vector<std::vector<std::vector<float>>>& data);
+
 		uint32_t GetWidth() const;
 		uint32_t GetHeight() const;
 		uint32_t GetDepth() const;
@@ -41,10 +46,11 @@ namespace en::vk
 
 		VkImage m_Image;
 		VkImageView m_ImageView;
-		VkDeviceMemory m_DeviceMemory;
+		MemoryAllocator::Allocation m_DeviceMemory;
 		VkImageLayout m_ImageLayout;
 		VkSampler m_Sampler;
 
+		std::vector<uint8_t> PackData(const std::vector<std::vector<std::vector<float>>>& data) const;
 		void LoadToDevice(void* data, VkFilter filter, VkSamplerAddressMode addressMode, VkBorderColor borderColor);
 		void ChangeLayout(VkImageLayout layout, VkCommandBuffer commandBuffer, VkQueue queue);
 		void WriteBufferToImage(VkCommandBuffer commandBuffer, VkQueue queue, VkBuffer buffer);
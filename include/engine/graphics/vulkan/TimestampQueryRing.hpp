@@ -0,0 +1,62 @@
+#pragma once
+
+#include <engine/graphics/vulkan/FramePacer.hpp>
+#include <string>
+#include <vector>
+
+namespace en::vk
+{
+	// Timestamp queries for command buffers that are recorded once per ring slot and submitted round robin. Each slot has
+	// its own query pool, and finished slots are read back without waiting, so statistics lag a few frames behind.
+	// Pass i is measured from timestamp i to i + 1. A last "Total" pass spans the first to the last timestamp.
+	class TimestampQueryRing
+	{
+	public:
+		struct Stats
+		{
+			float last;
+			float mean;
+			float min;
+			float max;
+			float p50;
+			float p95;
+			float p99;
+		};
+
+		static const uint32_t c_RingSize = FramePacer::c_MaxFramesInFlight + 1;
+		static const size_t c_WindowSize = 128;
+
+		TimestampQueryRing(const std::vector<std::string>& passNames);
+
+		void Destroy();
+
+		void CmdReset(VkCommandBuffer commandBuffer, uint32_t slot) const;
+		void CmdWriteTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage, uint32_t slot, uint32_t index) const;
+
+		// Collects finished slots and returns the slot the next submission has to use
+		uint32_t NextSlot();
+		void Collect();
+
+		size_t GetPassCount() const;
+		size_t GetTotalPass() const;
+		const std::string& GetPassName(size_t pass) const;
+		float GetLast(size_t pass) const;
+		Stats GetStats(size_t pass) const;
+
+		void RenderImGui() const;
+
+	private:
+		std::vector<std::string> m_PassNames;
+		uint32_t m_TimestampCount;
+		float m_TimestampPeriodInMS;
+
+		std::array<VkQueryPool, c_RingSize> m_QueryPools;
+		std::array<bool, c_RingSize> m_Pending;
+		uint32_t m_NextSlot;
+
+		std::vector<std::vector<float>> m_Samples; // Per pass window, written round robin
+		size_t m_SampleCount;
+
+		bool ReadSlot(uint32_t slot, bool wait);
+	};
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <engine/graphics/vulkan/Buffer.hpp>
+#include <deque>
+#include <mutex>
+
+namespace en::vk
+{
+	// Uploads host data to device local buffers and images through a persistent staging ring. Copies are batched and
+	// submitted together by Flush, on the dedicated transfer queue if the device has one. Ownership of the destination
+	// is then acquired by the graphics queue, so graphics work submitted after Flush sees the data without a host wait.
+	// Destinations must be created with exclusive sharing mode.
+	class Uploader
+	{
+	public:
+		static void Init();
+		static void Shutdown();
+
+		// data is copied into the ring before returning
+		static void UploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size);
+
+		// Uploads mip level 0 and layer 0 of a color image that is in oldLayout and leaves it in finalLayout.
+		// data is tightly packed and size is the size of the whole extent.
+		static void UploadImage(
+			VkImage image,
+			VkExtent3D extent,
+			const void* data,
+			VkDeviceSize size,
+			VkImageLayout oldLayout,
+			VkImageLayout finalLayout);
+
+		// Returns the timeline value that is reached once the batch is visible to the graphics queue
+		static uint64_t Flush();
+		static void Wait(uint64_t value);
+		static bool IsComplete(uint64_t value);
+
+	private:
+		struct Batch
+		{
+			VkCommandBuffer transferCommandBuffer;
+			VkCommandBuffer graphicsCommandBuffer; // VK_NULL_HANDLE if transfer and graphics share a family
+			uint64_t ringEnd;
+			uint64_t value;
+		};
+
+		static const VkDeviceSize c_RingSize = 64 * 1024 * 1024;
+		static const VkDeviceSize c_RingAlignment = 16;
+
+		static std::mutex s_Mutex;
+
+		static Buffer* s_RingBuffer;
+		static uint8_t* s_RingData;
+		static uint64_t s_RingHead; // Both grow monotonically, the ring position is modulo c_RingSize
+		static uint64_t s_RingTail;
+
+		static VkSemaphore s_TimelineSemaphore;
+		static uint64_t s_TimelineValue;
+
+		static VkCommandPool s_TransferCommandPool;
+		static VkCommandPool s_GraphicsCommandPool;
+		static std::vector<VkCommandBuffer> s_FreeTransferCommandBuffers;
+		static std::vector<VkCommandBuffer> s_FreeGraphicsCommandBuffers;
+
+		static Batch s_Batch;
+		static bool s_BatchOpen;
+		static std::deque<Batch> s_InFlightBatches;
+
+		static bool IsSeparateTransferQueue();
+		static void BeginBatch();
+		static uint64_t SubmitBatch();
+		static void Reclaim(bool wait);
+		static VkDeviceSize Reserve(VkDeviceSize size);
+		static VkCommandBuffer GetCommandBuffer(VkCommandPool commandPool, std::vector<VkCommandBuffer>& freeCommandBuffers);
+	};
+}
@@ -4,6 +4,7 @@
 #include <glm/glm.hpp>
 #include <engine/graphics/vulkan/Buffer.hpp>
 #include <engine/graphics/Camera.hpp>
+#include <engine/util/OccupancyGrid.hpp>
 
 namespace en
 {
@@ -14,7 +15,13 @@ namespace en
 		static void Shutdown(VkDevice device);
 		static VkDescriptorSetLayout GetDescriptorSetLayout();
 
-		VolumeData(const vk::Texture3D* densityTex, float densityFactor, float g);
+		VolumeData(
+			const vk::Texture3D* densityTex,
+			const std::vector<std::vector<std::vector<float>>>& densityData,
+			float densityFactor,
+			float g,
+			bool residualRatioTracking,
+			bool emptySpaceSkipping);
 
 		void Destroy();
 
@@ -22,6 +29,8 @@ namespace en
 
 		float GetDensityFactor() const;
 		float GetG() const;
+		bool UsesResidualRatioTracking() const;
+		bool UsesEmptySpaceSkipping() const;
 		VkDescriptorSet GetDescriptorSet() const;
 		VkExtent3D GetExtent() const;
 
@@ -31,11 +40,19 @@ namespace en
 
 		float m_DensityFactor = 0.0;
 		float m_G = 0.0;
+		bool m_ResidualRatioTracking = false;
+		bool m_EmptySpaceSkipping = false;
 
 		VkDescriptorSet m_DescriptorSet;
 
 		const vk::Texture3D* m_DensityTex;
+		vk::Texture3D* m_DensityGridTex = nullptr;
 
+		OccupancyGrid m_OccupancyGrid;
+		vk::Buffer* m_OccupancyBuffer = nullptr;
+
+		static vk::Texture3D* CreateDensityGrid(const std::vector<std::vector<std::vector<float>>>& densityData);
+		void CreateOccupancyBuffer();
 		void UpdateDescriptorSet();
 	};
 }
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <string>
+#include <ostream>
+#include <cstring>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <type_traits>
+
+namespace en
+{
+	// Deferred and batched log output. Writers copy a format string pointer and their arguments into a preallocated
+	// ring buffer of the calling thread. A background thread formats the records and writes them per stream in batches.
+	class AsyncLog
+	{
+	public:
+		static void Init();
+		static void Shutdown();
+		static void Flush();
+
+		// Writes prefix + formatted fmt + newline. prefix, fmt and string arguments are stored as pointers, so fmt and
+		// string arguments only bind to char arrays (string literals). Each "{}" is replaced by the next argument.
+		template<size_t N, typename... Args>
+		static void WriteLine(std::ostream* stream, const char* prefix, const char (&fmt)[N], const Args&... args);
+
+		// Copies str and writes prefix + str + newline
+		static void WriteLine(std::ostream* stream, const char* prefix, const std::string& str);
+
+	private:
+		struct Record;
+		typedef void (*FormatFn)(const Record& record, std::string& out);
+
+		static const size_t c_RecordSize = 128;
+		static const size_t c_RingCapacity = 4096;
+
+		struct Record
+		{
+			FormatFn format;
+			std::ostream* stream;
+			const char* prefix;
+			const char* fmt;
+			alignas(8) uint8_t data[c_RecordSize - 4 * sizeof(void*)];
+		};
+
+		struct ThreadRing;
+		struct RingOwner;
+
+		// Arrays (string literals) are stored as pointers, everything else by value
+		template<typename T>
+		using StoredType = std::conditional_t<std::is_array_v<T>, const std::remove_extent_t<T>*, std::decay_t<T>>;
+
+		// A char pointer argument may point into a temporary string that is gone before the record is formatted
+		template<typename T>
+		static constexpr bool IsRawString =
+			!std::is_array_v<T> && (std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*>);
+
+		static std::atomic<bool> s_Running;
+
+		static ThreadRing* GetThreadRing();
+		static std::vector<std::unique_ptr<ThreadRing>>& GetRings();
+
+		// Returns nullptr once the log is shut down, the record is then written synchronously
+		static Record* BeginRecord();
+		static void CommitRecord();
+		static void WriteNow(const Record& record);
+		static bool IsIdle();
+
+		static void AppendUntilPlaceholder(std::string& out, const char*& fmt);
+
+		template<typename T>
+		static void AppendValue(std::string& out, T value)
+		{
+			if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>)
+			{
+				out += value;
+			}
+			else
+			{
+				static_assert(std::is_arithmetic_v<T>, "AsyncLog only formats arithmetic values and C strings");
+				out += std::to_string(value);
+			}
+		}
+
+		template<typename T>
+		static void PackArg(uint8_t* data, size_t& offset, const T& value)
+		{
+			std::memcpy(data + offset, &value, sizeof(T));
+			offset += sizeof(T);
+		}
+
+		template<typename T>
+		static void AppendArg(std::string& out, const char*& fmt, const uint8_t* data, size_t& offset)
+		{
+			T value;
+			std::memcpy(&value, data + offset, sizeof(T));
+			offset += sizeof(T);
+
+			AppendUntilPlaceholder(out, fmt);
+			AppendValue(out, value);
+		}
+
+		template<typename... Args>
+		static void FormatArgs(const Record& record, std::string& out)
+		{
+			out += record.prefix;
+
+			const char* fmt = record.fmt;
+			size_t offset = 0;
+			(AppendArg<Args>(out, fmt, record.data, offset), ...);
+			out += fmt;
+			out += '\n';
+		}
+
+		static void FormatInlineString(const Record& record, std::string& out);
+		static void FormatHeapString(const Record& record, std::string& out);
+		static void Drain();
+		static void FlusherLoop();
+		static void CrashHandler(int signal);
+	};
+
+	template<size_t N, typename... Args>
+	void AsyncLog::WriteLine(std::ostream* stream, const char* prefix, const char (&fmt)[N], const Args&... args)
+	{
+		static_assert((std::is_trivially_copyable_v<StoredType<Args>> && ...), "AsyncLog arguments must be trivially copyable");
+		static_assert((sizeof(StoredType<Args>) + ... + 0) <= sizeof(Record::data), "AsyncLog arguments do not fit into one record");
+		static_assert(!(IsRawString<Args> || ...), "AsyncLog string arguments must be string literals");
+
+		Record local;
+		Record* record = BeginRecord();
+		if (record == nullptr) { record = &local; }
+		record->format = &FormatArgs<StoredType<Args>...>;
+		record->stream = stream;
+		record->prefix = prefix;
+		record->fmt = fmt;
+
+		size_t offset = 0;
+		(PackArg<StoredType<Args>>(record->data, offset, args), ...);
+
+		if (record == &local) { WriteNow(local); }
+		else { CommitRecord(); }
+	}
+}
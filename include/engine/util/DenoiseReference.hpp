@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+namespace en
+{
+	// Host reference of the HpmDenoiser passes (data/shader/denoise). Images are rgba32f. Keeps the temporal history
+	// between calls, so a sequence of frames produces the same output as the gpu denoiser.
+	class DenoiseReference
+	{
+	public:
+		static constexpr uint32_t c_AtrousIterationCount = 5;
+		static constexpr uint32_t c_MinTemporalVarianceHistory = 4;
+		static constexpr float c_KernelWeights[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f }; // KERNEL_WEIGHTS in atrous.comp
+
+		struct Params
+		{
+			bool temporal = true;
+			float maxHistory = 32.0f;
+			float depthTolerance = 0.25f;
+			float sigmaLuminance = 4.0f;
+			float sigmaPosition = 1.0f;
+			float sigmaTransmittance = 0.1f;
+		};
+
+		struct Frame
+		{
+			glm::mat4 invProjView;
+			glm::mat4 prevProjView;
+			glm::vec3 camPos;
+			glm::vec3 prevCamPos;
+			const float* color; // rgb = renderer output
+			const float* guide; // x = scatter flag, y = first scatter depth
+		};
+
+		DenoiseReference(uint32_t width, uint32_t height, const Params& params);
+
+		void Denoise(const Frame& frame, float* output);
+		void Reset();
+
+	private:
+		uint32_t m_Width;
+		uint32_t m_Height;
+		Params m_Params;
+
+		std::vector<glm::vec4> m_History;
+		std::vector<glm::vec4> m_Moments;
+		std::vector<glm::vec4> m_Ping;
+		std::vector<glm::vec4> m_Pong;
+
+		size_t GetIndex(int32_t x, int32_t y) const;
+		bool IsInsideImage(int32_t x, int32_t y) const;
+		glm::vec3 GetPrimaryRayDir(const Frame& frame, int32_t x, int32_t y) const;
+
+		void TemporalPass(const Frame& frame, const std::vector<glm::vec4>& prevHistory, const std::vector<glm::vec4>& prevMoments);
+		float EstimateSpatialVariance(const Frame& frame, int32_t x, int32_t y, float scatter) const;
+		void AtrousPass(const Frame& frame, uint32_t stepSize, const std::vector<glm::vec4>& input, std::vector<glm::vec4>& result) const;
+	};
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <engine/util/Random.hpp>
+
+namespace en
+{
+	// Coarse control density and residual majorant per c_CellSize^3 voxels for residual ratio tracking. Statistics are
+	// taken over the 8 bit values the density texture stores, so the residual majorant bounds every voxel of its cell.
+	// ResidualRatioTrack and RatioTrack mirror the functions of the same name in data/shader/include/path_trace.glsl,
+	// RatioTrack without empty space skipping.
+	class DensityGrid
+	{
+	public:
+		static const uint32_t c_CellSize = 16; // DENSITY_GRID_CELL_SIZE in volume.glsl
+		static const uint32_t c_MaxDensityLookups = 128; // RESIDUAL_MAX_DENSITY_LOOKUPS in path_trace.glsl
+
+		DensityGrid(const std::vector<std::vector<std::vector<float>>>& densityData);
+
+		const glm::ivec3& GetCellCount() const;
+
+		// Both in 8 bit texture units
+		uint8_t GetControl(const glm::ivec3& cell) const;
+		uint8_t GetResidualMajorant(const glm::ivec3& cell) const;
+
+		// Transmittance from start to end. The volume is centered at the origin with boxSize and its stored densities
+		// are scaled by densityFactor (VOLUME_DENSITY_FACTOR). densityLookupCount receives the number of density
+		// texture lookups if it is not nullptr
+		float ResidualRatioTrack(
+			const glm::vec3& boxSize,
+			float densityFactor,
+			const glm::vec3& start,
+			const glm::vec3& end,
+			Random& random,
+			uint32_t* densityLookupCount = nullptr) const;
+
+		// Ratio tracking against the global majorant densityFactor
+		float RatioTrack(
+			const glm::vec3& boxSize,
+			float densityFactor,
+			const glm::vec3& start,
+			const glm::vec3& end,
+			Random& random,
+			uint32_t* densityLookupCount = nullptr) const;
+
+	private:
+		std::array<uint32_t, 3> m_DensitySize;
+		glm::ivec3 m_CellCount;
+		std::vector<uint8_t> m_Density;
+		std::vector<uint8_t> m_Control;
+		std::vector<uint8_t> m_ResidualMajorant;
+
+		uint32_t GetCellIndex(const glm::ivec3& cell) const;
+
+		// Nearest voxel lookup with a black border like the density texture, in 8 bit texture units
+		uint8_t GetDensity(const glm::vec3& voxelPos) const;
+	};
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <engine/util/Random.hpp>
+
+namespace en
+{
+	// Importance sampling tables of the hdr env map. Rows are weighted by cos(latitude), so the pdf is proportional to
+	// brightness per solid angle. Pdf and SampleDir are the host mirrors of HdrEnvMapPdf and SampleHdrEnvMapDir in
+	// data/shader/include/path_trace.glsl
+	class EnvMapDistribution
+	{
+	public:
+		// hdr4f holds width * height rgba pixels, rows from bottom (latitude -pi/2) to top
+		EnvMapDistribution(const std::vector<float>& hdr4f, uint32_t width, uint32_t height);
+
+		// Solid angle pdf of the env map sampling strategy for the normalized direction dir
+		float Pdf(const glm::vec3& dir) const;
+
+		// Direction distributed by Pdf. Draws the same four random numbers as the shader
+		glm::vec3 SampleDir(Random& random) const;
+
+		// Cdf of x given y, width values per row
+		const std::vector<float>& GetCdfX() const;
+		const std::vector<float>& GetCdfY() const;
+
+		static glm::vec2 DirToUv(const glm::vec3& dir);
+		static glm::vec3 UvToDir(const glm::vec2& uv);
+
+	private:
+		uint32_t m_Width;
+		uint32_t m_Height;
+		std::vector<float> m_CdfX;
+		std::vector<float> m_CdfY;
+	};
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace en
+{
+	// Host side comparison of rgba32f images. Sums are accumulated per fixed size tile with kahan summation
+	// and tile results are reduced pairwise in a fixed order, so results do not depend on the thread count.
+	class ImageCompare
+	{
+	public:
+		struct Result
+		{
+			double mse; // Mean squared error over rgb
+			double relMse; // Squared error relative to squared reference value
+			double smape; // Symmetric mean absolute percentage error
+			double ssim; // Mean SSIM of luminance over 8x8 windows
+			std::array<double, 3> refMean; // Per channel mean of reference image
+			std::array<double, 3> ownMean; // Per channel mean of "not reference" image
+			std::array<double, 3> ownVar; // Per channel variance of "not reference" image
+			std::array<double, 3> bias; // Per channel mean of own - ref
+			uint32_t validPixelCount; // Number of pixels with ref alpha != 0 and converged reference
+
+			float GetRefMean() const;
+			float GetOwnMean() const;
+			float GetOwnVar() const;
+			float GetBias() const;
+			float GetRelBias() const;
+			float GetRelVar() const;
+			float GetCV() const;
+		};
+
+		// Pixels whose refError is above maxRefError are excluded if a reference error map is given
+		static Result Compare(
+			const float* ref,
+			const float* own,
+			uint32_t width,
+			uint32_t height,
+			const float* refError = nullptr,
+			float maxRefError = 0.0f);
+		static Result CompareExr(const std::string& refPath, const std::string& ownPath);
+
+		static void SetThreadCount(uint32_t threadCount);
+
+	private:
+		struct TileSums;
+
+		static const uint32_t c_TileHeight = 8;
+		static const uint32_t c_SsimWindowSize = 8;
+
+		static uint32_t s_ThreadCount;
+
+		static void AccumulateTile(
+			const float* ref,
+			const float* own,
+			const float* refError,
+			float maxRefError,
+			uint32_t width,
+			uint32_t height,
+			uint32_t tileIndex,
+			TileSums& sums);
+	};
+}
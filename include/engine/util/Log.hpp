@@ -4,6 +4,8 @@
 #include <vulkan/vulkan_core.h>
 #include <unordered_map>
 #include <fstream>
+#include <iostream>
+#include <engine/util/AsyncLog.hpp>
 
 namespace en
 {
@@ -12,6 +14,14 @@ namespace en
 	public:
 		static void Info(const std::string& msg);
 		static void Warn(const std::string& msg);
+
+		// Deferred formatting for hot paths, see AsyncLog::WriteLine. fmt must be a string literal
+		template<size_t N, typename... Args>
+		static void Info(const char (&fmt)[N], const Args&... args)
+		{
+			AsyncLog::WriteLine(&std::cout, "INFO: \t", fmt, args...);
+		}
+
 		static void Error(const std::string& msg, bool exit);
 		static void LocationError(const std::string& msg, VkResult res, const std::string& file, const int line, bool exit);
 	};
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <fstream>
+#include <engine/util/AsyncLog.hpp>
 
 namespace en
 {
@@ -13,6 +14,13 @@ namespace en
 
 		void WriteLine(const std::string& line);
 
+		// Deferred formatting, see AsyncLog::WriteLine. fmt must be a string literal
+		template<size_t N, typename... Args>
+		void WriteLine(const char (&fmt)[N], const Args&... args)
+		{
+			AsyncLog::WriteLine(&m_File, "", fmt, args...);
+		}
+
 	private:
 		std::ofstream m_File;
 	};
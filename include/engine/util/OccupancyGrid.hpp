@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace en
+{
+	// Two level occupancy bitfield of the density volume for empty space skipping. A fine brick covers c_BrickSize^3
+	// voxels, a coarse brick c_CoarseFactor^3 fine bricks. A brick is empty if its voxels and their direct neighbours all
+	// store 0 in the 8 bit density texture, so rounding at brick faces can never skip density.
+	// SkipEmptySpace mirrors SkipEmptySpace in data/shader/include/volume.glsl.
+	class OccupancyGrid
+	{
+	public:
+		static const uint32_t c_BrickSize = 8; // OCCUPANCY_BRICK_SIZE in volume.glsl
+		static const uint32_t c_CoarseFactor = 4; // OCCUPANCY_COARSE_FACTOR in volume.glsl
+		static const uint32_t c_MaxSkipSteps = 64;
+
+		OccupancyGrid(const std::vector<std::vector<std::vector<float>>>& densityData);
+
+		// Fine level bits followed by the coarse level bits. Bit i of a level is brick x + count.x * (y + count.y * z)
+		const std::vector<uint32_t>& GetBits() const;
+		bool IsOccupied(uint32_t level, const glm::ivec3& brick) const;
+		float GetOccupiedFraction(uint32_t level) const;
+
+		// Distance along the ray to the first occupied fine brick at or after t, or tMax if the rest of the ray is empty.
+		// The volume is centered at the origin with boxSize. Collisions of delta and ratio tracking can only happen at
+		// non zero density, so restarting them at the returned distance does not change their distribution.
+		float SkipEmptySpace(const glm::vec3& boxSize, const glm::vec3& ro, const glm::vec3& rd, float t, float tMax) const;
+
+	private:
+		std::array<uint32_t, 3> m_DensitySize;
+		std::array<glm::ivec3, 2> m_BrickCount;
+		std::array<uint32_t, 2> m_WordOffset;
+		std::vector<uint32_t> m_Bits;
+
+		void SetOccupied(uint32_t level, const glm::ivec3& brick);
+		uint32_t GetBitIndex(uint32_t level, const glm::ivec3& brick) const;
+	};
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace en
+{
+	// Host mirror of data/shader/include/random.glsl. Given the same pixel, frame, sample, view and bounce it returns
+	// bit identical values to the shaders, so host and device results can be compared sample for sample.
+	class Random
+	{
+	public:
+		static std::array<uint32_t, 4> Pcg4d(std::array<uint32_t, 4> v);
+		static float UintToUnitFloat(uint32_t x);
+
+		Random(uint32_t pixelX, uint32_t pixelY, uint32_t frameIndex, uint32_t sampleIndex, uint32_t viewIndex = 0);
+
+		void SetBounce(uint32_t bounce);
+		uint32_t NextUint();
+		float NextFloat(float maxVal = 1.0f);
+
+	private:
+		std::array<uint32_t, 4> m_Key;
+	};
+}
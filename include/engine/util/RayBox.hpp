@@ -0,0 +1,15 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace en
+{
+	// Host mirror of ray_box_intersect in data/shader/include/volume.glsl
+	class RayBox
+	{
+	public:
+		// Returns false if the ray misses the box. Otherwise t = (tNear, tFar) with tNear clamped to 0 for origins
+		// inside the box. t is left untouched on a miss
+		static bool Intersect(const glm::vec3& boxPos, const glm::vec3& boxSize, const glm::vec3& ro, const glm::vec3& rd, glm::vec2& t);
+	};
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+namespace en
+{
+	// Picks the render scale that keeps the frame time at a target. Render cost is assumed to grow with the pixel count,
+	// so the scale only increases once the predicted frame time at the next step stays below the target. Every change
+	// recreates the renderer resources and resets their history, so changes are rate limited.
+	class ResolutionController
+	{
+	public:
+		static const uint32_t c_WidthAlignment = 32; // Dispatch width of the renderers
+		static const uint32_t c_HeightAlignment = 8; // TileScheduler::c_TileHeight
+
+		ResolutionController(float targetFrameTimeMS, float minScale, float maxScale, float scaleStep);
+
+		// Returns true if the scale changed
+		bool Update(float frameTimeMS);
+		void Reset();
+		void RenderImGui();
+
+		float GetScale() const;
+
+		// Multiples of c_WidthAlignment x c_HeightAlignment, no larger than the output size unless it is smaller than one step
+		void GetRenderSize(uint32_t outputWidth, uint32_t outputHeight, uint32_t& width, uint32_t& height) const;
+
+	private:
+		static const uint32_t c_CooldownFrameCount = 32;
+		static constexpr float c_FrameTimeSmoothing = 0.1f;
+		static constexpr float c_Tolerance = 0.05f;
+
+		float m_TargetFrameTimeMS;
+		float m_MinScale;
+		float m_MaxScale;
+		float m_ScaleStep;
+
+		float m_Scale;
+		float m_AvgFrameTimeMS = 0.0f;
+		uint32_t m_FramesSinceChange = 0;
+	};
+}
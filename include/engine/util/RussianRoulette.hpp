@@ -0,0 +1,17 @@
+#pragma once
+
+#include <engine/util/Random.hpp>
+
+namespace en
+{
+	// Host mirror of RussianRoulette in data/shader/include/path_trace.glsl
+	class RussianRoulette
+	{
+	public:
+		static const uint32_t c_MinBounces = 2; // RR_MIN_BOUNCES
+		static constexpr float c_Throughput = 0.1f; // RR_THROUGHPUT
+
+		// Returns false if the path ends after bounce. Survivors divide factor by their survival probability
+		static bool Continue(uint32_t bounce, float& factor, Random& random);
+	};
+}
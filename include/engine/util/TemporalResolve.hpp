@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+namespace en
+{
+	// Host reference of the temporal resolve in data/shader/nrc/render.comp. Images are rgba32f, the alpha channel of
+	// history and of the resolved result holds the accumulated sample count. The shader writes the resolved result to
+	// the next history and only its color to the output image.
+	class TemporalResolve
+	{
+	public:
+		static const uint32_t c_MaxMovingHistory = 32; // TEMPORAL_MAX_HISTORY in nrc-constants.glsl
+
+		struct Frame
+		{
+			uint32_t width;
+			uint32_t height;
+			glm::mat4 invProjView;
+			glm::mat4 prevProjView;
+			glm::vec3 camPos;
+			const float* current; // rgba, rgb = current frame color
+			const float* depth; // First scatter depth per pixel
+			const float* history; // rgba of last frame
+		};
+
+		// Returns false if the point lies behind last frames camera or outside of the image
+		static bool Reproject(
+			const glm::mat4& prevProjView,
+			const glm::vec3& worldPos,
+			uint32_t width,
+			uint32_t height,
+			glm::vec2& prevPixel);
+
+		// reset discards the history, reproject selects between a static and a moving camera
+		static void ResolveImage(const Frame& frame, bool reset, bool reproject, float* output);
+
+	private:
+		static glm::vec4 LoadHistoryBilinear(const Frame& frame, const glm::vec2& pixel);
+		static glm::vec4 ResolvePixel(const Frame& frame, bool reset, bool reproject, uint32_t x, uint32_t y);
+	};
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+namespace en
+{
+	// Host reference of the adaptive tile selection in data/shader/mc/tile_variance.comp. mean and info are the rgba32f
+	// output and info images of the McHpmRenderer, info.x holds the per pixel sample count and info.yzw the welford sums.
+	class TileScheduler
+	{
+	public:
+		static const uint32_t c_TileWidth = 32; // TILE_WIDTH in mc-constants.glsl
+		static const uint32_t c_TileHeight = 8; // TILE_HEIGHT in mc-constants.glsl
+		static const uint32_t c_DefaultMinSampleCount = 32;
+
+		// Relative standard error of the pixel mean summed over rgb. Pixels below minSampleCount count as unconverged.
+		static float GetPixelRelStdError(const float* mean, const float* info, uint32_t minSampleCount);
+
+		// Indices (y * tileCountX + x) of all tiles whose worst pixel is above targetRelStdError in ascending order.
+		// The gpu appends the same tiles with atomics, so its order differs between frames. Border tiles may be partial.
+		static std::vector<uint32_t> BuildTileList(
+			const float* mean,
+			const float* info,
+			uint32_t width,
+			uint32_t height,
+			float targetRelStdError,
+			uint32_t minSampleCount,
+			bool reset);
+
+		// Tiles along one axis, a partial tile covers the rest of the image
+		static uint32_t GetTileCount(uint32_t size, uint32_t tileSize);
+	};
+}
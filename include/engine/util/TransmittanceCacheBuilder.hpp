@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <future>
+#include <functional>
+#include <glm/glm.hpp>
+
+namespace en
+{
+	// Background rebuilds of a light transmittance grid. The key is the light direction or position the grid belongs
+	// to. A grid for a new key is built on a worker thread while shading keeps the previous grid, and only one build
+	// runs at a time.
+	class TransmittanceCacheBuilder
+	{
+	public:
+		typedef std::vector<std::vector<std::vector<float>>> Grid;
+		typedef std::function<Grid(const glm::vec3& key)> BuildFn;
+
+		// key is the key of the grid the caller already uses
+		TransmittanceCacheBuilder(const glm::vec3& key);
+		~TransmittanceCacheBuilder();
+
+		// Call once per frame with the current key of the light. Returns true if a build finished, its grid and key are
+		// then moved to grid and builtKey. Starts a build if key differs from the newest grid and none is running
+		bool Update(const glm::vec3& key, const BuildFn& build, Grid& grid, glm::vec3& builtKey);
+
+		bool NeedsRebuild(const glm::vec3& key) const;
+
+		// From the start of a build until Update returns its grid
+		bool IsBuilding() const;
+		void Wait();
+
+	private:
+		// Key of the newest grid, finished or in progress
+		glm::vec3 m_Key;
+		std::future<Grid> m_Future;
+	};
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace en
+{
+	// CPU builder of a coarse grid holding the transmittance from each cell center toward a directional light.
+	// Slices perpendicular to the dominant axis of the light direction are swept starting at the light side. Each cell
+	// continues the bilinearly interpolated transmittance of the previous slice, and the cells of one slice are built in parallel.
+	class TransmittanceGrid
+	{
+	public:
+		// Density voxels per grid cell and axis (DIR_LIGHT_TRANSMITTANCE_CELL_SIZE in path_trace.glsl)
+		static constexpr uint32_t c_CellSize = 4;
+		static constexpr uint32_t c_RadialSize = 128;
+
+		// voxelSize is the world space edge length of one density voxel
+		TransmittanceGrid(const std::vector<std::vector<std::vector<float>>>& densityData, float densityFactor, float voxelSize);
+
+		// toLight points from the volume toward the light
+		std::vector<std::vector<std::vector<float>>> Build(const glm::vec3& toLight) const;
+
+		// Transmittance from a point light along c_RadialSize^2 octahedral mapped directions, at c_RadialSize radii evenly
+		// spaced from 0 to maxRadius. Rays are independent, so each one is marched outward once.
+		std::vector<std::vector<std::vector<float>>> BuildRadial(const glm::vec3& lightPos, float maxRadius) const;
+
+		// Distance from lightPos to the farthest corner of the volume
+		float GetMaxRadius(const glm::vec3& lightPos) const;
+
+		static glm::vec3 OctahedralToDir(float u, float v);
+
+		static void SetThreadCount(uint32_t threadCount);
+
+	private:
+		static uint32_t s_ThreadCount;
+
+		std::array<uint32_t, 3> m_DensitySize;
+		std::array<uint32_t, 3> m_Size;
+		std::vector<float> m_Density;
+		float m_DensityFactor;
+		float m_VoxelSize;
+
+		float GetDensity(const glm::vec3& voxelPos) const;
+		float SampleSlice(const std::vector<float>& transmittance, const glm::vec3& cellPos, uint32_t axis) const;
+		size_t GetIndex(uint32_t x, uint32_t y, uint32_t z) const;
+	};
+}
@@ -153,7 +153,7 @@ namespace en
 
 	AppConfig::AppConfig(const std::vector<char*>& argv)
 	{
-		if (argv.size() != 18) { Log::Error("Argument count does not match requirements for AppConfig", true); }
+		if (argv.size() != 18 && argv.size() != 19) { Log::Error("Argument count does not match requirements for AppConfig", true); }
 
 		size_t index = 1;
 
@@ -179,6 +179,7 @@ namespace en
 		primaryRayLength = std::stoi(argv[index++]);
 		primaryRayProb = std::stof(argv[index++]);
 		trainRayLength = std::stoi(argv[index++]);
+		if (index < argv.size()) { primaryRaySpreadTermination = std::stoi(argv[index++]) != 0; }
 	}
 
 	std::string AppConfig::GetName() const
@@ -201,6 +202,7 @@ namespace en
 		str += std::to_string(primaryRayLength) + "_";
 		str += std::to_string(primaryRayProb) + "_";
 		str += std::to_string(trainRayLength);
+		if (primaryRaySpreadTermination) { str += "_spread"; }
 		return str;
 	}
 
@@ -222,6 +224,7 @@ namespace en
 		ImGui::Text("Primary ray length %d", primaryRayLength);
 		ImGui::Text("Primary ray prob %f", primaryRayProb);
 		ImGui::Text("Train ray length %d", trainRayLength);
+		ImGui::Text("Primary ray spread termination %d", primaryRaySpreadTermination);
 		ImGui::End();
 	}
 }
@@ -0,0 +1,304 @@
+#include <engine/util/AsyncLog.hpp>
+#include <iostream>
+#include <vector>
+#include <array>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
+#include <csignal>
+#include <exception>
+#include <algorithm>
+
+namespace en
+{
+	// Single producer (owning thread) single consumer (drain) ring
+	struct AsyncLog::ThreadRing
+	{
+		std::array<Record, c_RingCapacity> records;
+		std::atomic<size_t> head = 0;
+		std::atomic<size_t> tail = 0;
+		std::atomic<bool> writing = false; // Between BeginRecord and CommitRecord
+		bool retired = false; // Owning thread has exited, guarded by s_RingsMutex
+	};
+
+	std::atomic<bool> AsyncLog::s_Running = false;
+
+	static std::mutex s_RingsMutex;
+	static std::atomic<uint64_t> s_RingGeneration = 1; // Rings of older generations were freed by Shutdown
+
+	static std::mutex s_DrainMutex;
+	static std::mutex s_WakeMutex;
+	static std::condition_variable s_WakeCv;
+	static bool s_StopFlusher = false;
+	static std::thread s_FlusherThread;
+	static std::terminate_handler s_PrevTerminateHandler = nullptr;
+
+	void AsyncLog::Init()
+	{
+		if (s_Running) { return; }
+
+		s_StopFlusher = false;
+		s_FlusherThread = std::thread(FlusherLoop);
+		s_Running = true;
+
+		// Best effort flush on crash
+		std::signal(SIGSEGV, CrashHandler);
+		std::signal(SIGABRT, CrashHandler);
+		std::signal(SIGFPE, CrashHandler);
+		std::signal(SIGILL, CrashHandler);
+		s_PrevTerminateHandler = std::set_terminate([]()
+		{
+			Flush();
+			if (s_PrevTerminateHandler != nullptr) { s_PrevTerminateHandler(); }
+			std::abort();
+		});
+	}
+
+	// Retires the ring of the thread on exit, the drain frees it once its records are written
+	struct AsyncLog::RingOwner
+	{
+		ThreadRing* ring = nullptr;
+		uint64_t generation = 0;
+
+		~RingOwner()
+		{
+			std::lock_guard<std::mutex> lock(s_RingsMutex);
+			if (ring != nullptr && generation == s_RingGeneration) { ring->retired = true; }
+		}
+	};
+
+	void AsyncLog::Shutdown()
+	{
+		if (!s_Running) { return; }
+
+		// New records are written synchronously from here on
+		s_Running = false;
+		{
+			std::lock_guard<std::mutex> lock(s_WakeMutex);
+			s_StopFlusher = true;
+		}
+		s_WakeCv.notify_one();
+		s_FlusherThread.join();
+
+		// Writers that saw s_Running before it was cleared may still commit
+		while (!IsIdle())
+		{
+			Flush();
+			std::this_thread::yield();
+		}
+		Flush();
+
+		std::lock_guard<std::mutex> lock(s_RingsMutex);
+		GetRings().clear();
+		s_RingGeneration++;
+	}
+
+	void AsyncLog::Flush()
+	{
+		std::lock_guard<std::mutex> lock(s_DrainMutex);
+		Drain();
+	}
+
+	void AsyncLog::WriteLine(std::ostream* stream, const char* prefix, const std::string& str)
+	{
+		Record local;
+		Record* record = BeginRecord();
+		if (record == nullptr) { record = &local; }
+		record->stream = stream;
+		record->prefix = prefix;
+		record->fmt = nullptr;
+
+		// Short strings are copied into the record, long ones are moved to the heap and freed by the drain
+		const uint32_t length = static_cast<uint32_t>(str.size());
+		if (sizeof(uint32_t) + length <= sizeof(Record::data))
+		{
+			record->format = &FormatInlineString;
+			std::memcpy(record->data, &length, sizeof(uint32_t));
+			std::memcpy(record->data + sizeof(uint32_t), str.data(), length);
+		}
+		else
+		{
+			record->format = &FormatHeapString;
+			std::string* heapStr = new std::string(str);
+			std::memcpy(record->data, &heapStr, sizeof(std::string*));
+		}
+
+		if (record == &local) { WriteNow(local); }
+		else { CommitRecord(); }
+	}
+
+	AsyncLog::Record* AsyncLog::BeginRecord()
+	{
+		if (!s_Running) { return nullptr; }
+
+		// Shutdown clears s_Running before it checks writing, so one of both sees the other
+		ThreadRing* ring = GetThreadRing();
+		ring->writing = true;
+		if (!s_Running)
+		{
+			ring->writing = false;
+			return nullptr;
+		}
+
+		// Block while the ring is full. The flusher is gone after shutdown, so the record is written synchronously then
+		const size_t head = ring->head.load(std::memory_order_relaxed);
+		while (head - ring->tail.load(std::memory_order_acquire) >= c_RingCapacity)
+		{
+			if (!s_Running)
+			{
+				ring->writing = false;
+				return nullptr;
+			}
+			s_WakeCv.notify_one();
+			std::this_thread::yield();
+		}
+
+		return &ring->records[head % c_RingCapacity];
+	}
+
+	void AsyncLog::CommitRecord()
+	{
+		ThreadRing* ring = GetThreadRing();
+		const size_t head = ring->head.load(std::memory_order_relaxed) + 1;
+		ring->head.store(head, std::memory_order_release);
+		ring->writing = false;
+
+		// Wake the flusher early if the ring is filling up
+		if (head - ring->tail.load(std::memory_order_relaxed) == c_RingCapacity / 2) { s_WakeCv.notify_one(); }
+	}
+
+	bool AsyncLog::IsIdle()
+	{
+		std::lock_guard<std::mutex> lock(s_RingsMutex);
+		for (const std::unique_ptr<ThreadRing>& ring : GetRings())
+		{
+			if (ring->writing || ring->tail.load(std::memory_order_acquire) != ring->head.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void AsyncLog::WriteNow(const Record& record)
+	{
+		std::string str;
+		record.format(record, str);
+		std::lock_guard<std::mutex> lock(s_DrainMutex);
+		record.stream->write(str.data(), str.size());
+		record.stream->flush();
+	}
+
+	void AsyncLog::AppendUntilPlaceholder(std::string& out, const char*& fmt)
+	{
+		const char* placeholder = std::strstr(fmt, "{}");
+		if (placeholder == nullptr)
+		{
+			out += fmt;
+			fmt += std::strlen(fmt);
+			return;
+		}
+
+		out.append(fmt, placeholder - fmt);
+		fmt = placeholder + 2;
+	}
+
+	AsyncLog::ThreadRing* AsyncLog::GetThreadRing()
+	{
+		thread_local RingOwner owner;
+		if (owner.ring == nullptr || owner.generation != s_RingGeneration)
+		{
+			std::lock_guard<std::mutex> lock(s_RingsMutex);
+			GetRings().push_back(std::make_unique<ThreadRing>());
+			owner.ring = GetRings().back().get();
+			owner.generation = s_RingGeneration;
+		}
+		return owner.ring;
+	}
+
+	std::vector<std::unique_ptr<AsyncLog::ThreadRing>>& AsyncLog::GetRings()
+	{
+		static std::vector<std::unique_ptr<ThreadRing>> rings;
+		return rings;
+	}
+
+	void AsyncLog::FormatInlineString(const Record& record, std::string& out)
+	{
+		uint32_t length;
+		std::memcpy(&length, record.data, sizeof(uint32_t));
+
+		out += record.prefix;
+		out.append(reinterpret_cast<const char*>(record.data + sizeof(uint32_t)), length);
+		out += '\n';
+	}
+
+	void AsyncLog::FormatHeapString(const Record& record, std::string& out)
+	{
+		std::string* str;
+		std::memcpy(&str, record.data, sizeof(std::string*));
+
+		out += record.prefix;
+		out += *str;
+		out += '\n';
+		delete str;
+	}
+
+	void AsyncLog::Drain()
+	{
+		// Format every committed record into one batch per stream
+		std::unordered_map<std::ostream*, std::string> batches;
+		{
+			std::lock_guard<std::mutex> lock(s_RingsMutex);
+			std::vector<std::unique_ptr<ThreadRing>>& rings = GetRings();
+			for (const std::unique_ptr<ThreadRing>& ring : rings)
+			{
+				const size_t tail = ring->tail.load(std::memory_order_relaxed);
+				const size_t head = ring->head.load(std::memory_order_acquire);
+				for (size_t i = tail; i < head; i++)
+				{
+					const Record& record = ring->records[i % c_RingCapacity];
+					record.format(record, batches[record.stream]);
+				}
+				ring->tail.store(head, std::memory_order_release);
+			}
+
+			// Rings of exited threads receive no more records once drained
+			rings.erase(
+				std::remove_if(rings.begin(), rings.end(), [](const std::unique_ptr<ThreadRing>& ring) { return ring->retired; }),
+				rings.end());
+		}
+
+		for (auto& [stream, batch] : batches)
+		{
+			stream->write(batch.data(), batch.size());
+			stream->flush();
+		}
+	}
+
+	void AsyncLog::FlusherLoop()
+	{
+		std::unique_lock<std::mutex> wakeLock(s_WakeMutex);
+		while (!s_StopFlusher)
+		{
+			s_WakeCv.wait_for(wakeLock, std::chrono::milliseconds(10));
+
+			wakeLock.unlock();
+			Flush();
+			wakeLock.lock();
+		}
+	}
+
+	void AsyncLog::CrashHandler(int signal)
+	{
+		// Not async signal safe, but losing the last log lines of a crash is worse
+		if (s_DrainMutex.try_lock())
+		{
+			Drain();
+			s_DrainMutex.unlock();
+		}
+
+		std::signal(signal, SIG_DFL);
+		std::raise(signal);
+	}
+}
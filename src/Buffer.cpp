@@ -1,6 +1,5 @@
 #include <engine/cuda_common.hpp>
 #include <engine/graphics/vulkan/Buffer.hpp>
-#include <engine/graphics/vulkan/CommandPool.hpp>
 #include <cstring>
 
 namespace en::vk
@@ -11,53 +10,6 @@ namespace en::vk
 	PFN_vkGetMemoryFdKHR fpGetMemoryFdKHR = nullptr;
 #endif
 
-	void Buffer::Copy(const Buffer* src, Buffer* dest, VkDeviceSize size)
-	{
-		VkQueue queue = VulkanAPI::GetGraphicsQueue();
-
-		CommandPool commandPool(0, VulkanAPI::GetGraphicsQFI());
-		commandPool.AllocateBuffers(1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-		VkCommandBuffer commandBuffer = commandPool.GetBuffer(0);
-
-		VkCommandBufferBeginInfo beginInfo;
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.pNext = nullptr;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-		beginInfo.pInheritanceInfo = nullptr;
-
-		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
-		ASSERT_VULKAN(result);
-
-		VkBufferCopy bufferCopy;
-		bufferCopy.srcOffset = 0;
-		bufferCopy.dstOffset = 0;
-		bufferCopy.size = size;
-
-		vkCmdCopyBuffer(commandBuffer, src->GetVulkanHandle(), dest->GetVulkanHandle(), 1, &bufferCopy);
-
-		result = vkEndCommandBuffer(commandBuffer);
-		ASSERT_VULKAN(result);
-
-		VkSubmitInfo submitInfo;
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.pNext = nullptr;
-		submitInfo.waitSemaphoreCount = 0;
-		submitInfo.pWaitSemaphores = nullptr;
-		submitInfo.pWaitDstStageMask = nullptr;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-		submitInfo.signalSemaphoreCount = 0;
-		submitInfo.pSignalSemaphores = nullptr;
-
-		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		ASSERT_VULKAN(result);
-
-		result = vkQueueWaitIdle(queue);
-		ASSERT_VULKAN(result);
-
-		commandPool.Destroy();
-	}
-
 	Buffer::Buffer(
 		VkDeviceSize size,
 		VkMemoryPropertyFlags memoryProperties,
@@ -109,12 +61,10 @@ namespace en::vk
 		VkResult result = vkCreateBuffer(device, &createInfo, nullptr, &m_VulkanHandle);
 		ASSERT_VULKAN(result);
 
-		// Find Memory Type
+		// Allocate Memory
 		VkMemoryRequirements memoryRequirements;
 		vkGetBufferMemoryRequirements(device, m_VulkanHandle, &memoryRequirements);
-		uint32_t memoryTypeIndex = VulkanAPI::FindMemoryType(memoryRequirements.memoryTypeBits, memoryProperties);
 
-		// Allocate Memory
 		void* allocateInfoPnext = nullptr;
 		VkExportMemoryAllocateInfoKHR vulkanExportMemoryAllocateInfoKHR{};
 
@@ -149,14 +99,15 @@ namespace en::vk
 		}
 #endif
 
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = allocateInfoPnext;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = memoryTypeIndex;
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_DeviceMemory);
-		ASSERT_VULKAN(result);
+		// Exported memory needs its own VkDeviceMemory because CUDA imports the whole allocation
+		if (allocateInfoPnext != nullptr)
+		{
+			m_Memory = MemoryAllocator::AllocateExport(memoryRequirements, memoryProperties, allocateInfoPnext);
+		}
+		else
+		{
+			m_Memory = MemoryAllocator::Allocate(memoryRequirements, memoryProperties, true);
+		}
 
 		// Retreive memory handle
 #ifdef _WIN64
@@ -172,7 +123,7 @@ namespace en::vk
 			VkMemoryGetWin32HandleInfoKHR vkMemoryGetWin32HandleInfoKHR = {};
 			vkMemoryGetWin32HandleInfoKHR.sType = VK_STRUCTURE_TYPE_MEMORY_GET_WIN32_HANDLE_INFO_KHR;
 			vkMemoryGetWin32HandleInfoKHR.pNext = nullptr;
-			vkMemoryGetWin32HandleInfoKHR.memory = m_DeviceMemory;
+			vkMemoryGetWin32HandleInfoKHR.memory = m_Memory.memory;
 			vkMemoryGetWin32HandleInfoKHR.handleType = extMemType;
 
 			fpGetMemoryWin32HandleKHR(VulkanAPI::GetDevice(), &vkMemoryGetWin32HandleInfoKHR, &m_Win32Handle);
@@ -190,7 +141,7 @@ namespace en::vk
 			VkMemoryGetFdInfoKHR memoryFdInfo;
 			memoryFdInfo.sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR;
 			memoryFdInfo.pNext = nullptr;
-			memoryFdInfo.memory = m_DeviceMemory;
+			memoryFdInfo.memory = m_Memory.memory;
 			memoryFdInfo.handleType = extMemType;
 
 			fpGetMemoryFdKHR(VulkanAPI::GetDevice(), &memoryFdInfo, &m_Fd);
@@ -198,7 +149,40 @@ namespace en::vk
 #endif
 
 		// Bind Memory
-		result = vkBindBufferMemory(device, m_VulkanHandle, m_DeviceMemory, 0);
+		result = vkBindBufferMemory(device, m_VulkanHandle, m_Memory.memory, m_Memory.offset);
+		ASSERT_VULKAN(result);
+	}
+
+	Buffer Buffer::FromFrameArena(VkDeviceSize size, VkBufferUsageFlags usage)
+	{
+		return Buffer(size, usage);
+	}
+
+	Buffer::Buffer(VkDeviceSize size, VkBufferUsageFlags usage)
+		:
+		m_Mapped(false),
+		m_UsedSize(size)
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		VkBufferCreateInfo createInfo;
+		createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = 0;
+		createInfo.size = size;
+		createInfo.usage = usage;
+		createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		createInfo.queueFamilyIndexCount = 0;
+		createInfo.pQueueFamilyIndices = nullptr;
+
+		VkResult result = vkCreateBuffer(device, &createInfo, nullptr, &m_VulkanHandle);
+		ASSERT_VULKAN(result);
+
+		VkMemoryRequirements memoryRequirements;
+		vkGetBufferMemoryRequirements(device, m_VulkanHandle, &memoryRequirements);
+		m_Memory = MemoryAllocator::AllocateFrame(memoryRequirements);
+
+		result = vkBindBufferMemory(device, m_VulkanHandle, m_Memory.memory, m_Memory.offset);
 		ASSERT_VULKAN(result);
 	}
 
@@ -206,8 +190,8 @@ namespace en::vk
 	{
 		VkDevice device = VulkanAPI::GetDevice();
 
-		vkFreeMemory(device, m_DeviceMemory, nullptr);
 		vkDestroyBuffer(device, m_VulkanHandle, nullptr);
+		MemoryAllocator::Free(m_Memory);
 	}
 
 	void Buffer::MapMemory(VkDeviceSize offset, void** memory)
@@ -215,8 +199,11 @@ namespace en::vk
 		if (m_Mapped)
 			Log::Error("Vulkan Device Memory is already mapped", true);
 
-		VkResult result = vkMapMemory(VulkanAPI::GetDevice(), m_DeviceMemory, offset, m_UsedSize, 0, memory);
-		ASSERT_VULKAN(result);
+		// Host visible memory is persistently mapped by the allocator
+		if (m_Memory.mapped == nullptr)
+			Log::Error("vk::Buffer memory is not host visible", true);
+
+		*memory = static_cast<char*>(m_Memory.mapped) + offset;
 
 		m_Mapped = true;
 	}
@@ -226,8 +213,6 @@ namespace en::vk
 		if (!m_Mapped)
 			Log::Warn("Vulkan Device Memory was not mapped");
 
-		vkUnmapMemory(VulkanAPI::GetDevice(), m_DeviceMemory);
-
 		m_Mapped = false;
 	}
 
@@ -243,8 +228,6 @@ namespace en::vk
 
 	void Buffer::GetData(VkDeviceSize size, void* dst, VkDeviceSize offset, VkMemoryMapFlags mapFlags)
 	{
-		VkDevice device = VulkanAPI::GetDevice();
-		
 		void* mappedMemory;
 		MapMemory(offset, &mappedMemory);
 
@@ -267,15 +250,11 @@ namespace en::vk
 
 	void Buffer::SetData(VkDeviceSize size, const void* data, VkDeviceSize offset, VkMemoryMapFlags mapFlags)
 	{
-		VkDevice device = VulkanAPI::GetDevice();
-		VkResult result;
-
 		void* mappedMemory;
-		result = vkMapMemory(device, m_DeviceMemory, offset, size, mapFlags, &mappedMemory);
-		ASSERT_VULKAN(result);
+		MapMemory(offset, &mappedMemory);
 
 		memcpy(mappedMemory, data, static_cast<size_t>(size));
 
-		vkUnmapMemory(device, m_DeviceMemory);
+		UnmapMemory();
 	}
 }
@@ -1,4 +1,5 @@
 #include <engine/graphics/Camera.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
 #include <engine/graphics/VulkanAPI.hpp>
 #include <glm/gtx/transform.hpp>
 
@@ -41,7 +42,7 @@ namespace en
 		// Create Descriptor Pool
 		VkDescriptorPoolSize poolSize;
 		poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSize.descriptorCount = 1;
+		poolSize.descriptorCount = 2 * MAX_CAMERA_COUNT;
 
 		VkDescriptorPoolCreateInfo descPoolCreateInfo;
 		descPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -88,16 +89,19 @@ namespace en
 		m_MatrixUniformBuffer(new vk::Buffer(
 			sizeof(CameraMatrices),
 			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			{})),
 		m_PosUniformBuffer(new vk::Buffer(
 			sizeof(glm::vec3),
 			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			{}))
 	{
 		VkDevice device = VulkanAPI::GetDevice();
 
+		// Zero matrices make the first prevProjView project everything behind the camera
+		m_Matrices.projView = glm::mat4(0.0f);
+
 		// Allocate Descriptor Set
 		VkDescriptorSetAllocateInfo allocateInfo;
 		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -165,12 +169,12 @@ namespace en
 	{
 		glm::mat4 projMat = glm::perspective(m_Fov, m_AspectRatio, m_NearPlane, m_FarPlane);
 		glm::mat4 viewMat = glm::lookAt(m_Pos, m_Pos + m_ViewDir, m_Up);
-		m_Matrices.prevProjView = projMat;
+		m_Matrices.prevProjView = m_Matrices.projView;
 		m_Matrices.projView = projMat * viewMat;
 		m_Matrices.invProjView = glm::inverse(m_Matrices.projView);
 
-		m_MatrixUniformBuffer->SetData(sizeof(CameraMatrices), &m_Matrices, 0, 0);
-		m_PosUniformBuffer->SetData(sizeof(glm::vec3), &m_Pos, 0, 0);
+		vk::FramePacer::UpdateBuffer(*m_MatrixUniformBuffer, sizeof(CameraMatrices), &m_Matrices, 0);
+		vk::FramePacer::UpdateBuffer(*m_PosUniformBuffer, sizeof(glm::vec3), &m_Pos, 0);
 	}
 
 	void Camera::RotateAroundOrigin(const glm::vec3& axis, float angle)
@@ -0,0 +1,200 @@
+#include <engine/graphics/CameraPath.hpp>
+#include <engine/util/Log.hpp>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+
+namespace en
+{
+	static glm::vec3 Hermite(const glm::vec3& p0, const glm::vec3& m0, const glm::vec3& p1, const glm::vec3& m1, float h, float t)
+	{
+		const float t2 = t * t;
+		const float t3 = t2 * t;
+		return
+			(2.0f * t3 - 3.0f * t2 + 1.0f) * p0 +
+			(t3 - 2.0f * t2 + t) * h * m0 +
+			(-2.0f * t3 + 3.0f * t2) * p1 +
+			(t3 - t2) * h * m1;
+	}
+
+	void CameraPath::StartRecording()
+	{
+		m_Keyframes.clear();
+		m_PosTangents.clear();
+		m_ViewDirTangents.clear();
+		m_Recording = true;
+		m_RecordFrame = 0;
+		m_RecordMoving = false;
+	}
+
+	void CameraPath::Record(const Camera& camera)
+	{
+		if (!m_Recording) { return; }
+
+		const bool moving = camera.HasChanged();
+		if (m_Keyframes.empty() || moving != m_RecordMoving)
+		{
+			// A motion that starts here leaves the previous frame as the last resting position
+			if (moving && !m_Keyframes.empty() && m_Keyframes.back().frame + 1 < m_RecordFrame)
+			{
+				Keyframe rest = m_Keyframes.back();
+				rest.frame = m_RecordFrame - 1;
+				m_Keyframes.push_back(rest);
+			}
+			AddKeyframe(camera, m_RecordFrame);
+		}
+		else if (moving && m_RecordFrame - m_Keyframes.back().frame >= c_KeyframeInterval)
+		{
+			AddKeyframe(camera, m_RecordFrame);
+		}
+
+		m_RecordMoving = moving;
+		m_RecordFrame++;
+	}
+
+	void CameraPath::StopRecording()
+	{
+		if (!m_Recording) { return; }
+		m_Recording = false;
+
+		// Close the last segment at the last recorded frame
+		if (!m_Keyframes.empty() && m_Keyframes.back().frame + 1 < m_RecordFrame)
+		{
+			Keyframe last = m_Keyframes.back();
+			last.frame = m_RecordFrame - 1;
+			if (m_RecordMoving) { Log::Warn("Camera path recording stopped while moving, the last keyframe holds the previous pose"); }
+			m_Keyframes.push_back(last);
+		}
+
+		CalcTangents();
+		Log::Info("Recorded camera path with {} keyframes over {} frames", m_Keyframes.size(), GetFrameCount());
+	}
+
+	bool CameraPath::IsRecording() const
+	{
+		return m_Recording;
+	}
+
+	bool CameraPath::Load(const std::string& filePath)
+	{
+		std::ifstream file(filePath, std::ios::binary);
+		if (!file.is_open()) { return false; }
+
+		FileHeader header = {};
+		file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+		if (!file.good() || header.magic != c_FileMagic || header.version != c_FileVersion)
+		{
+			Log::Error(filePath + " is not a camera path file", true);
+		}
+
+		m_Keyframes.resize(header.keyframeCount);
+		file.read(reinterpret_cast<char*>(m_Keyframes.data()), m_Keyframes.size() * sizeof(Keyframe));
+		if (!file.good()) { Log::Error(filePath + " is truncated", true); }
+
+		CalcTangents();
+		Log::Info(
+			"Loaded camera path " + filePath +
+			" with " + std::to_string(m_Keyframes.size()) + " keyframes over " + std::to_string(GetFrameCount()) + " frames");
+		return true;
+	}
+
+	void CameraPath::Save(const std::string& filePath) const
+	{
+		const std::filesystem::path path(filePath);
+		if (path.has_parent_path()) { std::filesystem::create_directories(path.parent_path()); }
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) { Log::Error("Failed to write camera path " + filePath, true); }
+
+		FileHeader header;
+		header.magic = c_FileMagic;
+		header.version = c_FileVersion;
+		header.keyframeCount = static_cast<uint32_t>(m_Keyframes.size());
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+		file.write(reinterpret_cast<const char*>(m_Keyframes.data()), m_Keyframes.size() * sizeof(Keyframe));
+	}
+
+	void CameraPath::Apply(Camera& camera, uint32_t frame) const
+	{
+		if (m_Keyframes.empty()) { return; }
+
+		const uint32_t segment = GetSegmentIndex(frame);
+		const size_t i0 = segment;
+		const size_t i1 = std::min<size_t>(segment + 1, m_Keyframes.size() - 1);
+		const Keyframe& k0 = m_Keyframes[i0];
+		const Keyframe& k1 = m_Keyframes[i1];
+
+		const float h = static_cast<float>(k1.frame - k0.frame);
+		const float t = h > 0.0f ? std::clamp(static_cast<float>(frame - std::min(frame, k0.frame)) / h, 0.0f, 1.0f) : 0.0f;
+
+		camera.SetPos(Hermite(k0.pos, m_PosTangents[i0], k1.pos, m_PosTangents[i1], h, t));
+		camera.SetViewDir(Hermite(k0.viewDir, m_ViewDirTangents[i0], k1.viewDir, m_ViewDirTangents[i1], h, t));
+		camera.SetFov(k0.fov + t * (k1.fov - k0.fov));
+		camera.SetChanged(IsSegmentMoving(segment) && frame < GetFrameCount());
+	}
+
+	bool CameraPath::IsEmpty() const
+	{
+		return m_Keyframes.empty();
+	}
+
+	uint32_t CameraPath::GetFrameCount() const
+	{
+		return m_Keyframes.empty() ? 0 : m_Keyframes.back().frame + 1;
+	}
+
+	uint32_t CameraPath::GetSegmentCount() const
+	{
+		return m_Keyframes.size() < 2 ? 1 : static_cast<uint32_t>(m_Keyframes.size() - 1);
+	}
+
+	uint32_t CameraPath::GetSegmentIndex(uint32_t frame) const
+	{
+		// Segment i covers the frames [keyframe i, keyframe i + 1)
+		const auto it = std::upper_bound(
+			m_Keyframes.begin(),
+			m_Keyframes.end(),
+			frame,
+			[](uint32_t f, const Keyframe& keyframe) { return f < keyframe.frame; });
+		const size_t index = it == m_Keyframes.begin() ? 0 : static_cast<size_t>(it - m_Keyframes.begin()) - 1;
+		return std::min(static_cast<uint32_t>(index), GetSegmentCount() - 1);
+	}
+
+	bool CameraPath::IsSegmentMoving(uint32_t segment) const
+	{
+		if (segment + 1 >= m_Keyframes.size()) { return false; }
+		const Keyframe& k0 = m_Keyframes[segment];
+		const Keyframe& k1 = m_Keyframes[segment + 1];
+		return k0.pos != k1.pos || k0.viewDir != k1.viewDir || k0.fov != k1.fov;
+	}
+
+	void CameraPath::AddKeyframe(const Camera& camera, uint32_t frame)
+	{
+		Keyframe keyframe;
+		keyframe.frame = frame;
+		keyframe.pos = camera.GetPos();
+		keyframe.viewDir = camera.GetViewDir();
+		keyframe.fov = camera.GetFov();
+		m_Keyframes.push_back(keyframe);
+	}
+
+	void CameraPath::CalcTangents()
+	{
+		// Finite difference tangents per frame. Keyframes next to a resting segment get zero tangents, so the spline does
+		// not overshoot into the resting phase
+		const size_t count = m_Keyframes.size();
+		m_PosTangents.assign(count, glm::vec3(0.0f));
+		m_ViewDirTangents.assign(count, glm::vec3(0.0f));
+		for (size_t i = 1; i + 1 < count; i++)
+		{
+			if (!IsSegmentMoving(static_cast<uint32_t>(i - 1)) || !IsSegmentMoving(static_cast<uint32_t>(i))) { continue; }
+
+			const Keyframe& prev = m_Keyframes[i - 1];
+			const Keyframe& next = m_Keyframes[i + 1];
+			const float frameDist = static_cast<float>(next.frame - prev.frame);
+			m_PosTangents[i] = (next.pos - prev.pos) / frameDist;
+			m_ViewDirTangents[i] = (next.viewDir - prev.viewDir) / frameDist;
+		}
+	}
+}
@@ -0,0 +1,244 @@
+#include <engine/util/DenoiseReference.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace en
+{
+	static const float c_MaxRayDistance = 100000.0f;
+
+	static float Luminance(const glm::vec3& color)
+	{
+		return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+	}
+
+	DenoiseReference::DenoiseReference(uint32_t width, uint32_t height, const Params& params) :
+		m_Width(width),
+		m_Height(height),
+		m_Params(params),
+		m_History(static_cast<size_t>(width) * height, glm::vec4(0.0f)),
+		m_Moments(static_cast<size_t>(width) * height, glm::vec4(0.0f)),
+		m_Ping(static_cast<size_t>(width) * height),
+		m_Pong(static_cast<size_t>(width) * height)
+	{
+	}
+
+	void DenoiseReference::Denoise(const Frame& frame, float* output)
+	{
+		const std::vector<glm::vec4> prevHistory = m_History;
+		const std::vector<glm::vec4> prevMoments = m_Moments;
+		TemporalPass(frame, prevHistory, prevMoments);
+
+		// Even iterations read ping, the first one feeds the history
+		for (uint32_t i = 0; i < c_AtrousIterationCount; i++)
+		{
+			const bool readPing = i % 2 == 0;
+			AtrousPass(frame, 1 << i, readPing ? m_Ping : m_Pong, readPing ? m_Pong : m_Ping);
+
+			if (i == 0)
+			{
+				for (size_t pixel = 0; pixel < m_History.size(); pixel++)
+				{
+					m_History[pixel] = glm::vec4(glm::vec3(m_Pong[pixel]), m_History[pixel].w);
+				}
+			}
+		}
+
+		// Alpha is the scatter probability
+		const std::vector<glm::vec4>& result = c_AtrousIterationCount % 2 == 1 ? m_Pong : m_Ping;
+		for (size_t pixel = 0; pixel < result.size(); pixel++)
+		{
+			output[pixel * 4 + 0] = result[pixel].x;
+			output[pixel * 4 + 1] = result[pixel].y;
+			output[pixel * 4 + 2] = result[pixel].z;
+			output[pixel * 4 + 3] = m_Moments[pixel].z;
+		}
+	}
+
+	void DenoiseReference::Reset()
+	{
+		std::fill(m_History.begin(), m_History.end(), glm::vec4(0.0f));
+		std::fill(m_Moments.begin(), m_Moments.end(), glm::vec4(0.0f));
+	}
+
+	size_t DenoiseReference::GetIndex(int32_t x, int32_t y) const
+	{
+		return static_cast<size_t>(y) * m_Width + x;
+	}
+
+	bool DenoiseReference::IsInsideImage(int32_t x, int32_t y) const
+	{
+		return x >= 0 && y >= 0 && x < static_cast<int32_t>(m_Width) && y < static_cast<int32_t>(m_Height);
+	}
+
+	glm::vec3 DenoiseReference::GetPrimaryRayDir(const Frame& frame, int32_t x, int32_t y) const
+	{
+		const glm::vec2 fragUV(static_cast<float>(x) / m_Width, static_cast<float>(y) / m_Height);
+		const glm::vec4 worldPos = frame.invProjView * glm::vec4((fragUV * 2.0f) - glm::vec2(1.0f), 0.0f, 1.0f);
+		return glm::normalize((glm::vec3(worldPos) / worldPos.w) - frame.camPos);
+	}
+
+	void DenoiseReference::TemporalPass(const Frame& frame, const std::vector<glm::vec4>& prevHistory, const std::vector<glm::vec4>& prevMoments)
+	{
+		for (int32_t y = 0; y < static_cast<int32_t>(m_Height); y++)
+		{
+			for (int32_t x = 0; x < static_cast<int32_t>(m_Width); x++)
+			{
+				const size_t index = GetIndex(x, y);
+				const glm::vec3 color(frame.color[index * 4 + 0], frame.color[index * 4 + 1], frame.color[index * 4 + 2]);
+				const float scatter = frame.guide[index * 4 + 0];
+				const float depth = frame.guide[index * 4 + 1];
+				const bool didScatter = scatter > 0.0f;
+				const float luminance = Luminance(color);
+
+				// History
+				glm::vec4 history(0.0f);
+				glm::vec4 moments(0.0f);
+				bool validHistory = false;
+				if (m_Params.temporal)
+				{
+					const glm::vec3 worldPos = frame.camPos + (GetPrimaryRayDir(frame, x, y) * depth);
+					const glm::vec4 prevClip = frame.prevProjView * glm::vec4(worldPos, 1.0f);
+					if (prevClip.w > 0.0f)
+					{
+						const glm::vec2 ndc = glm::vec2(prevClip.x, prevClip.y) / prevClip.w;
+						const glm::vec2 prevPixel = ((ndc * 0.5f) + glm::vec2(0.5f)) * glm::vec2(m_Width, m_Height);
+						const int32_t prevX = static_cast<int32_t>(std::round(prevPixel.x));
+						const int32_t prevY = static_cast<int32_t>(std::round(prevPixel.y));
+						if (IsInsideImage(prevX, prevY))
+						{
+							history = prevHistory[GetIndex(prevX, prevY)];
+							moments = prevMoments[GetIndex(prevX, prevY)];
+							validHistory = history.w != 0.0f;
+							if (validHistory && didScatter && moments.z > 0.0f)
+							{
+								const float expectedDepth = glm::distance(frame.prevCamPos, worldPos);
+								validHistory = std::abs(moments.w - expectedDepth) <= m_Params.depthTolerance * expectedDepth;
+							}
+						}
+					}
+
+					if (!validHistory)
+					{
+						history = glm::vec4(0.0f);
+						moments = glm::vec4(0.0f);
+					}
+				}
+
+				// Accumulate
+				const float historyLength = validHistory ? std::min(history.w, m_Params.maxHistory) + 1.0f : 1.0f;
+				const float alpha = 1.0f / historyLength;
+
+				const glm::vec3 accColor = glm::mix(glm::vec3(history), color, alpha);
+				const glm::vec2 accMoments = glm::mix(glm::vec2(moments), glm::vec2(luminance, luminance * luminance), alpha);
+				const float scatterProb = glm::mix(moments.z, scatter, alpha);
+
+				float accDepth = c_MaxRayDistance;
+				if (didScatter) { accDepth = (validHistory && moments.z > 0.0f) ? glm::mix(moments.w, depth, alpha) : depth; }
+				else if (validHistory) { accDepth = moments.w; }
+
+				const float variance = historyLength >= static_cast<float>(c_MinTemporalVarianceHistory) ?
+					std::max(0.0f, accMoments.y - (accMoments.x * accMoments.x)) :
+					EstimateSpatialVariance(frame, x, y, scatter);
+
+				m_History[index] = glm::vec4(accColor, historyLength);
+				m_Moments[index] = glm::vec4(accMoments, scatterProb, accDepth);
+				m_Ping[index] = glm::vec4(accColor, variance);
+			}
+		}
+	}
+
+	float DenoiseReference::EstimateSpatialVariance(const Frame& frame, int32_t x, int32_t y, float scatter) const
+	{
+		glm::vec2 moments(0.0f);
+		float weightSum = 0.0f;
+		for (int32_t dy = -1; dy <= 1; dy++)
+		{
+			for (int32_t dx = -1; dx <= 1; dx++)
+			{
+				if (!IsInsideImage(x + dx, y + dy)) { continue; }
+
+				const size_t index = GetIndex(x + dx, y + dy);
+				if (frame.guide[index * 4] != scatter) { continue; }
+
+				const float luminance = Luminance(glm::vec3(frame.color[index * 4 + 0], frame.color[index * 4 + 1], frame.color[index * 4 + 2]));
+				moments += glm::vec2(luminance, luminance * luminance);
+				weightSum += 1.0f;
+			}
+		}
+
+		moments /= weightSum;
+		return std::max(0.0f, moments.y - (moments.x * moments.x));
+	}
+
+	void DenoiseReference::AtrousPass(const Frame& frame, uint32_t stepSize, const std::vector<glm::vec4>& input, std::vector<glm::vec4>& result) const
+	{
+		const int32_t step = static_cast<int32_t>(stepSize);
+		const float centerWeight = c_KernelWeights[0] * c_KernelWeights[0];
+
+		for (int32_t y = 0; y < static_cast<int32_t>(m_Height); y++)
+		{
+			for (int32_t x = 0; x < static_cast<int32_t>(m_Width); x++)
+			{
+				const glm::vec4& center = input[GetIndex(x, y)];
+				const glm::vec4& centerMoments = m_Moments[GetIndex(x, y)];
+				const float centerLuminance = Luminance(glm::vec3(center));
+				const glm::vec3 centerRayDir = GetPrimaryRayDir(frame, x, y);
+				const glm::vec3 centerPos = frame.camPos + (centerRayDir * centerMoments.w);
+
+				// 3x3 gaussian of the variance
+				const float varianceWeights[2] = { 0.5f, 0.25f };
+				float filteredVariance = 0.0f;
+				float varianceWeightSum = 0.0f;
+				for (int32_t dy = -1; dy <= 1; dy++)
+				{
+					for (int32_t dx = -1; dx <= 1; dx++)
+					{
+						if (!IsInsideImage(x + dx, y + dy)) { continue; }
+
+						const float weight = varianceWeights[std::abs(dx)] * varianceWeights[std::abs(dy)];
+						filteredVariance += input[GetIndex(x + dx, y + dy)].w * weight;
+						varianceWeightSum += weight;
+					}
+				}
+				filteredVariance /= varianceWeightSum;
+
+				const float luminanceScale = (m_Params.sigmaLuminance * std::sqrt(filteredVariance)) + 1e-6f;
+				const float pixelAngle = glm::length(GetPrimaryRayDir(frame, x + 1, y) - centerRayDir);
+				const float positionScale = (m_Params.sigmaPosition * centerMoments.w * pixelAngle * static_cast<float>(stepSize)) + 1e-6f;
+
+				glm::vec3 colorSum = glm::vec3(center) * centerWeight;
+				float varianceSum = center.w * centerWeight * centerWeight;
+				float weightSum = centerWeight;
+				for (int32_t dy = -2; dy <= 2; dy++)
+				{
+					for (int32_t dx = -2; dx <= 2; dx++)
+					{
+						if (dx == 0 && dy == 0) { continue; }
+
+						const int32_t nx = x + (dx * step);
+						const int32_t ny = y + (dy * step);
+						if (!IsInsideImage(nx, ny)) { continue; }
+
+						const glm::vec4& neighborColor = input[GetIndex(nx, ny)];
+						const glm::vec4& neighborMoments = m_Moments[GetIndex(nx, ny)];
+						const glm::vec3 neighborPos = frame.camPos + (GetPrimaryRayDir(frame, nx, ny) * neighborMoments.w);
+
+						const float luminanceDist = std::abs(centerLuminance - Luminance(glm::vec3(neighborColor))) / luminanceScale;
+						const float positionDist = glm::distance(centerPos, neighborPos) / positionScale;
+						const float transmittanceDist = std::abs(centerMoments.z - neighborMoments.z) / m_Params.sigmaTransmittance;
+
+						const float weight =
+							c_KernelWeights[std::abs(dx)] * c_KernelWeights[std::abs(dy)] *
+							std::exp(-luminanceDist - positionDist - transmittanceDist);
+
+						colorSum += glm::vec3(neighborColor) * weight;
+						varianceSum += neighborColor.w * weight * weight;
+						weightSum += weight;
+					}
+				}
+
+				result[GetIndex(x, y)] = glm::vec4(colorSum / weightSum, varianceSum / (weightSum * weightSum));
+			}
+		}
+	}
+}
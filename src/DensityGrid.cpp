@@ -0,0 +1,219 @@
+#include <engine/util/DensityGrid.hpp>
+#include <engine/util/RayBox.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace en
+{
+	DensityGrid::DensityGrid(const std::vector<std::vector<std::vector<float>>>& densityData) :
+		m_DensitySize({
+			static_cast<uint32_t>(densityData.size()),
+			static_cast<uint32_t>(densityData[0].size()),
+			static_cast<uint32_t>(densityData[0][0].size()) }),
+		m_CellCount(
+			(m_DensitySize[0] + c_CellSize - 1) / c_CellSize,
+			(m_DensitySize[1] + c_CellSize - 1) / c_CellSize,
+			(m_DensitySize[2] + c_CellSize - 1) / c_CellSize)
+	{
+		const uint32_t sizeX = m_DensitySize[0];
+		const uint32_t sizeY = m_DensitySize[1];
+		const uint32_t sizeZ = m_DensitySize[2];
+
+		// Same truncation as the 8 bit density texture
+		m_Density.resize(sizeX * sizeY * sizeZ);
+		for (uint32_t x = 0; x < sizeX; x++)
+		{
+			for (uint32_t y = 0; y < sizeY; y++)
+			{
+				for (uint32_t z = 0; z < sizeZ; z++)
+				{
+					m_Density[x + (sizeX * (y + (sizeY * z)))] = static_cast<uint8_t>(densityData[x][y][z] * 255.0f);
+				}
+			}
+		}
+
+		// Control density is the cell average, the residual majorant max |density - control| in the cell
+		m_Control.resize(m_CellCount.x * m_CellCount.y * m_CellCount.z);
+		m_ResidualMajorant.resize(m_Control.size());
+		for (int cx = 0; cx < m_CellCount.x; cx++)
+		{
+			for (int cy = 0; cy < m_CellCount.y; cy++)
+			{
+				for (int cz = 0; cz < m_CellCount.z; cz++)
+				{
+					uint32_t sum = 0;
+					uint32_t count = 0;
+					uint32_t minValue = 255;
+					uint32_t maxValue = 0;
+					for (uint32_t x = cx * c_CellSize; x < std::min((cx + 1) * c_CellSize, sizeX); x++)
+					{
+						for (uint32_t y = cy * c_CellSize; y < std::min((cy + 1) * c_CellSize, sizeY); y++)
+						{
+							for (uint32_t z = cz * c_CellSize; z < std::min((cz + 1) * c_CellSize, sizeZ); z++)
+							{
+								const uint32_t value = m_Density[x + (sizeX * (y + (sizeY * z)))];
+								sum += value;
+								count++;
+								minValue = std::min(minValue, value);
+								maxValue = std::max(maxValue, value);
+							}
+						}
+					}
+
+					const uint32_t control = static_cast<uint32_t>(std::round(static_cast<float>(sum) / static_cast<float>(count)));
+					const uint32_t cellIndex = GetCellIndex(glm::ivec3(cx, cy, cz));
+					m_Control[cellIndex] = static_cast<uint8_t>(control);
+					m_ResidualMajorant[cellIndex] = static_cast<uint8_t>(std::max(control - minValue, maxValue - control));
+				}
+			}
+		}
+	}
+
+	const glm::ivec3& DensityGrid::GetCellCount() const
+	{
+		return m_CellCount;
+	}
+
+	uint8_t DensityGrid::GetControl(const glm::ivec3& cell) const
+	{
+		return m_Control[GetCellIndex(cell)];
+	}
+
+	uint8_t DensityGrid::GetResidualMajorant(const glm::ivec3& cell) const
+	{
+		return m_ResidualMajorant[GetCellIndex(cell)];
+	}
+
+	float DensityGrid::ResidualRatioTrack(
+		const glm::vec3& boxSize,
+		float densityFactor,
+		const glm::vec3& start,
+		const glm::vec3& end,
+		Random& random,
+		uint32_t* densityLookupCount) const
+	{
+		if (densityLookupCount != nullptr) { *densityLookupCount = 0; }
+
+		const glm::vec3 dir = glm::normalize(end - start);
+		glm::vec2 tBox;
+		if (!RayBox::Intersect(glm::vec3(0.0f), boxSize, start, dir, tBox)) { return 1.0f; }
+		const float tEnter = tBox.x;
+		const float tExit = std::min(tBox.y, glm::distance(end, start));
+		if (tExit <= tEnter) { return 1.0f; }
+
+		const glm::vec3 densitySize(m_DensitySize[0], m_DensitySize[1], m_DensitySize[2]);
+		const glm::vec3 gridOrigin = -boxSize / 2.0f;
+		const glm::vec3 cellSize = boxSize * static_cast<float>(c_CellSize) / densitySize;
+		const float unitDensity = densityFactor / 255.0f;
+
+		// DDA setup
+		glm::ivec3 cellStep;
+		glm::vec3 deltaT;
+		glm::ivec3 cell;
+		glm::vec3 nextT;
+		const glm::vec3 entryCell = (start + (tEnter * dir) - gridOrigin) / cellSize;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			cell[axis] = std::clamp(static_cast<int>(std::floor(entryCell[axis])), 0, m_CellCount[axis] - 1);
+			if (dir[axis] == 0.0f)
+			{
+				cellStep[axis] = 0;
+				deltaT[axis] = 1e30f;
+				nextT[axis] = 1e30f;
+				continue;
+			}
+
+			cellStep[axis] = dir[axis] > 0.0f ? 1 : -1;
+			deltaT[axis] = std::abs(cellSize[axis] / dir[axis]);
+			nextT[axis] = (gridOrigin[axis] + (static_cast<float>(cell[axis] + std::max(cellStep[axis], 0)) * cellSize[axis]) - start[axis]) / dir[axis];
+		}
+
+		// A segment enters every cell at most once, so only density lookups are capped
+		const int maxCellSteps = m_CellCount.x + m_CellCount.y + m_CellCount.z;
+		float transmittance = 1.0f;
+		float t = tEnter;
+		uint32_t lookupCount = 0;
+		for (int step = 0; step < maxCellSteps && t < tExit; step++)
+		{
+			const float cellExit = std::min(tExit, std::min(nextT.x, std::min(nextT.y, nextT.z)));
+			const float control = static_cast<float>(GetControl(cell)) * unitDensity;
+			const float residualMajorant = static_cast<float>(GetResidualMajorant(cell)) * unitDensity;
+
+			transmittance *= std::exp(-control * std::max(cellExit - t, 0.0f));
+
+			if (residualMajorant > 0.0f)
+			{
+				const float invResidualMajorant = 1.0f / residualMajorant;
+				float s = t;
+				while (lookupCount < c_MaxDensityLookups)
+				{
+					s -= std::log(1.0f - random.NextFloat()) * invResidualMajorant;
+					if (s >= cellExit) { break; }
+					const glm::vec3 voxelPos = (start + (s * dir) - gridOrigin) / boxSize * densitySize;
+					const float density = static_cast<float>(GetDensity(voxelPos)) * unitDensity;
+					transmittance *= 1.0f - ((density - control) * invResidualMajorant);
+					lookupCount++;
+				}
+			}
+
+			t = cellExit;
+			if (nextT.x <= nextT.y && nextT.x <= nextT.z) { cell.x += cellStep.x; nextT.x += deltaT.x; }
+			else if (nextT.y <= nextT.z) { cell.y += cellStep.y; nextT.y += deltaT.y; }
+			else { cell.z += cellStep.z; nextT.z += deltaT.z; }
+
+			if (cell.x < 0 || cell.y < 0 || cell.z < 0 || cell.x >= m_CellCount.x || cell.y >= m_CellCount.y || cell.z >= m_CellCount.z) { break; }
+		}
+
+		if (densityLookupCount != nullptr) { *densityLookupCount = lookupCount; }
+		return transmittance;
+	}
+
+	float DensityGrid::RatioTrack(
+		const glm::vec3& boxSize,
+		float densityFactor,
+		const glm::vec3& start,
+		const glm::vec3& end,
+		Random& random,
+		uint32_t* densityLookupCount) const
+	{
+		const glm::vec3 densitySize(m_DensitySize[0], m_DensitySize[1], m_DensitySize[2]);
+		const glm::vec3 gridOrigin = -boxSize / 2.0f;
+		const float unitDensity = densityFactor / 255.0f;
+		const float invMaxDensity = 1.0f / densityFactor;
+
+		const glm::vec3 dir = glm::normalize(end - start);
+		const float tMax = glm::distance(end, start);
+		float transmittance = 1.0f;
+		float t = 0.0f;
+		uint32_t lookupCount = 0;
+		while (lookupCount < c_MaxDensityLookups)
+		{
+			t -= std::log(1.0f - random.NextFloat()) * invMaxDensity;
+			if (t >= tMax) { break; }
+			const glm::vec3 voxelPos = (start + (t * dir) - gridOrigin) / boxSize * densitySize;
+			transmittance *= 1.0f - (static_cast<float>(GetDensity(voxelPos)) * unitDensity * invMaxDensity);
+			lookupCount++;
+		}
+
+		if (densityLookupCount != nullptr) { *densityLookupCount = lookupCount; }
+		return transmittance;
+	}
+
+	uint32_t DensityGrid::GetCellIndex(const glm::ivec3& cell) const
+	{
+		return cell.x + (m_CellCount.x * (cell.y + (m_CellCount.y * cell.z)));
+	}
+
+	uint8_t DensityGrid::GetDensity(const glm::vec3& voxelPos) const
+	{
+		const glm::vec3 voxel = glm::floor(voxelPos);
+		if (voxel.x < 0.0f || voxel.y < 0.0f || voxel.z < 0.0f) { return 0; }
+
+		const uint32_t x = static_cast<uint32_t>(voxel.x);
+		const uint32_t y = static_cast<uint32_t>(voxel.y);
+		const uint32_t z = static_cast<uint32_t>(voxel.z);
+		if (x >= m_DensitySize[0] || y >= m_DensitySize[1] || z >= m_DensitySize[2]) { return 0; }
+
+		return m_Density[x + (m_DensitySize[0] * (y + (m_DensitySize[1] * z)))];
+	}
+}
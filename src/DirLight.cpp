@@ -1,4 +1,5 @@
 #include <engine/graphics/DirLight.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
 #include <glm/gtx/transform.hpp>
 #include <imgui.h>
 
@@ -31,12 +32,22 @@ namespace en
 		layoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 		layoutBinding.pImmutableSamplers = nullptr;
 
+		// Transmittance toward the light
+		VkDescriptorSetLayoutBinding transmittanceBinding;
+		transmittanceBinding.binding = 1;
+		transmittanceBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		transmittanceBinding.descriptorCount = 1;
+		transmittanceBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+		transmittanceBinding.pImmutableSamplers = nullptr;
+
+		std::vector<VkDescriptorSetLayoutBinding> bindings = { layoutBinding, transmittanceBinding };
+
 		VkDescriptorSetLayoutCreateInfo descSetLayoutCreateInfo;
 		descSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 		descSetLayoutCreateInfo.pNext = nullptr;
 		descSetLayoutCreateInfo.flags = 0;
-		descSetLayoutCreateInfo.bindingCount = 1;
-		descSetLayoutCreateInfo.pBindings = &layoutBinding;
+		descSetLayoutCreateInfo.bindingCount = bindings.size();
+		descSetLayoutCreateInfo.pBindings = bindings.data();
 
 		VkResult result = vkCreateDescriptorSetLayout(device, &descSetLayoutCreateInfo, nullptr, &m_DescriptorSetLayout);
 		ASSERT_VULKAN(result);
@@ -46,13 +57,19 @@ namespace en
 		poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		poolSize.descriptorCount = 1;
 
+		VkDescriptorPoolSize transmittancePoolSize;
+		transmittancePoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		transmittancePoolSize.descriptorCount = 1;
+
+		std::vector<VkDescriptorPoolSize> poolSizes = { poolSize, transmittancePoolSize };
+
 		VkDescriptorPoolCreateInfo descPoolCreateInfo;
 		descPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 		descPoolCreateInfo.pNext = nullptr;
 		descPoolCreateInfo.flags = 0;
 		descPoolCreateInfo.maxSets = 1;
-		descPoolCreateInfo.poolSizeCount = 1;
-		descPoolCreateInfo.pPoolSizes = &poolSize;
+		descPoolCreateInfo.poolSizeCount = poolSizes.size();
+		descPoolCreateInfo.pPoolSizes = poolSizes.data();
 
 		result = vkCreateDescriptorPool(device, &descPoolCreateInfo, nullptr, &m_Pool);
 		ASSERT_VULKAN(result);
@@ -82,7 +99,7 @@ namespace en
 				sizeof(DirLightData),
 				VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
 				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 				{}
 			) }
 	{
@@ -119,7 +136,7 @@ namespace en
 
 		vkUpdateDescriptorSets(device, 1, &writeDescSet, 0, nullptr);
 
-		m_UniformBuffer.SetData(sizeof(DirLightData), &m_DirLightData, 0, 0);
+		vk::FramePacer::UpdateBuffer(m_UniformBuffer, sizeof(DirLightData), &m_DirLightData, 0);
 	}
 
 	void DirLight::Destroy()
@@ -137,24 +154,51 @@ namespace en
 		return m_DirLightData.m_Azimuth;
 	}
 
+	glm::vec3 DirLight::GetDir() const
+	{
+		return m_DirLightData.m_Dir;
+	}
+
 	void DirLight::SetZenith(float z)
 	{
 		m_DirLightData.m_Zenith = z;
 		m_DirLightData.m_Dir = VecFromAngles(z, m_DirLightData.m_Azimuth);
-		m_UniformBuffer.SetData(sizeof(DirLightData), &m_DirLightData, 0, 0);
+		vk::FramePacer::UpdateBuffer(m_UniformBuffer, sizeof(DirLightData), &m_DirLightData, 0);
 	}
 
 	void DirLight::SetAzimuth(float a)
 	{
 		m_DirLightData.m_Azimuth = a;
 		m_DirLightData.m_Dir = VecFromAngles(m_DirLightData.m_Zenith, a);
-		m_UniformBuffer.SetData(sizeof(DirLightData), &m_DirLightData, 0, 0);
+		vk::FramePacer::UpdateBuffer(m_UniformBuffer, sizeof(DirLightData), &m_DirLightData, 0);
 	}
 
 	void DirLight::SetColor(glm::vec3 c)
 	{
 		m_DirLightData.m_Color = c;
-		m_UniformBuffer.SetData(sizeof(glm::vec3), &c, offsetof(DirLightData, m_Color), 0);
+		vk::FramePacer::UpdateBuffer(m_UniformBuffer, sizeof(glm::vec3), &c, offsetof(DirLightData, m_Color));
+	}
+
+	void DirLight::SetTransmittanceTex(const vk::Texture3D* transmittanceTex)
+	{
+		VkDescriptorImageInfo imageInfo;
+		imageInfo.sampler = transmittanceTex->GetSampler();
+		imageInfo.imageView = transmittanceTex->GetImageView();
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkWriteDescriptorSet writeDescSet;
+		writeDescSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writeDescSet.pNext = nullptr;
+		writeDescSet.dstSet = m_DescriptorSet;
+		writeDescSet.dstBinding = 1;
+		writeDescSet.dstArrayElement = 0;
+		writeDescSet.descriptorCount = 1;
+		writeDescSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writeDescSet.pImageInfo = &imageInfo;
+		writeDescSet.pBufferInfo = nullptr;
+		writeDescSet.pTexelBufferView = nullptr;
+
+		vkUpdateDescriptorSets(VulkanAPI::GetDevice(), 1, &writeDescSet, 0, nullptr);
 	}
 
 	VkDescriptorSet DirLight::GetDescriptorSet() const
@@ -170,7 +214,7 @@ namespace en
 		ImGui::DragFloat("Strength", &m_DirLightData.m_Strenth, 0.01);
 
 		m_DirLightData.m_Dir = VecFromAngles(m_DirLightData.m_Zenith, m_DirLightData.m_Azimuth);
-		m_UniformBuffer.SetData(sizeof(DirLightData), &m_DirLightData, 0, 0);
+		vk::FramePacer::UpdateBuffer(m_UniformBuffer, sizeof(DirLightData), &m_DirLightData, 0);
 
 		ImGui::End();
 	}
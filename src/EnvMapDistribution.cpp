@@ -0,0 +1,120 @@
+#include <engine/util/EnvMapDistribution.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace en
+{
+	EnvMapDistribution::EnvMapDistribution(const std::vector<float>& hdr4f, uint32_t width, uint32_t height) :
+		m_Width(width),
+		m_Height(height),
+		m_CdfX(width * height),
+		m_CdfY(height)
+	{
+		std::vector<float> rowWeights(height);
+		for (size_t y = 0; y < height; y++)
+		{
+			const float latitude = ((static_cast<float>(y) + 0.5f) / static_cast<float>(height) - 0.5f) * 3.14159265f;
+			rowWeights[y] = std::cos(latitude);
+		}
+
+		// Get cdf of x given y
+		float totalBrightness = 0.0f;
+		for (size_t y = 0; y < height; y++)
+		{
+			float* cdfXgivenY = m_CdfX.data() + (y * width);
+			float brightnessSum = 0.0f;
+			for (size_t x = 0; x < width; x++)
+			{
+				const float r = hdr4f[(y * width * 4) + (x * 4) + 0];
+				const float g = hdr4f[(y * width * 4) + (x * 4) + 1];
+				const float b = hdr4f[(y * width * 4) + (x * 4) + 2];
+
+				brightnessSum += r + g + b;
+				cdfXgivenY[x] = brightnessSum;
+			}
+
+			// Norm. Black rows fall back to uniform
+			for (size_t x = 0; x < width; x++)
+			{
+				cdfXgivenY[x] = brightnessSum > 0.0f ? cdfXgivenY[x] / brightnessSum : static_cast<float>(x + 1) / static_cast<float>(width);
+			}
+
+			// Store pdf unorm of y
+			m_CdfY[y] = brightnessSum * rowWeights[y];
+			totalBrightness += brightnessSum;
+		}
+
+		// Cdf of y. A black map falls back to uniform over the sphere
+		float cdfSum = 0.0f;
+		for (size_t y = 0; y < height; y++)
+		{
+			cdfSum += totalBrightness > 0.0f ? m_CdfY[y] : rowWeights[y];
+			m_CdfY[y] = cdfSum;
+		}
+
+		for (size_t y = 0; y < height; y++)
+		{
+			m_CdfY[y] /= cdfSum;
+		}
+	}
+
+	float EnvMapDistribution::Pdf(const glm::vec3& dir) const
+	{
+		const glm::vec2 uv = DirToUv(dir);
+		const uint32_t x = std::min(static_cast<uint32_t>(std::max(uv.x * static_cast<float>(m_Width), 0.0f)), m_Width - 1);
+		const uint32_t y = std::min(static_cast<uint32_t>(std::max(uv.y * static_cast<float>(m_Height), 0.0f)), m_Height - 1);
+
+		const float* cdfXgivenY = m_CdfX.data() + (y * m_Width);
+		const float pdfY = m_CdfY[y] - (y == 0 ? 0.0f : m_CdfY[y - 1]);
+		const float pdfX = cdfXgivenY[x] - (x == 0 ? 0.0f : cdfXgivenY[x - 1]);
+		const float pixelPdf = pdfY * pdfX;
+
+		const float cosLat = std::cos((uv.y - 0.5f) * 3.14159265f);
+		if (cosLat <= 0.0f) { return 0.0f; }
+
+		return pixelPdf * static_cast<float>(m_Width * m_Height) / (2.0f * 3.14159265f * 3.14159265f * cosLat);
+	}
+
+	glm::vec3 EnvMapDistribution::SampleDir(Random& random) const
+	{
+		// First index whose cdf value is above xi, like SearchHdrEnvMapCdfY and SearchHdrEnvMapCdfX
+		const float xiY = random.NextFloat();
+		const uint32_t y = static_cast<uint32_t>(std::min(
+			static_cast<size_t>(std::upper_bound(m_CdfY.begin(), m_CdfY.end(), xiY) - m_CdfY.begin()),
+			m_CdfY.size() - 1));
+
+		const float xiX = random.NextFloat();
+		const std::vector<float>::const_iterator rowBegin = m_CdfX.begin() + (y * m_Width);
+		const uint32_t x = static_cast<uint32_t>(std::min(
+			static_cast<size_t>(std::upper_bound(rowBegin, rowBegin + m_Width, xiX) - rowBegin),
+			static_cast<size_t>(m_Width - 1)));
+
+		const float u = (static_cast<float>(x) + random.NextFloat()) / static_cast<float>(m_Width);
+		const float v = (static_cast<float>(y) + random.NextFloat()) / static_cast<float>(m_Height);
+		return UvToDir(glm::vec2(u, v));
+	}
+
+	const std::vector<float>& EnvMapDistribution::GetCdfX() const
+	{
+		return m_CdfX;
+	}
+
+	const std::vector<float>& EnvMapDistribution::GetCdfY() const
+	{
+		return m_CdfY;
+	}
+
+	glm::vec2 EnvMapDistribution::DirToUv(const glm::vec3& dir)
+	{
+		return glm::vec2(
+			std::atan2(dir.z, dir.x) / (2.0f * 3.14159265f) + 0.5f,
+			std::asin(std::clamp(dir.y, -1.0f, 1.0f)) / 3.14159265f + 0.5f);
+	}
+
+	glm::vec3 EnvMapDistribution::UvToDir(const glm::vec2& uv)
+	{
+		const float phi = (uv.x - 0.5f) * 2.0f * 3.14159265f;
+		const float lat = (uv.y - 0.5f) * 3.14159265f;
+		return glm::vec3(std::cos(lat) * std::cos(phi), std::sin(lat), std::cos(lat) * std::sin(phi));
+	}
+}
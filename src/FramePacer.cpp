@@ -0,0 +1,285 @@
+#include <engine/graphics/vulkan/FramePacer.hpp>
+#include <engine/graphics/VulkanAPI.hpp>
+
+namespace en::vk
+{
+	VkSemaphore FramePacer::s_TimelineSemaphore = VK_NULL_HANDLE;
+	uint64_t FramePacer::s_TimelineValue = 0;
+
+	uint64_t FramePacer::s_FrameIndex = 0;
+	bool FramePacer::s_FrameActive = false;
+	std::array<uint64_t, FramePacer::c_MaxFramesInFlight> FramePacer::s_FrameEndValues;
+
+	VkCommandPool FramePacer::s_CommandPool = VK_NULL_HANDLE;
+	std::array<VkCommandBuffer, FramePacer::c_MaxFramesInFlight> FramePacer::s_UpdateCommandBuffers;
+	bool FramePacer::s_UpdatesRecording = false;
+
+	void FramePacer::Init()
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		// Timeline semaphore
+		VkSemaphoreTypeCreateInfo semaphoreTypeCI;
+		semaphoreTypeCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		semaphoreTypeCI.pNext = nullptr;
+		semaphoreTypeCI.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		semaphoreTypeCI.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreCI;
+		semaphoreCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreCI.pNext = &semaphoreTypeCI;
+		semaphoreCI.flags = 0;
+
+		VkResult result = vkCreateSemaphore(device, &semaphoreCI, nullptr, &s_TimelineSemaphore);
+		ASSERT_VULKAN(result);
+		s_TimelineValue = 0;
+
+		// Per frame command buffers for buffer updates
+		VkCommandPoolCreateInfo commandPoolCI;
+		commandPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		commandPoolCI.pNext = nullptr;
+		commandPoolCI.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		commandPoolCI.queueFamilyIndex = VulkanAPI::GetGraphicsQFI();
+
+		result = vkCreateCommandPool(device, &commandPoolCI, nullptr, &s_CommandPool);
+		ASSERT_VULKAN(result);
+
+		VkCommandBufferAllocateInfo allocateInfo;
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.pNext = nullptr;
+		allocateInfo.commandPool = s_CommandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = c_MaxFramesInFlight;
+
+		result = vkAllocateCommandBuffers(device, &allocateInfo, s_UpdateCommandBuffers.data());
+		ASSERT_VULKAN(result);
+
+		s_FrameIndex = 0;
+		s_FrameActive = false;
+		s_FrameEndValues.fill(0);
+		s_UpdatesRecording = false;
+	}
+
+	void FramePacer::Shutdown()
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		WaitIdle();
+
+		vkDestroyCommandPool(device, s_CommandPool, nullptr);
+		s_CommandPool = VK_NULL_HANDLE;
+
+		vkDestroySemaphore(device, s_TimelineSemaphore, nullptr);
+		s_TimelineSemaphore = VK_NULL_HANDLE;
+	}
+
+	uint32_t FramePacer::BeginFrame()
+	{
+		if (s_FrameActive) { Log::Error("FramePacer::BeginFrame called twice without EndFrame", true); }
+
+		const uint32_t slot = GetFrameSlot();
+		Wait(s_FrameEndValues[slot]);
+		s_FrameActive = true;
+		return slot;
+	}
+
+	void FramePacer::EndFrame(VkQueue queue)
+	{
+		if (!s_FrameActive) { Log::Error("FramePacer::EndFrame called without BeginFrame", true); }
+
+		SubmitUpdates(queue);
+		s_FrameEndValues[GetFrameSlot()] = Signal(queue);
+		s_FrameIndex++;
+		s_FrameActive = false;
+	}
+
+	bool FramePacer::IsFrameActive()
+	{
+		return s_FrameActive;
+	}
+
+	uint32_t FramePacer::GetFrameSlot()
+	{
+		return static_cast<uint32_t>(s_FrameIndex % c_MaxFramesInFlight);
+	}
+
+	bool FramePacer::IsPreviousFrameComplete()
+	{
+		const uint32_t previousSlot = static_cast<uint32_t>((s_FrameIndex + c_MaxFramesInFlight - 1) % c_MaxFramesInFlight);
+
+		uint64_t currentValue;
+		VkResult result = vkGetSemaphoreCounterValue(VulkanAPI::GetDevice(), s_TimelineSemaphore, &currentValue);
+		ASSERT_VULKAN(result);
+		return currentValue >= s_FrameEndValues[previousSlot];
+	}
+
+	void FramePacer::WaitIdle()
+	{
+		Wait(s_TimelineValue);
+	}
+
+	void FramePacer::Submit(VkQueue queue, const VkSubmitInfo& submitInfo, VkFence fence)
+	{
+		if (!s_FrameActive)
+		{
+			ASSERT_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, fence));
+			return;
+		}
+
+		SubmitUpdates(queue);
+		ASSERT_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, fence));
+		SubmitBarrier(queue);
+	}
+
+	void FramePacer::UpdateBuffer(Buffer& buffer, VkDeviceSize size, const void* data, VkDeviceSize offset)
+	{
+		if (!s_FrameActive)
+		{
+			buffer.SetData(size, data, offset, 0);
+			return;
+		}
+
+		// vkCmdUpdateBuffer is limited to small and 4 byte aligned updates. Others are written by the host once no
+		// frame in flight can read the buffer anymore
+		if (size > c_MaxUpdateSize || size % 4 != 0 || offset % 4 != 0)
+		{
+			WaitIdle();
+			buffer.SetData(size, data, offset, 0);
+			return;
+		}
+
+		VkCommandBuffer commandBuffer = s_UpdateCommandBuffers[GetFrameSlot()];
+		if (!s_UpdatesRecording)
+		{
+			VkCommandBufferBeginInfo beginInfo;
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.pNext = nullptr;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			beginInfo.pInheritanceInfo = nullptr;
+
+			VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+			ASSERT_VULKAN(result);
+			s_UpdatesRecording = true;
+		}
+
+		vkCmdUpdateBuffer(commandBuffer, buffer.GetVulkanHandle(), offset, size, data);
+	}
+
+	void FramePacer::SubmitUpdates(VkQueue queue)
+	{
+		if (!s_UpdatesRecording) { return; }
+
+		VkCommandBuffer commandBuffer = s_UpdateCommandBuffers[GetFrameSlot()];
+		VkResult result = vkEndCommandBuffer(commandBuffer);
+		ASSERT_VULKAN(result);
+		s_UpdatesRecording = false;
+
+		VkSubmitInfo submitInfo;
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = nullptr;
+		submitInfo.waitSemaphoreCount = 0;
+		submitInfo.pWaitSemaphores = nullptr;
+		submitInfo.pWaitDstStageMask = nullptr;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 0;
+		submitInfo.pSignalSemaphores = nullptr;
+
+		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		ASSERT_VULKAN(result);
+
+		SubmitBarrier(queue);
+	}
+
+	void FramePacer::SubmitBarrier(VkQueue queue)
+	{
+		// A signal covers all commands submitted before it and a wait blocks all commands submitted after it, so the
+		// pair is a full execution and memory dependency between everything before and after on the queue
+		const uint64_t value = ++s_TimelineValue;
+
+		VkTimelineSemaphoreSubmitInfo signalTimelineInfo;
+		signalTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		signalTimelineInfo.pNext = nullptr;
+		signalTimelineInfo.waitSemaphoreValueCount = 0;
+		signalTimelineInfo.pWaitSemaphoreValues = nullptr;
+		signalTimelineInfo.signalSemaphoreValueCount = 1;
+		signalTimelineInfo.pSignalSemaphoreValues = &value;
+
+		VkTimelineSemaphoreSubmitInfo waitTimelineInfo;
+		waitTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		waitTimelineInfo.pNext = nullptr;
+		waitTimelineInfo.waitSemaphoreValueCount = 1;
+		waitTimelineInfo.pWaitSemaphoreValues = &value;
+		waitTimelineInfo.signalSemaphoreValueCount = 0;
+		waitTimelineInfo.pSignalSemaphoreValues = nullptr;
+
+		const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+		std::array<VkSubmitInfo, 2> submitInfos;
+		submitInfos[0].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfos[0].pNext = &signalTimelineInfo;
+		submitInfos[0].waitSemaphoreCount = 0;
+		submitInfos[0].pWaitSemaphores = nullptr;
+		submitInfos[0].pWaitDstStageMask = nullptr;
+		submitInfos[0].commandBufferCount = 0;
+		submitInfos[0].pCommandBuffers = nullptr;
+		submitInfos[0].signalSemaphoreCount = 1;
+		submitInfos[0].pSignalSemaphores = &s_TimelineSemaphore;
+
+		submitInfos[1].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfos[1].pNext = &waitTimelineInfo;
+		submitInfos[1].waitSemaphoreCount = 1;
+		submitInfos[1].pWaitSemaphores = &s_TimelineSemaphore;
+		submitInfos[1].pWaitDstStageMask = &waitStage;
+		submitInfos[1].commandBufferCount = 0;
+		submitInfos[1].pCommandBuffers = nullptr;
+		submitInfos[1].signalSemaphoreCount = 0;
+		submitInfos[1].pSignalSemaphores = nullptr;
+
+		VkResult result = vkQueueSubmit(queue, static_cast<uint32_t>(submitInfos.size()), submitInfos.data(), VK_NULL_HANDLE);
+		ASSERT_VULKAN(result);
+	}
+
+	uint64_t FramePacer::Signal(VkQueue queue)
+	{
+		const uint64_t value = ++s_TimelineValue;
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo;
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.pNext = nullptr;
+		timelineInfo.waitSemaphoreValueCount = 0;
+		timelineInfo.pWaitSemaphoreValues = nullptr;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &value;
+
+		VkSubmitInfo submitInfo;
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.waitSemaphoreCount = 0;
+		submitInfo.pWaitSemaphores = nullptr;
+		submitInfo.pWaitDstStageMask = nullptr;
+		submitInfo.commandBufferCount = 0;
+		submitInfo.pCommandBuffers = nullptr;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &s_TimelineSemaphore;
+
+		VkResult result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		ASSERT_VULKAN(result);
+
+		return value;
+	}
+
+	void FramePacer::Wait(uint64_t value)
+	{
+		VkSemaphoreWaitInfo waitInfo;
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.pNext = nullptr;
+		waitInfo.flags = 0;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &s_TimelineSemaphore;
+		waitInfo.pValues = &value;
+
+		VkResult result = vkWaitSemaphores(VulkanAPI::GetDevice(), &waitInfo, UINT64_MAX);
+		ASSERT_VULKAN(result);
+	}
+}
@@ -1,9 +1,7 @@
 #include <engine/graphics/HdrEnvMap.hpp>
 #include <engine/util/read_file.hpp>
 #include <engine/graphics/VulkanAPI.hpp>
-#include <engine/graphics/vulkan/Buffer.hpp>
-#include <engine/graphics/vulkan/CommandRecorder.hpp>
-#include <engine/graphics/vulkan/CommandPool.hpp>
+#include <engine/graphics/vulkan/Uploader.hpp>
 #include <imgui.h>
 
 namespace en
@@ -98,12 +96,12 @@ namespace en
 		m_ColorImageLayout(VK_IMAGE_LAYOUT_PREINITIALIZED)
 	{
 		VkDevice device = VulkanAPI::GetDevice();
-		VkQueue queue = VulkanAPI::GetGraphicsQueue();
-		
-		// Create images and resources
-		CreateColorImage(device, queue, hdr4f);
-		CreateCdfXImage(device, queue, cdfX);
-		CreateCdfYImage(device, queue, cdfY);
+
+		// Create images and resources. The three uploads are submitted as one batch
+		CreateColorImage(device, hdr4f);
+		CreateCdfXImage(device, cdfX);
+		CreateCdfYImage(device, cdfY);
+		vk::Uploader::Flush();
 
 		// Create Sampler
 		VkFilter filter = VK_FILTER_LINEAR;
@@ -206,15 +204,15 @@ namespace en
 
 		vkDestroySampler(device, m_Sampler, nullptr);
 
-		vkFreeMemory(device, m_CdfYImageMemory, nullptr);
+		vk::MemoryAllocator::Free(m_CdfYImageMemory);
 		vkDestroyImageView(device, m_CdfYImageView, nullptr);
 		vkDestroyImage(device, m_CdfYImage, nullptr);
 
-		vkFreeMemory(device, m_CdfXImageMemory, nullptr);
+		vk::MemoryAllocator::Free(m_CdfXImageMemory);
 		vkDestroyImageView(device, m_CdfXImageView, nullptr);
 		vkDestroyImage(device, m_CdfXImage, nullptr);
 
-		vkFreeMemory(device, m_ColorImageMemory, nullptr);
+		vk::MemoryAllocator::Free(m_ColorImageMemory);
 		vkDestroyImageView(device, m_ColorImageView, nullptr);
 		vkDestroyImage(device, m_ColorImage, nullptr);
 	}
@@ -229,7 +227,7 @@ namespace en
 		return m_DescSet;
 	}
 
-	void HdrEnvMap::CreateColorImage(VkDevice device, VkQueue queue, const std::vector<float>& hdr4f)
+	void HdrEnvMap::CreateColorImage(VkDevice device, const std::vector<float>& hdr4f)
 	{
 		// Create Image
 		VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT;
@@ -255,22 +253,7 @@ namespace en
 		ASSERT_VULKAN(result);
 
 		// Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_ColorImage, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_ColorImageMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_ColorImage, m_ColorImageMemory, 0);
-		ASSERT_VULKAN(result);
+		m_ColorImageMemory = vk::MemoryAllocator::AllocateImage(m_ColorImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Create ImageView
 		VkImageViewCreateInfo imageViewCreateInfo;
@@ -293,29 +276,18 @@ namespace en
 		result = vkCreateImageView(device, &imageViewCreateInfo, nullptr, &m_ColorImageView);
 		ASSERT_VULKAN(result);
 
-		// Staging Buffer
-		vk::Buffer stagingBuffer(
-			m_RawColorSize,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			{});
-
-		stagingBuffer.SetData(m_RawColorSize, hdr4f.data(), 0, 0);
-
 		// Transfer data
-		vk::CommandPool commandPool = vk::CommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, VulkanAPI::GetGraphicsQFI());
-		commandPool.AllocateBuffers(1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-		VkCommandBuffer commandBuffer = commandPool.GetBuffer(0);
-
-		ChangeColorImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, commandBuffer, queue);
-		WriteBufferToColorImage(commandBuffer, queue, stagingBuffer.GetVulkanHandle());
-		ChangeColorImageLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer, queue);
-
-		stagingBuffer.Destroy();
-		commandPool.Destroy();
+		vk::Uploader::UploadImage(
+			m_ColorImage,
+			{ m_Width, m_Height, 1 },
+			hdr4f.data(),
+			m_RawColorSize,
+			m_ColorImageLayout,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		m_ColorImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 	}
 
-	void HdrEnvMap::CreateCdfXImage(VkDevice device, VkQueue queue, const std::vector<float>& cdfX)
+	void HdrEnvMap::CreateCdfXImage(VkDevice device, const std::vector<float>& cdfX)
 	{
 		// Create Image
 		VkFormat format = VK_FORMAT_R32_SFLOAT;
@@ -341,22 +313,7 @@ namespace en
 		ASSERT_VULKAN(result);
 
 		// Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_CdfXImage, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_CdfXImageMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_CdfXImage, m_CdfXImageMemory, 0);
-		ASSERT_VULKAN(result);
+		m_CdfXImageMemory = vk::MemoryAllocator::AllocateImage(m_CdfXImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Create ImageView
 		VkImageViewCreateInfo imageViewCreateInfo;
@@ -379,85 +336,17 @@ namespace en
 		result = vkCreateImageView(device, &imageViewCreateInfo, nullptr, &m_CdfXImageView);
 		ASSERT_VULKAN(result);
 
-		// Staging Buffer
-		vk::Buffer stagingBuffer(
-			m_RawCdfXSize,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			{});
-
-		stagingBuffer.SetData(m_RawCdfXSize, cdfX.data(), 0, 0);
-
 		// Transfer data
-		vk::CommandPool commandPool = vk::CommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, VulkanAPI::GetGraphicsQFI());
-		commandPool.AllocateBuffers(1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-		VkCommandBuffer commandBuffer = commandPool.GetBuffer(0);
-
-		VkCommandBufferBeginInfo beginInfo;
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.pNext = nullptr;
-		beginInfo.flags = 0;
-		beginInfo.pInheritanceInfo = nullptr;
-		
-		result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
-		ASSERT_VULKAN(result);
-
-		vk::CommandRecorder::ImageLayoutTransfer(
-			commandBuffer, 
+		vk::Uploader::UploadImage(
 			m_CdfXImage,
+			{ m_Width, m_Height, 1 },
+			cdfX.data(),
+			m_RawCdfXSize,
 			VK_IMAGE_LAYOUT_PREINITIALIZED,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_ACCESS_NONE,
-			VK_ACCESS_TRANSFER_WRITE_BIT,
-			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-
-		VkBufferImageCopy bufferImageCopy;
-		bufferImageCopy.bufferOffset = 0;
-		bufferImageCopy.bufferRowLength = 0;
-		bufferImageCopy.bufferImageHeight = 0;
-		bufferImageCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		bufferImageCopy.imageSubresource.mipLevel = 0;
-		bufferImageCopy.imageSubresource.baseArrayLayer = 0;
-		bufferImageCopy.imageSubresource.layerCount = 1;
-		bufferImageCopy.imageOffset = { 0, 0, 0 };
-		bufferImageCopy.imageExtent = { m_Width, m_Height, 1 };
-
-		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.GetVulkanHandle(), m_CdfXImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferImageCopy);
-
-		vk::CommandRecorder::ImageLayoutTransfer(
-			commandBuffer,
-			m_CdfXImage,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			VK_ACCESS_TRANSFER_WRITE_BIT,
-			VK_ACCESS_SHADER_READ_BIT,
-			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-
-		vkEndCommandBuffer(commandBuffer);
-
-		VkSubmitInfo submitInfo;
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.pNext = nullptr;
-		submitInfo.waitSemaphoreCount = 0;
-		submitInfo.pWaitSemaphores = nullptr;
-		submitInfo.pWaitDstStageMask = nullptr;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-		submitInfo.signalSemaphoreCount = 0;
-		submitInfo.pSignalSemaphores = nullptr;
-		
-		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		ASSERT_VULKAN(result);
-		result = vkQueueWaitIdle(queue);
-		ASSERT_VULKAN(result);
-
-		stagingBuffer.Destroy();
-		commandPool.Destroy();
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	}
 
-	void HdrEnvMap::CreateCdfYImage(VkDevice device, VkQueue queue, const std::vector<float>& cdfY)
+	void HdrEnvMap::CreateCdfYImage(VkDevice device, const std::vector<float>& cdfY)
 	{
 		// Create Image
 		VkFormat format = VK_FORMAT_R32_SFLOAT;
@@ -483,22 +372,7 @@ namespace en
 		ASSERT_VULKAN(result);
 
 		// Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_CdfYImage, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_CdfYImageMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_CdfYImage, m_CdfYImageMemory, 0);
-		ASSERT_VULKAN(result);
+		m_CdfYImageMemory = vk::MemoryAllocator::AllocateImage(m_CdfYImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Create ImageView
 		VkImageViewCreateInfo imageViewCreateInfo;
@@ -521,191 +395,13 @@ namespace en
 		result = vkCreateImageView(device, &imageViewCreateInfo, nullptr, &m_CdfYImageView);
 		ASSERT_VULKAN(result);
 
-		// Staging Buffer
-		vk::Buffer stagingBuffer(
-			m_RawCdfYSize,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			{});
-
-		stagingBuffer.SetData(m_RawCdfYSize, cdfY.data(), 0, 0);
-
 		// Transfer data
-		vk::CommandPool commandPool = vk::CommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, VulkanAPI::GetGraphicsQFI());
-		commandPool.AllocateBuffers(1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-		VkCommandBuffer commandBuffer = commandPool.GetBuffer(0);
-
-		VkCommandBufferBeginInfo beginInfo;
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.pNext = nullptr;
-		beginInfo.flags = 0;
-		beginInfo.pInheritanceInfo = nullptr;
-
-		result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
-		ASSERT_VULKAN(result);
-
-		vk::CommandRecorder::ImageLayoutTransfer(
-			commandBuffer,
+		vk::Uploader::UploadImage(
 			m_CdfYImage,
+			{ m_Height, 1, 1 },
+			cdfY.data(),
+			m_RawCdfYSize,
 			VK_IMAGE_LAYOUT_PREINITIALIZED,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_ACCESS_NONE,
-			VK_ACCESS_TRANSFER_WRITE_BIT,
-			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-
-		VkBufferImageCopy bufferImageCopy;
-		bufferImageCopy.bufferOffset = 0;
-		bufferImageCopy.bufferRowLength = 0;
-		bufferImageCopy.bufferImageHeight = 0;
-		bufferImageCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		bufferImageCopy.imageSubresource.mipLevel = 0;
-		bufferImageCopy.imageSubresource.baseArrayLayer = 0;
-		bufferImageCopy.imageSubresource.layerCount = 1;
-		bufferImageCopy.imageOffset = { 0, 0, 0 };
-		bufferImageCopy.imageExtent = { m_Height, 1, 1 };
-
-		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.GetVulkanHandle(), m_CdfYImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferImageCopy);
-
-		vk::CommandRecorder::ImageLayoutTransfer(
-			commandBuffer,
-			m_CdfYImage,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			VK_ACCESS_TRANSFER_WRITE_BIT,
-			VK_ACCESS_SHADER_READ_BIT,
-			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-
-		vkEndCommandBuffer(commandBuffer);
-
-		VkSubmitInfo submitInfo;
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.pNext = nullptr;
-		submitInfo.waitSemaphoreCount = 0;
-		submitInfo.pWaitSemaphores = nullptr;
-		submitInfo.pWaitDstStageMask = nullptr;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-		submitInfo.signalSemaphoreCount = 0;
-		submitInfo.pSignalSemaphores = nullptr;
-
-		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		ASSERT_VULKAN(result);
-		result = vkQueueWaitIdle(queue);
-		ASSERT_VULKAN(result);
-
-		stagingBuffer.Destroy();
-		commandPool.Destroy();
-	}
-
-	void HdrEnvMap::ChangeColorImageLayout(VkImageLayout layout, VkCommandBuffer commandBuffer, VkQueue queue)
-	{
-		VkAccessFlags srcAccessMask;
-		VkAccessFlags dstAccessMask;
-
-		VkPipelineStageFlags srcStageFlags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-		VkPipelineStageFlags dstStageFlags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-
-		if (m_ColorImageLayout == VK_IMAGE_LAYOUT_PREINITIALIZED && layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-		{
-			srcAccessMask = VK_ACCESS_NONE_KHR;
-			dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		}
-		else if (m_ColorImageLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		{
-			srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		}
-		else
-		{
-			Log::Error("Unknown image layout transision in Texture2D", true);
-		}
-
-		VkCommandBufferBeginInfo beginInfo;
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.pNext = nullptr;
-		beginInfo.flags = 0;
-		beginInfo.pInheritanceInfo = nullptr;
-
-		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
-		ASSERT_VULKAN(result);
-
-		vk::CommandRecorder::ImageLayoutTransfer(
-			commandBuffer,
-			m_ColorImage,
-			m_ColorImageLayout,
-			layout,
-			srcAccessMask,
-			dstAccessMask,
-			srcStageFlags,
-			dstStageFlags);
-
-		result = vkEndCommandBuffer(commandBuffer);
-		ASSERT_VULKAN(result);
-
-		VkSubmitInfo submitInfo;
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.pNext = nullptr;
-		submitInfo.waitSemaphoreCount = 0;
-		submitInfo.pWaitSemaphores = nullptr;
-		submitInfo.pWaitDstStageMask = nullptr;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-		submitInfo.signalSemaphoreCount = 0;
-		submitInfo.pSignalSemaphores = nullptr;
-
-		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		ASSERT_VULKAN(result);
-
-		result = vkQueueWaitIdle(queue);
-		ASSERT_VULKAN(result);
-
-		m_ColorImageLayout = layout;
-	}
-
-	void HdrEnvMap::WriteBufferToColorImage(VkCommandBuffer commandBuffer, VkQueue queue, VkBuffer buffer)
-	{
-		VkCommandBufferBeginInfo beginInfo;
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.pNext = nullptr;
-		beginInfo.flags = 0;
-		beginInfo.pInheritanceInfo = nullptr;
-
-		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
-		ASSERT_VULKAN(result);
-
-		VkBufferImageCopy bufferImageCopy;
-		bufferImageCopy.bufferOffset = 0;
-		bufferImageCopy.bufferRowLength = 0;
-		bufferImageCopy.bufferImageHeight = 0;
-		bufferImageCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		bufferImageCopy.imageSubresource.mipLevel = 0;
-		bufferImageCopy.imageSubresource.baseArrayLayer = 0;
-		bufferImageCopy.imageSubresource.layerCount = 1;
-		bufferImageCopy.imageOffset = { 0, 0, 0 };
-		bufferImageCopy.imageExtent = { m_Width, m_Height, 1 };
-
-		vkCmdCopyBufferToImage(commandBuffer, buffer, m_ColorImage, m_ColorImageLayout, 1, &bufferImageCopy);
-
-		result = vkEndCommandBuffer(commandBuffer);
-		ASSERT_VULKAN(result);
-
-		VkSubmitInfo submitInfo;
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.pNext = nullptr;
-		submitInfo.waitSemaphoreCount = 0;
-		submitInfo.pWaitSemaphores = nullptr;
-		submitInfo.pWaitDstStageMask = nullptr;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-		submitInfo.signalSemaphoreCount = 0;
-		submitInfo.pSignalSemaphores = nullptr;
-
-		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		ASSERT_VULKAN(result);
-
-		result = vkQueueWaitIdle(queue);
-		ASSERT_VULKAN(result);
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	}
 }
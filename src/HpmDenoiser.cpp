@@ -0,0 +1,692 @@
+#include <engine/graphics/renderer/HpmDenoiser.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
+#include <engine/graphics/vulkan/CommandRecorder.hpp>
+#include <engine/graphics/vulkan/ShaderCompiler.hpp>
+#include <engine/graphics/VulkanAPI.hpp>
+#include <engine/util/Log.hpp>
+#include <imgui.h>
+
+namespace en
+{
+	VkDescriptorSetLayout HpmDenoiser::s_DescSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool HpmDenoiser::s_DescPool = VK_NULL_HANDLE;
+
+	// color, guide, history, moments, prev history, prev moments, ping, pong, output
+	static const uint32_t c_StorageImageCount = 9;
+
+	void HpmDenoiser::Init(VkDevice device)
+	{
+		vk::ShaderCompiler::Precompile({ "denoise/temporal.comp", "denoise/atrous.comp" });
+
+		// Create desc set layout
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		for (uint32_t i = 0; i < c_StorageImageCount; i++)
+		{
+			VkDescriptorSetLayoutBinding storageImageBinding;
+			storageImageBinding.binding = i;
+			storageImageBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			storageImageBinding.descriptorCount = 1;
+			storageImageBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			storageImageBinding.pImmutableSamplers = nullptr;
+			bindings.push_back(storageImageBinding);
+		}
+
+		VkDescriptorSetLayoutBinding uniformBufferBinding;
+		uniformBufferBinding.binding = c_StorageImageCount;
+		uniformBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uniformBufferBinding.descriptorCount = 1;
+		uniformBufferBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		uniformBufferBinding.pImmutableSamplers = nullptr;
+		bindings.push_back(uniformBufferBinding);
+
+		VkDescriptorSetLayoutCreateInfo layoutCI;
+		layoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutCI.pNext = nullptr;
+		layoutCI.flags = 0;
+		layoutCI.bindingCount = bindings.size();
+		layoutCI.pBindings = bindings.data();
+
+		VkResult result = vkCreateDescriptorSetLayout(device, &layoutCI, nullptr, &s_DescSetLayout);
+		ASSERT_VULKAN(result);
+
+		// Create desc pool
+		const uint32_t maxSets = 4;
+
+		VkDescriptorPoolSize storageImagePS;
+		storageImagePS.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		storageImagePS.descriptorCount = maxSets * c_StorageImageCount;
+
+		VkDescriptorPoolSize uniformBufferPS;
+		uniformBufferPS.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uniformBufferPS.descriptorCount = maxSets;
+
+		std::vector<VkDescriptorPoolSize> poolSizes = { storageImagePS, uniformBufferPS };
+
+		VkDescriptorPoolCreateInfo poolCI;
+		poolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolCI.pNext = nullptr;
+		poolCI.flags = 0;
+		poolCI.maxSets = maxSets;
+		poolCI.poolSizeCount = poolSizes.size();
+		poolCI.pPoolSizes = poolSizes.data();
+
+		result = vkCreateDescriptorPool(device, &poolCI, nullptr, &s_DescPool);
+		ASSERT_VULKAN(result);
+	}
+
+	void HpmDenoiser::Shutdown(VkDevice device)
+	{
+		vkDestroyDescriptorPool(device, s_DescPool, nullptr);
+		vkDestroyDescriptorSetLayout(device, s_DescSetLayout, nullptr);
+	}
+
+	HpmDenoiser::HpmDenoiser(uint32_t width, uint32_t height, const Camera* camera, VkImageView colorImageView, VkImageView guideImageView) :
+		m_RenderWidth(width),
+		m_RenderHeight(height),
+		m_Camera(camera),
+		m_ColorImageView(colorImageView),
+		m_GuideImageView(guideImageView),
+		m_UniformBuffer(
+			sizeof(UniformData),
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			{}),
+		m_TemporalShader("denoise/temporal.comp", false),
+		m_AtrousShader("denoise/atrous.comp", false),
+		m_Timestamps({ "Denoise" }),
+		m_CommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, VulkanAPI::GetGraphicsQFI())
+	{
+		Log::Info("Create HpmDenoiser");
+
+		// Init components
+		VkDevice device = VulkanAPI::GetDevice();
+
+		m_CommandPool.AllocateBuffers(vk::TimestampQueryRing::c_RingSize + 1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		for (uint32_t slot = 0; slot < vk::TimestampQueryRing::c_RingSize; slot++) { m_DenoiseCommandBuffers[slot] = m_CommandPool.GetBuffer(slot); }
+		m_RandomTasksCmdBuf = m_CommandPool.GetBuffer(vk::TimestampQueryRing::c_RingSize);
+
+		CreatePipelineLayout(device);
+
+		InitSpecializationConstants();
+
+		CreatePipelines(device);
+
+		for (Image* image : { &m_HistoryImage, &m_MomentsImage, &m_PrevHistoryImage, &m_PrevMomentsImage, &m_PingImage, &m_PongImage, &m_OutputImage })
+		{
+			CreateImage(device, *image);
+		}
+		ClearHistory(VulkanAPI::GetGraphicsQueue());
+
+		AllocateAndUpdateDescriptorSet(device);
+
+
+		for (uint32_t slot = 0; slot < vk::TimestampQueryRing::c_RingSize; slot++) { RecordDenoiseCommandBuffer(slot); }
+	}
+
+	void HpmDenoiser::Denoise(VkQueue queue)
+	{
+		// Update uniform buffer. The previous camera position validates the reprojected depth
+		vk::FramePacer::UpdateBuffer(m_UniformBuffer, sizeof(UniformData), &m_UniformData, 0);
+		m_UniformData.prevCamPos = m_Camera->GetPos();
+
+		// Denoise
+		const uint32_t slot = m_Timestamps.NextSlot();
+
+		VkSubmitInfo submitInfo;
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = nullptr;
+		submitInfo.waitSemaphoreCount = 0;
+		submitInfo.pWaitSemaphores = nullptr;
+		submitInfo.pWaitDstStageMask = nullptr;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &m_DenoiseCommandBuffers[slot];
+		submitInfo.signalSemaphoreCount = 0;
+		submitInfo.pSignalSemaphores = nullptr;
+
+		vk::FramePacer::Submit(queue, submitInfo, VK_NULL_HANDLE);
+	}
+
+	void HpmDenoiser::Destroy()
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		m_CommandPool.Destroy();
+
+		m_UniformBuffer.Destroy();
+
+		m_Timestamps.Destroy();
+
+		for (Image* image : { &m_HistoryImage, &m_MomentsImage, &m_PrevHistoryImage, &m_PrevMomentsImage, &m_PingImage, &m_PongImage, &m_OutputImage })
+		{
+			DestroyImage(device, *image);
+		}
+
+		for (VkPipeline pipeline : m_AtrousPipelines) { vkDestroyPipeline(device, pipeline, nullptr); }
+		m_AtrousShader.Destroy();
+
+		vkDestroyPipeline(device, m_TemporalPipeline, nullptr);
+		m_TemporalShader.Destroy();
+
+		vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
+	}
+
+	void HpmDenoiser::EvaluateTimestampQueries()
+	{
+		m_Timestamps.Collect();
+	}
+
+	void HpmDenoiser::RenderImGui(const char* name)
+	{
+		ImGui::Begin(name);
+
+		m_Timestamps.RenderImGui();
+
+		bool temporal = m_UniformData.temporal == 1;
+		ImGui::Checkbox("Temporal", &temporal);
+		m_UniformData.temporal = temporal ? 1 : 0;
+
+		ImGui::DragFloat("Max history", &m_UniformData.maxHistory, 1.0f, 1.0f, 256.0f);
+		ImGui::DragFloat("Depth tolerance", &m_UniformData.depthTolerance, 0.01f, 0.0f, 1.0f);
+		ImGui::DragFloat("Sigma luminance", &m_UniformData.sigmaLuminance, 0.1f, 0.0f, 64.0f);
+		ImGui::DragFloat("Sigma position", &m_UniformData.sigmaPosition, 0.1f, 0.01f, 64.0f);
+		ImGui::DragFloat("Sigma transmittance", &m_UniformData.sigmaTransmittance, 0.01f, 0.001f, 1.0f);
+
+		ImGui::End();
+	}
+
+	VkImage HpmDenoiser::GetImage() const
+	{
+		return m_OutputImage.image;
+	}
+
+	VkImageView HpmDenoiser::GetImageView() const
+	{
+		return m_OutputImage.view;
+	}
+
+	float HpmDenoiser::GetTimeMS() const
+	{
+		return m_Timestamps.GetLast(m_Timestamps.GetTotalPass());
+	}
+
+	void HpmDenoiser::SetCamera(VkQueue queue, const Camera* camera)
+	{
+		// Set members
+		m_Camera = camera;
+		m_UniformData.prevCamPos = camera->GetPos();
+
+		// History of the old camera is invalid
+		ClearHistory(queue);
+
+		// Rerecord cmd buf
+		for (uint32_t slot = 0; slot < vk::TimestampQueryRing::c_RingSize; slot++) { RecordDenoiseCommandBuffer(slot); }
+	}
+
+	void HpmDenoiser::SetRenderSize(VkQueue queue, uint32_t width, uint32_t height, VkImageView colorImageView, VkImageView guideImageView)
+	{
+		// Frames in flight still use the old resources
+		vk::FramePacer::WaitIdle();
+
+		VkDevice device = VulkanAPI::GetDevice();
+
+		m_RenderWidth = width;
+		m_RenderHeight = height;
+		m_ColorImageView = colorImageView;
+		m_GuideImageView = guideImageView;
+
+		// The render size is baked into the pipelines as specialization constant
+		for (VkPipeline pipeline : m_AtrousPipelines) { vkDestroyPipeline(device, pipeline, nullptr); }
+		vkDestroyPipeline(device, m_TemporalPipeline, nullptr);
+		CreatePipelines(device);
+
+		for (Image* image : { &m_HistoryImage, &m_MomentsImage, &m_PrevHistoryImage, &m_PrevMomentsImage, &m_PingImage, &m_PongImage, &m_OutputImage })
+		{
+			DestroyImage(device, *image);
+			CreateImage(device, *image);
+		}
+		ClearHistory(queue);
+
+		UpdateDescriptorSet(device);
+
+		for (uint32_t slot = 0; slot < vk::TimestampQueryRing::c_RingSize; slot++) { RecordDenoiseCommandBuffer(slot); }
+	}
+
+	void HpmDenoiser::CreatePipelineLayout(VkDevice device)
+	{
+		std::vector<VkDescriptorSetLayout> layouts = {
+			Camera::GetDescriptorSetLayout(),
+			s_DescSetLayout };
+
+		VkPipelineLayoutCreateInfo layoutCreateInfo;
+		layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutCreateInfo.pNext = nullptr;
+		layoutCreateInfo.flags = 0;
+		layoutCreateInfo.setLayoutCount = layouts.size();
+		layoutCreateInfo.pSetLayouts = layouts.data();
+		layoutCreateInfo.pushConstantRangeCount = 0;
+		layoutCreateInfo.pPushConstantRanges = nullptr;
+
+		VkResult result = vkCreatePipelineLayout(device, &layoutCreateInfo, nullptr, &m_PipelineLayout);
+		ASSERT_VULKAN(result);
+	}
+
+	void HpmDenoiser::InitSpecializationConstants()
+	{
+		uint32_t mapEntryIndex = 0;
+
+		VkSpecializationMapEntry renderWidthEntry;
+		renderWidthEntry.constantID = mapEntryIndex++;
+		renderWidthEntry.offset = offsetof(SpecializationData, SpecializationData::renderWidth);
+		renderWidthEntry.size = sizeof(uint32_t);
+
+		VkSpecializationMapEntry renderHeightEntry;
+		renderHeightEntry.constantID = mapEntryIndex++;
+		renderHeightEntry.offset = offsetof(SpecializationData, SpecializationData::renderHeight);
+		renderHeightEntry.size = sizeof(uint32_t);
+
+		VkSpecializationMapEntry atrousStepSizeEntry;
+		atrousStepSizeEntry.constantID = mapEntryIndex++;
+		atrousStepSizeEntry.offset = offsetof(SpecializationData, SpecializationData::atrousStepSize);
+		atrousStepSizeEntry.size = sizeof(uint32_t);
+
+		VkSpecializationMapEntry atrousReadPingEntry;
+		atrousReadPingEntry.constantID = mapEntryIndex++;
+		atrousReadPingEntry.offset = offsetof(SpecializationData, SpecializationData::atrousReadPing);
+		atrousReadPingEntry.size = sizeof(uint32_t);
+
+		VkSpecializationMapEntry atrousFeedbackEntry;
+		atrousFeedbackEntry.constantID = mapEntryIndex++;
+		atrousFeedbackEntry.offset = offsetof(SpecializationData, SpecializationData::atrousFeedback);
+		atrousFeedbackEntry.size = sizeof(uint32_t);
+
+		VkSpecializationMapEntry atrousLastEntry;
+		atrousLastEntry.constantID = mapEntryIndex++;
+		atrousLastEntry.offset = offsetof(SpecializationData, SpecializationData::atrousLast);
+		atrousLastEntry.size = sizeof(uint32_t);
+
+		m_SpecMapEntries = {
+			renderWidthEntry,
+			renderHeightEntry,
+			atrousStepSizeEntry,
+			atrousReadPingEntry,
+			atrousFeedbackEntry,
+			atrousLastEntry
+		};
+	}
+
+	VkPipeline HpmDenoiser::CreatePipeline(VkDevice device, const vk::Shader& shader, const SpecializationData& specData)
+	{
+		VkSpecializationInfo specInfo;
+		specInfo.mapEntryCount = m_SpecMapEntries.size();
+		specInfo.pMapEntries = m_SpecMapEntries.data();
+		specInfo.dataSize = sizeof(SpecializationData);
+		specInfo.pData = &specData;
+
+		VkPipelineShaderStageCreateInfo shaderStage;
+		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStage.pNext = nullptr;
+		shaderStage.flags = 0;
+		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		shaderStage.module = shader.GetVulkanModule();
+		shaderStage.pName = "main";
+		shaderStage.pSpecializationInfo = &specInfo;
+
+		VkComputePipelineCreateInfo pipelineCI;
+		pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineCI.pNext = nullptr;
+		pipelineCI.flags = 0;
+		pipelineCI.stage = shaderStage;
+		pipelineCI.layout = m_PipelineLayout;
+		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineCI.basePipelineIndex = 0;
+
+		VkPipeline pipeline;
+		VkResult result = VulkanAPI::CreateComputePipeline(pipelineCI, &pipeline);
+		ASSERT_VULKAN(result);
+
+		return pipeline;
+	}
+
+	void HpmDenoiser::CreatePipelines(VkDevice device)
+	{
+		SpecializationData specData;
+		specData.renderWidth = m_RenderWidth;
+		specData.renderHeight = m_RenderHeight;
+		specData.atrousStepSize = 1;
+		specData.atrousReadPing = VK_TRUE;
+		specData.atrousFeedback = VK_FALSE;
+		specData.atrousLast = VK_FALSE;
+
+		m_TemporalPipeline = CreatePipeline(device, m_TemporalShader, specData);
+
+		// The temporal pass writes ping, so even iterations read ping. The first iteration feeds the history.
+		for (uint32_t i = 0; i < c_AtrousIterationCount; i++)
+		{
+			specData.atrousStepSize = 1 << i;
+			specData.atrousReadPing = i % 2 == 0 ? VK_TRUE : VK_FALSE;
+			specData.atrousFeedback = i == 0 ? VK_TRUE : VK_FALSE;
+			specData.atrousLast = i == c_AtrousIterationCount - 1 ? VK_TRUE : VK_FALSE;
+			m_AtrousPipelines[i] = CreatePipeline(device, m_AtrousShader, specData);
+		}
+	}
+
+	void HpmDenoiser::CreateImage(VkDevice device, Image& image)
+	{
+		VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT;
+
+		// Create Image
+		VkImageCreateInfo imageCI;
+		imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageCI.pNext = nullptr;
+		imageCI.flags = 0;
+		imageCI.imageType = VK_IMAGE_TYPE_2D;
+		imageCI.format = format;
+		imageCI.extent = { m_RenderWidth, m_RenderHeight, 1 };
+		imageCI.mipLevels = 1;
+		imageCI.arrayLayers = 1;
+		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageCI.queueFamilyIndexCount = 0;
+		imageCI.pQueueFamilyIndices = nullptr;
+		imageCI.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+
+		VkResult result = vkCreateImage(device, &imageCI, nullptr, &image.image);
+		ASSERT_VULKAN(result);
+
+		// Image Memory
+		image.memory = vk::MemoryAllocator::AllocateImage(image.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		// Create image view
+		VkImageViewCreateInfo imageViewCI;
+		imageViewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		imageViewCI.pNext = nullptr;
+		imageViewCI.flags = 0;
+		imageViewCI.image = image.image;
+		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		imageViewCI.format = format;
+		imageViewCI.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageViewCI.subresourceRange.baseMipLevel = 0;
+		imageViewCI.subresourceRange.levelCount = 1;
+		imageViewCI.subresourceRange.baseArrayLayer = 0;
+		imageViewCI.subresourceRange.layerCount = 1;
+
+		result = vkCreateImageView(device, &imageViewCI, nullptr, &image.view);
+		ASSERT_VULKAN(result);
+
+		// Change image layout
+		VkCommandBufferBeginInfo beginInfo;
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.pNext = nullptr;
+		beginInfo.flags = 0;
+		beginInfo.pInheritanceInfo = nullptr;
+
+		result = vkBeginCommandBuffer(m_RandomTasksCmdBuf, &beginInfo);
+		ASSERT_VULKAN(result);
+
+		vk::CommandRecorder::ImageLayoutTransfer(
+			m_RandomTasksCmdBuf,
+			image.image,
+			VK_IMAGE_LAYOUT_PREINITIALIZED,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_ACCESS_NONE,
+			VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+		result = vkEndCommandBuffer(m_RandomTasksCmdBuf);
+		ASSERT_VULKAN(result);
+
+		VkSubmitInfo submitInfo;
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = nullptr;
+		submitInfo.waitSemaphoreCount = 0;
+		submitInfo.pWaitSemaphores = nullptr;
+		submitInfo.pWaitDstStageMask = nullptr;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &m_RandomTasksCmdBuf;
+		submitInfo.signalSemaphoreCount = 0;
+		submitInfo.pSignalSemaphores = nullptr;
+
+		VkQueue queue = VulkanAPI::GetGraphicsQueue();
+		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		ASSERT_VULKAN(result);
+		result = vkQueueWaitIdle(queue);
+		ASSERT_VULKAN(result);
+	}
+
+	void HpmDenoiser::DestroyImage(VkDevice device, Image& image)
+	{
+		vkDestroyImageView(device, image.view, nullptr);
+		vk::MemoryAllocator::Free(image.memory);
+		vkDestroyImage(device, image.image, nullptr);
+	}
+
+	void HpmDenoiser::ClearHistory(VkQueue queue)
+	{
+		VkCommandBufferBeginInfo beginInfo;
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.pNext = nullptr;
+		beginInfo.flags = 0;
+		beginInfo.pInheritanceInfo = nullptr;
+		ASSERT_VULKAN(vkBeginCommandBuffer(m_RandomTasksCmdBuf, &beginInfo));
+
+		// History length 0 marks the history as invalid
+		VkClearColorValue clearColor = { 0.0f, 0.0f, 0.0f, 0.0f };
+		VkImageSubresourceRange subresourceRange;
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = 1;
+		subresourceRange.baseArrayLayer = 0;
+		subresourceRange.layerCount = 1;
+		vkCmdClearColorImage(m_RandomTasksCmdBuf, m_HistoryImage.image, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
+		vkCmdClearColorImage(m_RandomTasksCmdBuf, m_MomentsImage.image, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
+
+		ASSERT_VULKAN(vkEndCommandBuffer(m_RandomTasksCmdBuf));
+
+		VkSubmitInfo submitInfo;
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = nullptr;
+		submitInfo.waitSemaphoreCount = 0;
+		submitInfo.pWaitSemaphores = nullptr;
+		submitInfo.pWaitDstStageMask = nullptr;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &m_RandomTasksCmdBuf;
+		submitInfo.signalSemaphoreCount = 0;
+		submitInfo.pSignalSemaphores = nullptr;
+		ASSERT_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
+		ASSERT_VULKAN(vkQueueWaitIdle(queue));
+	}
+
+	void HpmDenoiser::AllocateAndUpdateDescriptorSet(VkDevice device)
+	{
+		// Allocate
+		VkDescriptorSetAllocateInfo descSetAI;
+		descSetAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descSetAI.pNext = nullptr;
+		descSetAI.descriptorPool = s_DescPool;
+		descSetAI.descriptorSetCount = 1;
+		descSetAI.pSetLayouts = &s_DescSetLayout;
+
+		VkResult result = vkAllocateDescriptorSets(device, &descSetAI, &m_DescSet);
+		ASSERT_VULKAN(result);
+
+		UpdateDescriptorSet(device);
+	}
+
+	void HpmDenoiser::UpdateDescriptorSet(VkDevice device)
+	{
+		// Storage image writes in binding order
+		const std::array<VkImageView, c_StorageImageCount> storageImageViews = {
+			m_ColorImageView,
+			m_GuideImageView,
+			m_HistoryImage.view,
+			m_MomentsImage.view,
+			m_PrevHistoryImage.view,
+			m_PrevMomentsImage.view,
+			m_PingImage.view,
+			m_PongImage.view,
+			m_OutputImage.view
+		};
+
+		std::array<VkDescriptorImageInfo, c_StorageImageCount> storageImageInfos;
+		std::vector<VkWriteDescriptorSet> writes;
+		for (uint32_t i = 0; i < c_StorageImageCount; i++)
+		{
+			storageImageInfos[i].sampler = VK_NULL_HANDLE;
+			storageImageInfos[i].imageView = storageImageViews[i];
+			storageImageInfos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			VkWriteDescriptorSet storageImageWrite;
+			storageImageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			storageImageWrite.pNext = nullptr;
+			storageImageWrite.dstSet = m_DescSet;
+			storageImageWrite.dstBinding = i;
+			storageImageWrite.dstArrayElement = 0;
+			storageImageWrite.descriptorCount = 1;
+			storageImageWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			storageImageWrite.pImageInfo = &storageImageInfos[i];
+			storageImageWrite.pBufferInfo = nullptr;
+			storageImageWrite.pTexelBufferView = nullptr;
+			writes.push_back(storageImageWrite);
+		}
+
+		// Uniform buffer write
+		VkDescriptorBufferInfo uniformBufferInfo;
+		uniformBufferInfo.buffer = m_UniformBuffer.GetVulkanHandle();
+		uniformBufferInfo.offset = 0;
+		uniformBufferInfo.range = sizeof(UniformData);
+
+		VkWriteDescriptorSet uniformBufferWrite;
+		uniformBufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		uniformBufferWrite.pNext = nullptr;
+		uniformBufferWrite.dstSet = m_DescSet;
+		uniformBufferWrite.dstBinding = c_StorageImageCount;
+		uniformBufferWrite.dstArrayElement = 0;
+		uniformBufferWrite.descriptorCount = 1;
+		uniformBufferWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uniformBufferWrite.pImageInfo = nullptr;
+		uniformBufferWrite.pBufferInfo = &uniformBufferInfo;
+		uniformBufferWrite.pTexelBufferView = nullptr;
+		writes.push_back(uniformBufferWrite);
+
+		vkUpdateDescriptorSets(device, writes.size(), writes.data(), 0, nullptr);
+	}
+
+	void HpmDenoiser::RecordDenoiseCommandBuffer(uint32_t slot)
+	{
+		VkCommandBuffer commandBuffer = m_DenoiseCommandBuffers[slot];
+
+		// Begin command buffer
+		VkCommandBufferBeginInfo beginInfo;
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.pNext = nullptr;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		beginInfo.pInheritanceInfo = nullptr;
+
+		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		ASSERT_VULKAN(result);
+
+		// Reset query pool
+		m_Timestamps.CmdReset(commandBuffer, slot);
+
+		// Bind descriptor sets
+		std::vector<VkDescriptorSet> descSets = { m_Camera->GetDescriptorSet(), m_DescSet };
+		vkCmdBindDescriptorSets(
+			commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout,
+			0, descSets.size(), descSets.data(),
+			0, nullptr);
+
+		// Renderer output and last denoise must be written before the history is copied
+		VkMemoryBarrier shaderWriteBarrier;
+		shaderWriteBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		shaderWriteBarrier.pNext = nullptr;
+		shaderWriteBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		shaderWriteBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1, &shaderWriteBarrier,
+			0, nullptr,
+			0, nullptr);
+
+		// Timestamp
+		m_Timestamps.CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, slot, 0);
+
+		// Copy history, the temporal pass reads reprojected neighbors of it while writing the new one
+		VkImageCopy imageCopy;
+		imageCopy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageCopy.srcSubresource.mipLevel = 0;
+		imageCopy.srcSubresource.baseArrayLayer = 0;
+		imageCopy.srcSubresource.layerCount = 1;
+		imageCopy.srcOffset = { 0, 0, 0 };
+		imageCopy.dstSubresource = imageCopy.srcSubresource;
+		imageCopy.dstOffset = { 0, 0, 0 };
+		imageCopy.extent = { m_RenderWidth, m_RenderHeight, 1 };
+		vkCmdCopyImage(
+			commandBuffer,
+			m_HistoryImage.image, VK_IMAGE_LAYOUT_GENERAL,
+			m_PrevHistoryImage.image, VK_IMAGE_LAYOUT_GENERAL,
+			1, &imageCopy);
+		vkCmdCopyImage(
+			commandBuffer,
+			m_MomentsImage.image, VK_IMAGE_LAYOUT_GENERAL,
+			m_PrevMomentsImage.image, VK_IMAGE_LAYOUT_GENERAL,
+			1, &imageCopy);
+
+		VkMemoryBarrier copyBarrier;
+		copyBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		copyBarrier.pNext = nullptr;
+		copyBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+		copyBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1, &copyBarrier,
+			0, nullptr,
+			0, nullptr);
+
+		// Passes
+		VkMemoryBarrier passBarrier;
+		passBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		passBarrier.pNext = nullptr;
+		passBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		passBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		std::vector<VkPipeline> pipelines = { m_TemporalPipeline };
+		pipelines.insert(pipelines.end(), m_AtrousPipelines.begin(), m_AtrousPipelines.end());
+		for (size_t i = 0; i < pipelines.size(); i++)
+		{
+			if (i > 0)
+			{
+				vkCmdPipelineBarrier(
+					commandBuffer,
+					VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					0,
+					1, &passBarrier,
+					0, nullptr,
+					0, nullptr);
+			}
+
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines[i]);
+			vkCmdDispatch(commandBuffer, m_RenderWidth / 32, m_RenderHeight, 1);
+		}
+
+		// Timestamp
+		m_Timestamps.CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, slot, 1);
+
+		// End command buffer
+		result = vkEndCommandBuffer(commandBuffer);
+		ASSERT_VULKAN(result);
+	}
+}
@@ -1,5 +1,6 @@
 #include <engine/HpmScene.hpp>
 #include <engine/util/read_file.hpp>
+#include <engine/util/EnvMapDistribution.hpp>
 
 namespace en
 {
@@ -22,7 +23,9 @@ namespace en
 
 	HpmScene::HpmScene(const AppConfig& appConfig) :
 		m_ID(appConfig.scene.id),
-		m_Dynamic(appConfig.scene.dynamic)
+		m_Dynamic(appConfig.scene.dynamic),
+		m_DirLightTransmittanceCache(appConfig.scene.dirLightTransmittanceCache),
+		m_PointLightTransmittanceCache(appConfig.scene.pointLightTransmittanceCache)
 	{
 		// Lighting
 		m_DirLight = new DirLight(-1.57f, 0.0f, glm::vec3(1.0f), appConfig.scene.dirLightStrength);
@@ -31,18 +34,72 @@ namespace en
 
 		int hdrWidth, hdrHeight;
 		std::vector<float> hdr4fData = en::ReadFileHdr4f(appConfig.scene.hdrEnvMapPath, hdrWidth, hdrHeight, 10000.0f);
-		std::array<std::vector<float>, 2> hdrCdf = en::Hdr4fToCdf(hdr4fData, hdrWidth, hdrHeight);
+		const EnvMapDistribution hdrDistribution(hdr4fData, hdrWidth, hdrHeight);
 		m_HdrEnvMap = new HdrEnvMap(
 			appConfig.scene.hdrEnvMapStrength,
 			hdrWidth,
 			hdrHeight,
 			hdr4fData,
-			hdrCdf[0],
-			hdrCdf[1]);
+			hdrDistribution.GetCdfX(),
+			hdrDistribution.GetCdfY());
 
 		// Load data
-		m_Density3DTex = new vk::Texture3D(vk::Texture3D::FromVDB("data/volume/wdas_cloud_quarter.vdb"));
-		m_VolumeData = new VolumeData(m_Density3DTex, appConfig.scene.density, 0.8f);
+		const std::vector<std::vector<std::vector<float>>> densityData = vk::Texture3D::LoadVDB("data/volume/wdas_cloud_quarter.vdb");
+		m_Density3DTex = new vk::Texture3D(
+			densityData,
+			VK_FILTER_NEAREST,
+			VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
+			VK_BORDER_COLOR_INT_OPAQUE_BLACK);
+		m_VolumeData = new VolumeData(
+			m_Density3DTex,
+			densityData,
+			appConfig.scene.density,
+			0.8f,
+			appConfig.scene.residualRatioTracking,
+			appConfig.scene.emptySpaceSkipping);
+
+		// Light transmittance caches. Without a cache a constant texture keeps the descriptor valid
+		if (m_DirLightTransmittanceCache || m_PointLightTransmittanceCache)
+		{
+			// Voxel size of the volume extent the renderers use (normalized extent * 107.5)
+			const glm::vec3 densitySize(densityData.size(), densityData[0].size(), densityData[0][0].size());
+			const float voxelSize = 107.5f / glm::length(densitySize);
+			m_TransmittanceGrid = new TransmittanceGrid(densityData, appConfig.scene.density, voxelSize);
+		}
+
+		if (m_DirLightTransmittanceCache)
+		{
+			const glm::vec3 dir = m_DirLight->GetDir();
+			m_DirLightTransmittanceBuilder = new TransmittanceCacheBuilder(dir);
+			m_DirLightTransmittanceTex = new vk::Texture3D(
+				m_TransmittanceGrid->Build(-dir),
+				VK_FILTER_LINEAR,
+				VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+				VK_BORDER_COLOR_INT_OPAQUE_BLACK);
+		}
+		else
+		{
+			m_DirLightTransmittanceTex = CreateConstantTransmittanceTex();
+		}
+		m_DirLight->SetTransmittanceTex(m_DirLightTransmittanceTex);
+
+		if (m_PointLightTransmittanceCache)
+		{
+			const glm::vec3 pos = m_PointLight->GetPos();
+			const float radius = m_TransmittanceGrid->GetMaxRadius(pos);
+			m_PointLightTransmittanceBuilder = new TransmittanceCacheBuilder(pos);
+			m_PointLightTransmittanceTex = new vk::Texture3D(
+				m_TransmittanceGrid->BuildRadial(pos, radius),
+				VK_FILTER_LINEAR,
+				VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+				VK_BORDER_COLOR_INT_OPAQUE_BLACK);
+			m_PointLight->SetTransmittanceOrigin(pos, radius);
+		}
+		else
+		{
+			m_PointLightTransmittanceTex = CreateConstantTransmittanceTex();
+		}
+		m_PointLight->SetTransmittanceTex(m_PointLightTransmittanceTex);
 
 		// Store desc sets
 		m_DescSets = {
@@ -62,21 +119,37 @@ namespace en
 			m_PointLight->RenderImGui();
 		}
 
-		if (!m_Dynamic) { return; }
-		switch (m_ID)
+		if (m_Dynamic)
 		{
-		case 3:
-			m_DirLight->SetAzimuth(std::fmod(m_DirLight->GetAzimuth() + (deltaTime * 0.5f), 2.0f * 3.141));
-			break;
-		case 4:
-			break;
-		default:
-			break;
+			switch (m_ID)
+			{
+			case 3:
+				m_DirLight->SetAzimuth(std::fmod(m_DirLight->GetAzimuth() + (deltaTime * 0.5f), 2.0f * 3.141));
+				break;
+			case 4:
+				break;
+			default:
+				break;
+			}
 		}
+
+		// The imgui controls move the lights in static scenes too
+		UpdateDirLightTransmittance();
+		UpdatePointLightTransmittance();
 	}
 
 	void HpmScene::Destroy()
 	{
+		delete m_DirLightTransmittanceBuilder;
+		delete m_PointLightTransmittanceBuilder;
+		delete m_TransmittanceGrid;
+
+		m_PointLightTransmittanceTex->Destroy();
+		delete m_PointLightTransmittanceTex;
+
+		m_DirLightTransmittanceTex->Destroy();
+		delete m_DirLightTransmittanceTex;
+
 		m_VolumeData->Destroy();
 		delete m_VolumeData;
 
@@ -112,4 +185,57 @@ namespace en
 	{
 		return m_HdrEnvMap;
 	}
+
+	bool HpmScene::UsesDirLightTransmittanceCache() const
+	{
+		return m_DirLightTransmittanceCache;
+	}
+
+	bool HpmScene::UsesPointLightTransmittanceCache() const
+	{
+		return m_PointLightTransmittanceCache;
+	}
+
+	vk::Texture3D* HpmScene::CreateConstantTransmittanceTex()
+	{
+		return new vk::Texture3D(
+			std::vector<std::vector<std::vector<float>>>(1, std::vector<std::vector<float>>(1, std::vector<float>(1, 1.0f))),
+			VK_FILTER_NEAREST,
+			VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+			VK_BORDER_COLOR_INT_OPAQUE_BLACK);
+	}
+
+	void HpmScene::UpdateDirLightTransmittance()
+	{
+		if (!m_DirLightTransmittanceCache) { return; }
+
+		// Shading keeps using the previous grid until the build for the new direction is done
+		TransmittanceCacheBuilder::Grid grid;
+		glm::vec3 dir;
+		const bool finished = m_DirLightTransmittanceBuilder->Update(
+			m_DirLight->GetDir(),
+			[this](const glm::vec3& buildDir) { return m_TransmittanceGrid->Build(-buildDir); },
+			grid,
+			dir);
+		if (finished) { m_DirLightTransmittanceTex->SetData(grid); }
+	}
+
+	void HpmScene::UpdatePointLightTransmittance()
+	{
+		if (!m_PointLightTransmittanceCache) { return; }
+
+		// The cache origin only moves together with the new data, so shading stays consistent while building
+		TransmittanceCacheBuilder::Grid grid;
+		glm::vec3 pos;
+		const bool finished = m_PointLightTransmittanceBuilder->Update(
+			m_PointLight->GetPos(),
+			[this](const glm::vec3& buildPos) { return m_TransmittanceGrid->BuildRadial(buildPos, m_TransmittanceGrid->GetMaxRadius(buildPos)); },
+			grid,
+			pos);
+		if (finished)
+		{
+			m_PointLightTransmittanceTex->SetData(grid);
+			m_PointLight->SetTransmittanceOrigin(pos, m_TransmittanceGrid->GetMaxRadius(pos));
+		}
+	}
 }
@@ -1,5 +1,7 @@
 #include <engine/graphics/renderer/ImGuiRenderer.hpp>
 #include <engine/graphics/VulkanAPI.hpp>
+#include <engine/graphics/vulkan/ShaderCompiler.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
 #include <engine/graphics/Window.hpp>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_vulkan.h>
@@ -27,12 +29,12 @@ namespace en
 
 	VkFormat ImGuiRenderer::m_Format;
 	VkImage ImGuiRenderer::m_Image;
-	VkDeviceMemory ImGuiRenderer::m_ImageMemory;
+	vk::MemoryAllocator::Allocation ImGuiRenderer::m_ImageMemory;
 	VkImageView ImGuiRenderer::m_ImageView;
 
 	VkFramebuffer ImGuiRenderer::m_Framebuffer;
 	vk::CommandPool* ImGuiRenderer::m_CommandPool;
-	VkCommandBuffer ImGuiRenderer::m_CommandBuffer;
+	std::array<VkCommandBuffer, vk::FramePacer::c_MaxFramesInFlight> ImGuiRenderer::m_CommandBuffers;
 
 	void ImGuiRenderer::Init(uint32_t width, uint32_t height)
 	{
@@ -48,6 +50,7 @@ namespace en
 		CreateSampler(device);
 		CreateDescriptorSet(device);
 		CreateRenderPass(device);
+		vk::ShaderCompiler::Precompile({ "draw_tex2D/draw_tex2D.vert", "draw_tex2D/draw_tex2D.frag" });
 		m_VertShader = new vk::Shader("draw_tex2D/draw_tex2D.vert", false);
 		m_FragShader = new vk::Shader("draw_tex2D/draw_tex2D.frag", false);
 		CreatePipelineLayout(device);
@@ -75,7 +78,7 @@ namespace en
 		vkDestroyFramebuffer(device, m_Framebuffer, nullptr);
 
 		vkDestroyImageView(device, m_ImageView, nullptr);
-		vkFreeMemory(device, m_ImageMemory, nullptr);
+		vk::MemoryAllocator::Free(m_ImageMemory);
 		vkDestroyImage(device, m_Image, nullptr);
 
 		vkDestroyPipeline(device, m_Pipeline, nullptr);
@@ -102,7 +105,7 @@ namespace en
 		// Destroy
 		vkDestroyFramebuffer(device, m_Framebuffer, nullptr);
 		vkDestroyImageView(device, m_ImageView, nullptr);
-		vkFreeMemory(device, m_ImageMemory, nullptr);
+		vk::MemoryAllocator::Free(m_ImageMemory);
 		vkDestroyImage(device, m_Image, nullptr);
 
 		// Create
@@ -123,6 +126,9 @@ namespace en
 		ImGui::Render();
 		ImDrawData* drawData = ImGui::GetDrawData();
 
+		// Each frame in flight records into its own command buffer
+		VkCommandBuffer commandBuffer = m_CommandBuffers[vk::FramePacer::GetFrameSlot()];
+
 		// Begin command buffer
 		VkCommandBufferBeginInfo beginInfo;
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -130,7 +136,7 @@ namespace en
 		beginInfo.flags = 0;
 		beginInfo.pInheritanceInfo = nullptr;
 
-		VkResult result = vkBeginCommandBuffer(m_CommandBuffer, &beginInfo);
+		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
 		ASSERT_VULKAN(result);
 
 		// Begin renderPass
@@ -146,10 +152,10 @@ namespace en
 		renderPassBeginInfo.clearValueCount = 1;
 		renderPassBeginInfo.pClearValues = &clearValue;
 
-		vkCmdBeginRenderPass(m_CommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 		// Bind pipeline
-		vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
 
 		// Viewport
 		VkViewport viewport;
@@ -160,27 +166,27 @@ namespace en
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
 
-		vkCmdSetViewport(m_CommandBuffer, 0, 1, &viewport);
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
 		// Scissor
 		VkRect2D scissor;
 		scissor.offset = { 0, 0 };
 		scissor.extent = { m_Width, m_Height };
 
-		vkCmdSetScissor(m_CommandBuffer, 0, 1, &scissor);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
 		// Draw brackground image
-		vkCmdBindDescriptorSets(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_DescriptorSet, 0, nullptr);
-		vkCmdDraw(m_CommandBuffer, 6, 1, 0, 0);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_DescriptorSet, 0, nullptr);
+		vkCmdDraw(commandBuffer, 6, 1, 0, 0);
 
 		// Vulkan render
-		ImGui_ImplVulkan_RenderDrawData(drawData, m_CommandBuffer);
+		ImGui_ImplVulkan_RenderDrawData(drawData, commandBuffer);
 
 		// End renderPass
-		vkCmdEndRenderPass(m_CommandBuffer);
+		vkCmdEndRenderPass(commandBuffer);
 
 		// End command buffer
-		result = vkEndCommandBuffer(m_CommandBuffer);
+		result = vkEndCommandBuffer(commandBuffer);
 		ASSERT_VULKAN(result);
 
 		// Submit
@@ -202,12 +208,11 @@ namespace en
 			submitInfo.pWaitDstStageMask = &waitStage;
 		}
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_CommandBuffer;
+		submitInfo.pCommandBuffers = &commandBuffer;
 		submitInfo.signalSemaphoreCount = 0;
 		submitInfo.pSignalSemaphores = nullptr;
 
-		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		ASSERT_VULKAN(result);
+		vk::FramePacer::Submit(queue, submitInfo, VK_NULL_HANDLE);
 	}
 
 	bool ImGuiRenderer::IsInitialized()
@@ -222,6 +227,9 @@ namespace en
 
 	void ImGuiRenderer::SetBackgroundImageView(VkImageView backgroundImageView)
 	{
+		// The descriptor set must not be in use by a frame in flight while it is updated
+		vk::FramePacer::WaitIdle();
+
 		m_BackgroundImageView = backgroundImageView;
 
 		VkDescriptorImageInfo imageInfo;
@@ -580,7 +588,7 @@ namespace en
 		createInfo.basePipelineHandle = VK_NULL_HANDLE;
 		createInfo.basePipelineIndex = -1;
 
-		VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &m_Pipeline);
+		VkResult result = VulkanAPI::CreateGraphicsPipeline(createInfo, &m_Pipeline);
 		ASSERT_VULKAN(result);
 	}
 
@@ -608,22 +616,7 @@ namespace en
 		ASSERT_VULKAN(result);
 
 		// Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_Image, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_ImageMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_Image, m_ImageMemory, 0);
-		ASSERT_VULKAN(result);
+		m_ImageMemory = vk::MemoryAllocator::AllocateImage(m_Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Create image view
 		VkImageViewCreateInfo imageViewCreateInfo;
@@ -667,8 +660,8 @@ namespace en
 	void ImGuiRenderer::CreateCommandPoolAndBuffer()
 	{
 		m_CommandPool = new vk::CommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, VulkanAPI::GetGraphicsQFI());
-		m_CommandPool->AllocateBuffers(1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-		m_CommandBuffer = m_CommandPool->GetBuffer(0);
+		m_CommandPool->AllocateBuffers(vk::FramePacer::c_MaxFramesInFlight, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		for (uint32_t i = 0; i < vk::FramePacer::c_MaxFramesInFlight; i++) { m_CommandBuffers[i] = m_CommandPool->GetBuffer(i); }
 	}
 
 	void CheckVkResult(VkResult result)
@@ -680,7 +673,7 @@ namespace en
 	{
 		uint32_t qfi = VulkanAPI::GetGraphicsQFI();
 		VkQueue queue = VulkanAPI::GetGraphicsQueue();
-		uint32_t imageCount = 2; // Not correct but working
+		uint32_t imageCount = vk::FramePacer::c_MaxFramesInFlight; // ImGui keeps one vertex and index buffer per frame in flight
 
 		// Init imgui backend
 		IMGUI_CHECKVERSION();
@@ -0,0 +1,318 @@
+#include <engine/util/ImageCompare.hpp>
+#include <engine/util/Log.hpp>
+#include <tinyexr.h>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+
+namespace en
+{
+	struct KahanSum
+	{
+		double sum = 0.0;
+		double c = 0.0;
+
+		void Add(double value)
+		{
+			const double y = value - c;
+			const double t = sum + y;
+			c = (t - sum) - y;
+			sum = t;
+		}
+
+		double Get() const
+		{
+			return sum - c;
+		}
+	};
+
+	struct ImageCompare::TileSums
+	{
+		KahanSum errSq;
+		KahanSum relErrSq;
+		KahanSum smape;
+		KahanSum ssim;
+		std::array<KahanSum, 3> ref;
+		std::array<KahanSum, 3> own;
+		std::array<KahanSum, 3> ownSq;
+		uint32_t validPixelCount = 0;
+		uint32_t ssimWindowCount = 0;
+	};
+
+	// Reduces values[begin, end) as a balanced binary tree so the result only depends on the tile count
+	static double PairwiseSum(const std::vector<double>& values, size_t begin, size_t end)
+	{
+		if (end - begin == 0) { return 0.0; }
+		if (end - begin == 1) { return values[begin]; }
+		const size_t mid = begin + (end - begin) / 2;
+		return PairwiseSum(values, begin, mid) + PairwiseSum(values, mid, end);
+	}
+
+	static double Luminance(const float* rgba)
+	{
+		return 0.2126 * rgba[0] + 0.7152 * rgba[1] + 0.0722 * rgba[2];
+	}
+
+	float ImageCompare::Result::GetRefMean() const
+	{
+		return static_cast<float>((refMean[0] + refMean[1] + refMean[2]) / 3.0);
+	}
+
+	float ImageCompare::Result::GetOwnMean() const
+	{
+		return static_cast<float>((ownMean[0] + ownMean[1] + ownMean[2]) / 3.0);
+	}
+
+	float ImageCompare::Result::GetOwnVar() const
+	{
+		return static_cast<float>((ownVar[0] + ownVar[1] + ownVar[2]) / 3.0);
+	}
+
+	float ImageCompare::Result::GetBias() const
+	{
+		return GetOwnMean() - GetRefMean();
+	}
+
+	float ImageCompare::Result::GetRelBias() const
+	{
+		return GetBias() / GetRefMean();
+	}
+
+	float ImageCompare::Result::GetRelVar() const
+	{
+		return GetOwnVar() / GetRefMean();
+	}
+
+	float ImageCompare::Result::GetCV() const
+	{
+		return std::sqrt(GetOwnVar()) / GetOwnMean();
+	}
+
+	uint32_t ImageCompare::s_ThreadCount = 0;
+
+	ImageCompare::Result ImageCompare::Compare(
+		const float* ref,
+		const float* own,
+		uint32_t width,
+		uint32_t height,
+		const float* refError,
+		float maxRefError)
+	{
+		const uint32_t tileCount = (height + c_TileHeight - 1) / c_TileHeight;
+		std::vector<TileSums> tiles(tileCount);
+
+		// Tiles are pulled from a shared counter but each writes only its own slot
+		uint32_t threadCount = s_ThreadCount == 0 ? std::thread::hardware_concurrency() : s_ThreadCount;
+		threadCount = std::max(1u, std::min(threadCount, tileCount));
+
+		std::atomic<uint32_t> nextTile = 0;
+		auto worker = [&]()
+		{
+			for (uint32_t tile = nextTile++; tile < tileCount; tile = nextTile++)
+			{
+				AccumulateTile(ref, own, refError, maxRefError, width, height, tile, tiles[tile]);
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (uint32_t i = 1; i < threadCount; i++) { threads.emplace_back(worker); }
+		worker();
+		for (std::thread& thread : threads) { thread.join(); }
+
+		// Reduce
+		Result result = {};
+		for (const TileSums& tile : tiles)
+		{
+			result.validPixelCount += tile.validPixelCount;
+		}
+
+		uint32_t ssimWindowCount = 0;
+		for (const TileSums& tile : tiles)
+		{
+			ssimWindowCount += tile.ssimWindowCount;
+		}
+
+		if (result.validPixelCount == 0)
+		{
+			Log::Warn("ImageCompare found no valid pixels");
+			return result;
+		}
+
+		std::vector<double> values(tileCount);
+		auto reduce = [&](auto get)
+		{
+			for (uint32_t i = 0; i < tileCount; i++) { values[i] = get(tiles[i]); }
+			return PairwiseSum(values, 0, tileCount);
+		};
+
+		const double normFactor = 1.0 / static_cast<double>(result.validPixelCount);
+		const double channelNormFactor = normFactor / 3.0;
+
+		result.mse = channelNormFactor * reduce([](const TileSums& t) { return t.errSq.Get(); });
+		result.relMse = channelNormFactor * reduce([](const TileSums& t) { return t.relErrSq.Get(); });
+		result.smape = channelNormFactor * reduce([](const TileSums& t) { return t.smape.Get(); });
+		if (ssimWindowCount > 0)
+		{
+			result.ssim = reduce([](const TileSums& t) { return t.ssim.Get(); }) / static_cast<double>(ssimWindowCount);
+		}
+
+		for (size_t c = 0; c < 3; c++)
+		{
+			result.refMean[c] = normFactor * reduce([c](const TileSums& t) { return t.ref[c].Get(); });
+			result.ownMean[c] = normFactor * reduce([c](const TileSums& t) { return t.own[c].Get(); });
+			const double ownSqMean = normFactor * reduce([c](const TileSums& t) { return t.ownSq[c].Get(); });
+			result.ownVar[c] = std::max(0.0, ownSqMean - result.ownMean[c] * result.ownMean[c]);
+			result.bias[c] = result.ownMean[c] - result.refMean[c];
+		}
+
+		return result;
+	}
+
+	ImageCompare::Result ImageCompare::CompareExr(const std::string& refPath, const std::string& ownPath)
+	{
+		float* ref = nullptr;
+		int refWidth = -1;
+		int refHeight = -1;
+		if (TINYEXR_SUCCESS != LoadEXR(&ref, &refWidth, &refHeight, refPath.c_str(), nullptr))
+		{
+			Log::Error("TinyEXR failed to load " + refPath, true);
+		}
+
+		float* own = nullptr;
+		int ownWidth = -1;
+		int ownHeight = -1;
+		if (TINYEXR_SUCCESS != LoadEXR(&own, &ownWidth, &ownHeight, ownPath.c_str(), nullptr))
+		{
+			free(ref);
+			Log::Error("TinyEXR failed to load " + ownPath, true);
+		}
+
+		if (refWidth != ownWidth || refHeight != ownHeight)
+		{
+			free(ref);
+			free(own);
+			Log::Error(refPath + " and " + ownPath + " have different resolutions", true);
+		}
+
+		Result result = Compare(ref, own, static_cast<uint32_t>(refWidth), static_cast<uint32_t>(refHeight));
+
+		free(ref);
+		free(own);
+
+		return result;
+	}
+
+	void ImageCompare::SetThreadCount(uint32_t threadCount)
+	{
+		s_ThreadCount = threadCount;
+	}
+
+	void ImageCompare::AccumulateTile(
+		const float* ref,
+		const float* own,
+		const float* refError,
+		float maxRefError,
+		uint32_t width,
+		uint32_t height,
+		uint32_t tileIndex,
+		TileSums& sums)
+	{
+		const uint32_t yStart = tileIndex * c_TileHeight;
+		const uint32_t yEnd = std::min(yStart + c_TileHeight, height);
+
+		// Per pixel metrics. Rows are summed plainly in double and then added to the tile sums with kahan summation
+		for (uint32_t y = yStart; y < yEnd; y++)
+		{
+			double errSq = 0.0;
+			double relErrSq = 0.0;
+			double smape = 0.0;
+			std::array<double, 3> refSum = { 0.0, 0.0, 0.0 };
+			std::array<double, 3> ownSum = { 0.0, 0.0, 0.0 };
+			std::array<double, 3> ownSqSum = { 0.0, 0.0, 0.0 };
+			uint32_t validPixelCount = 0;
+
+			const float* refRow = ref + static_cast<size_t>(y) * width * 4;
+			const float* ownRow = own + static_cast<size_t>(y) * width * 4;
+			for (uint32_t x = 0; x < width; x++)
+			{
+				const float* refColor = refRow + x * 4;
+				const float* ownColor = ownRow + x * 4;
+				if (refColor[3] == 0.0f) { continue; }
+				if (refError != nullptr && refError[static_cast<size_t>(y) * width + x] > maxRefError) { continue; }
+
+				for (size_t c = 0; c < 3; c++)
+				{
+					const double r = refColor[c];
+					const double o = ownColor[c];
+					const double err = o - r;
+					errSq += err * err;
+					relErrSq += (err * err) / (r * r + 1e-2);
+					smape += 2.0 * std::abs(err) / (std::abs(o) + std::abs(r) + 1e-2);
+					refSum[c] += r;
+					ownSum[c] += o;
+					ownSqSum[c] += o * o;
+				}
+				validPixelCount++;
+			}
+
+			sums.errSq.Add(errSq);
+			sums.relErrSq.Add(relErrSq);
+			sums.smape.Add(smape);
+			for (size_t c = 0; c < 3; c++)
+			{
+				sums.ref[c].Add(refSum[c]);
+				sums.own[c].Add(ownSum[c]);
+				sums.ownSq[c].Add(ownSqSum[c]);
+			}
+			sums.validPixelCount += validPixelCount;
+		}
+
+		// SSIM on luminance over non overlapping windows that lie fully inside the tile and contain only valid pixels
+		if (yEnd - yStart < c_SsimWindowSize) { return; }
+
+		const double c1 = 0.01 * 0.01;
+		const double c2 = 0.03 * 0.03;
+		const double windowNorm = 1.0 / static_cast<double>(c_SsimWindowSize * c_SsimWindowSize);
+		for (uint32_t wx = 0; wx + c_SsimWindowSize <= width; wx += c_SsimWindowSize)
+		{
+			double refSum = 0.0;
+			double ownSum = 0.0;
+			double refSqSum = 0.0;
+			double ownSqSum = 0.0;
+			double crossSum = 0.0;
+			bool valid = true;
+			for (uint32_t y = yStart; y < yStart + c_SsimWindowSize && valid; y++)
+			{
+				for (uint32_t x = wx; x < wx + c_SsimWindowSize; x++)
+				{
+					const size_t index = (static_cast<size_t>(y) * width + x) * 4;
+					if (ref[index + 3] == 0.0f) { valid = false; break; }
+					if (refError != nullptr && refError[index / 4] > maxRefError) { valid = false; break; }
+
+					const double r = Luminance(ref + index);
+					const double o = Luminance(own + index);
+					refSum += r;
+					ownSum += o;
+					refSqSum += r * r;
+					ownSqSum += o * o;
+					crossSum += r * o;
+				}
+			}
+			if (!valid) { continue; }
+
+			const double refMean = refSum * windowNorm;
+			const double ownMean = ownSum * windowNorm;
+			const double refVar = refSqSum * windowNorm - refMean * refMean;
+			const double ownVar = ownSqSum * windowNorm - ownMean * ownMean;
+			const double cov = crossSum * windowNorm - refMean * ownMean;
+
+			const double ssim =
+				((2.0 * refMean * ownMean + c1) * (2.0 * cov + c2)) /
+				((refMean * refMean + ownMean * ownMean + c1) * (refVar + ownVar + c2));
+
+			sums.ssim.Add(ssim);
+			sums.ssimWindowCount++;
+		}
+	}
+}
@@ -0,0 +1,329 @@
+#include <engine/graphics/vulkan/ImageExporter.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
+#include <engine/graphics/VulkanAPI.hpp>
+#include <engine/util/Log.hpp>
+#include <tinyexr.h>
+#include <algorithm>
+
+namespace en::vk
+{
+	std::mutex ImageExporter::s_Mutex;
+	std::condition_variable ImageExporter::s_WorkCv;
+	std::condition_variable ImageExporter::s_FreeCv;
+	bool ImageExporter::s_Running = false;
+
+	VkCommandPool ImageExporter::s_CommandPool = VK_NULL_HANDLE;
+	std::array<ImageExporter::Slot, ImageExporter::c_SlotCount> ImageExporter::s_Slots;
+	std::deque<uint32_t> ImageExporter::s_PendingSlots;
+	std::vector<std::thread> ImageExporter::s_Workers;
+
+	void ImageExporter::Init()
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		VkCommandPoolCreateInfo commandPoolCI;
+		commandPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		commandPoolCI.pNext = nullptr;
+		commandPoolCI.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		commandPoolCI.queueFamilyIndex = VulkanAPI::GetGraphicsQFI();
+
+		VkResult result = vkCreateCommandPool(device, &commandPoolCI, nullptr, &s_CommandPool);
+		ASSERT_VULKAN(result);
+
+		std::array<VkCommandBuffer, c_SlotCount> commandBuffers;
+
+		VkCommandBufferAllocateInfo allocateInfo;
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.pNext = nullptr;
+		allocateInfo.commandPool = s_CommandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = c_SlotCount;
+
+		result = vkAllocateCommandBuffers(device, &allocateInfo, commandBuffers.data());
+		ASSERT_VULKAN(result);
+
+		// Readback buffers are created on first use, so slots only cost memory once frames are exported
+		VkFenceCreateInfo fenceCI;
+		fenceCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceCI.pNext = nullptr;
+		fenceCI.flags = 0;
+
+		for (uint32_t i = 0; i < c_SlotCount; i++)
+		{
+			Slot& slot = s_Slots[i];
+			slot.buffer = nullptr;
+			slot.data = nullptr;
+			slot.size = 0;
+			slot.commandBuffer = commandBuffers[i];
+			slot.busy = false;
+
+			result = vkCreateFence(device, &fenceCI, nullptr, &slot.fence);
+			ASSERT_VULKAN(result);
+		}
+
+		// Encoding is mostly compression, one worker per slot at most and leave cores to the render thread
+		const uint32_t workerCount = std::clamp(std::thread::hardware_concurrency() / 2, 1u, c_SlotCount);
+		s_Running = true;
+		for (uint32_t i = 0; i < workerCount; i++) { s_Workers.emplace_back(WorkerLoop); }
+	}
+
+	void ImageExporter::Shutdown()
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		WaitIdle();
+
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			s_Running = false;
+		}
+		s_WorkCv.notify_all();
+		for (std::thread& worker : s_Workers) { worker.join(); }
+		s_Workers.clear();
+
+		for (Slot& slot : s_Slots)
+		{
+			if (slot.buffer != nullptr)
+			{
+				slot.buffer->UnmapMemory();
+				slot.buffer->Destroy();
+				delete slot.buffer;
+				slot.buffer = nullptr;
+			}
+			vkDestroyFence(device, slot.fence, nullptr);
+		}
+
+		vkDestroyCommandPool(device, s_CommandPool, nullptr);
+		s_CommandPool = VK_NULL_HANDLE;
+	}
+
+	void ImageExporter::ExportImage(
+		VkQueue queue,
+		VkImage image,
+		VkImageLayout layout,
+		uint32_t width,
+		uint32_t height,
+		const std::string& filePath,
+		Compression compression,
+		bool halfFloat)
+	{
+		// Take a free slot. Workers hand slots back once their file is written
+		uint32_t slotIndex;
+		{
+			std::unique_lock<std::mutex> lock(s_Mutex);
+			auto findFree = [&]()
+			{
+				for (slotIndex = 0; slotIndex < c_SlotCount; slotIndex++)
+				{
+					if (!s_Slots[slotIndex].busy) { return true; }
+				}
+				return false;
+			};
+			s_FreeCv.wait(lock, findFree);
+			s_Slots[slotIndex].busy = true;
+		}
+
+		// A free slot is not touched by any worker, so it is set up without the lock
+		Slot& slot = s_Slots[slotIndex];
+		slot.filePath = filePath;
+		slot.width = width;
+		slot.height = height;
+		slot.compression = compression;
+		slot.halfFloat = halfFloat;
+
+		EnsureBufferSize(slot, static_cast<VkDeviceSize>(width) * height * 4 * sizeof(float));
+		RecordCopy(slot, image, layout);
+
+		VkResult result = vkResetFences(VulkanAPI::GetDevice(), 1, &slot.fence);
+		ASSERT_VULKAN(result);
+
+		VkSubmitInfo submitInfo;
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = nullptr;
+		submitInfo.waitSemaphoreCount = 0;
+		submitInfo.pWaitSemaphores = nullptr;
+		submitInfo.pWaitDstStageMask = nullptr;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &slot.commandBuffer;
+		submitInfo.signalSemaphoreCount = 0;
+		submitInfo.pSignalSemaphores = nullptr;
+
+		FramePacer::Submit(queue, submitInfo, slot.fence);
+
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			s_PendingSlots.push_back(slotIndex);
+		}
+		s_WorkCv.notify_one();
+	}
+
+	void ImageExporter::WaitIdle()
+	{
+		std::unique_lock<std::mutex> lock(s_Mutex);
+		s_FreeCv.wait(lock, []()
+		{
+			return std::none_of(s_Slots.begin(), s_Slots.end(), [](const Slot& slot) { return slot.busy; });
+		});
+	}
+
+	void ImageExporter::EnsureBufferSize(Slot& slot, VkDeviceSize size)
+	{
+		if (slot.buffer != nullptr && slot.size >= size) { return; }
+
+		if (slot.buffer != nullptr)
+		{
+			slot.buffer->UnmapMemory();
+			slot.buffer->Destroy();
+			delete slot.buffer;
+		}
+
+		slot.buffer = new Buffer(
+			size,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			{});
+		void* data;
+		slot.buffer->MapMemory(0, &data);
+		slot.data = static_cast<const float*>(data);
+		slot.size = size;
+	}
+
+	void ImageExporter::RecordCopy(Slot& slot, VkImage image, VkImageLayout layout)
+	{
+		VkCommandBufferBeginInfo beginInfo;
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.pNext = nullptr;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = nullptr;
+
+		VkResult result = vkBeginCommandBuffer(slot.commandBuffer, &beginInfo);
+		ASSERT_VULKAN(result);
+
+		// Previous shader writes to the image must be visible to the copy
+		VkMemoryBarrier barrier;
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.pNext = nullptr;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(
+			slot.commandBuffer,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		VkBufferImageCopy region;
+		region.bufferOffset = 0;
+		region.bufferRowLength = slot.width;
+		region.bufferImageHeight = slot.height;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { slot.width, slot.height, 1 };
+
+		vkCmdCopyImageToBuffer(slot.commandBuffer, image, layout, slot.buffer->GetVulkanHandle(), 1, &region);
+
+		// Make the copy visible to the host once the fence is signaled. Later submissions may overwrite the image right
+		// away, so they also wait for the copy to finish reading it
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(
+			slot.commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		result = vkEndCommandBuffer(slot.commandBuffer);
+		ASSERT_VULKAN(result);
+	}
+
+	void ImageExporter::WorkerLoop()
+	{
+		while (true)
+		{
+			uint32_t slotIndex;
+			{
+				std::unique_lock<std::mutex> lock(s_Mutex);
+				s_WorkCv.wait(lock, []() { return !s_Running || !s_PendingSlots.empty(); });
+				if (s_PendingSlots.empty()) { return; }
+
+				slotIndex = s_PendingSlots.front();
+				s_PendingSlots.pop_front();
+			}
+
+			const Slot& slot = s_Slots[slotIndex];
+			VkResult result = vkWaitForFences(VulkanAPI::GetDevice(), 1, &slot.fence, VK_TRUE, UINT64_MAX);
+			ASSERT_VULKAN(result);
+
+			Encode(slot);
+
+			{
+				std::lock_guard<std::mutex> lock(s_Mutex);
+				s_Slots[slotIndex].busy = false;
+			}
+			s_FreeCv.notify_all();
+		}
+	}
+
+	void ImageExporter::Encode(const Slot& slot)
+	{
+		// EXR stores channels planar and sorted by name
+		const size_t pixelCount = static_cast<size_t>(slot.width) * slot.height;
+		std::array<std::vector<float>, 4> planes;
+		for (std::vector<float>& plane : planes) { plane.resize(pixelCount); }
+		for (size_t i = 0; i < pixelCount; i++)
+		{
+			planes[0][i] = slot.data[i * 4 + 3];
+			planes[1][i] = slot.data[i * 4 + 2];
+			planes[2][i] = slot.data[i * 4 + 1];
+			planes[3][i] = slot.data[i * 4 + 0];
+		}
+		std::array<unsigned char*, 4> planePtrs;
+		for (size_t c = 0; c < 4; c++) { planePtrs[c] = reinterpret_cast<unsigned char*>(planes[c].data()); }
+
+		EXRImage image;
+		InitEXRImage(&image);
+		image.num_channels = 4;
+		image.images = planePtrs.data();
+		image.width = static_cast<int>(slot.width);
+		image.height = static_cast<int>(slot.height);
+
+		std::array<EXRChannelInfo, 4> channels = {};
+		channels[0].name[0] = 'A';
+		channels[1].name[0] = 'B';
+		channels[2].name[0] = 'G';
+		channels[3].name[0] = 'R';
+
+		const int requestedPixelType = slot.halfFloat ? TINYEXR_PIXELTYPE_HALF : TINYEXR_PIXELTYPE_FLOAT;
+		std::array<int, 4> pixelTypes = { TINYEXR_PIXELTYPE_FLOAT, TINYEXR_PIXELTYPE_FLOAT, TINYEXR_PIXELTYPE_FLOAT, TINYEXR_PIXELTYPE_FLOAT };
+		std::array<int, 4> requestedPixelTypes = { requestedPixelType, requestedPixelType, requestedPixelType, requestedPixelType };
+
+		EXRHeader header;
+		InitEXRHeader(&header);
+		header.num_channels = 4;
+		header.channels = channels.data();
+		header.pixel_types = pixelTypes.data();
+		header.requested_pixel_types = requestedPixelTypes.data();
+		switch (slot.compression)
+		{
+		case Compression::None:
+			header.compression_type = TINYEXR_COMPRESSIONTYPE_NONE;
+			break;
+		case Compression::Zip:
+			header.compression_type = TINYEXR_COMPRESSIONTYPE_ZIP;
+			break;
+		case Compression::Piz:
+			header.compression_type = TINYEXR_COMPRESSIONTYPE_PIZ;
+			break;
+		}
+
+		// Errors are not fatal on a worker thread, a missing frame must not take the renderer down
+		const char* err = nullptr;
+		if (TINYEXR_SUCCESS != SaveEXRImageToFile(&image, &header, slot.filePath.c_str(), &err))
+		{
+			Log::Error("TinyEXR failed to save " + slot.filePath + (err != nullptr ? std::string(": ") + err : std::string()), false);
+			if (err != nullptr) { FreeEXRErrorMessage(err); }
+		}
+	}
+}
@@ -5,15 +5,16 @@ namespace en
 {
 	void Log::Info(const std::string& msg)
 	{
-		std::cout << "INFO: \t" << msg << std::endl;
+		AsyncLog::WriteLine(&std::cout, "INFO: \t", msg);
 	}
 
 	void Log::Warn(const std::string& msg)
 	{
-		std::cout << "WARN: \t" << msg << std::endl;
+		AsyncLog::WriteLine(&std::cout, "WARN: \t", msg);
 	}
 
 	void Log::Error(const std::string& msg, bool exit) {
+		AsyncLog::Flush();
 		std::cout << "ERROR:\t" << msg << std::endl;
 		if (exit)
 			throw std::runtime_error("SkyRenderer ERROR: " + msg);
@@ -21,6 +22,7 @@ namespace en
 
 	void Log::LocationError(const std::string& msg, VkResult res, const std::string& file, const int line, bool exit)
 	{
+		AsyncLog::Flush();
 		std::cout << "Error\t" << msg << ", errno " << res << "\n\t in " << file << ":" << line << std::endl;
 		if (exit)
 			throw std::runtime_error("SkyRenderer ERROR: " + msg);
@@ -17,11 +17,12 @@ namespace en
 
 	LogFile::~LogFile()
 	{
+		AsyncLog::Flush();
 		m_File.close();
 	}
 
 	void LogFile::WriteLine(const std::string& line)
 	{
-		m_File << line << std::endl;
+		AsyncLog::WriteLine(&m_File, "", line);
 	}
 }
@@ -1,8 +1,9 @@
 #include <engine/graphics/renderer/McHpmRenderer.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
 #include <engine/graphics/vulkan/CommandRecorder.hpp>
-#include <glm/gtc/random.hpp>
-#include <tinyexr.h>
+#include <engine/graphics/vulkan/ShaderCompiler.hpp>
 #include <imgui.h>
+#include <array>
 
 namespace en
 {
@@ -11,6 +12,8 @@ namespace en
 
 	void McHpmRenderer::Init(VkDevice device)
 	{
+		vk::ShaderCompiler::Precompile({ "mc/render.comp", "mc/tile_variance.comp" });
+
 		// Create desc set layout
 		VkDescriptorSetLayoutBinding outputImageBinding;
 		outputImageBinding.binding = 0;
@@ -33,10 +36,26 @@ namespace en
 		uniformBufferBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 		uniformBufferBinding.pImmutableSamplers = nullptr;
 
+		VkDescriptorSetLayoutBinding guideImageBinding;
+		guideImageBinding.binding = 3;
+		guideImageBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		guideImageBinding.descriptorCount = 1;
+		guideImageBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		guideImageBinding.pImmutableSamplers = nullptr;
+
+		VkDescriptorSetLayoutBinding tileListBinding;
+		tileListBinding.binding = 4;
+		tileListBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		tileListBinding.descriptorCount = 1;
+		tileListBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		tileListBinding.pImmutableSamplers = nullptr;
+
 		std::vector<VkDescriptorSetLayoutBinding> bindings = {
 			outputImageBinding,
 			infoImageBinding,
-			uniformBufferBinding
+			uniformBufferBinding,
+			guideImageBinding,
+			tileListBinding
 		};
 
 		VkDescriptorSetLayoutCreateInfo layoutCI;
@@ -52,13 +71,17 @@ namespace en
 		// Create desc pool
 		VkDescriptorPoolSize storageImagePS;
 		storageImagePS.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-		storageImagePS.descriptorCount = 2;
+		storageImagePS.descriptorCount = 3;
 
 		VkDescriptorPoolSize uniformBufferPS;
 		uniformBufferPS.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		uniformBufferPS.descriptorCount = 1;
 
-		std::vector<VkDescriptorPoolSize> poolSizes = { storageImagePS, uniformBufferPS };
+		VkDescriptorPoolSize storageBufferPS;
+		storageBufferPS.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		storageBufferPS.descriptorCount = 1;
+
+		std::vector<VkDescriptorPoolSize> poolSizes = { storageImagePS, uniformBufferPS, storageBufferPS };
 
 		VkDescriptorPoolCreateInfo poolCI;
 		poolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -78,64 +101,91 @@ namespace en
 		vkDestroyDescriptorSetLayout(device, s_DescSetLayout, nullptr);
 	}
 
-	McHpmRenderer::McHpmRenderer(uint32_t width, uint32_t height, uint32_t pathLength, bool blend, const Camera* camera, const HpmScene& scene) :
+	McHpmRenderer::McHpmRenderer(
+		uint32_t width,
+		uint32_t height,
+		uint32_t pathLength,
+		bool blend,
+		bool adaptiveSampling,
+		const Camera* camera,
+		const HpmScene& scene,
+		uint32_t maxViewCount)
+		:
 		m_RenderWidth(width),
 		m_RenderHeight(height),
 		m_PathLength(pathLength),
+		m_MaxViewCount(maxViewCount),
 		m_ShouldBlend(blend),
-		m_Camera(camera),
+		m_AdaptiveSampling(adaptiveSampling),
+		m_Cameras({ camera }),
 		m_HpmScene(scene),
 		m_UniformBuffer(
 			sizeof(UniformData),
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			{}),
+		m_TileListBuffer(
+			c_TileListHeaderSize + sizeof(uint32_t) * TileScheduler::GetTileCount(width, TileScheduler::c_TileWidth) * TileScheduler::GetTileCount(height, TileScheduler::c_TileHeight),
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			{}),
 		m_RenderShader("mc/render.comp", false),
+		m_TileShader("mc/tile_variance.comp", false),
+		m_Timestamps({ "Render" }),
 		m_CommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, VulkanAPI::GetGraphicsQFI())
 	{
 		Log::Info("Create McHpmRenderer");
 
+		// The tile list of adaptive sampling covers one image
+		if (m_MaxViewCount == 0 || m_MaxViewCount > MAX_CAMERA_COUNT) { Log::Error("McHpmRenderer view count is invalid", true); }
+		if (m_AdaptiveSampling && m_MaxViewCount > 1) { Log::Error("McHpmRenderer adaptive sampling only supports a single view", true); }
+
 		// Init components
 		VkDevice device = VulkanAPI::GetDevice();
 
-		m_CommandPool.AllocateBuffers(2, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-		m_RenderCommandBuffer = m_CommandPool.GetBuffer(0);
-		m_RandomTasksCmdBuf = m_CommandPool.GetBuffer(1);
+		m_CommandPool.AllocateBuffers(vk::TimestampQueryRing::c_RingSize + 1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		for (uint32_t slot = 0; slot < vk::TimestampQueryRing::c_RingSize; slot++) { m_RenderCommandBuffers[slot] = m_CommandPool.GetBuffer(slot); }
+		m_RandomTasksCmdBuf = m_CommandPool.GetBuffer(vk::TimestampQueryRing::c_RingSize);
 
 		CreatePipelineLayout(device);
 
 		InitSpecializationConstants();
 
 		CreateRenderPipeline(device);
+		CreateTilePipeline(device);
 
 		CreateOutputImage(device);
 		CreateInfoImage(device);
+		CreateGuideImage(device);
 
 		AllocateAndUpdateDescriptorSet(device);
 
-		CreateQueryPool(device);
-
-		RecordRenderCommandBuffer();
+		for (uint32_t slot = 0; slot < vk::TimestampQueryRing::c_RingSize; slot++) { RecordRenderCommandBuffer(slot); }
 	}
 
 	void McHpmRenderer::Render(VkQueue queue)
 	{
-		// Check if camera moved
-		if (m_Camera->HasChanged()) { m_BlendIndex = 1; }
+		// Check if a camera moved
+		for (const Camera* camera : m_Cameras)
+		{
+			if (camera->HasChanged()) { m_BlendIndex = 1; }
+		}
 
 		// Calc blendFactor
 		m_UniformData.blendFactor = 1.0 / static_cast<float>(m_BlendIndex);
-
-		// Generate random
-		m_UniformData.random = glm::linearRand(glm::vec4(0.0f), glm::vec4(1.0f));
 		
 		// Update uniform buffer
-		m_UniformBuffer.SetData(sizeof(UniformData), &m_UniformData, 0, 0);
+		vk::FramePacer::UpdateBuffer(m_UniformBuffer, sizeof(UniformData), &m_UniformData, 0);
+
+		// Random sequences are keyed by frame, independent of blending
+		m_UniformData.frameIndex++;
 
 		// Update blending index
 		if (m_ShouldBlend) { m_BlendIndex++; }
 
-		// Render
+		// Render. Every ring slot has its own command buffer that writes the timestamps of that slot
+		const uint32_t slot = m_Timestamps.NextSlot();
+
 		VkSubmitInfo submitInfo;
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 		submitInfo.pNext = nullptr;
@@ -143,11 +193,11 @@ namespace en
 		submitInfo.pWaitSemaphores = nullptr;
 		submitInfo.pWaitDstStageMask = nullptr;
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_RenderCommandBuffer;
+		submitInfo.pCommandBuffers = &m_RenderCommandBuffers[slot];
 		submitInfo.signalSemaphoreCount = 0;
 		submitInfo.pSignalSemaphores = nullptr;
 
-		ASSERT_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
+		vk::FramePacer::Submit(queue, submitInfo, VK_NULL_HANDLE);
 	}
 
 	void McHpmRenderer::Destroy()
@@ -157,16 +207,14 @@ namespace en
 		m_CommandPool.Destroy();
 
 		m_UniformBuffer.Destroy();
+		m_TileListBuffer.Destroy();
 
-		vkDestroyQueryPool(device, m_QueryPool, nullptr);
+		m_Timestamps.Destroy();
 
-		vkDestroyImageView(device, m_InfoImageView, nullptr);
-		vkFreeMemory(device, m_InfoImageMemory, nullptr);
-		vkDestroyImage(device, m_InfoImage, nullptr);
+		DestroyImages(device);
 
-		vkDestroyImageView(device, m_OutputImageView, nullptr);
-		vkFreeMemory(device, m_OutputImageMemory, nullptr);
-		vkDestroyImage(device, m_OutputImage, nullptr);
+		vkDestroyPipeline(device, m_TilePipeline, nullptr);
+		m_TileShader.Destroy();
 
 		vkDestroyPipeline(device, m_RenderPipeline, nullptr);
 		m_RenderShader.Destroy();
@@ -174,92 +222,42 @@ namespace en
 		vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
 	}
 
-	void McHpmRenderer::ExportOutputImageToFile(VkQueue queue, const std::string& filePath) const
+	void McHpmRenderer::ExportOutputImageToFile(
+		VkQueue queue,
+		const std::string& filePath,
+		vk::ImageExporter::Compression compression,
+		bool halfFloat) const
 	{
-		const size_t floatCount = m_RenderWidth * m_RenderHeight * 4;
-		const size_t bufferSize = floatCount * sizeof(float);
-
-		vk::Buffer vkBuffer(
-			bufferSize,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			{});
-
-		VkCommandBufferBeginInfo cmdBufBI;
-		cmdBufBI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		cmdBufBI.pNext = nullptr;
-		cmdBufBI.flags = 0;
-		cmdBufBI.pInheritanceInfo = nullptr;
-		ASSERT_VULKAN(vkBeginCommandBuffer(m_RandomTasksCmdBuf, &cmdBufBI));
-
-		VkBufferImageCopy region;
-		region.bufferOffset = 0;
-		region.bufferRowLength = m_RenderWidth;
-		region.bufferImageHeight = m_RenderHeight;
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = 0;
-		region.imageSubresource.baseArrayLayer = 0;
-		region.imageSubresource.layerCount = 1;
-		region.imageOffset = { 0, 0, 0 };
-		region.imageExtent = { m_RenderWidth, m_RenderHeight, 1 };
-
-		vkCmdCopyImageToBuffer(m_RandomTasksCmdBuf, m_OutputImage, VK_IMAGE_LAYOUT_GENERAL, vkBuffer.GetVulkanHandle(), 1, &region);
-
-		ASSERT_VULKAN(vkEndCommandBuffer(m_RandomTasksCmdBuf));
-
-		VkSubmitInfo submitInfo;
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.pNext = nullptr;
-		submitInfo.waitSemaphoreCount = 0;
-		submitInfo.pWaitSemaphores = nullptr;
-		submitInfo.pWaitDstStageMask = nullptr;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_RandomTasksCmdBuf;
-		submitInfo.signalSemaphoreCount = 0;
-		submitInfo.pSignalSemaphores = nullptr;
-
-		ASSERT_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
-		ASSERT_VULKAN(vkQueueWaitIdle(queue));
-
-		std::vector<float> buffer(floatCount);
-		vkBuffer.GetData(bufferSize, buffer.data(), 0, 0);
-		vkBuffer.Destroy();
-
-		if (TINYEXR_SUCCESS != SaveEXR(buffer.data(), m_RenderWidth, m_RenderHeight, 4, 0, filePath.c_str(), nullptr))
-		{
-			en::Log::Error("TINYEXR Error", true);
-		}
+		vk::ImageExporter::ExportImage(
+			queue,
+			m_OutputImage,
+			VK_IMAGE_LAYOUT_GENERAL,
+			m_RenderWidth,
+			m_RenderHeight,
+			filePath,
+			compression,
+			halfFloat);
 	}
 
 	void McHpmRenderer::EvaluateTimestampQueries()
 	{
-		VkDevice device = VulkanAPI::GetDevice();
-		std::vector<uint64_t> queryResults(c_QueryCount);
-		ASSERT_VULKAN(vkGetQueryPoolResults(
-			device,
-			m_QueryPool,
-			0,
-			c_QueryCount,
-			sizeof(uint64_t) * c_QueryCount,
-			queryResults.data(),
-			sizeof(uint64_t),
-			VK_QUERY_RESULT_64_BIT));
-		vkResetQueryPool(device, m_QueryPool, 0, c_QueryCount);
-
-		const float timestampPeriodInMS = VulkanAPI::GetTimestampPeriod() * 1e-6f;
-		m_TimePeriod = timestampPeriodInMS * static_cast<float>(queryResults[1] - queryResults[0]);
+		m_Timestamps.Collect();
 	}
 
 	void McHpmRenderer::RenderImGui()
 	{
 		ImGui::Begin("McHpmRenderer");
 		
-		ImGui::Text("Total Time %f ms", m_TimePeriod);
-		ImGui::Text("Theoretical FPS %f", 1000.0f / m_TimePeriod);
+		m_Timestamps.RenderImGui();
 
 		ImGui::Checkbox("Blend", &m_ShouldBlend);
 		ImGui::Text("Blend index %u", m_BlendIndex);
 		if (ImGui::Button("Reset blending")) { m_BlendIndex = 1; }
+
+		if (m_AdaptiveSampling)
+		{
+			ImGui::DragFloat("Adaptive target error", &m_UniformData.adaptiveTargetRelStdError, 0.001f, 0.0f, 1.0f);
+		}
 		
 		ImGui::End();
 	}
@@ -352,18 +350,131 @@ namespace en
 		return m_OutputImageView;
 	}
 
+	VkImage McHpmRenderer::GetInfoImage() const
+	{
+		return m_InfoImage;
+	}
+
+	VkImageView McHpmRenderer::GetGuideImageView() const
+	{
+		return m_GuideImageView;
+	}
+
 	bool McHpmRenderer::IsBlending() const
 	{
 		return m_ShouldBlend;
 	}
 
+	float McHpmRenderer::GetFrameTimeMS() const
+	{
+		return m_Timestamps.GetLast(m_Timestamps.GetTotalPass());
+	}
+
+	uint32_t McHpmRenderer::GetViewCount() const
+	{
+		return m_Cameras.size();
+	}
+
+	uint32_t McHpmRenderer::GetMaxViewCount() const
+	{
+		return m_MaxViewCount;
+	}
+
 	void McHpmRenderer::SetCamera(VkQueue queue, const Camera* camera)
 	{
+		SetCameras(queue, { camera });
+	}
+
+	void McHpmRenderer::SetCameras(VkQueue queue, const std::vector<const Camera*>& cameras)
+	{
+		if (cameras.empty() || cameras.size() > m_MaxViewCount) { Log::Error("McHpmRenderer camera count is invalid", true); }
+
 		// Set members
 		m_BlendIndex = 1;
-		m_Camera = camera;
+		m_Cameras = cameras;
+
+		ClearImages(queue);
+
+		// Rerecord cmd buf
+		for (uint32_t slot = 0; slot < vk::TimestampQueryRing::c_RingSize; slot++) { RecordRenderCommandBuffer(slot); }
+	}
+
+	void McHpmRenderer::SetBlend(bool blend)
+	{
+		m_ShouldBlend = blend;
+		m_BlendIndex = 1;
+	}
+
+	void McHpmRenderer::SetAdaptiveTarget(float relStdError, uint32_t minSampleCount)
+	{
+		m_UniformData.adaptiveTargetRelStdError = relStdError;
+		m_UniformData.adaptiveMinSampleCount = minSampleCount;
+	}
 
-		// Clear images
+	void McHpmRenderer::SetRenderSize(VkQueue queue, uint32_t width, uint32_t height)
+	{
+		if (width == m_RenderWidth && height == m_RenderHeight) { return; }
+
+		// Frames in flight still use the old resources
+		vk::FramePacer::WaitIdle();
+
+		m_RenderWidth = width;
+		m_RenderHeight = height;
+		m_BlendIndex = 1;
+
+		RecreateSizeDependentResources(queue);
+	}
+
+	void McHpmRenderer::SetMaxViewCount(VkQueue queue, uint32_t maxViewCount)
+	{
+		if (maxViewCount == m_MaxViewCount) { return; }
+		if (maxViewCount == 0 || maxViewCount > MAX_CAMERA_COUNT || maxViewCount < m_Cameras.size())
+		{
+			Log::Error("McHpmRenderer view count is invalid", true);
+		}
+		if (m_AdaptiveSampling && maxViewCount > 1) { Log::Error("McHpmRenderer adaptive sampling only supports a single view", true); }
+
+		vk::FramePacer::WaitIdle();
+
+		m_MaxViewCount = maxViewCount;
+		m_BlendIndex = 1;
+
+		RecreateSizeDependentResources(queue);
+	}
+
+	void McHpmRenderer::RecreateSizeDependentResources(VkQueue queue)
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		// Destroy size dependent resources
+		vkDestroyPipeline(device, m_TilePipeline, nullptr);
+		vkDestroyPipeline(device, m_RenderPipeline, nullptr);
+		DestroyImages(device);
+		m_TileListBuffer.Destroy();
+
+		// Recreate them. The render size is baked into the pipelines as specialization constant
+		m_TileListBuffer = vk::Buffer(
+			c_TileListHeaderSize + sizeof(uint32_t) * TileScheduler::GetTileCount(m_RenderWidth, TileScheduler::c_TileWidth) * TileScheduler::GetTileCount(m_RenderHeight, TileScheduler::c_TileHeight),
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			{});
+
+		InitSpecializationConstants();
+		CreateRenderPipeline(device);
+		CreateTilePipeline(device);
+
+		CreateOutputImage(device);
+		CreateInfoImage(device);
+		CreateGuideImage(device);
+		ClearImages(queue);
+
+		UpdateDescriptorSet(device);
+
+		for (uint32_t slot = 0; slot < vk::TimestampQueryRing::c_RingSize; slot++) { RecordRenderCommandBuffer(slot); }
+	}
+
+	void McHpmRenderer::ClearImages(VkQueue queue)
+	{
 		VkCommandBufferBeginInfo beginInfo;
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		beginInfo.pNext = nullptr;
@@ -377,9 +488,10 @@ namespace en
 		subresourceRange.baseMipLevel = 0;
 		subresourceRange.levelCount = 1;
 		subresourceRange.baseArrayLayer = 0;
-		subresourceRange.layerCount = 1;
+		subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
 		vkCmdClearColorImage(m_RandomTasksCmdBuf, m_OutputImage, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
 		vkCmdClearColorImage(m_RandomTasksCmdBuf, m_InfoImage, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
+		vkCmdClearColorImage(m_RandomTasksCmdBuf, m_GuideImage, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
 
 		ASSERT_VULKAN(vkEndCommandBuffer(m_RandomTasksCmdBuf));
 
@@ -395,15 +507,6 @@ namespace en
 		submitInfo.pSignalSemaphores = nullptr;
 		ASSERT_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
 		ASSERT_VULKAN(vkQueueWaitIdle(queue));
-
-		// Rerecord cmd buf
-		RecordRenderCommandBuffer();
-	}
-
-	void McHpmRenderer::SetBlend(bool blend)
-	{
-		m_ShouldBlend = blend;
-		m_BlendIndex = 1;
 	}
 
 	void McHpmRenderer::CreatePipelineLayout(VkDevice device)
@@ -416,14 +519,20 @@ namespace en
 			HdrEnvMap::GetDescriptorSetLayout(),
 			s_DescSetLayout };
 
+		// View index
+		VkPushConstantRange viewRange;
+		viewRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		viewRange.offset = 0;
+		viewRange.size = sizeof(uint32_t);
+
 		VkPipelineLayoutCreateInfo layoutCreateInfo;
 		layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		layoutCreateInfo.pNext = nullptr;
 		layoutCreateInfo.flags = 0;
 		layoutCreateInfo.setLayoutCount = layouts.size();
 		layoutCreateInfo.pSetLayouts = layouts.data();
-		layoutCreateInfo.pushConstantRangeCount = 0;
-		layoutCreateInfo.pPushConstantRanges = nullptr;
+		layoutCreateInfo.pushConstantRangeCount = 1;
+		layoutCreateInfo.pPushConstantRanges = &viewRange;
 
 		VkResult result = vkCreatePipelineLayout(device, &layoutCreateInfo, nullptr, &m_PipelineLayout);
 		ASSERT_VULKAN(result);
@@ -448,6 +557,14 @@ namespace en
 
 		m_SpecData.hdrEnvMapStrength = m_HpmScene.GetHdrEnvMap()->GetStrength();
 
+		m_SpecData.residualRatioTracking = m_HpmScene.GetVolumeData()->UsesResidualRatioTracking() ? VK_TRUE : VK_FALSE;
+		m_SpecData.dirLightTransmittanceCache = m_HpmScene.UsesDirLightTransmittanceCache() ? VK_TRUE : VK_FALSE;
+		m_SpecData.pointLightTransmittanceCache = m_HpmScene.UsesPointLightTransmittanceCache() ? VK_TRUE : VK_FALSE;
+
+		m_SpecData.adaptiveSampling = m_AdaptiveSampling ? VK_TRUE : VK_FALSE;
+
+		m_SpecData.emptySpaceSkipping = m_HpmScene.GetVolumeData()->UsesEmptySpaceSkipping() ? VK_TRUE : VK_FALSE;
+
 		// Init map entries
 		uint32_t mapEntryIndex = 0;
 
@@ -496,6 +613,31 @@ namespace en
 		hdrEnvMapStrengthEntry.offset = offsetof(SpecializationData, SpecializationData::hdrEnvMapStrength);
 		hdrEnvMapStrengthEntry.size = sizeof(float);
 
+		VkSpecializationMapEntry residualRatioTrackingEntry;
+		residualRatioTrackingEntry.constantID = mapEntryIndex++;
+		residualRatioTrackingEntry.offset = offsetof(SpecializationData, SpecializationData::residualRatioTracking);
+		residualRatioTrackingEntry.size = sizeof(uint32_t);
+
+		VkSpecializationMapEntry dirLightTransmittanceCacheEntry;
+		dirLightTransmittanceCacheEntry.constantID = mapEntryIndex++;
+		dirLightTransmittanceCacheEntry.offset = offsetof(SpecializationData, SpecializationData::dirLightTransmittanceCache);
+		dirLightTransmittanceCacheEntry.size = sizeof(uint32_t);
+
+		VkSpecializationMapEntry pointLightTransmittanceCacheEntry;
+		pointLightTransmittanceCacheEntry.constantID = mapEntryIndex++;
+		pointLightTransmittanceCacheEntry.offset = offsetof(SpecializationData, SpecializationData::pointLightTransmittanceCache);
+		pointLightTransmittanceCacheEntry.size = sizeof(uint32_t);
+
+		VkSpecializationMapEntry adaptiveSamplingEntry;
+		adaptiveSamplingEntry.constantID = mapEntryIndex++;
+		adaptiveSamplingEntry.offset = offsetof(SpecializationData, SpecializationData::adaptiveSampling);
+		adaptiveSamplingEntry.size = sizeof(uint32_t);
+
+		VkSpecializationMapEntry emptySpaceSkippingEntry;
+		emptySpaceSkippingEntry.constantID = mapEntryIndex++;
+		emptySpaceSkippingEntry.offset = offsetof(SpecializationData, SpecializationData::emptySpaceSkipping);
+		emptySpaceSkippingEntry.size = sizeof(uint32_t);
+
 		m_SpecMapEntries = {
 			renderWidthEntry,
 			renderHeightEntry,
@@ -505,7 +647,12 @@ namespace en
 			volumeSizeZEntry,
 			volumeDensityFactorEntry,
 			volumeGEntry,
-			hdrEnvMapStrengthEntry
+			hdrEnvMapStrengthEntry,
+			residualRatioTrackingEntry,
+			dirLightTransmittanceCacheEntry,
+			pointLightTransmittanceCacheEntry,
+			adaptiveSamplingEntry,
+			emptySpaceSkippingEntry
 		};
 
 		m_SpecInfo.mapEntryCount = m_SpecMapEntries.size();
@@ -534,7 +681,31 @@ namespace en
 		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineCI.basePipelineIndex = 0;
 
-		VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_RenderPipeline);
+		VkResult result = VulkanAPI::CreateComputePipeline(pipelineCI, &m_RenderPipeline);
+		ASSERT_VULKAN(result);
+	}
+
+	void McHpmRenderer::CreateTilePipeline(VkDevice device)
+	{
+		VkPipelineShaderStageCreateInfo shaderStage;
+		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStage.pNext = nullptr;
+		shaderStage.flags = 0;
+		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		shaderStage.module = m_TileShader.GetVulkanModule();
+		shaderStage.pName = "main";
+		shaderStage.pSpecializationInfo = &m_SpecInfo;
+
+		VkComputePipelineCreateInfo pipelineCI;
+		pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineCI.pNext = nullptr;
+		pipelineCI.flags = 0;
+		pipelineCI.stage = shaderStage;
+		pipelineCI.layout = m_PipelineLayout;
+		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineCI.basePipelineIndex = 0;
+
+		VkResult result = VulkanAPI::CreateComputePipeline(pipelineCI, &m_TilePipeline);
 		ASSERT_VULKAN(result);
 	}
 
@@ -551,7 +722,7 @@ namespace en
 		imageCI.format = format;
 		imageCI.extent = { m_RenderWidth, m_RenderHeight, 1 };
 		imageCI.mipLevels = 1;
-		imageCI.arrayLayers = 1;
+		imageCI.arrayLayers = m_MaxViewCount;
 		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
 		imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
@@ -564,22 +735,7 @@ namespace en
 		ASSERT_VULKAN(result);
 
 		// Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_OutputImage, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_OutputImageMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_OutputImage, m_OutputImageMemory, 0);
-		ASSERT_VULKAN(result);
+		m_OutputImageMemory = vk::MemoryAllocator::AllocateImage(m_OutputImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Create image view
 		VkImageViewCreateInfo imageViewCI;
@@ -602,6 +758,13 @@ namespace en
 		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_OutputImageView);
 		ASSERT_VULKAN(result);
 
+		// Shaders access all layers
+		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+		imageViewCI.subresourceRange.layerCount = m_MaxViewCount;
+
+		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_OutputArrayView);
+		ASSERT_VULKAN(result);
+
 		// Change image layout
 		VkCommandBufferBeginInfo beginInfo;
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -656,7 +819,7 @@ namespace en
 		imageCI.format = format;
 		imageCI.extent = { m_RenderWidth, m_RenderHeight, 1 };
 		imageCI.mipLevels = 1;
-		imageCI.arrayLayers = 1;
+		imageCI.arrayLayers = m_MaxViewCount;
 		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
 		imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
@@ -669,29 +832,104 @@ namespace en
 		ASSERT_VULKAN(result);
 
 		// Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_InfoImage, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_InfoImageMemory);
+		m_InfoImageMemory = vk::MemoryAllocator::AllocateImage(m_InfoImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		// Create image view
+		VkImageViewCreateInfo imageViewCI;
+		imageViewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		imageViewCI.pNext = nullptr;
+		imageViewCI.flags = 0;
+		imageViewCI.image = m_InfoImage;
+		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+		imageViewCI.format = format;
+		imageViewCI.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageViewCI.subresourceRange.baseMipLevel = 0;
+		imageViewCI.subresourceRange.levelCount = 1;
+		imageViewCI.subresourceRange.baseArrayLayer = 0;
+		imageViewCI.subresourceRange.layerCount = m_MaxViewCount;
+
+		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_InfoImageView);
 		ASSERT_VULKAN(result);
 
-		result = vkBindImageMemory(device, m_InfoImage, m_InfoImageMemory, 0);
+		// Change image layout
+		VkCommandBufferBeginInfo beginInfo;
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.pNext = nullptr;
+		beginInfo.flags = 0;
+		beginInfo.pInheritanceInfo = nullptr;
+
+		result = vkBeginCommandBuffer(m_RandomTasksCmdBuf, &beginInfo);
 		ASSERT_VULKAN(result);
 
+		vk::CommandRecorder::ImageLayoutTransfer(
+			m_RandomTasksCmdBuf,
+			m_InfoImage,
+			VK_IMAGE_LAYOUT_PREINITIALIZED,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_ACCESS_NONE,
+			VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+		result = vkEndCommandBuffer(m_RandomTasksCmdBuf);
+		ASSERT_VULKAN(result);
+
+		VkSubmitInfo submitInfo;
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = nullptr;
+		submitInfo.waitSemaphoreCount = 0;
+		submitInfo.pWaitSemaphores = nullptr;
+		submitInfo.pWaitDstStageMask = nullptr;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &m_RandomTasksCmdBuf;
+		submitInfo.signalSemaphoreCount = 0;
+		submitInfo.pSignalSemaphores = nullptr;
+
+		VkQueue queue = VulkanAPI::GetGraphicsQueue();
+		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		ASSERT_VULKAN(result);
+		result = vkQueueWaitIdle(queue);
+		ASSERT_VULKAN(result);
+	}
+
+	void McHpmRenderer::CreateGuideImage(VkDevice device)
+	{
+		VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT;
+
+		// Create Image
+		VkImageCreateInfo imageCI;
+		imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageCI.pNext = nullptr;
+		imageCI.flags = 0;
+		imageCI.imageType = VK_IMAGE_TYPE_2D;
+		imageCI.format = format;
+		imageCI.extent = { m_RenderWidth, m_RenderHeight, 1 };
+		imageCI.mipLevels = 1;
+		imageCI.arrayLayers = m_MaxViewCount;
+		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageCI.queueFamilyIndexCount = 0;
+		imageCI.pQueueFamilyIndices = nullptr;
+		imageCI.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+
+		VkResult result = vkCreateImage(device, &imageCI, nullptr, &m_GuideImage);
+		ASSERT_VULKAN(result);
+
+		// Image Memory
+		m_GuideImageMemory = vk::MemoryAllocator::AllocateImage(m_GuideImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
 		// Create image view
 		VkImageViewCreateInfo imageViewCI;
 		imageViewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 		imageViewCI.pNext = nullptr;
 		imageViewCI.flags = 0;
-		imageViewCI.image = m_InfoImage;
+		imageViewCI.image = m_GuideImage;
 		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
 		imageViewCI.format = format;
 		imageViewCI.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -704,7 +942,14 @@ namespace en
 		imageViewCI.subresourceRange.baseArrayLayer = 0;
 		imageViewCI.subresourceRange.layerCount = 1;
 
-		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_InfoImageView);
+		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_GuideImageView);
+		ASSERT_VULKAN(result);
+
+		// Shaders access all layers
+		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+		imageViewCI.subresourceRange.layerCount = m_MaxViewCount;
+
+		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_GuideArrayView);
 		ASSERT_VULKAN(result);
 
 		// Change image layout
@@ -719,7 +964,7 @@ namespace en
 
 		vk::CommandRecorder::ImageLayoutTransfer(
 			m_RandomTasksCmdBuf,
-			m_InfoImage,
+			m_GuideImage,
 			VK_IMAGE_LAYOUT_PREINITIALIZED,
 			VK_IMAGE_LAYOUT_GENERAL,
 			VK_ACCESS_NONE,
@@ -748,6 +993,23 @@ namespace en
 		ASSERT_VULKAN(result);
 	}
 
+	void McHpmRenderer::DestroyImages(VkDevice device)
+	{
+		vkDestroyImageView(device, m_GuideArrayView, nullptr);
+		vkDestroyImageView(device, m_GuideImageView, nullptr);
+		vk::MemoryAllocator::Free(m_GuideImageMemory);
+		vkDestroyImage(device, m_GuideImage, nullptr);
+
+		vkDestroyImageView(device, m_InfoImageView, nullptr);
+		vk::MemoryAllocator::Free(m_InfoImageMemory);
+		vkDestroyImage(device, m_InfoImage, nullptr);
+
+		vkDestroyImageView(device, m_OutputArrayView, nullptr);
+		vkDestroyImageView(device, m_OutputImageView, nullptr);
+		vk::MemoryAllocator::Free(m_OutputImageMemory);
+		vkDestroyImage(device, m_OutputImage, nullptr);
+	}
+
 	void McHpmRenderer::AllocateAndUpdateDescriptorSet(VkDevice device)
 	{
 		// Allocate
@@ -761,11 +1023,15 @@ namespace en
 		VkResult result = vkAllocateDescriptorSets(device, &descSetAI, &m_DescSet);
 		ASSERT_VULKAN(result);
 
-		// Write
+		UpdateDescriptorSet(device);
+	}
+
+	void McHpmRenderer::UpdateDescriptorSet(VkDevice device)
+	{
 		// Storage image writes
 		VkDescriptorImageInfo outputImageInfo;
 		outputImageInfo.sampler = VK_NULL_HANDLE;
-		outputImageInfo.imageView = m_OutputImageView;
+		outputImageInfo.imageView = m_OutputArrayView;
 		outputImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 		VkWriteDescriptorSet outputImageWrite;
@@ -815,70 +1081,160 @@ namespace en
 		uniformBufferWrite.pBufferInfo = &uniformBufferInfo;
 		uniformBufferWrite.pTexelBufferView = nullptr;
 
+		// Guide image write
+		VkDescriptorImageInfo guideImageInfo;
+		guideImageInfo.sampler = VK_NULL_HANDLE;
+		guideImageInfo.imageView = m_GuideArrayView;
+		guideImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet guideImageWrite;
+		guideImageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		guideImageWrite.pNext = nullptr;
+		guideImageWrite.dstSet = m_DescSet;
+		guideImageWrite.dstBinding = 3;
+		guideImageWrite.dstArrayElement = 0;
+		guideImageWrite.descriptorCount = 1;
+		guideImageWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		guideImageWrite.pImageInfo = &guideImageInfo;
+		guideImageWrite.pBufferInfo = nullptr;
+		guideImageWrite.pTexelBufferView = nullptr;
+
+		// Tile list write
+		VkDescriptorBufferInfo tileListBufferInfo;
+		tileListBufferInfo.buffer = m_TileListBuffer.GetVulkanHandle();
+		tileListBufferInfo.offset = 0;
+		tileListBufferInfo.range = VK_WHOLE_SIZE;
+
+		VkWriteDescriptorSet tileListWrite;
+		tileListWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		tileListWrite.pNext = nullptr;
+		tileListWrite.dstSet = m_DescSet;
+		tileListWrite.dstBinding = 4;
+		tileListWrite.dstArrayElement = 0;
+		tileListWrite.descriptorCount = 1;
+		tileListWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		tileListWrite.pImageInfo = nullptr;
+		tileListWrite.pBufferInfo = &tileListBufferInfo;
+		tileListWrite.pTexelBufferView = nullptr;
+
 		// Write writes
 		std::vector<VkWriteDescriptorSet> writes = {
 			outputImageWrite,
 			infoImageWrite,
-			uniformBufferWrite
+			uniformBufferWrite,
+			guideImageWrite,
+			tileListWrite
 		};
 
 		vkUpdateDescriptorSets(device, writes.size(), writes.data(), 0, nullptr);
 	}
 
-	void McHpmRenderer::CreateQueryPool(VkDevice device)
+	void McHpmRenderer::CmdBindView(VkCommandBuffer commandBuffer, uint32_t view) const
 	{
-		VkQueryPoolCreateInfo queryPoolCI;
-		queryPoolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
-		queryPoolCI.pNext = nullptr;
-		queryPoolCI.flags = 0;
-		queryPoolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
-		queryPoolCI.queryCount = c_QueryCount;
-		queryPoolCI.pipelineStatistics = 0;
-
-		ASSERT_VULKAN(vkCreateQueryPool(device, &queryPoolCI, nullptr, &m_QueryPool));
+		// Only the camera set changes between views, the other sets stay bound
+		const VkDescriptorSet cameraDescSet = m_Cameras[view]->GetDescriptorSet();
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &cameraDescSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &view);
 	}
 
-	void McHpmRenderer::RecordRenderCommandBuffer()
+	void McHpmRenderer::RecordRenderCommandBuffer(uint32_t slot)
 	{
+		VkCommandBuffer commandBuffer = m_RenderCommandBuffers[slot];
+
 		m_QueryIndex = 0;
 
 		// Begin command buffer
 		VkCommandBufferBeginInfo beginInfo;
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		beginInfo.pNext = nullptr;
-		beginInfo.flags = 0;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
 		beginInfo.pInheritanceInfo = nullptr;
 
-		VkResult result = vkBeginCommandBuffer(m_RenderCommandBuffer, &beginInfo);
+		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
 		ASSERT_VULKAN(result);
 
 		// Reset query pool
-		vkCmdResetQueryPool(m_RenderCommandBuffer, m_QueryPool, 0, c_QueryCount);
+		m_Timestamps.CmdReset(commandBuffer, slot);
 
 		// Collect descriptor sets
-		std::vector<VkDescriptorSet> descSets = { m_Camera->GetDescriptorSet() };
+		std::vector<VkDescriptorSet> descSets = { m_Cameras[0]->GetDescriptorSet() };
 		const std::vector<VkDescriptorSet>& hpmSceneDescSets = m_HpmScene.GetDescriptorSets();
 		descSets.insert(descSets.end(), hpmSceneDescSets.begin(), hpmSceneDescSets.end());
 		descSets.push_back(m_DescSet);
 
 		// Bind descriptor sets
 		vkCmdBindDescriptorSets(
-			m_RenderCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout,
+			commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout,
 			0, descSets.size(), descSets.data(),
 			0, nullptr);
 
 		// Timestamp
-		vkCmdWriteTimestamp(m_RenderCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_QueryPool, m_QueryIndex++);
+		m_Timestamps.CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, slot, m_QueryIndex++);
 
-		// Render pipeline
-		vkCmdBindPipeline(m_RenderCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_RenderPipeline);
-		vkCmdDispatch(m_RenderCommandBuffer, m_RenderWidth / 32, m_RenderHeight, 1);
+		if (m_AdaptiveSampling)
+		{
+			CmdBindView(commandBuffer, 0);
+
+			// Reset the indirect dispatch to zero tiles of TILE_HEIGHT rows
+			const std::array<uint32_t, 3> emptyDispatch = { 0, TileScheduler::c_TileHeight, 1 };
+			vkCmdUpdateBuffer(commandBuffer, m_TileListBuffer.GetVulkanHandle(), 0, c_TileListHeaderSize, emptyDispatch.data());
+
+			VkMemoryBarrier resetBarrier;
+			resetBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			resetBarrier.pNext = nullptr;
+			resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				0,
+				1, &resetBarrier,
+				0, nullptr,
+				0, nullptr);
+
+			// Collect unconverged tiles
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_TilePipeline);
+			vkCmdDispatch(
+				commandBuffer,
+				TileScheduler::GetTileCount(m_RenderWidth, TileScheduler::c_TileWidth),
+				TileScheduler::GetTileCount(m_RenderHeight, TileScheduler::c_TileHeight),
+				1);
+
+			VkMemoryBarrier tileListBarrier;
+			tileListBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			tileListBarrier.pNext = nullptr;
+			tileListBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			tileListBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				0,
+				1, &tileListBarrier,
+				0, nullptr,
+				0, nullptr);
+
+			// Render pipeline, one sample for every pixel of the listed tiles
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_RenderPipeline);
+			vkCmdDispatchIndirect(commandBuffer, m_TileListBuffer.GetVulkanHandle(), 0);
+		}
+		else
+		{
+			// Render pipeline, one dispatch per view
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_RenderPipeline);
+			for (uint32_t view = 0; view < m_Cameras.size(); view++)
+			{
+				CmdBindView(commandBuffer, view);
+				vkCmdDispatch(commandBuffer, (m_RenderWidth + 31) / 32, m_RenderHeight, 1);
+			}
+		}
 
 		// Timestamp
-		vkCmdWriteTimestamp(m_RenderCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_QueryPool, m_QueryIndex++);
+		m_Timestamps.CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, slot, m_QueryIndex++);
 
 		// End command buffer
-		result = vkEndCommandBuffer(m_RenderCommandBuffer);
+		result = vkEndCommandBuffer(commandBuffer);
 		ASSERT_VULKAN(result);
 	}
 }
@@ -0,0 +1,291 @@
+#include <engine/graphics/vulkan/MemoryAllocator.hpp>
+#include <engine/graphics/VulkanAPI.hpp>
+#include <engine/util/Log.hpp>
+#include <algorithm>
+
+namespace en::vk
+{
+	std::mutex MemoryAllocator::s_Mutex;
+	std::map<uint64_t, std::vector<std::unique_ptr<MemoryAllocator::Block>>> MemoryAllocator::s_Blocks;
+	std::array<MemoryAllocator::PoolStats, MemoryAllocator::PoolCount> MemoryAllocator::s_Stats;
+
+	VkDeviceMemory MemoryAllocator::s_FrameMemory = VK_NULL_HANDLE;
+	void* MemoryAllocator::s_FrameMapped = nullptr;
+	uint32_t MemoryAllocator::s_FrameMemoryTypeIndex = UINT32_MAX;
+	VkDeviceSize MemoryAllocator::s_FrameOffset = 0;
+
+	void MemoryAllocator::Init()
+	{
+		s_Stats = {};
+		s_FrameMemory = VK_NULL_HANDLE;
+		s_FrameMapped = nullptr;
+		s_FrameMemoryTypeIndex = UINT32_MAX;
+		s_FrameOffset = 0;
+	}
+
+	void MemoryAllocator::Shutdown()
+	{
+		LogStats();
+
+		for (auto& [key, blocks] : s_Blocks)
+		{
+			for (const std::unique_ptr<Block>& block : blocks)
+			{
+				FreeDeviceMemory(block->memory, block->size, Default);
+			}
+		}
+		s_Blocks.clear();
+
+		if (s_FrameMemory != VK_NULL_HANDLE) { FreeDeviceMemory(s_FrameMemory, c_FrameArenaSize, Frame); }
+		s_FrameMemory = VK_NULL_HANDLE;
+	}
+
+	MemoryAllocator::Allocation MemoryAllocator::Allocate(
+		const VkMemoryRequirements& requirements,
+		VkMemoryPropertyFlags properties,
+		bool linear)
+	{
+		const uint32_t memoryTypeIndex = VulkanAPI::FindMemoryType(requirements.memoryTypeBits, properties);
+
+		// Power of two slots are aligned to their size, which covers every alignment vulkan reports
+		VkDeviceSize slotSize = c_MinSlotSize;
+		while (slotSize < requirements.size || slotSize < requirements.alignment) { slotSize *= 2; }
+
+		if (slotSize > c_MaxSlotSize)
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			return AllocateDedicated(requirements.size, memoryTypeIndex, nullptr, Default);
+		}
+
+		uint32_t sizeClass = 0;
+		while ((c_MinSlotSize << sizeClass) < slotSize) { sizeClass++; }
+		const uint64_t key = (static_cast<uint64_t>(memoryTypeIndex) << 32) | (static_cast<uint64_t>(sizeClass) << 1) | (linear ? 1 : 0);
+
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		std::vector<std::unique_ptr<Block>>& blocks = s_Blocks[key];
+
+		auto blockIt = std::find_if(
+			blocks.begin(),
+			blocks.end(),
+			[](const std::unique_ptr<Block>& block) { return !block->freeSlots.empty(); });
+		if (blockIt == blocks.end())
+		{
+			// Small size classes get small blocks, large ones share the size cap with fewer slots
+			std::unique_ptr<Block> block = std::make_unique<Block>();
+			block->key = key;
+			block->size = std::min(slotSize * c_BlockSlotCount, c_MaxBlockSize);
+			block->memory = AllocateDeviceMemory(block->size, memoryTypeIndex, nullptr, Default, &block->mapped);
+			block->slotSize = slotSize;
+			block->slotCount = static_cast<uint32_t>(block->size / slotSize);
+
+			// Reversed so slots are handed out front to back
+			block->freeSlots.resize(block->slotCount);
+			for (uint32_t i = 0; i < block->slotCount; i++) { block->freeSlots[i] = block->slotCount - 1 - i; }
+
+			blocks.push_back(std::move(block));
+			blockIt = blocks.end() - 1;
+		}
+
+		Block* block = blockIt->get();
+
+		Allocation allocation;
+		allocation.slot = block->freeSlots.back();
+		block->freeSlots.pop_back();
+		allocation.memory = block->memory;
+		allocation.offset = allocation.slot * slotSize;
+		allocation.size = requirements.size;
+		allocation.mapped = block->mapped == nullptr ? nullptr : static_cast<char*>(block->mapped) + allocation.offset;
+		allocation.pool = Default;
+		allocation.block = block;
+
+		s_Stats[Default].allocationCount++;
+		s_Stats[Default].usedSize += allocation.size;
+
+		return allocation;
+	}
+
+	MemoryAllocator::Allocation MemoryAllocator::AllocateImage(VkImage image, VkMemoryPropertyFlags properties)
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		VkMemoryRequirements memoryRequirements;
+		vkGetImageMemoryRequirements(device, image, &memoryRequirements);
+
+		const Allocation allocation = Allocate(memoryRequirements, properties, false);
+
+		VkResult result = vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+		ASSERT_VULKAN(result);
+
+		return allocation;
+	}
+
+	MemoryAllocator::Allocation MemoryAllocator::AllocateExport(
+		const VkMemoryRequirements& requirements,
+		VkMemoryPropertyFlags properties,
+		const void* pNext)
+	{
+		const uint32_t memoryTypeIndex = VulkanAPI::FindMemoryType(requirements.memoryTypeBits, properties);
+
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		return AllocateDedicated(requirements.size, memoryTypeIndex, pNext, Export);
+	}
+
+	MemoryAllocator::Allocation MemoryAllocator::AllocateFrame(const VkMemoryRequirements& requirements)
+	{
+		const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		std::lock_guard<std::mutex> lock(s_Mutex);
+
+		// The arena is created with the first request, later requests must accept the same memory type
+		if (s_FrameMemory == VK_NULL_HANDLE)
+		{
+			s_FrameMemoryTypeIndex = VulkanAPI::FindMemoryType(requirements.memoryTypeBits, properties);
+			s_FrameMemory = AllocateDeviceMemory(c_FrameArenaSize, s_FrameMemoryTypeIndex, nullptr, Frame, &s_FrameMapped);
+		}
+
+		if ((requirements.memoryTypeBits & (1u << s_FrameMemoryTypeIndex)) == 0)
+		{
+			Log::Error("MemoryAllocator frame arena has an incompatible memory type", true);
+		}
+
+		const VkDeviceSize offset = (s_FrameOffset + requirements.alignment - 1) / requirements.alignment * requirements.alignment;
+		if (offset + requirements.size > c_FrameArenaSize)
+		{
+			Log::Error("MemoryAllocator frame arena is full. Is ResetFrameArena called every frame?", true);
+		}
+		s_FrameOffset = offset + requirements.size;
+
+		Allocation allocation;
+		allocation.memory = s_FrameMemory;
+		allocation.offset = offset;
+		allocation.size = requirements.size;
+		allocation.mapped = static_cast<char*>(s_FrameMapped) + offset;
+		allocation.pool = Frame;
+
+		s_Stats[Frame].allocationCount++;
+		s_Stats[Frame].usedSize = s_FrameOffset;
+
+		return allocation;
+	}
+
+	void MemoryAllocator::ResetFrameArena()
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		s_FrameOffset = 0;
+		s_Stats[Frame].allocationCount = 0;
+		s_Stats[Frame].usedSize = 0;
+	}
+
+	void MemoryAllocator::Free(const Allocation& allocation)
+	{
+		// Frame allocations are released together by ResetFrameArena
+		if (allocation.memory == VK_NULL_HANDLE || allocation.pool == Frame) { return; }
+
+		std::lock_guard<std::mutex> lock(s_Mutex);
+
+		s_Stats[allocation.pool].allocationCount--;
+		s_Stats[allocation.pool].usedSize -= allocation.size;
+
+		if (allocation.block == nullptr)
+		{
+			FreeDeviceMemory(allocation.memory, allocation.size, allocation.pool);
+		}
+		else
+		{
+			Block* block = allocation.block;
+			block->freeSlots.push_back(allocation.slot);
+			if (block->freeSlots.size() < block->slotCount) { return; }
+
+			// One block with free slots stays per size class, so alternating allocate and free does not reach the driver
+			std::vector<std::unique_ptr<Block>>& blocks = s_Blocks[block->key];
+			const bool hasSpare = std::any_of(
+				blocks.begin(),
+				blocks.end(),
+				[block](const std::unique_ptr<Block>& other) { return other.get() != block && !other->freeSlots.empty(); });
+			if (!hasSpare) { return; }
+
+			FreeDeviceMemory(block->memory, block->size, Default);
+			blocks.erase(std::find_if(
+				blocks.begin(),
+				blocks.end(),
+				[block](const std::unique_ptr<Block>& other) { return other.get() == block; }));
+		}
+	}
+
+	MemoryAllocator::PoolStats MemoryAllocator::GetStats(Pool pool)
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		return s_Stats[pool];
+	}
+
+	void MemoryAllocator::LogStats()
+	{
+		const std::array<const char*, PoolCount> poolNames = { "Default", "Export", "Frame" };
+		for (uint32_t pool = 0; pool < PoolCount; pool++)
+		{
+			const PoolStats stats = GetStats(static_cast<Pool>(pool));
+			Log::Info(
+				"Memory pool {}: {} device allocations with {} bytes, {} allocations using {} bytes",
+				poolNames[pool],
+				stats.deviceAllocationCount,
+				stats.reservedSize,
+				stats.allocationCount,
+				stats.usedSize);
+		}
+	}
+
+	MemoryAllocator::Allocation MemoryAllocator::AllocateDedicated(VkDeviceSize size, uint32_t memoryTypeIndex, const void* pNext, Pool pool)
+	{
+		Allocation allocation;
+		allocation.memory = AllocateDeviceMemory(size, memoryTypeIndex, pNext, pool, &allocation.mapped);
+		allocation.offset = 0;
+		allocation.size = size;
+		allocation.pool = pool;
+
+		s_Stats[pool].allocationCount++;
+		s_Stats[pool].usedSize += size;
+
+		return allocation;
+	}
+
+	VkDeviceMemory MemoryAllocator::AllocateDeviceMemory(
+		VkDeviceSize size,
+		uint32_t memoryTypeIndex,
+		const void* pNext,
+		Pool pool,
+		void** mapped)
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		VkMemoryAllocateInfo allocateInfo;
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.pNext = pNext;
+		allocateInfo.allocationSize = size;
+		allocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+		VkDeviceMemory memory;
+		VkResult result = vkAllocateMemory(device, &allocateInfo, nullptr, &memory);
+		ASSERT_VULKAN(result);
+
+		*mapped = nullptr;
+		if (VulkanAPI::GetMemoryTypeProperties(memoryTypeIndex) & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			result = vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped);
+			ASSERT_VULKAN(result);
+		}
+
+		s_Stats[pool].deviceAllocationCount++;
+		s_Stats[pool].reservedSize += size;
+
+		return memory;
+	}
+
+	void MemoryAllocator::FreeDeviceMemory(VkDeviceMemory memory, VkDeviceSize size, Pool pool)
+	{
+		// Freeing implicitly unmaps
+		vkFreeMemory(VulkanAPI::GetDevice(), memory, nullptr);
+
+		s_Stats[pool].deviceAllocationCount--;
+		s_Stats[pool].reservedSize -= size;
+	}
+}
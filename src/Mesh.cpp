@@ -1,5 +1,6 @@
 #include <engine/objects/Mesh.hpp>
 #include <engine/graphics/VulkanAPI.hpp>
+#include <engine/graphics/vulkan/Uploader.hpp>
 
 namespace en
 {
@@ -11,42 +12,26 @@ namespace en
 		// Vertex Buffer
 		VkDeviceSize vertexDataSize = static_cast<VkDeviceSize>(sizeof(PNTVertex) * m_Vertices.size());
 
-		vk::Buffer vertexStagingBuffer(
-			vertexDataSize,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			{});
-		vertexStagingBuffer.SetData(vertexDataSize, m_Vertices.data(), 0, 0);
-
 		m_VertexBuffer = new vk::Buffer(
 			vertexDataSize,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			{});
 
-		vk::Buffer::Copy(&vertexStagingBuffer, m_VertexBuffer, vertexDataSize);
-
-		vertexStagingBuffer.Destroy();
+		vk::Uploader::UploadBuffer(m_VertexBuffer->GetVulkanHandle(), 0, m_Vertices.data(), vertexDataSize);
 
 		// Index Buffer
 		VkDeviceSize indexDataSize = static_cast<VkDeviceSize>(sizeof(uint32_t) * m_Indices.size());
 
-		vk::Buffer indexStagingBuffer(
-			indexDataSize,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			{});
-		indexStagingBuffer.SetData(indexDataSize, m_Indices.data(), 0, 0);
-
 		m_IndexBuffer = new vk::Buffer(
 			indexDataSize,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			{});
 
-		vk::Buffer::Copy(&indexStagingBuffer, m_IndexBuffer, indexDataSize);
+		vk::Uploader::UploadBuffer(m_IndexBuffer->GetVulkanHandle(), 0, m_Indices.data(), indexDataSize);
 
-		indexStagingBuffer.Destroy();
+		vk::Uploader::Flush();
 	}
 
 	void Mesh::DestroyVulkanBuffers()
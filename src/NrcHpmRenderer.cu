@@ -1,9 +1,11 @@
 #include <engine/cuda_common.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
 #include <engine/graphics/NeuralRadianceCache.hpp>
 #include <engine/graphics/renderer/NrcHpmRenderer.hpp>
 #include <engine/util/Log.hpp>
 #include <engine/graphics/vulkan/CommandRecorder.hpp>
-#include <glm/gtc/random.hpp>
+#include <engine/graphics/vulkan/ShaderCompiler.hpp>
+#include <engine/graphics/vulkan/Uploader.hpp>
 #include <imgui.h>
 #include <chrono>
 #include <thread>
@@ -64,6 +66,13 @@ namespace en
 
 	void NrcHpmRenderer::Init(VkDevice device)
 	{
+		vk::ShaderCompiler::Precompile({
+			"nrc/clear.comp",
+			"nrc/gen_rays.comp",
+			"nrc/prep_infer_rays.comp",
+			"nrc/prep_train_rays.comp",
+			"nrc/render.comp" });
+
 		// Create desc set layout
 		uint32_t bindingIndex = 0;
 
@@ -151,6 +160,13 @@ namespace en
 		uniformBufferBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 		uniformBufferBinding.pImmutableSamplers = nullptr;
 
+		VkDescriptorSetLayoutBinding historyImageBinding;
+		historyImageBinding.binding = bindingIndex++;
+		historyImageBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		historyImageBinding.descriptorCount = 1;
+		historyImageBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		historyImageBinding.pImmutableSamplers = nullptr;
+
 		std::vector<VkDescriptorSetLayoutBinding> bindings = {
 			outputImageBinding,
 			primaryRayColorImageBinding,
@@ -163,7 +179,8 @@ namespace en
 			nrcTrainTargetBufferBinding,
 			nrcInferFilterBufferBinding,
 			nrcTrainRingBufferBinding,
-			uniformBufferBinding
+			uniformBufferBinding,
+			historyImageBinding
 		};
 
 		VkDescriptorSetLayoutCreateInfo layoutCI;
@@ -179,10 +196,10 @@ namespace en
 		// Create desc pool
 		VkDescriptorPoolSize storageImagePS;
 		storageImagePS.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-		storageImagePS.descriptorCount = 5;
+		storageImagePS.descriptorCount = 6;
 
 		VkDescriptorPoolSize storageBufferPS;
-		storageBufferPS.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		storageBufferPS.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 		storageBufferPS.descriptorCount = 6;
 
 		VkDescriptorPoolSize uniformBufferPS;
@@ -216,32 +233,37 @@ namespace en
 		const Camera* camera,
 		const AppConfig& appConfig,
 		const HpmScene& hpmScene,
-		NeuralRadianceCache& nrc)
+		NeuralRadianceCache& nrc,
+		uint32_t maxViewCount)
 		:
 		m_RenderWidth(width),
 		m_RenderHeight(height),
+		m_MaxViewCount(maxViewCount),
 		m_TrainSpp(appConfig.trainSpp),
 		m_PrimaryRayLength(appConfig.primaryRayLength),
 		m_PrimaryRayProb(appConfig.primaryRayProb),
 		m_TrainRayLength(appConfig.trainRayLength),
+		m_PrimaryRaySpreadTermination(appConfig.primaryRaySpreadTermination),
 		m_ShouldBlend(blend),
 		m_ClearShader("nrc/clear.comp", false),
 		m_GenRaysShader("nrc/gen_rays.comp", false),
 		m_PrepInferRaysShader("nrc/prep_infer_rays.comp", false),
 		m_PrepTrainRaysShader("nrc/prep_train_rays.comp", false),
 		m_RenderShader("nrc/render.comp", false),
+		m_Timestamps({ "Clear Buffers", "GenRays", "PrepInferRays", "Copy Infer Filter", "PrepTrainRays", "Cuda", "Render" }),
 		m_CommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, VulkanAPI::GetGraphicsQFI()),
-		m_Camera(camera),
+		m_Cameras({ camera }),
 		m_HpmScene(hpmScene),
 		m_Nrc(nrc),
 		m_UniformBuffer(
 			sizeof(UniformData), 
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
 			{})
 	{
 		Log::Info("Creating NrcHpmRenderer");
 
+		if (m_MaxViewCount == 0 || m_MaxViewCount > MAX_CAMERA_COUNT) { Log::Error("NrcHpmRenderer view count is invalid", true); }
 
 		// Calc train subset
 		const uint32_t trainPixelCount = appConfig.trainBatchCount * m_Nrc.GetTrainBatchSize();
@@ -257,7 +279,7 @@ namespace en
 
 		CreateNrcBuffers();
 		m_Nrc.Init(
-			m_RenderWidth * m_RenderHeight,
+			m_MaxViewCount * m_RenderWidth * m_RenderHeight,
 			reinterpret_cast<float*>(m_NrcInferInputDCuBuffer),
 			reinterpret_cast<float*>(m_NrcInferOutputDCuBuffer),
 			reinterpret_cast<float*>(m_NrcTrainInputDCuBuffer),
@@ -267,10 +289,13 @@ namespace en
 		CreateNrcInferFilterBuffer();
 		CreateNrcTrainRingBuffer();
 
-		m_CommandPool.AllocateBuffers(3, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-		m_PreCudaCommandBuffer = m_CommandPool.GetBuffer(0);
-		m_PostCudaCommandBuffer = m_CommandPool.GetBuffer(1);
-		m_RandomTasksCmdBuf = m_CommandPool.GetBuffer(2);
+		m_CommandPool.AllocateBuffers(2 * vk::TimestampQueryRing::c_RingSize + 1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		for (uint32_t slot = 0; slot < vk::TimestampQueryRing::c_RingSize; slot++)
+		{
+			m_PreCudaCommandBuffers[slot] = m_CommandPool.GetBuffer(2 * slot);
+			m_PostCudaCommandBuffers[slot] = m_CommandPool.GetBuffer(2 * slot + 1);
+		}
+		m_RandomTasksCmdBuf = m_CommandPool.GetBuffer(2 * vk::TimestampQueryRing::c_RingSize);
 
 		CreatePipelineLayout(device);
 
@@ -287,32 +312,42 @@ namespace en
 		CreatePrimaryRayInfoImage(device);
 		CreateNrcRayOriginImage(device);
 		CreateNrcRayDirImage(device);
+		CreateHistoryImage(device);
 
 		AllocateAndUpdateDescriptorSet(device);
 
-		CreateQueryPool(device);
-
-		RecordPreCudaCommandBuffer();
-		RecordPostCudaCommandBuffer();
+		for (uint32_t slot = 0; slot < vk::TimestampQueryRing::c_RingSize; slot++)
+		{
+			RecordPreCudaCommandBuffer(slot);
+			RecordPostCudaCommandBuffer(slot);
+		}
 	}
 
 	void NrcHpmRenderer::Render(VkQueue queue, bool train)
 	{
-		// Check if camera moved
-		if (m_Camera->HasChanged()) { m_BlendIndex = 1; }
+		// Check if a camera moved. With temporal reprojection the history is reprojected instead of discarded
+		bool cameraChanged = false;
+		for (const Camera* camera : m_Cameras)
+		{
+			if (camera->HasChanged()) { cameraChanged = true; }
+		}
+		if (cameraChanged && !m_TemporalReprojection) { m_BlendIndex = 1; }
+		m_UniformData.reproject = (cameraChanged && m_TemporalReprojection) ? 1 : 0;
 
 		// Calc blending factor
 		m_UniformData.blendFactor = 1.0 / static_cast<float>(m_BlendIndex);
 
-		// Generate random
-		m_UniformData.random = glm::linearRand(glm::vec4(0.0f), glm::vec4(1.0f));
-
 		// Update uniform buffer
-		m_UniformBuffer.SetData(sizeof(UniformData), &m_UniformData, 0, 0);
+		vk::FramePacer::UpdateBuffer(m_UniformBuffer, sizeof(UniformData), &m_UniformData, 0);
+
+		// Random sequences are keyed by frame, independent of blending
+		m_UniformData.frameIndex++;
 
 		// Update blending index
 		if (m_ShouldBlend) { m_BlendIndex++; }
 		
+		const uint32_t slot = m_Timestamps.NextSlot();
+
 		// Pre cuda
 		VkSubmitInfo submitInfo;
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -321,12 +356,11 @@ namespace en
 		submitInfo.pWaitSemaphores = nullptr;
 		submitInfo.pWaitDstStageMask = nullptr;
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_PreCudaCommandBuffer;
+		submitInfo.pCommandBuffers = &m_PreCudaCommandBuffers[slot];
 		submitInfo.signalSemaphoreCount = 1;
 		submitInfo.pSignalSemaphores = &m_CudaStartSemaphore;
 
-		VkResult result = vkQueueSubmit(queue, 1, &submitInfo, m_PreCudaFence);
-		ASSERT_VULKAN(result);
+		vk::FramePacer::Submit(queue, submitInfo, m_PreCudaFence);
 
 		// Sync infer filter
 		ASSERT_VULKAN(vkWaitForFences(VulkanAPI::GetDevice(), 1, &m_PreCudaFence, VK_TRUE, UINT64_MAX));
@@ -344,12 +378,11 @@ namespace en
 		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 		submitInfo.pWaitDstStageMask = &waitStage;
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_PostCudaCommandBuffer;
+		submitInfo.pCommandBuffers = &m_PostCudaCommandBuffers[slot];
 		submitInfo.signalSemaphoreCount = 0;
 		submitInfo.pSignalSemaphores = nullptr;
 
-		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		ASSERT_VULKAN(result);
+		vk::FramePacer::Submit(queue, submitInfo, VK_NULL_HANDLE);
 	}
 
 	void NrcHpmRenderer::Destroy()
@@ -360,27 +393,9 @@ namespace en
 
 		m_UniformBuffer.Destroy();
 
-		vkDestroyQueryPool(device, m_QueryPool, nullptr);
-
-		vkDestroyImageView(device, m_NrcRayDirImageView, nullptr);
-		vkFreeMemory(device, m_NrcRayDirImageMemory, nullptr);
-		vkDestroyImage(device, m_NrcRayDirImage, nullptr);
-
-		vkDestroyImageView(device, m_NrcRayOriginImageView, nullptr);
-		vkFreeMemory(device, m_NrcRayOriginImageMemory, nullptr);
-		vkDestroyImage(device, m_NrcRayOriginImage, nullptr);
-
-		vkDestroyImageView(device, m_PrimaryRayInfoImageView, nullptr);
-		vkFreeMemory(device, m_PrimaryRayInfoImageMemory, nullptr);
-		vkDestroyImage(device, m_PrimaryRayInfoImage, nullptr);
+		m_Timestamps.Destroy();
 
-		vkDestroyImageView(device, m_PrimaryRayColorImageView, nullptr);
-		vkFreeMemory(device, m_PrimaryRayColorImageMemory, nullptr);
-		vkDestroyImage(device, m_PrimaryRayColorImage, nullptr);
-
-		vkDestroyImageView(device, m_OutputImageView, nullptr);
-		vkFreeMemory(device, m_OutputImageMemory, nullptr);
-		vkDestroyImage(device, m_OutputImage, nullptr);
+		DestroyImages(device);
 
 		vkDestroyPipeline(device, m_RenderPipeline, nullptr);
 		m_RenderShader.Destroy();
@@ -402,27 +417,7 @@ namespace en
 		m_NrcTrainRingBuffer->Destroy();
 		delete m_NrcTrainRingBuffer;
 
-		m_NrcInferFilterBuffer->Destroy();
-		delete m_NrcInferFilterBuffer;
-		m_NrcInferFilterStagingBuffer->Destroy();
-		delete m_NrcInferFilterStagingBuffer;
-		delete m_NrcInferFilterData;
-
-		m_NrcTrainTargetBuffer->Destroy();
-		delete m_NrcTrainTargetBuffer;
-		ASSERT_CUDA(cudaDestroyExternalMemory(m_NrcTrainTargetCuExtMem));
-
-		m_NrcTrainInputBuffer->Destroy();
-		delete m_NrcTrainInputBuffer;
-		ASSERT_CUDA(cudaDestroyExternalMemory(m_NrcTrainInputCuExtMem));
-
-		m_NrcInferOutputBuffer->Destroy();
-		delete m_NrcInferOutputBuffer;
-		ASSERT_CUDA(cudaDestroyExternalMemory(m_NrcInferOutputCuExtMem));
-
-		m_NrcInferInputBuffer->Destroy();
-		delete m_NrcInferInputBuffer;
-		ASSERT_CUDA(cudaDestroyExternalMemory(m_NrcInferInputCuExtMem));
+		DestroyNrcBuffers();
 
 		vkDestroyFence(device, m_PostCudaFence, nullptr);
 		vkDestroyFence(device, m_PreCudaFence, nullptr);
@@ -434,106 +429,40 @@ namespace en
 		ASSERT_CUDA(cudaDestroyExternalSemaphore(m_CuExtCudaStartSemaphore));
 	}
 
-	void NrcHpmRenderer::ExportOutputImageToFile(VkQueue queue, const std::string& filePath) const
+	void NrcHpmRenderer::ExportOutputImageToFile(
+		VkQueue queue,
+		const std::string& filePath,
+		vk::ImageExporter::Compression compression,
+		bool halfFloat) const
 	{
-		const size_t floatCount = m_RenderWidth * m_RenderHeight * 4;
-		const size_t bufferSize = floatCount * sizeof(float);
-
-		vk::Buffer vkBuffer(
-			bufferSize,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			{});
-
-		VkCommandBufferBeginInfo cmdBufBI;
-		cmdBufBI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		cmdBufBI.pNext = nullptr;
-		cmdBufBI.flags = 0;
-		cmdBufBI.pInheritanceInfo = nullptr;
-		ASSERT_VULKAN(vkBeginCommandBuffer(m_RandomTasksCmdBuf, &cmdBufBI));
-
-		VkBufferImageCopy region;
-		region.bufferOffset = 0;
-		region.bufferRowLength = m_RenderWidth;
-		region.bufferImageHeight = m_RenderHeight;
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = 0;
-		region.imageSubresource.baseArrayLayer = 0;
-		region.imageSubresource.layerCount = 1;
-		region.imageOffset = { 0, 0, 0 };
-		region.imageExtent = { m_RenderWidth, m_RenderHeight, 1 };
-
-		vkCmdCopyImageToBuffer(m_RandomTasksCmdBuf, m_OutputImage, VK_IMAGE_LAYOUT_GENERAL, vkBuffer.GetVulkanHandle(), 1, &region);
-
-		ASSERT_VULKAN(vkEndCommandBuffer(m_RandomTasksCmdBuf));
-
-		VkSubmitInfo submitInfo;
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.pNext = nullptr;
-		submitInfo.waitSemaphoreCount = 0;
-		submitInfo.pWaitSemaphores = nullptr;
-		submitInfo.pWaitDstStageMask = nullptr;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_RandomTasksCmdBuf;
-		submitInfo.signalSemaphoreCount = 0;
-		submitInfo.pSignalSemaphores = nullptr;
-
-		ASSERT_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
-		ASSERT_VULKAN(vkQueueWaitIdle(queue));
-
-		std::vector<float> buffer(floatCount);
-		vkBuffer.GetData(bufferSize, buffer.data(), 0, 0);
-		vkBuffer.Destroy();
-
-		// Store in exr file
-		if (TINYEXR_SUCCESS != SaveEXR(buffer.data(), m_RenderWidth, m_RenderHeight, 4, 0, filePath.c_str(), nullptr))
-		{
-			en::Log::Error("TINYEXR Error", true);
-		}
+		vk::ImageExporter::ExportImage(
+			queue,
+			m_OutputImage,
+			VK_IMAGE_LAYOUT_GENERAL,
+			m_RenderWidth,
+			m_RenderHeight,
+			filePath,
+			compression,
+			halfFloat);
 	}
 
 	void NrcHpmRenderer::EvaluateTimestampQueries()
 	{
-		VkDevice device = VulkanAPI::GetDevice();
-		std::vector<uint64_t> queryResults(c_QueryCount);
-		ASSERT_VULKAN(vkGetQueryPoolResults(
-			device,
-			m_QueryPool,
-			0,
-			c_QueryCount,
-			sizeof(uint64_t) * c_QueryCount,
-			queryResults.data(),
-			sizeof(uint64_t),
-			VK_QUERY_RESULT_64_BIT));
-		vkResetQueryPool(device, m_QueryPool, 0, c_QueryCount);
-
-		for (size_t i = 0; i < c_QueryCount - 1; i++)
-		{
-			m_TimePeriods[i] = c_TimestampPeriodInMS * static_cast<float>(queryResults[i + 1] - queryResults[i]);
-		}
-		m_TimePeriods[c_QueryCount - 1] = c_TimestampPeriodInMS * static_cast<float>(queryResults[c_QueryCount - 1] - queryResults[0]);
+		m_Timestamps.Collect();
 	}
 
 	void NrcHpmRenderer::RenderImGui()
 	{
 		ImGui::Begin("NrcHpmRenderer");
 		
-		size_t periodIndex = 0;
-		ImGui::Text("Clear Buffers Time %f ms", m_TimePeriods[periodIndex++]);
-		ImGui::Text("GenRays Time %f ms", m_TimePeriods[periodIndex++]);
-		ImGui::Text("PrepInferRays Time %f ms", m_TimePeriods[periodIndex++]);
-		ImGui::Text("Copy Infer Filter Time %f ms", m_TimePeriods[periodIndex++]);
-		ImGui::Text("PrepTrainRays Time %f ms", m_TimePeriods[periodIndex++]);
-		ImGui::Text("Cuda Time %f ms", m_TimePeriods[periodIndex++]);
-		ImGui::Text("Render Time %f ms", m_TimePeriods[periodIndex++]);
-		ImGui::Text("Total Time %f ms", m_TimePeriods[periodIndex++]);
-		ImGui::Text("Theoretical FPS %f", 1000.0f / m_TimePeriods[c_QueryCount - 1]);
+		m_Timestamps.RenderImGui();
 
 		ImGui::Checkbox("Show NRC", reinterpret_cast<bool*>(&m_UniformData.showNrc));
 
 		ImGui::Checkbox("Blend", &m_ShouldBlend);
 		ImGui::Text("Blend index %u", m_BlendIndex);
 		if (ImGui::Button("Reset blending")) { m_BlendIndex = 1; }
+		ImGui::Checkbox("Temporal reprojection", &m_TemporalReprojection);
 
 		ImGui::End();
 	}
@@ -548,6 +477,11 @@ namespace en
 		return m_OutputImageView;
 	}
 
+	VkImageView NrcHpmRenderer::GetGuideImageView() const
+	{
+		return m_PrimaryRayInfoImageView;
+	}
+
 	bool NrcHpmRenderer::IsBlending() const
 	{
 		return m_ShouldBlend;
@@ -555,16 +489,132 @@ namespace en
 
 	float NrcHpmRenderer::GetFrameTimeMS() const
 	{
-		return m_TimePeriods[c_QueryCount - 1];
+		return m_Timestamps.GetLast(m_Timestamps.GetTotalPass());
+	}
+
+	uint32_t NrcHpmRenderer::GetViewCount() const
+	{
+		return m_Cameras.size();
+	}
+
+	uint32_t NrcHpmRenderer::GetMaxViewCount() const
+	{
+		return m_MaxViewCount;
 	}
 
 	void NrcHpmRenderer::SetCamera(VkQueue queue, const Camera* camera)
 	{
-		// Set members
+		SetCameras(queue, { camera });
+	}
+
+	void NrcHpmRenderer::SetCameras(VkQueue queue, const std::vector<const Camera*>& cameras)
+	{
+		if (cameras.empty() || cameras.size() > m_MaxViewCount) { Log::Error("NrcHpmRenderer camera count is invalid", true); }
+		if (cameras == m_Cameras) { return; }
+
+		// Blend index 1 ignores the history, so a camera jump needs no clear
+		m_BlendIndex = 1;
+		m_Cameras = cameras;
+
+		// Rerecord cmd buf
+		for (uint32_t slot = 0; slot < vk::TimestampQueryRing::c_RingSize; slot++)
+		{
+			RecordPreCudaCommandBuffer(slot);
+			RecordPostCudaCommandBuffer(slot);
+		}
+	}
+
+	void NrcHpmRenderer::SetBlend(bool blend)
+	{
+		m_ShouldBlend = blend;
+		m_BlendIndex = 1;
+	}
+
+	void NrcHpmRenderer::SetRenderSize(VkQueue queue, uint32_t width, uint32_t height)
+	{
+		if (width == m_RenderWidth && height == m_RenderHeight) { return; }
+		if (width % 32 != 0) { Log::Error("NrcHpmRenderer render width must be a multiple of 32", true); }
+
+		// Frames in flight still use the old resources. Waiting for the post cuda submission also waits for cuda
+		vk::FramePacer::WaitIdle();
+
+		m_RenderWidth = width;
+		m_RenderHeight = height;
 		m_BlendIndex = 1;
-		m_Camera = camera;
 
-		// Clear images
+		RecreateSizeDependentResources(queue);
+	}
+
+	void NrcHpmRenderer::SetMaxViewCount(VkQueue queue, uint32_t maxViewCount)
+	{
+		if (maxViewCount == m_MaxViewCount) { return; }
+		if (maxViewCount == 0 || maxViewCount > MAX_CAMERA_COUNT || maxViewCount < m_Cameras.size())
+		{
+			Log::Error("NrcHpmRenderer view count is invalid", true);
+		}
+
+		vk::FramePacer::WaitIdle();
+
+		m_MaxViewCount = maxViewCount;
+		m_BlendIndex = 1;
+
+		RecreateSizeDependentResources(queue);
+	}
+
+	void NrcHpmRenderer::RecreateSizeDependentResources(VkQueue queue)
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		// Destroy size dependent resources. The train ring buffer only holds world space rays and keeps its size
+		vkDestroyPipeline(device, m_RenderPipeline, nullptr);
+		vkDestroyPipeline(device, m_PrepTrainRaysPipeline, nullptr);
+		vkDestroyPipeline(device, m_PrepInferRaysPipeline, nullptr);
+		vkDestroyPipeline(device, m_GenRaysPipeline, nullptr);
+		vkDestroyPipeline(device, m_ClearPipeline, nullptr);
+		DestroyImages(device);
+		DestroyNrcBuffers();
+
+		// Recreate them
+		CalcTrainSubset(m_TrainWidth * m_TrainHeight);
+		if (m_TrainXDist == 0 || m_TrainYDist == 0) { Log::Error("NrcHpmRenderer render size is smaller than the train subset", true); }
+
+		CreateNrcBuffers();
+		m_Nrc.Init(
+			m_MaxViewCount * m_RenderWidth * m_RenderHeight,
+			reinterpret_cast<float*>(m_NrcInferInputDCuBuffer),
+			reinterpret_cast<float*>(m_NrcInferOutputDCuBuffer),
+			reinterpret_cast<float*>(m_NrcTrainInputDCuBuffer),
+			reinterpret_cast<float*>(m_NrcTrainTargetDCuBuffer),
+			m_CuExtCudaStartSemaphore,
+			m_CuExtCudaFinishedSemaphore);
+		CreateNrcInferFilterBuffer();
+
+		InitSpecializationConstants();
+		CreateClearPipeline(device);
+		CreateGenRaysPipeline(device);
+		CreatePrepInferRaysPipeline(device);
+		CreatePrepTrainRaysPipeline(device);
+		CreateRenderPipeline(device);
+
+		CreateOutputImage(device);
+		CreatePrimaryRayColorImage(device);
+		CreatePrimaryRayInfoImage(device);
+		CreateNrcRayOriginImage(device);
+		CreateNrcRayDirImage(device);
+		CreateHistoryImage(device);
+		ClearImages(queue);
+
+		UpdateDescriptorSet(device);
+
+		for (uint32_t slot = 0; slot < vk::TimestampQueryRing::c_RingSize; slot++)
+		{
+			RecordPreCudaCommandBuffer(slot);
+			RecordPostCudaCommandBuffer(slot);
+		}
+	}
+
+	void NrcHpmRenderer::ClearImages(VkQueue queue)
+	{
 		VkCommandBufferBeginInfo beginInfo;
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		beginInfo.pNext = nullptr;
@@ -578,10 +628,11 @@ namespace en
 		subresourceRange.baseMipLevel = 0;
 		subresourceRange.levelCount = 1;
 		subresourceRange.baseArrayLayer = 0;
-		subresourceRange.layerCount = 1;
+		subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
 		vkCmdClearColorImage(m_RandomTasksCmdBuf, m_OutputImage, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
 		vkCmdClearColorImage(m_RandomTasksCmdBuf, m_PrimaryRayColorImage, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
 		vkCmdClearColorImage(m_RandomTasksCmdBuf, m_PrimaryRayInfoImage, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
+		vkCmdClearColorImage(m_RandomTasksCmdBuf, m_HistoryImage, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
 
 		ASSERT_VULKAN(vkEndCommandBuffer(m_RandomTasksCmdBuf));
 
@@ -597,16 +648,6 @@ namespace en
 		submitInfo.pSignalSemaphores = nullptr;
 		ASSERT_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
 		ASSERT_VULKAN(vkQueueWaitIdle(queue));
-
-		// Rerecord cmd buf
-		RecordPreCudaCommandBuffer();
-		RecordPostCudaCommandBuffer();
-	}
-
-	void NrcHpmRenderer::SetBlend(bool blend)
-	{
-		m_ShouldBlend = blend;
-		m_BlendIndex = 1;
 	}
 
 	void NrcHpmRenderer::CalcTrainSubset(uint32_t trainPixelCount)
@@ -701,8 +742,8 @@ namespace en
 	{
 		Log::Info("NrcHpmRenderer: Creating nrc buffers");
 
-		// Calculate sizes
-		const size_t inferCount = m_RenderWidth * m_RenderHeight;
+		// Calculate sizes. Every view owns a slice of the infer buffers
+		const size_t inferCount = m_MaxViewCount * m_RenderWidth * m_RenderHeight;
 		//inferCount += m_Nrc.GetInferBatchSize() - (inferCount % m_Nrc.GetTrainBatchSize());
 		const size_t trainCount = m_TrainWidth * m_TrainHeight;
 
@@ -850,12 +891,6 @@ namespace en
 			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			{});
 
-		vk::Buffer stagingBuffer(
-			m_NrcTrainRingBufferSize,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			{});
-
 		void* nrcTrainRingData = malloc(m_NrcTrainRingBufferSize);
 		
 		uint32_t* indexData = reinterpret_cast<uint32_t*>(nrcTrainRingData);
@@ -874,10 +909,40 @@ namespace en
 			rayData[(6 * ray) + 5] = 1.0f;
 		}
 
-		stagingBuffer.SetData(m_NrcTrainRingBufferSize, nrcTrainRingData, 0, 0);
-		vk::Buffer::Copy(&stagingBuffer, m_NrcTrainRingBuffer, m_NrcTrainRingBufferSize);
+		vk::Uploader::UploadBuffer(m_NrcTrainRingBuffer->GetVulkanHandle(), 0, nrcTrainRingData, m_NrcTrainRingBufferSize);
+		vk::Uploader::Flush();
 
-		stagingBuffer.Destroy();
+		free(nrcTrainRingData);
+	}
+
+	void NrcHpmRenderer::DestroyNrcBuffers()
+	{
+		m_NrcInferFilterBuffer->Destroy();
+		delete m_NrcInferFilterBuffer;
+		m_NrcInferFilterStagingBuffer->Destroy();
+		delete m_NrcInferFilterStagingBuffer;
+		free(m_NrcInferFilterData);
+
+		// Mapped buffers are freed before their external memory is destroyed
+		ASSERT_CUDA(cudaFree(m_NrcTrainTargetDCuBuffer));
+		ASSERT_CUDA(cudaDestroyExternalMemory(m_NrcTrainTargetCuExtMem));
+		m_NrcTrainTargetBuffer->Destroy();
+		delete m_NrcTrainTargetBuffer;
+
+		ASSERT_CUDA(cudaFree(m_NrcTrainInputDCuBuffer));
+		ASSERT_CUDA(cudaDestroyExternalMemory(m_NrcTrainInputCuExtMem));
+		m_NrcTrainInputBuffer->Destroy();
+		delete m_NrcTrainInputBuffer;
+
+		ASSERT_CUDA(cudaFree(m_NrcInferOutputDCuBuffer));
+		ASSERT_CUDA(cudaDestroyExternalMemory(m_NrcInferOutputCuExtMem));
+		m_NrcInferOutputBuffer->Destroy();
+		delete m_NrcInferOutputBuffer;
+
+		ASSERT_CUDA(cudaFree(m_NrcInferInputDCuBuffer));
+		ASSERT_CUDA(cudaDestroyExternalMemory(m_NrcInferInputCuExtMem));
+		m_NrcInferInputBuffer->Destroy();
+		delete m_NrcInferInputBuffer;
 	}
 
 	void NrcHpmRenderer::CreatePipelineLayout(VkDevice device)
@@ -892,14 +957,20 @@ namespace en
 			HdrEnvMap::GetDescriptorSetLayout(),
 			m_DescSetLayout };
 
+		// View index
+		VkPushConstantRange viewRange;
+		viewRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		viewRange.offset = 0;
+		viewRange.size = sizeof(uint32_t);
+
 		VkPipelineLayoutCreateInfo layoutCreateInfo;
 		layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		layoutCreateInfo.pNext = nullptr;
 		layoutCreateInfo.flags = 0;
 		layoutCreateInfo.setLayoutCount = layouts.size();
 		layoutCreateInfo.pSetLayouts = layouts.data();
-		layoutCreateInfo.pushConstantRangeCount = 0;
-		layoutCreateInfo.pPushConstantRanges = nullptr;
+		layoutCreateInfo.pushConstantRangeCount = 1;
+		layoutCreateInfo.pPushConstantRanges = &viewRange;
 
 		VkResult result = vkCreatePipelineLayout(device, &layoutCreateInfo, nullptr, &m_PipelineLayout);
 		ASSERT_VULKAN(result);
@@ -935,6 +1006,12 @@ namespace en
 
 		m_SpecData.hdrEnvMapStrength = m_HpmScene.GetHdrEnvMap()->GetStrength();
 
+		m_SpecData.primaryRaySpreadTermination = m_PrimaryRaySpreadTermination ? VK_TRUE : VK_FALSE;
+		m_SpecData.residualRatioTracking = m_HpmScene.GetVolumeData()->UsesResidualRatioTracking() ? VK_TRUE : VK_FALSE;
+		m_SpecData.dirLightTransmittanceCache = m_HpmScene.UsesDirLightTransmittanceCache() ? VK_TRUE : VK_FALSE;
+		m_SpecData.pointLightTransmittanceCache = m_HpmScene.UsesPointLightTransmittanceCache() ? VK_TRUE : VK_FALSE;
+		m_SpecData.emptySpaceSkipping = m_HpmScene.GetVolumeData()->UsesEmptySpaceSkipping() ? VK_TRUE : VK_FALSE;
+
 		// Init map entries
 		uint32_t constantID = 0;
 
@@ -1033,6 +1110,31 @@ namespace en
 		hdrEnvMapStrengthEntry.offset = offsetof(SpecializationData, SpecializationData::hdrEnvMapStrength);
 		hdrEnvMapStrengthEntry.size = sizeof(float);
 
+		VkSpecializationMapEntry primaryRaySpreadTerminationEntry;
+		primaryRaySpreadTerminationEntry.constantID = constantID++;
+		primaryRaySpreadTerminationEntry.offset = offsetof(SpecializationData, SpecializationData::primaryRaySpreadTermination);
+		primaryRaySpreadTerminationEntry.size = sizeof(uint32_t);
+
+		VkSpecializationMapEntry residualRatioTrackingEntry;
+		residualRatioTrackingEntry.constantID = constantID++;
+		residualRatioTrackingEntry.offset = offsetof(SpecializationData, SpecializationData::residualRatioTracking);
+		residualRatioTrackingEntry.size = sizeof(uint32_t);
+
+		VkSpecializationMapEntry dirLightTransmittanceCacheEntry;
+		dirLightTransmittanceCacheEntry.constantID = constantID++;
+		dirLightTransmittanceCacheEntry.offset = offsetof(SpecializationData, SpecializationData::dirLightTransmittanceCache);
+		dirLightTransmittanceCacheEntry.size = sizeof(uint32_t);
+
+		VkSpecializationMapEntry pointLightTransmittanceCacheEntry;
+		pointLightTransmittanceCacheEntry.constantID = constantID++;
+		pointLightTransmittanceCacheEntry.offset = offsetof(SpecializationData, SpecializationData::pointLightTransmittanceCache);
+		pointLightTransmittanceCacheEntry.size = sizeof(uint32_t);
+
+		VkSpecializationMapEntry emptySpaceSkippingEntry;
+		emptySpaceSkippingEntry.constantID = constantID++;
+		emptySpaceSkippingEntry.offset = offsetof(SpecializationData, SpecializationData::emptySpaceSkipping);
+		emptySpaceSkippingEntry.size = sizeof(uint32_t);
+
 		m_SpecMapEntries = {
 			renderWidthEntry,
 			renderHeightEntry,
@@ -1044,6 +1146,7 @@ namespace en
 			primaryRayLengthEntry,
 			primaryRayProbEntry,
 			trainRingBufSizeEntry,
+			trainRayLengthEntry,
 			inferBatchSizeEntry,
 			trainBatchSizeEntry,
 			volumeSizeXEntry,
@@ -1051,7 +1154,12 @@ namespace en
 			volumeSizeZEntry,
 			volumeDensityFactorEntry,
 			volumeGEntry,
-			hdrEnvMapStrengthEntry
+			hdrEnvMapStrengthEntry,
+			primaryRaySpreadTerminationEntry,
+			residualRatioTrackingEntry,
+			dirLightTransmittanceCacheEntry,
+			pointLightTransmittanceCacheEntry,
+			emptySpaceSkippingEntry
 		};
 
 		m_SpecInfo.mapEntryCount = m_SpecMapEntries.size();
@@ -1080,7 +1188,7 @@ namespace en
 		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineCI.basePipelineIndex = 0;
 
-		VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_ClearPipeline);
+		VkResult result = VulkanAPI::CreateComputePipeline(pipelineCI, &m_ClearPipeline);
 		ASSERT_VULKAN(result);
 	}
 
@@ -1104,7 +1212,7 @@ namespace en
 		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineCI.basePipelineIndex = 0;
 
-		VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_GenRaysPipeline);
+		VkResult result = VulkanAPI::CreateComputePipeline(pipelineCI, &m_GenRaysPipeline);
 		ASSERT_VULKAN(result);
 	}
 
@@ -1128,7 +1236,7 @@ namespace en
 		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineCI.basePipelineIndex = 0;
 
-		VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_PrepInferRaysPipeline);
+		VkResult result = VulkanAPI::CreateComputePipeline(pipelineCI, &m_PrepInferRaysPipeline);
 		ASSERT_VULKAN(result);
 	}
 
@@ -1152,7 +1260,7 @@ namespace en
 		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineCI.basePipelineIndex = 0;
 
-		VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_PrepTrainRaysPipeline);
+		VkResult result = VulkanAPI::CreateComputePipeline(pipelineCI, &m_PrepTrainRaysPipeline);
 		ASSERT_VULKAN(result);
 	}
 
@@ -1176,7 +1284,7 @@ namespace en
 		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineCI.basePipelineIndex = 0;
 
-		VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_RenderPipeline);
+		VkResult result = VulkanAPI::CreateComputePipeline(pipelineCI, &m_RenderPipeline);
 		ASSERT_VULKAN(result);
 	}
 
@@ -1193,7 +1301,7 @@ namespace en
 		imageCI.format = format;
 		imageCI.extent = { m_RenderWidth, m_RenderHeight, 1 };
 		imageCI.mipLevels = 1;
-		imageCI.arrayLayers = 1;
+		imageCI.arrayLayers = m_MaxViewCount;
 		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
 		imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
@@ -1206,22 +1314,7 @@ namespace en
 		ASSERT_VULKAN(result);
 
 		// Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_OutputImage, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_OutputImageMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_OutputImage, m_OutputImageMemory, 0);
-		ASSERT_VULKAN(result);
+		m_OutputImageMemory = vk::MemoryAllocator::AllocateImage(m_OutputImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Create image view
 		VkImageViewCreateInfo imageViewCI;
@@ -1244,6 +1337,13 @@ namespace en
 		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_OutputImageView);
 		ASSERT_VULKAN(result);
 
+		// Shaders access all layers
+		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+		imageViewCI.subresourceRange.layerCount = m_MaxViewCount;
+
+		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_OutputArrayView);
+		ASSERT_VULKAN(result);
+
 		// Change image layout
 		VkCommandBufferBeginInfo beginInfo;
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -1298,7 +1398,7 @@ namespace en
 		imageCI.format = format;
 		imageCI.extent = { m_RenderWidth, m_RenderHeight, 1 };
 		imageCI.mipLevels = 1;
-		imageCI.arrayLayers = 1;
+		imageCI.arrayLayers = m_MaxViewCount;
 		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
 		imageCI.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
@@ -1311,22 +1411,7 @@ namespace en
 		ASSERT_VULKAN(result);
 
 		// Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_PrimaryRayColorImage, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_PrimaryRayColorImageMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_PrimaryRayColorImage, m_PrimaryRayColorImageMemory, 0);
-		ASSERT_VULKAN(result);
+		m_PrimaryRayColorImageMemory = vk::MemoryAllocator::AllocateImage(m_PrimaryRayColorImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Create image view
 		VkImageViewCreateInfo imageViewCI;
@@ -1334,7 +1419,7 @@ namespace en
 		imageViewCI.pNext = nullptr;
 		imageViewCI.flags = 0;
 		imageViewCI.image = m_PrimaryRayColorImage;
-		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
 		imageViewCI.format = format;
 		imageViewCI.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
 		imageViewCI.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -1344,7 +1429,7 @@ namespace en
 		imageViewCI.subresourceRange.baseMipLevel = 0;
 		imageViewCI.subresourceRange.levelCount = 1;
 		imageViewCI.subresourceRange.baseArrayLayer = 0;
-		imageViewCI.subresourceRange.layerCount = 1;
+		imageViewCI.subresourceRange.layerCount = m_MaxViewCount;
 
 		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_PrimaryRayColorImageView);
 		ASSERT_VULKAN(result);
@@ -1403,7 +1488,7 @@ namespace en
 		imageCI.format = format;
 		imageCI.extent = { m_RenderWidth, m_RenderHeight, 1 };
 		imageCI.mipLevels = 1;
-		imageCI.arrayLayers = 1;
+		imageCI.arrayLayers = m_MaxViewCount;
 		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
 		imageCI.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
@@ -1416,22 +1501,7 @@ namespace en
 		ASSERT_VULKAN(result);
 
 		// Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_PrimaryRayInfoImage, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_PrimaryRayInfoImageMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_PrimaryRayInfoImage, m_PrimaryRayInfoImageMemory, 0);
-		ASSERT_VULKAN(result);
+		m_PrimaryRayInfoImageMemory = vk::MemoryAllocator::AllocateImage(m_PrimaryRayInfoImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Create image view
 		VkImageViewCreateInfo imageViewCI;
@@ -1454,6 +1524,13 @@ namespace en
 		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_PrimaryRayInfoImageView);
 		ASSERT_VULKAN(result);
 
+		// Shaders access all layers
+		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+		imageViewCI.subresourceRange.layerCount = m_MaxViewCount;
+
+		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_PrimaryRayInfoArrayView);
+		ASSERT_VULKAN(result);
+
 		// Change image layout
 		VkCommandBufferBeginInfo beginInfo;
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -1508,7 +1585,7 @@ namespace en
 		imageCI.format = format;
 		imageCI.extent = { m_RenderWidth, m_RenderHeight, 1 };
 		imageCI.mipLevels = 1;
-		imageCI.arrayLayers = 1;
+		imageCI.arrayLayers = m_MaxViewCount;
 		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
 		imageCI.usage = VK_IMAGE_USAGE_STORAGE_BIT;
@@ -1521,22 +1598,7 @@ namespace en
 		ASSERT_VULKAN(result);
 
 		// Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_NrcRayOriginImage, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_NrcRayOriginImageMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_NrcRayOriginImage, m_NrcRayOriginImageMemory, 0);
-		ASSERT_VULKAN(result);
+		m_NrcRayOriginImageMemory = vk::MemoryAllocator::AllocateImage(m_NrcRayOriginImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Create image view
 		VkImageViewCreateInfo imageViewCI;
@@ -1544,7 +1606,7 @@ namespace en
 		imageViewCI.pNext = nullptr;
 		imageViewCI.flags = 0;
 		imageViewCI.image = m_NrcRayOriginImage;
-		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
 		imageViewCI.format = format;
 		imageViewCI.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
 		imageViewCI.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -1554,7 +1616,7 @@ namespace en
 		imageViewCI.subresourceRange.baseMipLevel = 0;
 		imageViewCI.subresourceRange.levelCount = 1;
 		imageViewCI.subresourceRange.baseArrayLayer = 0;
-		imageViewCI.subresourceRange.layerCount = 1;
+		imageViewCI.subresourceRange.layerCount = m_MaxViewCount;
 
 		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_NrcRayOriginImageView);
 		ASSERT_VULKAN(result);
@@ -1613,7 +1675,7 @@ namespace en
 		imageCI.format = format;
 		imageCI.extent = { m_RenderWidth, m_RenderHeight, 1 };
 		imageCI.mipLevels = 1;
-		imageCI.arrayLayers = 1;
+		imageCI.arrayLayers = m_MaxViewCount;
 		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
 		imageCI.usage = VK_IMAGE_USAGE_STORAGE_BIT;
@@ -1626,22 +1688,7 @@ namespace en
 		ASSERT_VULKAN(result);
 
 		// Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_NrcRayDirImage, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_NrcRayDirImageMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_NrcRayDirImage, m_NrcRayDirImageMemory, 0);
-		ASSERT_VULKAN(result);
+		m_NrcRayDirImageMemory = vk::MemoryAllocator::AllocateImage(m_NrcRayDirImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Create image view
 		VkImageViewCreateInfo imageViewCI;
@@ -1649,7 +1696,7 @@ namespace en
 		imageViewCI.pNext = nullptr;
 		imageViewCI.flags = 0;
 		imageViewCI.image = m_NrcRayDirImage;
-		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
 		imageViewCI.format = format;
 		imageViewCI.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
 		imageViewCI.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -1659,7 +1706,7 @@ namespace en
 		imageViewCI.subresourceRange.baseMipLevel = 0;
 		imageViewCI.subresourceRange.levelCount = 1;
 		imageViewCI.subresourceRange.baseArrayLayer = 0;
-		imageViewCI.subresourceRange.layerCount = 1;
+		imageViewCI.subresourceRange.layerCount = m_MaxViewCount;
 
 		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_NrcRayDirImageView);
 		ASSERT_VULKAN(result);
@@ -1705,6 +1752,125 @@ namespace en
 		ASSERT_VULKAN(result);
 	}
 
+	void NrcHpmRenderer::CreateHistoryImage(VkDevice device)
+	{
+		VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT;
+
+		// Create Image
+		VkImageCreateInfo imageCI;
+		imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageCI.pNext = nullptr;
+		imageCI.flags = 0;
+		imageCI.imageType = VK_IMAGE_TYPE_2D;
+		imageCI.format = format;
+		imageCI.extent = { m_RenderWidth, m_RenderHeight, 1 };
+		imageCI.mipLevels = 1;
+		imageCI.arrayLayers = 2 * m_MaxViewCount;
+		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageCI.queueFamilyIndexCount = 0;
+		imageCI.pQueueFamilyIndices = nullptr;
+		imageCI.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+
+		VkResult result = vkCreateImage(device, &imageCI, nullptr, &m_HistoryImage);
+		ASSERT_VULKAN(result);
+
+		// Image Memory
+		m_HistoryImageMemory = vk::MemoryAllocator::AllocateImage(m_HistoryImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		// Create image view
+		VkImageViewCreateInfo imageViewCI;
+		imageViewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		imageViewCI.pNext = nullptr;
+		imageViewCI.flags = 0;
+		imageViewCI.image = m_HistoryImage;
+		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+		imageViewCI.format = format;
+		imageViewCI.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageViewCI.subresourceRange.baseMipLevel = 0;
+		imageViewCI.subresourceRange.levelCount = 1;
+		imageViewCI.subresourceRange.baseArrayLayer = 0;
+		imageViewCI.subresourceRange.layerCount = 2 * m_MaxViewCount;
+
+		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_HistoryImageView);
+		ASSERT_VULKAN(result);
+
+		// Change image layout
+		VkCommandBufferBeginInfo beginInfo;
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.pNext = nullptr;
+		beginInfo.flags = 0;
+		beginInfo.pInheritanceInfo = nullptr;
+
+		result = vkBeginCommandBuffer(m_RandomTasksCmdBuf, &beginInfo);
+		ASSERT_VULKAN(result);
+
+		vk::CommandRecorder::ImageLayoutTransfer(
+			m_RandomTasksCmdBuf,
+			m_HistoryImage,
+			VK_IMAGE_LAYOUT_PREINITIALIZED,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_ACCESS_NONE,
+			VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+		result = vkEndCommandBuffer(m_RandomTasksCmdBuf);
+		ASSERT_VULKAN(result);
+
+		VkSubmitInfo submitInfo;
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = nullptr;
+		submitInfo.waitSemaphoreCount = 0;
+		submitInfo.pWaitSemaphores = nullptr;
+		submitInfo.pWaitDstStageMask = nullptr;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &m_RandomTasksCmdBuf;
+		submitInfo.signalSemaphoreCount = 0;
+		submitInfo.pSignalSemaphores = nullptr;
+
+		VkQueue queue = VulkanAPI::GetGraphicsQueue();
+		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		ASSERT_VULKAN(result);
+		result = vkQueueWaitIdle(queue);
+		ASSERT_VULKAN(result);
+	}
+
+	void NrcHpmRenderer::DestroyImages(VkDevice device)
+	{
+		vkDestroyImageView(device, m_HistoryImageView, nullptr);
+		vk::MemoryAllocator::Free(m_HistoryImageMemory);
+		vkDestroyImage(device, m_HistoryImage, nullptr);
+
+		vkDestroyImageView(device, m_NrcRayDirImageView, nullptr);
+		vk::MemoryAllocator::Free(m_NrcRayDirImageMemory);
+		vkDestroyImage(device, m_NrcRayDirImage, nullptr);
+
+		vkDestroyImageView(device, m_NrcRayOriginImageView, nullptr);
+		vk::MemoryAllocator::Free(m_NrcRayOriginImageMemory);
+		vkDestroyImage(device, m_NrcRayOriginImage, nullptr);
+
+		vkDestroyImageView(device, m_PrimaryRayInfoArrayView, nullptr);
+		vkDestroyImageView(device, m_PrimaryRayInfoImageView, nullptr);
+		vk::MemoryAllocator::Free(m_PrimaryRayInfoImageMemory);
+		vkDestroyImage(device, m_PrimaryRayInfoImage, nullptr);
+
+		vkDestroyImageView(device, m_PrimaryRayColorImageView, nullptr);
+		vk::MemoryAllocator::Free(m_PrimaryRayColorImageMemory);
+		vkDestroyImage(device, m_PrimaryRayColorImage, nullptr);
+
+		vkDestroyImageView(device, m_OutputArrayView, nullptr);
+		vkDestroyImageView(device, m_OutputImageView, nullptr);
+		vk::MemoryAllocator::Free(m_OutputImageMemory);
+		vkDestroyImage(device, m_OutputImage, nullptr);
+	}
+
 	void NrcHpmRenderer::AllocateAndUpdateDescriptorSet(VkDevice device)
 	{
 		// Allocate
@@ -1718,13 +1884,17 @@ namespace en
 		VkResult result = vkAllocateDescriptorSets(device, &descSetAI, &m_DescSet);
 		ASSERT_VULKAN(result);
 
-		// Write
+		UpdateDescriptorSet(device);
+	}
+
+	void NrcHpmRenderer::UpdateDescriptorSet(VkDevice device)
+	{
 		// Storage image writes
 		uint32_t bindingIndex = 0;
 
 		VkDescriptorImageInfo outputImageInfo;
 		outputImageInfo.sampler = VK_NULL_HANDLE;
-		outputImageInfo.imageView = m_OutputImageView;
+		outputImageInfo.imageView = m_OutputArrayView;
 		outputImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 		VkWriteDescriptorSet outputImageWrite;
@@ -1758,7 +1928,7 @@ namespace en
 
 		VkDescriptorImageInfo primaryRayInfoImageInfo;
 		primaryRayInfoImageInfo.sampler = VK_NULL_HANDLE;
-		primaryRayInfoImageInfo.imageView = m_PrimaryRayInfoImageView;
+		primaryRayInfoImageInfo.imageView = m_PrimaryRayInfoArrayView;
 		primaryRayInfoImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 		VkWriteDescriptorSet primaryRayInfoImageWrite;
@@ -1928,6 +2098,24 @@ namespace en
 		uniformBufferWrite.pBufferInfo = &uniformBufferInfo;
 		uniformBufferWrite.pTexelBufferView = nullptr;
 
+		// History image write
+		VkDescriptorImageInfo historyImageInfo;
+		historyImageInfo.sampler = VK_NULL_HANDLE;
+		historyImageInfo.imageView = m_HistoryImageView;
+		historyImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet historyImageWrite;
+		historyImageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		historyImageWrite.pNext = nullptr;
+		historyImageWrite.dstSet = m_DescSet;
+		historyImageWrite.dstBinding = bindingIndex++;
+		historyImageWrite.dstArrayElement = 0;
+		historyImageWrite.descriptorCount = 1;
+		historyImageWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		historyImageWrite.pImageInfo = &historyImageInfo;
+		historyImageWrite.pBufferInfo = nullptr;
+		historyImageWrite.pTexelBufferView = nullptr;
+
 		// Write writes
 		std::vector<VkWriteDescriptorSet> writes = { 
 			outputImageWrite,
@@ -1941,84 +2129,90 @@ namespace en
 			nrcTrainTargetBufferWrite,
 			nrcInferFilterBufferWrite,
 			nrcTrainRingBufferWrite,
-			uniformBufferWrite
+			uniformBufferWrite,
+			historyImageWrite
 		};
 
 		vkUpdateDescriptorSets(device, writes.size(), writes.data(), 0, nullptr);
 	}
 
-	void NrcHpmRenderer::CreateQueryPool(VkDevice device)
+	void NrcHpmRenderer::CmdBindView(VkCommandBuffer commandBuffer, uint32_t view) const
 	{
-		VkQueryPoolCreateInfo queryPoolCI;
-		queryPoolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
-		queryPoolCI.pNext = nullptr;
-		queryPoolCI.flags = 0;
-		queryPoolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
-		queryPoolCI.queryCount = c_QueryCount;
-		queryPoolCI.pipelineStatistics = 0;
-
-		ASSERT_VULKAN(vkCreateQueryPool(device, &queryPoolCI, nullptr, &m_QueryPool));
+		// Only the camera set changes between views, the other sets stay bound
+		const VkDescriptorSet cameraDescSet = m_Cameras[view]->GetDescriptorSet();
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &cameraDescSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &view);
 	}
 
-	void NrcHpmRenderer::RecordPreCudaCommandBuffer()
+	void NrcHpmRenderer::RecordPreCudaCommandBuffer(uint32_t slot)
 	{
+		VkCommandBuffer commandBuffer = m_PreCudaCommandBuffers[slot];
+
 		m_QueryIndex = 0;
 
 		// Begin
 		VkCommandBufferBeginInfo beginInfo;
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		beginInfo.pNext = nullptr;
-		beginInfo.flags = 0;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
 		beginInfo.pInheritanceInfo = nullptr;
 		
-		VkResult result = vkBeginCommandBuffer(m_PreCudaCommandBuffer, &beginInfo);
+		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
 		ASSERT_VULKAN(result);
 		
 		// Collect descriptor sets
-		std::vector<VkDescriptorSet> descSets = { m_Camera->GetDescriptorSet() };
+		std::vector<VkDescriptorSet> descSets = { m_Cameras[0]->GetDescriptorSet() };
 		const std::vector<VkDescriptorSet>& hpmSceneDescSets = m_HpmScene.GetDescriptorSets();
 		descSets.insert(descSets.end(), hpmSceneDescSets.begin(), hpmSceneDescSets.end());
 		descSets.push_back(m_DescSet);
 
 		// Bind descriptor sets
 		vkCmdBindDescriptorSets(
-			m_PreCudaCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout,
+			commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout,
 			0, descSets.size(), descSets.data(),
 			0, nullptr);
 
 		// Reset query pool
-		vkCmdResetQueryPool(m_PreCudaCommandBuffer, m_QueryPool, 0, c_QueryCount);
+		m_Timestamps.CmdReset(commandBuffer, slot);
 		
 		// Timestamp
-		vkCmdWriteTimestamp(m_PreCudaCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, m_QueryIndex++);
+		m_Timestamps.CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot, m_QueryIndex++);
 
 		// Clear buffers
-		vkCmdFillBuffer(m_PreCudaCommandBuffer, m_NrcInferInputBuffer->GetVulkanHandle(), 0, VK_WHOLE_SIZE, 0);
-		vkCmdFillBuffer(m_PreCudaCommandBuffer, m_NrcInferOutputBuffer->GetVulkanHandle(), 0, VK_WHOLE_SIZE, 0);
-		vkCmdFillBuffer(m_PreCudaCommandBuffer, m_NrcTrainInputBuffer->GetVulkanHandle(), 0, VK_WHOLE_SIZE, 0);
-		vkCmdFillBuffer(m_PreCudaCommandBuffer, m_NrcTrainTargetBuffer->GetVulkanHandle(), 0, VK_WHOLE_SIZE, 0);
-		vkCmdFillBuffer(m_PreCudaCommandBuffer, m_NrcInferFilterBuffer->GetVulkanHandle(), 0, VK_WHOLE_SIZE, 0);
+		vkCmdFillBuffer(commandBuffer, m_NrcInferInputBuffer->GetVulkanHandle(), 0, VK_WHOLE_SIZE, 0);
+		vkCmdFillBuffer(commandBuffer, m_NrcInferOutputBuffer->GetVulkanHandle(), 0, VK_WHOLE_SIZE, 0);
+		vkCmdFillBuffer(commandBuffer, m_NrcTrainInputBuffer->GetVulkanHandle(), 0, VK_WHOLE_SIZE, 0);
+		vkCmdFillBuffer(commandBuffer, m_NrcTrainTargetBuffer->GetVulkanHandle(), 0, VK_WHOLE_SIZE, 0);
+		vkCmdFillBuffer(commandBuffer, m_NrcInferFilterBuffer->GetVulkanHandle(), 0, VK_WHOLE_SIZE, 0);
 
 		// Clear using shader
-		vkCmdBindPipeline(m_PreCudaCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ClearPipeline);
-		vkCmdDispatch(m_PreCudaCommandBuffer, 1, 1, 1);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ClearPipeline);
+		vkCmdDispatch(commandBuffer, 1, 1, 1);
 
 		// Timestamp
-		vkCmdWriteTimestamp(m_PreCudaCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_QueryPool, m_QueryIndex++);
+		m_Timestamps.CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, slot, m_QueryIndex++);
 
-		// Gen rays pipeline
-		vkCmdBindPipeline(m_PreCudaCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_GenRaysPipeline);
-		vkCmdDispatch(m_PreCudaCommandBuffer, m_RenderWidth / 32, m_RenderHeight, 1);
+		// Gen rays pipeline, one dispatch per view
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_GenRaysPipeline);
+		for (uint32_t view = 0; view < m_Cameras.size(); view++)
+		{
+			CmdBindView(commandBuffer, view);
+			vkCmdDispatch(commandBuffer, m_RenderWidth / 32, m_RenderHeight, 1);
+		}
 
 		// Timestamp
-		vkCmdWriteTimestamp(m_PreCudaCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_QueryPool, m_QueryIndex++);
+		m_Timestamps.CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, slot, m_QueryIndex++);
 
-		// Prep infer rays
-		vkCmdBindPipeline(m_PreCudaCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PrepInferRaysPipeline);
-		vkCmdDispatch(m_PreCudaCommandBuffer, m_RenderWidth / 32, m_RenderHeight, 1);
+		// Prep infer rays. All views land in the same infer buffers and are inferred by one cuda pass
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PrepInferRaysPipeline);
+		for (uint32_t view = 0; view < m_Cameras.size(); view++)
+		{
+			CmdBindView(commandBuffer, view);
+			vkCmdDispatch(commandBuffer, m_RenderWidth / 32, m_RenderHeight, 1);
+		}
 
 		// Timestamp
-		vkCmdWriteTimestamp(m_PreCudaCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_QueryPool, m_QueryIndex++);
+		m_Timestamps.CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, slot, m_QueryIndex++);
 
 		// Copy nrc infer filter buffer to host
 		VkBufferCopy nrcInferFilterCopy;
@@ -2026,63 +2220,115 @@ namespace en
 		nrcInferFilterCopy.dstOffset = 0;
 		nrcInferFilterCopy.size = m_NrcInferFilterBufferSize;
 		vkCmdCopyBuffer(
-			m_PreCudaCommandBuffer, 
+			commandBuffer, 
 			m_NrcInferFilterBuffer->GetVulkanHandle(), 
 			m_NrcInferFilterStagingBuffer->GetVulkanHandle(), 
 			1, 
 			&nrcInferFilterCopy);
 
 		// Timestamp
-		vkCmdWriteTimestamp(m_PreCudaCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_QueryPool, m_QueryIndex++);
+		m_Timestamps.CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, slot, m_QueryIndex++);
 
-		// Prep train rays
-		vkCmdBindPipeline(m_PreCudaCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PrepTrainRaysPipeline);
-		vkCmdDispatch(m_PreCudaCommandBuffer, m_TrainWidth / 32, m_TrainHeight, 1);
+		// Prep train rays, only the first view is trained on
+		CmdBindView(commandBuffer, 0);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PrepTrainRaysPipeline);
+		vkCmdDispatch(commandBuffer, m_TrainWidth / 32, m_TrainHeight, 1);
 
 		// Timestamp
-		vkCmdWriteTimestamp(m_PreCudaCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_QueryPool, m_QueryIndex++);
+		m_Timestamps.CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, slot, m_QueryIndex++);
 		
 		// End
-		result = vkEndCommandBuffer(m_PreCudaCommandBuffer);
+		result = vkEndCommandBuffer(commandBuffer);
 		ASSERT_VULKAN(result);
 	}
 
-	void NrcHpmRenderer::RecordPostCudaCommandBuffer()
+	void NrcHpmRenderer::RecordPostCudaCommandBuffer(uint32_t slot)
 	{
+		VkCommandBuffer commandBuffer = m_PostCudaCommandBuffers[slot];
+
 		// Begin command buffer
 		VkCommandBufferBeginInfo beginInfo;
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		beginInfo.pNext = nullptr;
-		beginInfo.flags = 0;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
 		beginInfo.pInheritanceInfo = nullptr;
 
-		VkResult result = vkBeginCommandBuffer(m_PostCudaCommandBuffer, &beginInfo);
+		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
 		ASSERT_VULKAN(result);
 		
 		// Collect descriptor sets
-		std::vector<VkDescriptorSet> descSets = { m_Camera->GetDescriptorSet() };
+		std::vector<VkDescriptorSet> descSets = { m_Cameras[0]->GetDescriptorSet() };
 		const std::vector<VkDescriptorSet>& hpmSceneDescSets = m_HpmScene.GetDescriptorSets();
 		descSets.insert(descSets.end(), hpmSceneDescSets.begin(), hpmSceneDescSets.end());
 		descSets.push_back(m_DescSet);
 
 		// Bind descriptor sets
 		vkCmdBindDescriptorSets(
-			m_PostCudaCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout,
+			commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout,
 			0, descSets.size(), descSets.data(),
 			0, nullptr);
 
 		// Timestamp
-		vkCmdWriteTimestamp(m_PostCudaCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_QueryPool, m_QueryIndex++);
+		m_Timestamps.CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, slot, m_QueryIndex++);
+
+		// Copy last resolve to the lower history layers, the render pass reads reprojected neighbors of them while writing the upper ones
+		VkMemoryBarrier outputWrittenBarrier;
+		outputWrittenBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		outputWrittenBarrier.pNext = nullptr;
+		outputWrittenBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		outputWrittenBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0,
+			1, &outputWrittenBarrier,
+			0, nullptr,
+			0, nullptr);
 
-		// Render pipeline
-		vkCmdBindPipeline(m_PostCudaCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_RenderPipeline);
-		vkCmdDispatch(m_PostCudaCommandBuffer, m_RenderWidth / 32, m_RenderHeight, 1);
+		VkImageCopy historyCopy;
+		historyCopy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		historyCopy.srcSubresource.mipLevel = 0;
+		historyCopy.srcSubresource.baseArrayLayer = m_MaxViewCount;
+		historyCopy.srcSubresource.layerCount = m_Cameras.size();
+		historyCopy.srcOffset = { 0, 0, 0 };
+		historyCopy.dstSubresource = historyCopy.srcSubresource;
+		historyCopy.dstSubresource.baseArrayLayer = 0;
+		historyCopy.dstOffset = { 0, 0, 0 };
+		historyCopy.extent = { m_RenderWidth, m_RenderHeight, 1 };
+		vkCmdCopyImage(
+			commandBuffer,
+			m_HistoryImage, VK_IMAGE_LAYOUT_GENERAL,
+			m_HistoryImage, VK_IMAGE_LAYOUT_GENERAL,
+			1, &historyCopy);
+
+		VkMemoryBarrier historyCopiedBarrier;
+		historyCopiedBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		historyCopiedBarrier.pNext = nullptr;
+		historyCopiedBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		historyCopiedBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1, &historyCopiedBarrier,
+			0, nullptr,
+			0, nullptr);
+
+		// Render pipeline, one dispatch per view
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_RenderPipeline);
+		for (uint32_t view = 0; view < m_Cameras.size(); view++)
+		{
+			CmdBindView(commandBuffer, view);
+			vkCmdDispatch(commandBuffer, m_RenderWidth / 32, m_RenderHeight, 1);
+		}
 
 		// Timestamp
-		vkCmdWriteTimestamp(m_PostCudaCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_QueryPool, m_QueryIndex++);
+		m_Timestamps.CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, slot, m_QueryIndex++);
 		
 		// End command buffer
-		result = vkEndCommandBuffer(m_PostCudaCommandBuffer);
+		result = vkEndCommandBuffer(commandBuffer);
 		ASSERT_VULKAN(result);
 	}
 }
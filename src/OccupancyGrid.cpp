@@ -0,0 +1,151 @@
+#include <engine/util/OccupancyGrid.hpp>
+#include <engine/util/RayBox.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace en
+{
+	OccupancyGrid::OccupancyGrid(const std::vector<std::vector<std::vector<float>>>& densityData) :
+		m_DensitySize({
+			static_cast<uint32_t>(densityData.size()),
+			static_cast<uint32_t>(densityData[0].size()),
+			static_cast<uint32_t>(densityData[0][0].size()) })
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			m_BrickCount[0][axis] = (m_DensitySize[axis] + c_BrickSize - 1) / c_BrickSize;
+			m_BrickCount[1][axis] = (m_BrickCount[0][axis] + c_CoarseFactor - 1) / c_CoarseFactor;
+		}
+
+		const uint32_t fineCount = m_BrickCount[0].x * m_BrickCount[0].y * m_BrickCount[0].z;
+		const uint32_t coarseCount = m_BrickCount[1].x * m_BrickCount[1].y * m_BrickCount[1].z;
+		m_WordOffset = { 0, (fineCount + 31) / 32 };
+		m_Bits.resize(m_WordOffset[1] + ((coarseCount + 31) / 32), 0);
+
+		// Every non zero voxel marks the bricks of its 3x3x3 neighbourhood. Same truncation as Texture3D::PackData
+		for (uint32_t x = 0; x < m_DensitySize[0]; x++)
+		{
+			for (uint32_t y = 0; y < m_DensitySize[1]; y++)
+			{
+				for (uint32_t z = 0; z < m_DensitySize[2]; z++)
+				{
+					if (static_cast<uint8_t>(densityData[x][y][z] * 255.0f) == 0) { continue; }
+
+					const glm::ivec3 voxel(x, y, z);
+					const glm::ivec3 minBrick = glm::max(voxel - 1, glm::ivec3(0)) / static_cast<int>(c_BrickSize);
+					const glm::ivec3 maxBrick = glm::min((voxel + 1) / static_cast<int>(c_BrickSize), m_BrickCount[0] - 1);
+					for (int bx = minBrick.x; bx <= maxBrick.x; bx++)
+					{
+						for (int by = minBrick.y; by <= maxBrick.y; by++)
+						{
+							for (int bz = minBrick.z; bz <= maxBrick.z; bz++)
+							{
+								const glm::ivec3 brick(bx, by, bz);
+								SetOccupied(0, brick);
+								SetOccupied(1, brick / static_cast<int>(c_CoarseFactor));
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	const std::vector<uint32_t>& OccupancyGrid::GetBits() const
+	{
+		return m_Bits;
+	}
+
+	bool OccupancyGrid::IsOccupied(uint32_t level, const glm::ivec3& brick) const
+	{
+		const uint32_t index = GetBitIndex(level, brick);
+		return (m_Bits[m_WordOffset[level] + (index / 32)] & (1u << (index % 32))) != 0;
+	}
+
+	float OccupancyGrid::GetOccupiedFraction(uint32_t level) const
+	{
+		const glm::ivec3& count = m_BrickCount[level];
+		uint32_t occupiedCount = 0;
+		for (int x = 0; x < count.x; x++)
+		{
+			for (int y = 0; y < count.y; y++)
+			{
+				for (int z = 0; z < count.z; z++)
+				{
+					if (IsOccupied(level, glm::ivec3(x, y, z))) { occupiedCount++; }
+				}
+			}
+		}
+
+		return static_cast<float>(occupiedCount) / static_cast<float>(count.x * count.y * count.z);
+	}
+
+	float OccupancyGrid::SkipEmptySpace(const glm::vec3& boxSize, const glm::vec3& ro, const glm::vec3& rd, float t, float tMax) const
+	{
+		// Density outside the volume is 0 (clamp to black border)
+		glm::vec2 tBox;
+		if (!RayBox::Intersect(glm::vec3(0.0f), boxSize, ro, rd, tBox)) { return tMax; }
+		t = std::max(t, tBox.x);
+		tMax = std::min(tMax, tBox.y);
+
+		// Traverse in voxel space, t keeps its meaning
+		const glm::vec3 voxelCount(m_DensitySize[0], m_DensitySize[1], m_DensitySize[2]);
+		const glm::vec3 voxelScale = voxelCount / boxSize;
+		const glm::vec3 voxelRo = (ro + (boxSize / 2.0f)) * voxelScale;
+		const glm::vec3 voxelRd = rd * voxelScale;
+
+		// Steps past a face by a small fraction of a voxel, which the neighbour dilation covers
+		const float nudge = 1e-3f / std::max(std::abs(voxelRd.x), std::max(std::abs(voxelRd.y), std::abs(voxelRd.z)));
+
+		for (uint32_t i = 0; i < c_MaxSkipSteps && t < tMax; i++)
+		{
+			const glm::vec3 pos = voxelRo + (t * voxelRd);
+			const glm::ivec3 fine = glm::clamp(
+				glm::ivec3(glm::floor(pos / static_cast<float>(c_BrickSize))),
+				glm::ivec3(0),
+				m_BrickCount[0] - 1);
+			const glm::ivec3 coarse = fine / static_cast<int>(c_CoarseFactor);
+
+			glm::ivec3 cell;
+			float cellSize;
+			if (!IsOccupied(1, coarse))
+			{
+				cell = coarse;
+				cellSize = static_cast<float>(c_BrickSize * c_CoarseFactor);
+			}
+			else if (!IsOccupied(0, fine))
+			{
+				cell = fine;
+				cellSize = static_cast<float>(c_BrickSize);
+			}
+			else
+			{
+				return t;
+			}
+
+			// Leave the empty cell through its far faces
+			float tExit = tMax;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				if (voxelRd[axis] == 0.0f) { continue; }
+				const float farPlane = (static_cast<float>(cell[axis]) + (voxelRd[axis] > 0.0f ? 1.0f : 0.0f)) * cellSize;
+				tExit = std::min(tExit, (farPlane - voxelRo[axis]) / voxelRd[axis]);
+			}
+			t = std::max(t, tExit) + nudge;
+		}
+
+		return std::min(t, tMax);
+	}
+
+	void OccupancyGrid::SetOccupied(uint32_t level, const glm::ivec3& brick)
+	{
+		const uint32_t index = GetBitIndex(level, brick);
+		m_Bits[m_WordOffset[level] + (index / 32)] |= 1u << (index % 32);
+	}
+
+	uint32_t OccupancyGrid::GetBitIndex(uint32_t level, const glm::ivec3& brick) const
+	{
+		const glm::ivec3& count = m_BrickCount[level];
+		return brick.x + count.x * (brick.y + count.y * brick.z);
+	}
+}
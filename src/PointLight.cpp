@@ -1,4 +1,5 @@
 #include <engine/graphics/PointLight.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
 #include <imgui.h>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -17,7 +18,14 @@ namespace en
 		uniformBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 		uniformBinding.pImmutableSamplers = nullptr;
 
-		std::vector<VkDescriptorSetLayoutBinding> bindings = { uniformBinding };
+		VkDescriptorSetLayoutBinding transmittanceBinding;
+		transmittanceBinding.binding = 1;
+		transmittanceBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		transmittanceBinding.descriptorCount = 1;
+		transmittanceBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+		transmittanceBinding.pImmutableSamplers = nullptr;
+
+		std::vector<VkDescriptorSetLayoutBinding> bindings = { uniformBinding, transmittanceBinding };
 
 		VkDescriptorSetLayoutCreateInfo layoutCI;
 		layoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -34,7 +42,11 @@ namespace en
 		uniformBufferPS.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		uniformBufferPS.descriptorCount = 1;
 
-		std::vector<VkDescriptorPoolSize> poolSizes = { uniformBufferPS };
+		VkDescriptorPoolSize transmittancePS;
+		transmittancePS.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		transmittancePS.descriptorCount = 1;
+
+		std::vector<VkDescriptorPoolSize> poolSizes = { uniformBufferPS, transmittancePS };
 
 		VkDescriptorPoolCreateInfo poolCI;
 		poolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -60,17 +72,17 @@ namespace en
 	}
 
 	PointLight::PointLight(const glm::vec3& pos, const glm::vec3& color, float strength) :
-		m_UniformData({ pos, strength, color }),
+		m_UniformData({ pos, strength, color, 0.0f, pos }),
 		m_UniformBuffer(
 			sizeof(UniformData), 
 			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
 			{})
 	{
 		VkDevice device = VulkanAPI::GetDevice();
 
 		// Push data to buffer
-		m_UniformBuffer.SetData(sizeof(UniformData), &m_UniformData, 0, 0);
+		vk::FramePacer::UpdateBuffer(m_UniformBuffer, sizeof(UniformData), &m_UniformData, 0);
 
 		// Allocate desc set
 		VkDescriptorSetAllocateInfo descSetAI;
@@ -132,10 +144,44 @@ namespace en
 			oldColor != m_UniformData.color ||
 			oldStrength != m_UniformData.strength)
 		{
-			m_UniformBuffer.SetData(sizeof(m_UniformData), &m_UniformData, 0, 0);
+			vk::FramePacer::UpdateBuffer(m_UniformBuffer, sizeof(m_UniformData), &m_UniformData, 0);
 		}
 	}
 
+	glm::vec3 PointLight::GetPos() const
+	{
+		return m_UniformData.pos;
+	}
+
+	void PointLight::SetTransmittanceTex(const vk::Texture3D* transmittanceTex)
+	{
+		VkDescriptorImageInfo transmittanceImageInfo;
+		transmittanceImageInfo.sampler = transmittanceTex->GetSampler();
+		transmittanceImageInfo.imageView = transmittanceTex->GetImageView();
+		transmittanceImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkWriteDescriptorSet transmittanceWrite;
+		transmittanceWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		transmittanceWrite.pNext = nullptr;
+		transmittanceWrite.dstSet = m_DescSet;
+		transmittanceWrite.dstBinding = 1;
+		transmittanceWrite.dstArrayElement = 0;
+		transmittanceWrite.descriptorCount = 1;
+		transmittanceWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		transmittanceWrite.pImageInfo = &transmittanceImageInfo;
+		transmittanceWrite.pBufferInfo = nullptr;
+		transmittanceWrite.pTexelBufferView = nullptr;
+
+		vkUpdateDescriptorSets(VulkanAPI::GetDevice(), 1, &transmittanceWrite, 0, nullptr);
+	}
+
+	void PointLight::SetTransmittanceOrigin(const glm::vec3& pos, float radius)
+	{
+		m_UniformData.transmittancePos = pos;
+		m_UniformData.transmittanceRadius = radius;
+		vk::FramePacer::UpdateBuffer(m_UniformBuffer, sizeof(m_UniformData), &m_UniformData, 0);
+	}
+
 	VkDescriptorSet PointLight::GetDescriptorSet() const
 	{
 		return m_DescSet;
@@ -0,0 +1,52 @@
+#include <engine/util/Random.hpp>
+
+namespace en
+{
+	// Must match pcg4d in random.glsl: Pcg4d({ 0, 0, 0, 0 })[0] == 0x0F02F829, Pcg4d({ 1, 2, 3, 4 })[0] == 0x3622CD16
+	std::array<uint32_t, 4> Random::Pcg4d(std::array<uint32_t, 4> v)
+	{
+		for (uint32_t& x : v) { x = x * 1664525u + 1013904223u; }
+
+		v[0] += v[1] * v[3];
+		v[1] += v[2] * v[0];
+		v[2] += v[0] * v[1];
+		v[3] += v[1] * v[2];
+
+		for (uint32_t& x : v) { x ^= x >> 16u; }
+
+		v[0] += v[1] * v[3];
+		v[1] += v[2] * v[0];
+		v[2] += v[0] * v[1];
+		v[3] += v[1] * v[2];
+
+		return v;
+	}
+
+	float Random::UintToUnitFloat(uint32_t x)
+	{
+		return static_cast<float>(x >> 8u) * (1.0f / 16777216.0f);
+	}
+
+	Random::Random(uint32_t pixelX, uint32_t pixelY, uint32_t frameIndex, uint32_t sampleIndex, uint32_t viewIndex) :
+		m_Key({ (pixelY << 16u) | (pixelX & 0xFFFFu), frameIndex, ((viewIndex << 8u) | (sampleIndex & 0xFFu)) << 16u, 0u })
+	{
+	}
+
+	void Random::SetBounce(uint32_t bounce)
+	{
+		m_Key[2] = (m_Key[2] & 0xFFFF0000u) | (bounce & 0xFFFFu);
+		m_Key[3] = 0;
+	}
+
+	uint32_t Random::NextUint()
+	{
+		const uint32_t result = Pcg4d(m_Key)[0];
+		m_Key[3]++;
+		return result;
+	}
+
+	float Random::NextFloat(float maxVal)
+	{
+		return UintToUnitFloat(NextUint()) * maxVal;
+	}
+}
@@ -0,0 +1,35 @@
+#include <engine/util/RayBox.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace en
+{
+	bool RayBox::Intersect(const glm::vec3& boxPos, const glm::vec3& boxSize, const glm::vec3& ro, const glm::vec3& rd, glm::vec2& t)
+	{
+		float tNear = 0.0f;
+		float tFar = std::numeric_limits<float>::max();
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const float boxMin = boxPos[axis] - (boxSize[axis] / 2.0f);
+			const float boxMax = boxPos[axis] + (boxSize[axis] / 2.0f);
+
+			// Axis parallel rays never cross that slab. They are unbounded inside it (including its faces) and miss outside
+			if (rd[axis] == 0.0f)
+			{
+				if (ro[axis] < boxMin || ro[axis] > boxMax) { return false; }
+				continue;
+			}
+
+			const float invRd = 1.0f / rd[axis];
+			const float t0 = (boxMin - ro[axis]) * invRd;
+			const float t1 = (boxMax - ro[axis]) * invRd;
+			tNear = std::max(tNear, std::min(t0, t1));
+			tFar = std::min(tFar, std::max(t0, t1));
+		}
+
+		if (tFar < tNear) { return false; }
+
+		t = glm::vec2(tNear, tFar);
+		return true;
+	}
+}
@@ -2,564 +2,262 @@
 #include <filesystem>
 #include <engine/graphics/renderer/McHpmRenderer.hpp>
 #include <engine/graphics/VulkanAPI.hpp>
-#include <engine/graphics/vulkan/CommandRecorder.hpp>
+#include <engine/graphics/vulkan/ImageExporter.hpp>
+#include <engine/util/TileScheduler.hpp>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <limits>
+#include <chrono>
 #include <tinyexr.h>
 
 namespace en
 {
-	float Reference::Result::GetBias() const
+	std::vector<Reference::ViewConfig> Reference::GetDefaultViews(uint32_t orbitCount)
 	{
-		return ownMean - refMean;
-	}
-
-	float Reference::Result::GetRelBias() const
-	{
-		return GetBias() / refMean;
-	}
+		std::vector<ViewConfig> views;
 
-	float Reference::Result::GetRelVar() const
-	{
-		return ownVar / refMean;
-	}
+		// Orbit
+		for (uint32_t i = 0; i < orbitCount; i++)
+		{
+			const float angle = glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(orbitCount);
+			const glm::vec3 pos = 64.0f * glm::vec3(std::cos(angle), 0.0f, std::sin(angle));
+			views.push_back({ pos, -glm::normalize(pos), glm::radians(60.0f) });
+		}
 
-	float Reference::Result::GetCV() const
-	{
-		return std::sqrt(ownVar) / ownMean;
-	}
+		// Close-up
+		views.push_back({ glm::vec3(32.0f, 8.0f, 0.0f), glm::normalize(glm::vec3(-32.0f, -8.0f, 0.0f)), glm::radians(30.0f) });
 
+		// Inside volume
+		views.push_back({ glm::vec3(8.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::radians(90.0f) });
 
+		return views;
+	}
 
 	Reference::Reference(
 		uint32_t width, 
 		uint32_t height, 
 		const AppConfig& appConfig, 
 		const HpmScene& scene, 
+		const std::vector<ViewConfig>& views,
 		VkQueue queue)
 		:
 		m_Width(width),
 		m_Height(height),
+		m_ImageFloatCount(4 * static_cast<size_t>(width) * height),
 		m_CmdPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, VulkanAPI::GetGraphicsQFI()),
-		m_Cmp1Shader("ref/cmp1.comp", false),
-		m_NormShader("ref/norm.comp", false),
-		m_Cmp2Shader("ref/cmp2.comp", false),
-		m_ResultStagingBuffer(
-			sizeof(Reference::Result), 
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
+		m_Views(views),
+		m_ReadbackBuffer(
+			views.size() * 4 * sizeof(float) * width * height,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
 			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			{}),
-		m_ResultBuffer(
-			sizeof(Reference::Result),
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
 			{})
 	{
-		m_CmdPool.AllocateBuffers(1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-		m_CmdBuf = m_CmdPool.GetBuffer(0);
+		if (m_Views.empty() || m_Views.size() >= MAX_CAMERA_COUNT) { Log::Error("Reference view count is invalid", true); }
 
-		CreateDescriptor();
+		m_CmdPool.AllocateBuffers(m_Views.size(), VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 
-		InitSpecInfo();
-		CreatePipelineLayout();
-		CreateCmp1Pipeline();
-		CreateNormPipeline();
-		CreateCmp2Pipeline();
+		void* readbackData;
+		m_ReadbackBuffer.MapMemory(0, &readbackData);
+		m_ReadbackData = reinterpret_cast<float*>(readbackData);
 
 		CreateRefCameras();
-		CreateRefImages(queue);
 		GenRefImages(appConfig, scene, queue);
 	}
 
-	Reference::Result Reference::CompareNrc(NrcHpmRenderer& renderer, const Camera* oldCamera, VkQueue queue)
+	std::vector<Reference::Result> Reference::CompareNrc(NrcHpmRenderer& renderer, const Camera* oldCamera, VkQueue queue, HpmDenoiser* denoiser)
 	{
-		Result result{};
+		// Render all views as layers of one frame and read them back at once
+		if (denoiser == nullptr && renderer.GetMaxViewCount() >= m_Views.size())
 		{
-			// Render on noisy renderer
-			renderer.SetCamera(queue, m_RefCamera);
+			renderer.SetCameras(queue, std::vector<const Camera*>(m_RefCameras.begin(), m_RefCameras.end()));
 			renderer.Render(queue, false);
+			SubmitReadback(queue, m_CmdPool.GetBuffer(0), { renderer.GetImage() }, m_ReadbackBuffer.GetVulkanHandle(), 0, m_Views.size());
 			ASSERT_VULKAN(vkQueueWaitIdle(queue));
 
-			// Update
-			UpdateDescriptor(m_RefImageView, renderer.GetImageView());
-			RecordCmpCmdBuf();
-
-			// Submit comparision
-			VkSubmitInfo submitInfo = {};
-			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-			submitInfo.pNext = nullptr;
-			submitInfo.waitSemaphoreCount = 0;
-			submitInfo.pWaitSemaphores = nullptr;
-			submitInfo.pWaitDstStageMask = nullptr;
-			submitInfo.commandBufferCount = 1;
-			submitInfo.pCommandBuffers = &m_CmdBuf;
-			submitInfo.signalSemaphoreCount = 0;
-			submitInfo.pSignalSemaphores = nullptr;
-			ASSERT_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
-			ASSERT_VULKAN(vkQueueWaitIdle(queue));
+			renderer.SetCamera(queue, oldCamera);
+			return CompareReadbacks();
+		}
 
-			// Sync result buffer to host
-			vk::Buffer::Copy(&m_ResultBuffer, &m_ResultStagingBuffer, sizeof(Result));
-			m_ResultStagingBuffer.GetData(sizeof(Result), &result, 0, 0);
+		// Render all views and queue their readbacks. SetCamera waits for the previous view before rerecording.
+		for (uint32_t i = 0; i < m_Views.size(); i++)
+		{
+			renderer.SetCamera(queue, m_RefCameras[i]);
+			if (denoiser != nullptr) { denoiser->SetCamera(queue, m_RefCameras[i]); }
 
-			// Eval results
-			Log::Info(
-				"MSE: " + std::to_string(result.mse) +
-				" | rBias: " + std::to_string(result.GetRelBias()) +
-				" | rVar: " + std::to_string(result.GetRelVar()));
+			renderer.Render(queue, false);
+			if (denoiser != nullptr) { denoiser->Denoise(queue); }
+
+			const VkImage image = denoiser != nullptr ? denoiser->GetImage() : renderer.GetImage();
+			SubmitReadback(queue, m_CmdPool.GetBuffer(i), { image }, m_ReadbackBuffer.GetVulkanHandle(), i * GetImageSize(), 1);
 		}
+		ASSERT_VULKAN(vkQueueWaitIdle(queue));
 
 		renderer.SetCamera(queue, oldCamera);
-		return result;
+		if (denoiser != nullptr) { denoiser->SetCamera(queue, oldCamera); }
+		return CompareReadbacks();
 	}
 
-	Reference::Result Reference::CompareMc(McHpmRenderer& renderer, const Camera* oldCamera, VkQueue queue)
+	std::vector<Reference::Result> Reference::CompareMc(McHpmRenderer& renderer, const Camera* oldCamera, VkQueue queue, HpmDenoiser* denoiser)
 	{
-		Result result{};
+		// Render all views as layers of one frame and read them back at once
+		if (denoiser == nullptr && renderer.GetMaxViewCount() >= m_Views.size())
 		{
-			// Render on noisy renderer
-			renderer.SetCamera(queue, m_RefCamera);
+			renderer.SetCameras(queue, std::vector<const Camera*>(m_RefCameras.begin(), m_RefCameras.end()));
 			renderer.Render(queue);
+			SubmitReadback(queue, m_CmdPool.GetBuffer(0), { renderer.GetImage() }, m_ReadbackBuffer.GetVulkanHandle(), 0, m_Views.size());
 			ASSERT_VULKAN(vkQueueWaitIdle(queue));
 
-			// Update
-			UpdateDescriptor(m_RefImageView, renderer.GetImageView());
-			RecordCmpCmdBuf();
-
-			// Submit comparision
-			VkSubmitInfo submitInfo = {};
-			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-			submitInfo.pNext = nullptr;
-			submitInfo.waitSemaphoreCount = 0;
-			submitInfo.pWaitSemaphores = nullptr;
-			submitInfo.pWaitDstStageMask = nullptr;
-			submitInfo.commandBufferCount = 1;
-			submitInfo.pCommandBuffers = &m_CmdBuf;
-			submitInfo.signalSemaphoreCount = 0;
-			submitInfo.pSignalSemaphores = nullptr;
-			ASSERT_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
-			ASSERT_VULKAN(vkQueueWaitIdle(queue));
+			renderer.SetCamera(queue, oldCamera);
+			return CompareReadbacks();
+		}
 
-			// Sync result buffer to host
-			vk::Buffer::Copy(&m_ResultBuffer, &m_ResultStagingBuffer, sizeof(Result));
-			m_ResultStagingBuffer.GetData(sizeof(Result), &result, 0, 0);
+		// Render all views and queue their readbacks. SetCamera waits for the previous view before rerecording.
+		for (uint32_t i = 0; i < m_Views.size(); i++)
+		{
+			renderer.SetCamera(queue, m_RefCameras[i]);
+			if (denoiser != nullptr) { denoiser->SetCamera(queue, m_RefCameras[i]); }
 
-			// Eval results
-			Log::Info(
-				"MSE: " + std::to_string(result.mse) +
-				" | rBias: " + std::to_string(result.GetRelBias()) +
-				" | rVar: " + std::to_string(result.GetRelVar()));
+			renderer.Render(queue);
+			if (denoiser != nullptr) { denoiser->Denoise(queue); }
+
+			const VkImage image = denoiser != nullptr ? denoiser->GetImage() : renderer.GetImage();
+			SubmitReadback(queue, m_CmdPool.GetBuffer(i), { image }, m_ReadbackBuffer.GetVulkanHandle(), i * GetImageSize(), 1);
 		}
+		ASSERT_VULKAN(vkQueueWaitIdle(queue));
 
 		renderer.SetCamera(queue, oldCamera);
-		return result;
+		if (denoiser != nullptr) { denoiser->SetCamera(queue, oldCamera); }
+		return CompareReadbacks();
 	}
 
 	void Reference::Destroy()
 	{
-		VkDevice device = VulkanAPI::GetDevice();
-
-		m_RefCamera->Destroy();
-		delete m_RefCamera;
-
-		vkDestroyImageView(device, m_RefImageView, nullptr);
-		vkFreeMemory(device, m_RefImageMemory, nullptr);
-		vkDestroyImage(device, m_RefImage, nullptr);
-
-		vkDestroyPipeline(device, m_Cmp2Pipeline, nullptr);
-		m_Cmp2Shader.Destroy();
-
-		vkDestroyPipeline(device, m_NormPipeline, nullptr);
-		m_NormShader.Destroy();
-
-		vkDestroyPipeline(device, m_Cmp1Pipeline, nullptr);
-		m_Cmp1Shader.Destroy();
-
-		vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
-
-		vkDestroyDescriptorPool(device, m_DescPool, nullptr);
-		vkDestroyDescriptorSetLayout(device, m_DescSetLayout, nullptr);
+		for (Camera* camera : m_RefCameras)
+		{
+			camera->Destroy();
+			delete camera;
+		}
 
 		m_CmdPool.Destroy();
 
-		m_ResultBuffer.Destroy();
-		m_ResultStagingBuffer.Destroy();
-	}
-
-	void Reference::CreateDescriptor()
-	{
-		VkDevice device = VulkanAPI::GetDevice();
-
-		// Create desc set layout
-		uint32_t binding = 0;
-
-		VkDescriptorSetLayoutBinding refImageBinding = {};
-		refImageBinding.binding = binding++;
-		refImageBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-		refImageBinding.descriptorCount = 1;
-		refImageBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-		refImageBinding.pImmutableSamplers = nullptr;
-
-		VkDescriptorSetLayoutBinding cmdImageBinding = {};
-		cmdImageBinding.binding = binding++;
-		cmdImageBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-		cmdImageBinding.descriptorCount = 1;
-		cmdImageBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-		cmdImageBinding.pImmutableSamplers = nullptr;
-
-		VkDescriptorSetLayoutBinding resultBufferBinding = {};
-		resultBufferBinding.binding = binding++;
-		resultBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-		resultBufferBinding.descriptorCount = 1;
-		resultBufferBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-		resultBufferBinding.pImmutableSamplers = nullptr;
-
-		std::vector<VkDescriptorSetLayoutBinding> bindings = { refImageBinding, cmdImageBinding, resultBufferBinding };
-
-		VkDescriptorSetLayoutCreateInfo layoutCI = {};
-		layoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		layoutCI.pNext = nullptr;
-		layoutCI.flags = 0;
-		layoutCI.bindingCount = bindings.size();
-		layoutCI.pBindings = bindings.data();
-		ASSERT_VULKAN(vkCreateDescriptorSetLayout(device, &layoutCI, nullptr, &m_DescSetLayout));
-
-		// Create desc pool
-		VkDescriptorPoolSize storageImagePS = {};
-		storageImagePS.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-		storageImagePS.descriptorCount = 2;
-
-		VkDescriptorPoolSize storageBufferPS = {};
-		storageBufferPS.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-		storageBufferPS.descriptorCount = 1;
-
-		std::vector<VkDescriptorPoolSize> poolSizes = { storageImagePS, storageBufferPS };
-
-		VkDescriptorPoolCreateInfo poolCI = {};
-		poolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolCI.pNext = nullptr;
-		poolCI.flags = 0;
-		poolCI.maxSets = 1;
-		poolCI.poolSizeCount = poolSizes.size();
-		poolCI.pPoolSizes = poolSizes.data();
-		ASSERT_VULKAN(vkCreateDescriptorPool(device, &poolCI, nullptr, &m_DescPool));
-
-		// Allocate desc set
-		VkDescriptorSetAllocateInfo descSetAI = {};
-		descSetAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		descSetAI.pNext = nullptr;
-		descSetAI.descriptorPool = m_DescPool;
-		descSetAI.descriptorSetCount = 1;
-		descSetAI.pSetLayouts = &m_DescSetLayout;
-		ASSERT_VULKAN(vkAllocateDescriptorSets(device, &descSetAI, &m_DescSet));
-	}
-
-	void Reference::UpdateDescriptor(VkImageView refImageView, VkImageView cmpImageView)
-	{
-		uint32_t binding = 0;
-
-		VkDescriptorImageInfo refImageInfo = {};
-		refImageInfo.sampler = VK_NULL_HANDLE;
-		refImageInfo.imageView = refImageView;
-		refImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-		
-		VkWriteDescriptorSet refImageWrite = {};
-		refImageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		refImageWrite.pNext = nullptr;
-		refImageWrite.dstSet = m_DescSet;
-		refImageWrite.dstBinding = binding++;
-		refImageWrite.dstArrayElement = 0;
-		refImageWrite.descriptorCount = 1;
-		refImageWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-		refImageWrite.pImageInfo = &refImageInfo;
-		refImageWrite.pBufferInfo = nullptr;
-		refImageWrite.pTexelBufferView = nullptr;
-
-		VkDescriptorImageInfo cmpImageInfo = {};
-		cmpImageInfo.sampler = VK_NULL_HANDLE;
-		cmpImageInfo.imageView = cmpImageView;
-		cmpImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-		VkWriteDescriptorSet cmpImageWrite = {};
-		cmpImageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		cmpImageWrite.pNext = nullptr;
-		cmpImageWrite.dstSet = m_DescSet;
-		cmpImageWrite.dstBinding = binding++;
-		cmpImageWrite.dstArrayElement = 0;
-		cmpImageWrite.descriptorCount = 1;
-		cmpImageWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-		cmpImageWrite.pImageInfo = &cmpImageInfo;
-		cmpImageWrite.pBufferInfo = nullptr;
-		cmpImageWrite.pTexelBufferView = nullptr;
-
-		VkDescriptorBufferInfo resultBufferInfo = {};
-		resultBufferInfo.buffer = m_ResultBuffer.GetVulkanHandle();
-		resultBufferInfo.offset = 0;
-		resultBufferInfo.range = sizeof(Result);
-
-		VkWriteDescriptorSet resultBufferWrite = {};
-		resultBufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		resultBufferWrite.pNext = nullptr;
-		resultBufferWrite.dstSet = m_DescSet;
-		resultBufferWrite.dstBinding = binding++;
-		resultBufferWrite.dstArrayElement = 0;
-		resultBufferWrite.descriptorCount = 1;
-		resultBufferWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-		resultBufferWrite.pImageInfo = nullptr;
-		resultBufferWrite.pBufferInfo = &resultBufferInfo;
-		resultBufferWrite.pTexelBufferView = nullptr;
-
-		std::vector<VkWriteDescriptorSet> writes = { refImageWrite, cmpImageWrite, resultBufferWrite };
-		vkUpdateDescriptorSets(VulkanAPI::GetDevice(), writes.size(), writes.data(), 0, nullptr);
-	}
-
-	void Reference::InitSpecInfo()
-	{
-		m_SpecData.width = m_Width;
-		m_SpecData.height = m_Height;
-
-		uint32_t constantID = 0;
-
-		VkSpecializationMapEntry widthEntry = {};
-		widthEntry.constantID = constantID++;
-		widthEntry.offset = offsetof(SpecializationData, SpecializationData::width);
-		widthEntry.size = sizeof(uint32_t);
-
-		VkSpecializationMapEntry heightEntry = {};
-		heightEntry.constantID = constantID++;
-		heightEntry.offset = offsetof(SpecializationData, SpecializationData::height);
-		heightEntry.size = sizeof(uint32_t);
-
-		m_SpecEntries = { widthEntry, heightEntry };
-
-		m_SpecInfo.mapEntryCount = m_SpecEntries.size();
-		m_SpecInfo.pMapEntries = m_SpecEntries.data();
-		m_SpecInfo.dataSize = sizeof(SpecializationData);
-		m_SpecInfo.pData = &m_SpecData;
-	}
-
-	void Reference::CreatePipelineLayout()
-	{
-		VkPipelineLayoutCreateInfo layoutCI = {};
-		layoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		layoutCI.pNext = nullptr;
-		layoutCI.flags = 0;
-		layoutCI.setLayoutCount = 1;
-		layoutCI.pSetLayouts = &m_DescSetLayout;
-		layoutCI.pushConstantRangeCount = 0;
-		layoutCI.pPushConstantRanges = nullptr;
-		ASSERT_VULKAN(vkCreatePipelineLayout(VulkanAPI::GetDevice(), &layoutCI, nullptr, &m_PipelineLayout));
-	}
-
-	void Reference::CreateCmp1Pipeline()
-	{
-		VkPipelineShaderStageCreateInfo stageCI = {};
-		stageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		stageCI.pNext = nullptr;
-		stageCI.flags = 0;
-		stageCI.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-		stageCI.module = m_Cmp1Shader.GetVulkanModule();
-		stageCI.pName = "main";
-		stageCI.pSpecializationInfo = &m_SpecInfo;
-
-		VkComputePipelineCreateInfo pipelineCI = {};
-		pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-		pipelineCI.pNext = nullptr;
-		pipelineCI.flags = 0;
-		pipelineCI.stage = stageCI;
-		pipelineCI.layout = m_PipelineLayout;
-		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
-		pipelineCI.basePipelineIndex = 0;
-		ASSERT_VULKAN(vkCreateComputePipelines(VulkanAPI::GetDevice(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_Cmp1Pipeline));
+		m_ReadbackBuffer.UnmapMemory();
+		m_ReadbackBuffer.Destroy();
 	}
 
-	void Reference::CreateNormPipeline()
+	uint32_t Reference::GetViewCount() const
 	{
-		VkPipelineShaderStageCreateInfo stageCI = {};
-		stageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		stageCI.pNext = nullptr;
-		stageCI.flags = 0;
-		stageCI.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-		stageCI.module = m_NormShader.GetVulkanModule();
-		stageCI.pName = "main";
-		stageCI.pSpecializationInfo = &m_SpecInfo;
-
-		VkComputePipelineCreateInfo pipelineCI = {};
-		pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-		pipelineCI.pNext = nullptr;
-		pipelineCI.flags = 0;
-		pipelineCI.stage = stageCI;
-		pipelineCI.layout = m_PipelineLayout;
-		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
-		pipelineCI.basePipelineIndex = 0;
-		ASSERT_VULKAN(vkCreateComputePipelines(VulkanAPI::GetDevice(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_NormPipeline));
+		return m_Views.size();
 	}
 
-	void Reference::CreateCmp2Pipeline()
+	VkDeviceSize Reference::GetImageSize() const
 	{
-		VkPipelineShaderStageCreateInfo stageCI = {};
-		stageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		stageCI.pNext = nullptr;
-		stageCI.flags = 0;
-		stageCI.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-		stageCI.module = m_Cmp2Shader.GetVulkanModule();
-		stageCI.pName = "main";
-		stageCI.pSpecializationInfo = &m_SpecInfo;
-
-		VkComputePipelineCreateInfo pipelineCI = {};
-		pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-		pipelineCI.pNext = nullptr;
-		pipelineCI.flags = 0;
-		pipelineCI.stage = stageCI;
-		pipelineCI.layout = m_PipelineLayout;
-		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
-		pipelineCI.basePipelineIndex = 0;
-		ASSERT_VULKAN(vkCreateComputePipelines(VulkanAPI::GetDevice(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_Cmp2Pipeline));
+		return m_ImageFloatCount * sizeof(float);
 	}
 
-	void Reference::RecordCmpCmdBuf()
+	void Reference::SubmitReadback(
+		VkQueue queue,
+		VkCommandBuffer cmdBuf,
+		const std::vector<VkImage>& images,
+		VkBuffer buffer,
+		VkDeviceSize offset,
+		uint32_t layerCount)
 	{
 		VkCommandBufferBeginInfo beginInfo = {};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		beginInfo.pNext = nullptr;
-		beginInfo.flags = 0;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 		beginInfo.pInheritanceInfo = nullptr;
-		ASSERT_VULKAN(vkBeginCommandBuffer(m_CmdBuf, &beginInfo));
+		ASSERT_VULKAN(vkBeginCommandBuffer(cmdBuf, &beginInfo));
 
-		vkCmdFillBuffer(m_CmdBuf, m_ResultBuffer.GetVulkanHandle(), 0, sizeof(Result), 0);
+		VkMemoryBarrier renderBarrier = {};
+		renderBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		renderBarrier.pNext = nullptr;
+		renderBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		renderBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &renderBarrier, 0, nullptr, 0, nullptr);
 
-		vkCmdBindDescriptorSets(m_CmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &m_DescSet, 0, nullptr);
-
-		vkCmdBindPipeline(m_CmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_Cmp1Pipeline);
-		vkCmdDispatch(m_CmdBuf, m_Width / 32, m_Height, 1);
+		// The layers of all images are copied to consecutive slots starting at offset
+		for (size_t i = 0; i < images.size(); i++)
+		{
+			for (uint32_t layer = 0; layer < layerCount; layer++)
+			{
+				VkBufferImageCopy region = {};
+				region.bufferOffset = offset + (i * layerCount + layer) * m_ImageFloatCount * sizeof(float);
+				region.bufferRowLength = m_Width;
+				region.bufferImageHeight = m_Height;
+				region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				region.imageSubresource.mipLevel = 0;
+				region.imageSubresource.baseArrayLayer = layer;
+				region.imageSubresource.layerCount = 1;
+				region.imageOffset = { 0, 0, 0 };
+				region.imageExtent = { m_Width, m_Height, 1 };
+				vkCmdCopyImageToBuffer(cmdBuf, images[i], VK_IMAGE_LAYOUT_GENERAL, buffer, 1, &region);
+			}
+		}
 
-		vkCmdBindPipeline(m_CmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_NormPipeline);
-		vkCmdDispatch(m_CmdBuf, 1, 1, 1);
+		VkMemoryBarrier hostBarrier = {};
+		hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		hostBarrier.pNext = nullptr;
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
 
-		vkCmdBindPipeline(m_CmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_Cmp2Pipeline);
-		vkCmdDispatch(m_CmdBuf, m_Width / 32, m_Height, 1);
+		ASSERT_VULKAN(vkEndCommandBuffer(cmdBuf));
 
-		ASSERT_VULKAN(vkEndCommandBuffer(m_CmdBuf));
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = nullptr;
+		submitInfo.waitSemaphoreCount = 0;
+		submitInfo.pWaitSemaphores = nullptr;
+		submitInfo.pWaitDstStageMask = nullptr;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &cmdBuf;
+		submitInfo.signalSemaphoreCount = 0;
+		submitInfo.pSignalSemaphores = nullptr;
+		ASSERT_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
 	}
 
-	void Reference::CreateRefCameras()
+	std::vector<Reference::Result> Reference::CompareReadbacks()
 	{
-		const float aspectRatio = static_cast<float>(m_Width) / static_cast<float>(m_Height);
+		std::vector<Result> results(m_Views.size());
+		for (uint32_t i = 0; i < m_Views.size(); i++)
+		{
+			results[i] = ImageCompare::Compare(
+				m_RefData[i].data(),
+				m_ReadbackData + i * m_ImageFloatCount,
+				m_Width,
+				m_Height,
+				m_RefErrorData[i].empty() ? nullptr : m_RefErrorData[i].data(),
+				c_RefMaxPixelError);
 
-		m_RefCamera = new en::Camera(
-			glm::vec3(64.0f, 0.0f, 0.0f),
-			glm::vec3(-1.0f, 0.0f, 0.0f),
-			glm::vec3(0.0f, 1.0f, 0.0f),
-			aspectRatio,
-			glm::radians(60.0f),
-			0.1f,
-			100.0f);
+			Log::Info(
+				"View {} | MSE: {} | relMSE: {} | SMAPE: {} | SSIM: {} | rBias: {} | rVar: {}",
+				i,
+				results[i].mse,
+				results[i].relMse,
+				results[i].smape,
+				results[i].ssim,
+				results[i].GetRelBias(),
+				results[i].GetRelVar());
+		}
+
+		return results;
 	}
 
-	void Reference::CreateRefImages(VkQueue queue)
+	void Reference::CreateRefCameras()
 	{
-		VkDevice device = VulkanAPI::GetDevice();
+		const float aspectRatio = static_cast<float>(m_Width) / static_cast<float>(m_Height);
 
+		for (const ViewConfig& view : m_Views)
 		{
-			VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT;
-
-			// Create Image
-			VkImageCreateInfo imageCI;
-			imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-			imageCI.pNext = nullptr;
-			imageCI.flags = 0;
-			imageCI.imageType = VK_IMAGE_TYPE_2D;
-			imageCI.format = format;
-			imageCI.extent = { m_Width, m_Height, 1 };
-			imageCI.mipLevels = 1;
-			imageCI.arrayLayers = 1;
-			imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
-			imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-			imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-			imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-			imageCI.queueFamilyIndexCount = 0;
-			imageCI.pQueueFamilyIndices = nullptr;
-			imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-
-			VkResult result = vkCreateImage(device, &imageCI, nullptr, &m_RefImage);
-			ASSERT_VULKAN(result);
-
-			// Image Memory
-			VkMemoryRequirements memoryRequirements;
-			vkGetImageMemoryRequirements(device, m_RefImage, &memoryRequirements);
-
-			VkMemoryAllocateInfo allocateInfo;
-			allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-			allocateInfo.pNext = nullptr;
-			allocateInfo.allocationSize = memoryRequirements.size;
-			allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-				memoryRequirements.memoryTypeBits,
-				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-			result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_RefImageMemory);
-			ASSERT_VULKAN(result);
-
-			result = vkBindImageMemory(device, m_RefImage, m_RefImageMemory, 0);
-			ASSERT_VULKAN(result);
-
-			// Create image view
-			VkImageViewCreateInfo imageViewCI;
-			imageViewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-			imageViewCI.pNext = nullptr;
-			imageViewCI.flags = 0;
-			imageViewCI.image = m_RefImage;
-			imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
-			imageViewCI.format = format;
-			imageViewCI.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-			imageViewCI.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-			imageViewCI.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-			imageViewCI.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-			imageViewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			imageViewCI.subresourceRange.baseMipLevel = 0;
-			imageViewCI.subresourceRange.levelCount = 1;
-			imageViewCI.subresourceRange.baseArrayLayer = 0;
-			imageViewCI.subresourceRange.layerCount = 1;
-
-			result = vkCreateImageView(device, &imageViewCI, nullptr, &m_RefImageView);
-			ASSERT_VULKAN(result);
-
-			// Change image layout
-			VkCommandBufferBeginInfo beginInfo;
-			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			beginInfo.pNext = nullptr;
-			beginInfo.flags = 0;
-			beginInfo.pInheritanceInfo = nullptr;
-
-			result = vkBeginCommandBuffer(m_CmdBuf, &beginInfo);
-			ASSERT_VULKAN(result);
-
-			vk::CommandRecorder::ImageLayoutTransfer(
-				m_CmdBuf,
-				m_RefImage,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_GENERAL,
-				VK_ACCESS_NONE,
-				VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-
-			result = vkEndCommandBuffer(m_CmdBuf);
-			ASSERT_VULKAN(result);
-
-			VkSubmitInfo submitInfo;
-			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-			submitInfo.pNext = nullptr;
-			submitInfo.waitSemaphoreCount = 0;
-			submitInfo.pWaitSemaphores = nullptr;
-			submitInfo.pWaitDstStageMask = nullptr;
-			submitInfo.commandBufferCount = 1;
-			submitInfo.pCommandBuffers = &m_CmdBuf;
-			submitInfo.signalSemaphoreCount = 0;
-			submitInfo.pSignalSemaphores = nullptr;
-
-			VkQueue queue = VulkanAPI::GetGraphicsQueue();
-			result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-			ASSERT_VULKAN(result);
-			result = vkQueueWaitIdle(queue);
-			ASSERT_VULKAN(result);
+			m_RefCameras.push_back(new en::Camera(
+				view.pos,
+				view.viewDir,
+				glm::vec3(0.0f, 1.0f, 0.0f),
+				aspectRatio,
+				view.fov,
+				0.1f,
+				100.0f));
 		}
 	}
 
@@ -572,51 +270,126 @@ namespace en
 #if __cplusplus >= 201703L
 		en::Log::Warn("C++ version lower then 17. Cant create reference data");
 #else
-		// If reference image folder does not exists create reference images
-		if (!std::filesystem::is_directory(referenceDirPath) || !std::filesystem::exists(referenceDirPath))
-		{
-			en::Log::Info("Reference folder for scene " + std::to_string(sceneID) + " was not found. Creating reference images");
+		std::filesystem::create_directories(referenceDirPath);
 
-			// Create reference renderer
-			McHpmRenderer refRenderer(m_Width, m_Height, 64, true, m_RefCamera, scene);
+		// Generate every view that has no reference image yet
+		McHpmRenderer* refRenderer = nullptr;
+		vk::Buffer* statsBuffer = nullptr;
+		float* statsData = nullptr;
+		for (uint32_t i = 0; i < m_Views.size(); i++)
+		{
+			const std::string refImagePath = referenceDirPath + std::to_string(i) + ".exr";
+			if (std::filesystem::exists(refImagePath)) { continue; }
 
-			// Create folder
-			std::filesystem::create_directory(referenceDirPath);
+			en::Log::Info("Generating reference image " + std::to_string(i) + " for scene " + std::to_string(sceneID));
 
-			// Generate reference data
+			// Create reference renderer or move it to this view
+			if (refRenderer == nullptr)
+			{
+				refRenderer = new McHpmRenderer(m_Width, m_Height, 64, true, c_RefAdaptiveSampling, m_RefCameras[i], scene);
+				refRenderer->SetAdaptiveTarget(c_RefTargetRelStdError, c_RefMinSampleCount);
+
+				// Holds the blended output and the info image with the welford sums
+				statsBuffer = new vk::Buffer(
+					2 * GetImageSize(),
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+					VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					{});
+				void* data;
+				statsBuffer->MapMemory(0, &data);
+				statsData = reinterpret_cast<float*>(data);
+			}
+			else
 			{
-				en::Log::Info("Generating reference image " + std::to_string(0));
+				refRenderer->SetCamera(queue, m_RefCameras[i]);
+			}
 
-				// Generate reference image
-				for (size_t frame = 0; frame < 8192; frame++)
+			// Accumulate until the reference is converged
+			std::vector<float> errorMap(m_Width * m_Height);
+			float relStdError = std::numeric_limits<float>::max();
+			uint32_t frame = 0;
+			const auto startTime = std::chrono::high_resolution_clock::now();
+			while (frame < c_RefMaxFrames)
+			{
+				refRenderer->Render(queue);
+				ASSERT_VULKAN(vkQueueWaitIdle(queue));
+				frame++;
+
+				if (frame < c_RefMinFrames || frame % c_RefCheckInterval != 0) { continue; }
+
+				SubmitReadback(
+					queue,
+					m_CmdPool.GetBuffer(0),
+					{ refRenderer->GetImage(), refRenderer->GetInfoImage() },
+					statsBuffer->GetVulkanHandle(),
+					0,
+					1);
+				ASSERT_VULKAN(vkQueueWaitIdle(queue));
+
+				relStdError = CalcRelStdErrorMap(statsData, statsData + m_ImageFloatCount, errorMap);
+				en::Log::Info("Reference frame {} relative standard error {}", frame, relStdError);
+				if (relStdError <= c_RefTargetRelStdError) { break; }
+
+				if (c_RefAdaptiveSampling)
 				{
-					refRenderer.Render(queue);
-					ASSERT_VULKAN(vkQueueWaitIdle(queue));
+					const size_t activeTileCount = TileScheduler::BuildTileList(
+						statsData,
+						statsData + m_ImageFloatCount,
+						m_Width,
+						m_Height,
+						c_RefTargetRelStdError,
+						c_RefMinSampleCount,
+						false).size();
+					en::Log::Info("Reference frame {} active tiles {}", frame, activeTileCount);
+					if (activeTileCount == 0) { break; }
 				}
+			}
 
-				// Export reference image
-				refRenderer.ExportOutputImageToFile(queue, referenceDirPath + std::to_string(0) + ".exr");
+			// Uniform sampling would have spent frame samples on every pixel
+			const float seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - startTime).count();
+			double sampleSum = 0.0;
+			for (size_t pixel = 0; pixel < errorMap.size(); pixel++) { sampleSum += statsData[m_ImageFloatCount + pixel * 4]; }
+			en::Log::Info(
+				"Reference image " + std::to_string(i) +
+				" took " + std::to_string(seconds) + "s with " + std::to_string(sampleSum / static_cast<double>(errorMap.size())) +
+				" samples per pixel (uniform " + std::to_string(frame) + ")");
 
-				// Copy to ref image for faster comparison
-				//CopyToRefImage(i, refRenderer.GetImage(), queue);
+			if (relStdError > c_RefTargetRelStdError)
+			{
+				en::Log::Warn("Reference image " + std::to_string(i) + " did not converge within " + std::to_string(c_RefMaxFrames) + " frames");
 			}
 
-			refRenderer.Destroy();
+			// Export reference image and its error map
+			refRenderer->ExportOutputImageToFile(queue, refImagePath);
+
+			const std::string errorMapPath = referenceDirPath + std::to_string(i) + "_error.exr";
+			if (TINYEXR_SUCCESS != SaveEXR(errorMap.data(), m_Width, m_Height, 1, 0, errorMapPath.c_str(), nullptr))
+			{
+				en::Log::Error("TinyEXR failed to save " + errorMapPath, true);
+			}
 		}
-#endif
 
-		// Load reference images from path
-		const size_t imageBufferSize = 4 * sizeof(float) * m_Width * m_Height;
-		vk::Buffer stagingBuffer(
-			imageBufferSize,
-			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			{});
+		// Reference images are loaded below and the renderer is destroyed, so the exports must be written
+		vk::ImageExporter::WaitIdle();
+
+		if (refRenderer != nullptr)
+		{
+			statsBuffer->UnmapMemory();
+			statsBuffer->Destroy();
+			delete statsBuffer;
+
+			refRenderer->Destroy();
+			delete refRenderer;
+		}
+#endif
 
+		// Load reference images and error maps from path. References without error map use every pixel.
+		m_RefData.resize(m_Views.size());
+		m_RefErrorData.resize(m_Views.size());
+		for (uint32_t i = 0; i < m_Views.size(); i++)
 		{
-			const std::string refImagePath = referenceDirPath + std::to_string(0) + ".exr";
+			const std::string refImagePath = referenceDirPath + std::to_string(i) + ".exr";
 
-			// Load exr to memory
 			float* rgba = nullptr;
 			int width = -1;
 			int height = -1;
@@ -626,94 +399,44 @@ namespace en
 			}
 			if (width != m_Width || height != m_Height) { Log::Error(refImagePath + " has wrong resolution", true); }
 
-			// Load to staging buffer
-			stagingBuffer.SetData(imageBufferSize, rgba, 0, 0);
+			m_RefData[i].assign(rgba, rgba + m_ImageFloatCount);
 			free(rgba);
 
-			// Load to gpu
-			VkCommandBufferBeginInfo beginInfo = {};
-			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			beginInfo.pNext = nullptr;
-			beginInfo.flags = 0;
-			beginInfo.pInheritanceInfo = nullptr;
-			ASSERT_VULKAN(vkBeginCommandBuffer(m_CmdBuf, &beginInfo));
-
-			VkBufferImageCopy bufferImageCopy = {};
-			bufferImageCopy.bufferOffset = 0;
-			bufferImageCopy.bufferRowLength = m_Width;
-			bufferImageCopy.bufferImageHeight = m_Height;
-			bufferImageCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			bufferImageCopy.imageSubresource.mipLevel = 0;
-			bufferImageCopy.imageSubresource.baseArrayLayer = 0;
-			bufferImageCopy.imageSubresource.layerCount = 1;
-			bufferImageCopy.imageOffset = { 0, 0, 0 };
-			bufferImageCopy.imageExtent = { m_Width, m_Height, 1 };
-
-			vkCmdCopyBufferToImage(m_CmdBuf, stagingBuffer.GetVulkanHandle(), m_RefImage, VK_IMAGE_LAYOUT_GENERAL, 1, &bufferImageCopy);
-
-			ASSERT_VULKAN(vkEndCommandBuffer(m_CmdBuf));
-
-			VkSubmitInfo submitInfo = {};
-			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-			submitInfo.pNext = nullptr;
-			submitInfo.waitSemaphoreCount = 0;
-			submitInfo.pWaitSemaphores = nullptr;
-			submitInfo.pWaitDstStageMask = nullptr;
-			submitInfo.commandBufferCount = 1;
-			submitInfo.pCommandBuffers = &m_CmdBuf;
-			submitInfo.signalSemaphoreCount = 0;
-			submitInfo.pSignalSemaphores = nullptr;
-			ASSERT_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
-			ASSERT_VULKAN(vkQueueWaitIdle(queue));
-		}
+			const std::string errorMapPath = referenceDirPath + std::to_string(i) + "_error.exr";
+			if (!std::filesystem::exists(errorMapPath)) { continue; }
+
+			if (TINYEXR_SUCCESS != LoadEXR(&rgba, &width, &height, errorMapPath.c_str(), nullptr))
+			{
+				Log::Error("TinyEXR failed to load " + errorMapPath, true);
+			}
+			if (width != m_Width || height != m_Height) { Log::Error(errorMapPath + " has wrong resolution", true); }
 
-		stagingBuffer.Destroy();
+			m_RefErrorData[i].resize(m_Width * m_Height);
+			for (size_t pixel = 0; pixel < m_RefErrorData[i].size(); pixel++)
+			{
+				m_RefErrorData[i][pixel] = rgba[pixel * 4];
+			}
+			free(rgba);
+		}
 	}
 
-	void Reference::CopyToRefImage(uint32_t imageIdx, VkImage srcImage, VkQueue queue)
+	float Reference::CalcRelStdErrorMap(const float* mean, const float* info, std::vector<float>& errorMap) const
 	{
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.pNext = nullptr;
-		beginInfo.flags = 0;
-		beginInfo.pInheritanceInfo = nullptr;
-		ASSERT_VULKAN(vkBeginCommandBuffer(m_CmdBuf, &beginInfo));
-
-		VkImageCopy imageCopy = {};
-		imageCopy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		imageCopy.srcSubresource.mipLevel = 0;
-		imageCopy.srcSubresource.baseArrayLayer = 0;
-		imageCopy.srcSubresource.layerCount = 1;
-		imageCopy.srcOffset = { 0, 0, 0 };
-		imageCopy.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		imageCopy.dstSubresource.mipLevel = 0;
-		imageCopy.dstSubresource.baseArrayLayer = 0;
-		imageCopy.dstSubresource.layerCount = 1;
-		imageCopy.dstOffset = { 0, 0, 0 };
-		imageCopy.extent = { m_Width, m_Height, 1 };
-		vkCmdCopyImage(
-			m_CmdBuf, 
-			srcImage, 
-			VK_IMAGE_LAYOUT_GENERAL, 
-			m_RefImage, 
-			VK_IMAGE_LAYOUT_GENERAL, 
-			1, 
-			&imageCopy);
-
-		ASSERT_VULKAN(vkEndCommandBuffer(m_CmdBuf));
+		// Standard error of the mean from the welford sums with the sample count of each pixel
+		std::vector<float> volumeErrors;
+		for (size_t pixel = 0; pixel < errorMap.size(); pixel++)
+		{
+			const float* pixelMean = mean + pixel * 4;
+			errorMap[pixel] = TileScheduler::GetPixelRelStdError(pixelMean, info + pixel * 4, 0);
 
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.pNext = nullptr;
-		submitInfo.waitSemaphoreCount = 0;
-		submitInfo.pWaitSemaphores = nullptr;
-		submitInfo.pWaitDstStageMask = nullptr;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_CmdBuf;
-		submitInfo.signalSemaphoreCount = 0;
-		submitInfo.pSignalSemaphores = nullptr;
+			// Pixels that never scattered only see the env map and are not part of the estimate
+			if (pixelMean[3] > 0.0f) { volumeErrors.push_back(errorMap[pixel]); }
+		}
 
-		ASSERT_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
-		ASSERT_VULKAN(vkQueueWaitIdle(queue));
+		if (volumeErrors.empty()) { return 0.0f; }
+
+		const size_t percentileIndex = static_cast<size_t>(c_RefErrorPercentile * static_cast<float>(volumeErrors.size() - 1));
+		std::nth_element(volumeErrors.begin(), volumeErrors.begin() + percentileIndex, volumeErrors.end());
+		return volumeErrors[percentileIndex];
 	}
 }
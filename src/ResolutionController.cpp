@@ -0,0 +1,84 @@
+#include <engine/util/ResolutionController.hpp>
+#include <imgui.h>
+#include <algorithm>
+#include <cmath>
+
+namespace en
+{
+	// Never above size unless size is below one alignment step
+	static uint32_t AlignedSize(uint32_t size, float scale, uint32_t alignment)
+	{
+		const uint32_t blockCount = static_cast<uint32_t>(std::round(static_cast<float>(size) * scale / static_cast<float>(alignment)));
+		return std::max(1u, std::min(blockCount, size / alignment)) * alignment;
+	}
+
+	ResolutionController::ResolutionController(float targetFrameTimeMS, float minScale, float maxScale, float scaleStep) :
+		m_TargetFrameTimeMS(targetFrameTimeMS),
+		m_MinScale(minScale),
+		m_MaxScale(maxScale),
+		m_ScaleStep(scaleStep),
+		m_Scale(maxScale)
+	{
+	}
+
+	bool ResolutionController::Update(float frameTimeMS)
+	{
+		// The first frames after a change pay for the resource recreation and are not representative
+		m_FramesSinceChange++;
+		if (m_FramesSinceChange < c_CooldownFrameCount / 2) { return false; }
+
+		m_AvgFrameTimeMS = m_AvgFrameTimeMS == 0.0f ?
+			frameTimeMS :
+			m_AvgFrameTimeMS + c_FrameTimeSmoothing * (frameTimeMS - m_AvgFrameTimeMS);
+		if (m_FramesSinceChange < c_CooldownFrameCount) { return false; }
+
+		// Frame time at a given scale, relative to the current pixel count
+		auto predict = [this](float scale) { return m_AvgFrameTimeMS * (scale * scale) / (m_Scale * m_Scale); };
+
+		float newScale = m_Scale;
+		if (m_AvgFrameTimeMS > m_TargetFrameTimeMS * (1.0f + c_Tolerance))
+		{
+			// Jump directly to the largest step that is predicted to meet the target
+			newScale = m_Scale - m_ScaleStep;
+			while (newScale - m_ScaleStep >= m_MinScale && predict(newScale) > m_TargetFrameTimeMS) { newScale -= m_ScaleStep; }
+		}
+		else if (predict(m_Scale + m_ScaleStep) < m_TargetFrameTimeMS * (1.0f - c_Tolerance))
+		{
+			newScale = m_Scale + m_ScaleStep;
+		}
+
+		newScale = std::clamp(newScale, m_MinScale, m_MaxScale);
+		if (std::abs(newScale - m_Scale) < 0.5f * m_ScaleStep) { return false; }
+
+		m_Scale = newScale;
+		m_AvgFrameTimeMS = 0.0f;
+		m_FramesSinceChange = 0;
+		return true;
+	}
+
+	void ResolutionController::Reset()
+	{
+		m_Scale = m_MaxScale;
+		m_AvgFrameTimeMS = 0.0f;
+		m_FramesSinceChange = 0;
+	}
+
+	void ResolutionController::RenderImGui()
+	{
+		ImGui::DragFloat("Target frame time (ms)", &m_TargetFrameTimeMS, 0.5f, 1.0f, 1000.0f);
+		ImGui::Text("Render scale %f", m_Scale);
+		ImGui::Text("Avg frame time %f ms", m_AvgFrameTimeMS);
+	}
+
+	float ResolutionController::GetScale() const
+	{
+		return m_Scale;
+	}
+
+	void ResolutionController::GetRenderSize(uint32_t outputWidth, uint32_t outputHeight, uint32_t& width, uint32_t& height) const
+	{
+		// Aligned for the renderers at every scale, the upscaler covers the rest of an unaligned output
+		width = AlignedSize(outputWidth, m_Scale, c_WidthAlignment);
+		height = AlignedSize(outputHeight, m_Scale, c_HeightAlignment);
+	}
+}
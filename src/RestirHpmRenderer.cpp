@@ -301,7 +301,7 @@ namespace en
 		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineCI.basePipelineIndex = 0;
 
-		VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_LocalInitPipeline);
+		VkResult result = VulkanAPI::CreateComputePipeline(pipelineCI, &m_LocalInitPipeline);
 		ASSERT_VULKAN(result);
 	}
 
@@ -325,7 +325,7 @@ namespace en
 		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineCI.basePipelineIndex = 0;
 
-		VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_TemporalReusePipeline);
+		VkResult result = VulkanAPI::CreateComputePipeline(pipelineCI, &m_TemporalReusePipeline);
 		ASSERT_VULKAN(result);
 	}
 
@@ -349,7 +349,7 @@ namespace en
 		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineCI.basePipelineIndex = 0;
 
-		VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_SpatialReusePipeline);
+		VkResult result = VulkanAPI::CreateComputePipeline(pipelineCI, &m_SpatialReusePipeline);
 		ASSERT_VULKAN(result);
 	}
 
@@ -373,7 +373,7 @@ namespace en
 		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineCI.basePipelineIndex = 0;
 
-		VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &m_RenderPipeline);
+		VkResult result = VulkanAPI::CreateComputePipeline(pipelineCI, &m_RenderPipeline);
 		ASSERT_VULKAN(result);
 	}
 
@@ -0,0 +1,16 @@
+#include <engine/util/RussianRoulette.hpp>
+#include <algorithm>
+
+namespace en
+{
+	bool RussianRoulette::Continue(uint32_t bounce, float& factor, Random& random)
+	{
+		if (bounce < c_MinBounces) { return true; }
+
+		const float survivalProb = std::min(1.0f, factor / c_Throughput);
+		if (random.NextFloat() >= survivalProb) { return false; }
+
+		factor /= survivalProb;
+		return true;
+	}
+}
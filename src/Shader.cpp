@@ -1,11 +1,10 @@
 #include <engine/graphics/vulkan/Shader.hpp>
+#include <engine/graphics/vulkan/ShaderCompiler.hpp>
 #include <engine/graphics/VulkanAPI.hpp>
 #include <engine/util/Log.hpp>
 #include <engine/util/read_file.hpp>
 
-const std::string compilerPath = "glslc";
 const std::string shaderDirPath = "data/shader/";
-const std::string includeDirPath = "data/shader/include";
 
 namespace en::vk
 {
@@ -17,26 +16,15 @@ namespace en::vk
 
 	Shader::Shader(const std::string& fileName, bool compiled)
 	{
-		std::string fullFilePath = shaderDirPath + fileName;
-
-		std::string outputFileName = fullFilePath + ".spv";
-
-		if (!compiled)
+		// Precompiled shaders are read from the .spv next to the source, everything else goes through the spirv cache
+		if (compiled)
 		{
-			std::string command = 
-				compilerPath + " " +
-				fullFilePath +
-				" -I " + includeDirPath +
-				" --target-spv=spv1.5 " +
-				" -o " + outputFileName;
-			Log::Info("Shader Compile Command: " + command);
-
-			// Compile
-			if (std::system(command.c_str()) != 0)
-				Log::Error("Failed to compile shader", true);
+			Create(ReadFileBinary(shaderDirPath + fileName + ".spv"));
+		}
+		else
+		{
+			Create(ShaderCompiler::GetSpirv(fileName));
 		}
-
-		Create(ReadFileBinary(outputFileName));
 	}
 
 	void Shader::Destroy()
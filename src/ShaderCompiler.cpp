@@ -0,0 +1,252 @@
+#include <engine/graphics/vulkan/ShaderCompiler.hpp>
+#include <engine/util/Log.hpp>
+#include <engine/util/read_file.hpp>
+#include <shaderc/shaderc.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <chrono>
+#include <unordered_set>
+#include <algorithm>
+#include <cstring>
+
+const std::string shaderDirPath = "data/shader/";
+const std::string includeDirPath = "data/shader/include/";
+
+namespace en::vk
+{
+	class ShaderCompiler::Includer : public shaderc::CompileOptions::IncluderInterface
+	{
+	public:
+		shaderc_include_result* GetInclude(
+			const char* requestedSource,
+			shaderc_include_type type,
+			const char* requestingSource,
+			size_t includeDepth) override
+		{
+			IncludeData* data = new IncludeData();
+			data->path = ResolveInclude(requestingSource, requestedSource);
+			if (data->path.empty())
+			{
+				// An empty source name tells shaderc that the include failed, content holds the error message
+				data->content = "Cannot find include " + std::string(requestedSource);
+			}
+			else
+			{
+				data->content = ReadText(data->path);
+			}
+
+			data->result.source_name = data->path.c_str();
+			data->result.source_name_length = data->path.size();
+			data->result.content = data->content.c_str();
+			data->result.content_length = data->content.size();
+			data->result.user_data = data;
+			return &data->result;
+		}
+
+		void ReleaseInclude(shaderc_include_result* result) override
+		{
+			delete static_cast<IncludeData*>(result->user_data);
+		}
+
+	private:
+		struct IncludeData
+		{
+			shaderc_include_result result;
+			std::string path;
+			std::string content;
+		};
+	};
+
+	const char* ShaderCompiler::c_CacheDirPath = "cache/spirv/";
+	uint32_t ShaderCompiler::s_ThreadCount = 0;
+
+	std::vector<char> ShaderCompiler::GetSpirv(const std::string& fileName, const std::vector<std::string>& defines)
+	{
+		const std::string filePath = shaderDirPath + fileName;
+
+		// Key over the whole include closure, so editing any included file invalidates the entry
+		std::stringstream keyStream;
+		keyStream << std::hex << std::setw(16) << std::setfill('0') << GetCacheKey(filePath, defines);
+		const std::filesystem::path cachePath = std::filesystem::path(c_CacheDirPath) / (keyStream.str() + ".spv");
+
+		if (std::filesystem::exists(cachePath)) { return ReadFileBinary(cachePath.string()); }
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		const std::vector<uint32_t> words = Compile(ReadText(filePath), filePath, defines);
+		const double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		Log::Info("Compiled shader " + fileName + " in " + std::to_string(time) + " ms");
+
+		std::vector<char> code(words.size() * sizeof(uint32_t));
+		std::memcpy(code.data(), words.data(), code.size());
+
+		// Write to a unique temporary file first, concurrent runs may compile the same shader
+		std::filesystem::create_directories(c_CacheDirPath);
+		std::stringstream tempName;
+		tempName << cachePath.string() << "." << std::this_thread::get_id() << ".tmp";
+		const std::filesystem::path tempPath(tempName.str());
+
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (file.is_open())
+		{
+			file.write(code.data(), code.size());
+			file.close();
+
+			std::error_code error;
+			std::filesystem::rename(tempPath, cachePath, error);
+			if (error) { std::filesystem::remove(tempPath, error); }
+		}
+		else
+		{
+			Log::Warn("Failed to write spirv cache " + tempPath.string());
+		}
+
+		return code;
+	}
+
+	void ShaderCompiler::Precompile(const std::vector<std::string>& fileNames)
+	{
+		uint32_t threadCount = s_ThreadCount == 0 ? std::thread::hardware_concurrency() : s_ThreadCount;
+		threadCount = std::max(1u, std::min(threadCount, static_cast<uint32_t>(fileNames.size())));
+
+		// An exception escaping a std::thread terminates the process, so compile errors are rethrown after the join
+		std::atomic<size_t> nextFile = 0;
+		std::exception_ptr error;
+		std::mutex errorMutex;
+		auto worker = [&]()
+		{
+			try
+			{
+				for (size_t i = nextFile++; i < fileNames.size(); i = nextFile++)
+				{
+					GetSpirv(fileNames[i]);
+				}
+			}
+			catch (...)
+			{
+				nextFile = fileNames.size();
+				const std::lock_guard<std::mutex> lock(errorMutex);
+				if (!error) { error = std::current_exception(); }
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (uint32_t i = 1; i < threadCount; i++) { threads.emplace_back(worker); }
+		worker();
+		for (std::thread& thread : threads) { thread.join(); }
+
+		if (error) { std::rethrow_exception(error); }
+	}
+
+	std::vector<uint32_t> ShaderCompiler::Compile(const std::string& source, const std::string& sourceName, const std::vector<std::string>& defines)
+	{
+		const std::string extension = std::filesystem::path(sourceName).extension().string();
+		shaderc_shader_kind kind = shaderc_glsl_infer_from_source;
+		if (extension == ".comp") { kind = shaderc_glsl_compute_shader; }
+		else if (extension == ".vert") { kind = shaderc_glsl_vertex_shader; }
+		else if (extension == ".geom") { kind = shaderc_glsl_geometry_shader; }
+		else if (extension == ".frag") { kind = shaderc_glsl_fragment_shader; }
+
+		shaderc::CompileOptions options;
+		options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
+		options.SetTargetSpirv(shaderc_spirv_version_1_5);
+		options.SetIncluder(std::make_unique<Includer>());
+		for (const std::string& define : defines)
+		{
+			const size_t separator = define.find('=');
+			if (separator == std::string::npos) { options.AddMacroDefinition(define); }
+			else { options.AddMacroDefinition(define.substr(0, separator), define.substr(separator + 1)); }
+		}
+
+		// A compiler instance is cheap and keeps concurrent compilations independent
+		shaderc::Compiler compiler;
+		const shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(source, kind, sourceName.c_str(), options);
+		if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+		{
+			Log::Error("Failed to compile shader " + sourceName + "\n" + result.GetErrorMessage(), true);
+		}
+
+		return std::vector<uint32_t>(result.cbegin(), result.cend());
+	}
+
+	void ShaderCompiler::SetThreadCount(uint32_t threadCount)
+	{
+		s_ThreadCount = threadCount;
+	}
+
+	uint64_t ShaderCompiler::GetCacheKey(const std::string& filePath, const std::vector<std::string>& defines)
+	{
+		// FNV-1a over target, defines and every file of the include closure in discovery order
+		uint64_t hash = 14695981039346656037ull;
+		auto hashBytes = [&hash](const std::string& bytes)
+		{
+			for (const char c : bytes)
+			{
+				hash ^= static_cast<uint8_t>(c);
+				hash *= 1099511628211ull;
+			}
+			hash ^= 0xFF;
+			hash *= 1099511628211ull;
+		};
+
+		hashBytes("v" + std::to_string(c_CacheVersion) + " vulkan1.3 spv1.5");
+		for (const std::string& define : defines) { hashBytes(define); }
+
+		// Includes are followed regardless of preprocessor conditions, which can only add files to the key
+		std::vector<std::string> openPaths = { filePath };
+		std::unordered_set<std::string> visitedPaths;
+		while (!openPaths.empty())
+		{
+			const std::string path = openPaths.back();
+			openPaths.pop_back();
+			if (!visitedPaths.insert(path).second) { continue; }
+
+			const std::string source = ReadText(path);
+			hashBytes(path);
+			hashBytes(source);
+
+			std::istringstream lines(source);
+			std::string line;
+			while (std::getline(lines, line))
+			{
+				const size_t directive = line.find("#include");
+				if (directive == std::string::npos) { continue; }
+				const size_t nameBegin = line.find('"', directive);
+				const size_t nameEnd = line.find('"', nameBegin + 1);
+				if (nameBegin == std::string::npos || nameEnd == std::string::npos) { continue; }
+
+				const std::string includePath = ResolveInclude(path, line.substr(nameBegin + 1, nameEnd - nameBegin - 1));
+				if (!includePath.empty()) { openPaths.push_back(includePath); }
+			}
+		}
+
+		return hash;
+	}
+
+	std::string ShaderCompiler::ResolveInclude(const std::string& requestingPath, const std::string& includeName)
+	{
+		// Relative to the including file first, then the shared include directory (glslc -I)
+		const std::filesystem::path relativePath = std::filesystem::path(requestingPath).parent_path() / includeName;
+		if (std::filesystem::exists(relativePath)) { return relativePath.lexically_normal().generic_string(); }
+
+		const std::filesystem::path includePath = std::filesystem::path(includeDirPath) / includeName;
+		if (std::filesystem::exists(includePath)) { return includePath.lexically_normal().generic_string(); }
+
+		return "";
+	}
+
+	std::string ShaderCompiler::ReadText(const std::string& filePath)
+	{
+		std::ifstream file(filePath, std::ios::binary);
+		if (!file.is_open()) { Log::Error("Failed to open shader file " + filePath, true); }
+
+		std::stringstream content;
+		content << file.rdbuf();
+		return content.str();
+	}
+}
@@ -1,4 +1,5 @@
 #include <engine/graphics/renderer/SimpleModelRenderer.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
 #include <engine/graphics/VulkanAPI.hpp>
 #include <glm/glm.hpp>
 #include <engine/graphics/vulkan/CommandRecorder.hpp>
@@ -47,8 +48,7 @@ namespace en
 		submitInfo.signalSemaphoreCount = 0;
 		submitInfo.pSignalSemaphores = nullptr;
 
-		VkResult result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		ASSERT_VULKAN(result);
+		vk::FramePacer::Submit(queue, submitInfo, VK_NULL_HANDLE);
 	}
 
 	void SimpleModelRenderer::Destroy()
@@ -59,11 +59,11 @@ namespace en
 		vkDestroyFramebuffer(device, m_Framebuffer, nullptr);
 
 		vkDestroyImageView(device, m_DepthImageView, nullptr);
-		vkFreeMemory(device, m_DepthImageMemory, nullptr);
+		vk::MemoryAllocator::Free(m_DepthImageMemory);
 		vkDestroyImage(device, m_DepthImage, nullptr);
 
 		vkDestroyImageView(device, m_ColorImageView, nullptr);
-		vkFreeMemory(device, m_ColorImageMemory, nullptr);
+		vk::MemoryAllocator::Free(m_ColorImageMemory);
 		vkDestroyImage(device, m_ColorImage, nullptr);
 
 		vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
@@ -84,11 +84,11 @@ namespace en
 		vkDestroyFramebuffer(device, m_Framebuffer, nullptr);
 
 		vkDestroyImageView(device, m_DepthImageView, nullptr);
-		vkFreeMemory(device, m_DepthImageMemory, nullptr);
+		vk::MemoryAllocator::Free(m_DepthImageMemory);
 		vkDestroyImage(device, m_DepthImage, nullptr);
 
 		vkDestroyImageView(device, m_ColorImageView, nullptr);
-		vkFreeMemory(device, m_ColorImageMemory, nullptr);
+		vk::MemoryAllocator::Free(m_ColorImageMemory);
 		vkDestroyImage(device, m_ColorImage, nullptr);
 
 		// Create
@@ -403,7 +403,7 @@ namespace en
 		createInfo.basePipelineHandle = VK_NULL_HANDLE;
 		createInfo.basePipelineIndex = -1;
 
-		VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &m_Pipeline);
+		VkResult result = VulkanAPI::CreateGraphicsPipeline(createInfo, &m_Pipeline);
 		ASSERT_VULKAN(result);
 	}
 
@@ -431,22 +431,7 @@ namespace en
 		ASSERT_VULKAN(result);
 
 		// Allocate Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_ColorImage, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_ColorImageMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_ColorImage, m_ColorImageMemory, 0);
-		ASSERT_VULKAN(result);
+		m_ColorImageMemory = vk::MemoryAllocator::AllocateImage(m_ColorImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Create Image View
 		VkImageViewCreateInfo imageViewCreateInfo;
@@ -534,22 +519,7 @@ namespace en
 		ASSERT_VULKAN(result);
 
 		// Allocate Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_DepthImage, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_DepthImageMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_DepthImage, m_DepthImageMemory, 0);
-		ASSERT_VULKAN(result);
+		m_DepthImageMemory = vk::MemoryAllocator::AllocateImage(m_DepthImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Create Image View
 		VkImageViewCreateInfo imageViewCreateInfo;
@@ -598,7 +568,7 @@ namespace en
 		VkCommandBufferBeginInfo beginInfo;
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		beginInfo.pNext = nullptr;
-		beginInfo.flags = 0;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
 		beginInfo.pInheritanceInfo = nullptr;
 
 		VkResult result = vkBeginCommandBuffer(m_CommandBuffer, &beginInfo);
@@ -1,5 +1,6 @@
 #include <engine/graphics/vulkan/Swapchain.hpp>
 #include <engine/graphics/VulkanAPI.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
 #include <engine/graphics/Window.hpp>
 #include <engine/util/Log.hpp>
 
@@ -31,8 +32,11 @@ namespace en::vk
 	{
 		VkDevice device = VulkanAPI::GetDevice();
 
-		vkDestroySemaphore(device, m_ImageAvailableSemaphore, nullptr);
-		vkDestroySemaphore(device, m_RenderFinishedSemaphore, nullptr);
+		for (uint32_t i = 0; i < FramePacer::c_MaxFramesInFlight; i++)
+		{
+			vkDestroySemaphore(device, m_ImageAvailableSemaphores[i], nullptr);
+			vkDestroySemaphore(device, m_RenderFinishedSemaphores[i], nullptr);
+		}
 
 		m_CommandPool.Destroy();
 
@@ -44,6 +48,7 @@ namespace en::vk
 
 	void Swapchain::Resize(uint32_t width, uint32_t height)
 	{
+		FramePacer::WaitIdle();
 		Destroy(false);
 
 		VkSwapchainKHR oldSwapchain = m_Handle;
@@ -76,9 +81,14 @@ namespace en::vk
 		if (newWidth != m_Width || newHeight != m_Height)
 			resized = true;
 
+		// Semaphores are per frame in flight, so the ones of an earlier frame may still be pending
+		const uint32_t frameSlot = FramePacer::GetFrameSlot();
+		VkSemaphore imageAvailableSemaphore = m_ImageAvailableSemaphores[frameSlot];
+		VkSemaphore renderFinishedSemaphore = m_RenderFinishedSemaphores[frameSlot];
+
 		// Aquire image from swapchain
 		uint32_t imageIndex;
-		VkResult result = vkAcquireNextImageKHR(device, m_Handle, UINT64_MAX, m_ImageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+		VkResult result = vkAcquireNextImageKHR(device, m_Handle, UINT64_MAX, imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
 		if (resized || result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
 		{
 			m_ResizeCallback();
@@ -91,19 +101,19 @@ namespace en::vk
 		}
 
 		// Submit correct CommandBuffer
-		std::vector<VkSemaphore> renderWaitSemaphores = { m_ImageAvailableSemaphore };
+		std::vector<VkSemaphore> renderWaitSemaphores = { imageAvailableSemaphore };
 		std::vector<VkPipelineStageFlags> renderWaitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 		if (waitSemaphore != VK_NULL_HANDLE)
 		{
 			renderWaitSemaphores.push_back(waitSemaphore);
 			renderWaitStages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 		}
-		std::vector<VkSemaphore> renderSignalSemaphores = { m_RenderFinishedSemaphore };
+		std::vector<VkSemaphore> renderSignalSemaphores = { renderFinishedSemaphore };
 		if (signalSemaphore != VK_NULL_HANDLE)
 		{
 			renderSignalSemaphores.push_back(signalSemaphore);
 		}
-		std::vector<VkSemaphore> presentWaitSemaphores = { m_RenderFinishedSemaphore };
+		std::vector<VkSemaphore> presentWaitSemaphores = { renderFinishedSemaphore };
 
 		VkCommandBuffer commandBuffer = m_CommandPool.GetBuffer(imageIndex);
 
@@ -118,8 +128,7 @@ namespace en::vk
 		submitInfo.signalSemaphoreCount = renderSignalSemaphores.size();
 		submitInfo.pSignalSemaphores = renderSignalSemaphores.data();
 
-		result = vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-		ASSERT_VULKAN(result);
+		FramePacer::Submit(graphicsQueue, submitInfo, VK_NULL_HANDLE);
 
 		// Presentation
 		VkPresentInfoKHR presentInfo;
@@ -134,9 +143,6 @@ namespace en::vk
 
 		result = vkQueuePresentKHR(presentQueue, &presentInfo);
 		ASSERT_VULKAN(result);
-
-		result = vkQueueWaitIdle(graphicsQueue);
-		ASSERT_VULKAN(result);
 	}
 
 	VkSwapchainKHR Swapchain::GetHandle() const
@@ -204,10 +210,13 @@ namespace en::vk
 		semaphoreCreateInfo.pNext = nullptr;
 		semaphoreCreateInfo.flags = 0;
 
-		VkResult result = vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &m_ImageAvailableSemaphore);
-		ASSERT_VULKAN(result);
+		for (uint32_t i = 0; i < FramePacer::c_MaxFramesInFlight; i++)
+		{
+			VkResult result = vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &m_ImageAvailableSemaphores[i]);
+			ASSERT_VULKAN(result);
 
-		result = vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &m_RenderFinishedSemaphore);
-		ASSERT_VULKAN(result);
+			result = vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &m_RenderFinishedSemaphores[i]);
+			ASSERT_VULKAN(result);
+		}
 	}
 }
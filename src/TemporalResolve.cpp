@@ -0,0 +1,107 @@
+#include <engine/util/TemporalResolve.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace en
+{
+	static glm::vec4 LoadPixel(const float* image, uint32_t width, int32_t x, int32_t y)
+	{
+		const float* p = image + (static_cast<size_t>(y) * width + x) * 4;
+		return glm::vec4(p[0], p[1], p[2], p[3]);
+	}
+
+	bool TemporalResolve::Reproject(
+		const glm::mat4& prevProjView,
+		const glm::vec3& worldPos,
+		uint32_t width,
+		uint32_t height,
+		glm::vec2& prevPixel)
+	{
+		const glm::vec4 prevClip = prevProjView * glm::vec4(worldPos, 1.0f);
+		if (prevClip.w <= 0.0f) { return false; }
+
+		const glm::vec2 ndc = glm::vec2(prevClip.x, prevClip.y) / prevClip.w;
+		prevPixel = ((ndc * 0.5f) + glm::vec2(0.5f)) * glm::vec2(width, height);
+		return
+			prevPixel.x >= 0.0f && prevPixel.y >= 0.0f &&
+			prevPixel.x <= static_cast<float>(width - 1) && prevPixel.y <= static_cast<float>(height - 1);
+	}
+
+	void TemporalResolve::ResolveImage(const Frame& frame, bool reset, bool reproject, float* output)
+	{
+		for (uint32_t y = 0; y < frame.height; y++)
+		{
+			for (uint32_t x = 0; x < frame.width; x++)
+			{
+				const glm::vec4 color = ResolvePixel(frame, reset, reproject, x, y);
+				float* out = output + (static_cast<size_t>(y) * frame.width + x) * 4;
+				out[0] = color.x;
+				out[1] = color.y;
+				out[2] = color.z;
+				out[3] = color.w;
+			}
+		}
+	}
+
+	glm::vec4 TemporalResolve::LoadHistoryBilinear(const Frame& frame, const glm::vec2& pixel)
+	{
+		const int32_t x0 = static_cast<int32_t>(std::floor(pixel.x));
+		const int32_t y0 = static_cast<int32_t>(std::floor(pixel.y));
+		const int32_t x1 = std::min(x0 + 1, static_cast<int32_t>(frame.width) - 1);
+		const int32_t y1 = std::min(y0 + 1, static_cast<int32_t>(frame.height) - 1);
+		const float fx = pixel.x - static_cast<float>(x0);
+		const float fy = pixel.y - static_cast<float>(y0);
+
+		return glm::mix(
+			glm::mix(LoadPixel(frame.history, frame.width, x0, y0), LoadPixel(frame.history, frame.width, x1, y0), fx),
+			glm::mix(LoadPixel(frame.history, frame.width, x0, y1), LoadPixel(frame.history, frame.width, x1, y1), fx),
+			fy);
+	}
+
+	glm::vec4 TemporalResolve::ResolvePixel(const Frame& frame, bool reset, bool reproject, uint32_t x, uint32_t y)
+	{
+		const glm::vec3 currentColor = glm::vec3(LoadPixel(frame.current, frame.width, x, y));
+
+		glm::vec4 history(0.0f);
+		if (!reset)
+		{
+			if (!reproject)
+			{
+				history = LoadPixel(frame.history, frame.width, x, y);
+			}
+			else
+			{
+				// Same primary ray as in gen_rays
+				const glm::vec2 fragUV(static_cast<float>(x) / frame.width, static_cast<float>(y) / frame.height);
+				const glm::vec4 nearPos = frame.invProjView * glm::vec4((fragUV * 2.0f) - glm::vec2(1.0f), 0.0f, 1.0f);
+				const glm::vec3 rd = glm::normalize((glm::vec3(nearPos) / nearPos.w) - frame.camPos);
+				const float depth = frame.depth[static_cast<size_t>(y) * frame.width + x];
+
+				glm::vec2 prevPixel;
+				if (Reproject(frame.prevProjView, frame.camPos + (rd * depth), frame.width, frame.height, prevPixel))
+				{
+					glm::vec3 minColor = currentColor;
+					glm::vec3 maxColor = currentColor;
+					for (int32_t dy = -1; dy <= 1; dy++)
+					{
+						for (int32_t dx = -1; dx <= 1; dx++)
+						{
+							const int32_t nx = std::clamp(static_cast<int32_t>(x) + dx, 0, static_cast<int32_t>(frame.width) - 1);
+							const int32_t ny = std::clamp(static_cast<int32_t>(y) + dy, 0, static_cast<int32_t>(frame.height) - 1);
+							const glm::vec3 neighborColor = glm::vec3(LoadPixel(frame.current, frame.width, nx, ny));
+							minColor = glm::min(minColor, neighborColor);
+							maxColor = glm::max(maxColor, neighborColor);
+						}
+					}
+
+					history = LoadHistoryBilinear(frame, prevPixel);
+					const glm::vec3 clamped = glm::clamp(glm::vec3(history), minColor, maxColor);
+					history = glm::vec4(clamped, std::min(history.w, static_cast<float>(c_MaxMovingHistory)));
+				}
+			}
+		}
+
+		const float sampleCount = history.w + 1.0f;
+		return glm::vec4(glm::mix(glm::vec3(history), currentColor, 1.0f / sampleCount), sampleCount);
+	}
+}
@@ -3,9 +3,7 @@
 #include <stb_image.h>
 #include <engine/util/Log.hpp>
 #include <engine/graphics/VulkanAPI.hpp>
-#include <engine/graphics/vulkan/Buffer.hpp>
-#include <engine/graphics/vulkan/CommandPool.hpp>
-#include <engine/graphics/vulkan/CommandRecorder.hpp>
+#include <engine/graphics/vulkan/Uploader.hpp>
 
 namespace en::vk
 {
@@ -79,7 +77,7 @@ namespace en::vk
 	{
 		VkDevice device = VulkanAPI::GetDevice();
 
-		vkFreeMemory(device, m_DeviceMemory, nullptr);
+		MemoryAllocator::Free(m_DeviceMemory);
 		vkDestroySampler(device, m_Sampler, nullptr);
 		vkDestroyImageView(device, m_ImageView, nullptr);
 		vkDestroyImage(device, m_Image, nullptr);
@@ -124,23 +122,8 @@ namespace en::vk
 	{
 		VkDevice device = VulkanAPI::GetDevice();
 		VkDeviceSize size = static_cast<VkDeviceSize>(GetSizeInBytes());
-		VkQueue queue = VulkanAPI::GetGraphicsQueue(); // TODO: GetTransferQueue
 		VkResult result;
 
-		// Create image layout transfer commandpool + commandbuffer
-		CommandPool commandPool = CommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, VulkanAPI::GetGraphicsQFI());
-		commandPool.AllocateBuffers(1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-		VkCommandBuffer commandBuffer = commandPool.GetBuffer(0);
-
-		// Staging Buffer
-		Buffer stagingBuffer(
-			GetSizeInBytes(),
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			{});
-
-		stagingBuffer.SetData(size, data, 0, 0);
-
 		// Create Image
 		VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
 
@@ -165,35 +148,12 @@ namespace en::vk
 		ASSERT_VULKAN(result);
 
 		// Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_Image, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_DeviceMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_Image, m_DeviceMemory, 0);
-		ASSERT_VULKAN(result);
+		m_DeviceMemory = MemoryAllocator::AllocateImage(m_Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Transfer data
-		ChangeLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, commandBuffer, queue);
-
-		WriteBufferToImage(commandBuffer, queue, stagingBuffer.GetVulkanHandle());
-
-		ChangeLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer, queue);
-
-		// Destroy Staging buffer
-		stagingBuffer.Destroy();
-
-		// Destroy CommandBuffer and CommandPool
-		commandPool.Destroy();
+		Uploader::UploadImage(m_Image, { m_Width, m_Height, 1 }, data, size, m_ImageLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		Uploader::Flush();
+		m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
 		// Create ImageView
 		VkImageViewCreateInfo imageViewCreateInfo;
@@ -240,114 +200,4 @@ namespace en::vk
 		result = vkCreateSampler(device, &samplerCreateInfo, nullptr, &m_Sampler);
 		ASSERT_VULKAN(result);
 	}
-
-	void Texture2D::ChangeLayout(VkImageLayout layout, VkCommandBuffer commandBuffer, VkQueue queue)
-	{
-		VkAccessFlags srcAccessMask;
-		VkAccessFlags dstAccessMask;
-
-		VkPipelineStageFlags srcStageFlags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-		VkPipelineStageFlags dstStageFlags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-
-		if (m_ImageLayout == VK_IMAGE_LAYOUT_PREINITIALIZED && layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-		{
-			srcAccessMask = VK_ACCESS_NONE_KHR;
-			dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		}
-		else if (m_ImageLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		{
-			srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		}
-		else
-		{
-			Log::Error("Unknown image layout transision in Texture2D", true);
-		}
-
-		VkCommandBufferBeginInfo beginInfo;
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.pNext = nullptr;
-		beginInfo.flags = 0;
-		beginInfo.pInheritanceInfo = nullptr;
-
-		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
-		ASSERT_VULKAN(result);
-
-		vk::CommandRecorder::ImageLayoutTransfer(
-			commandBuffer,
-			m_Image,
-			m_ImageLayout,
-			layout,
-			srcAccessMask,
-			dstAccessMask,
-			srcStageFlags,
-			dstStageFlags);
-
-		result = vkEndCommandBuffer(commandBuffer);
-		ASSERT_VULKAN(result);
-
-		VkSubmitInfo submitInfo;
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.pNext = nullptr;
-		submitInfo.waitSemaphoreCount = 0;
-		submitInfo.pWaitSemaphores = nullptr;
-		submitInfo.pWaitDstStageMask = nullptr;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-		submitInfo.signalSemaphoreCount = 0;
-		submitInfo.pSignalSemaphores = nullptr;
-
-		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		ASSERT_VULKAN(result);
-
-		result = vkQueueWaitIdle(queue);
-		ASSERT_VULKAN(result);
-
-		m_ImageLayout = layout;
-	}
-
-	void Texture2D::WriteBufferToImage(VkCommandBuffer commandBuffer, VkQueue queue, VkBuffer buffer)
-	{
-		VkCommandBufferBeginInfo beginInfo;
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.pNext = nullptr;
-		beginInfo.flags = 0;
-		beginInfo.pInheritanceInfo = nullptr;
-
-		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
-		ASSERT_VULKAN(result);
-
-		VkBufferImageCopy bufferImageCopy;
-		bufferImageCopy.bufferOffset = 0;
-		bufferImageCopy.bufferRowLength = 0;
-		bufferImageCopy.bufferImageHeight = 0;
-		bufferImageCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		bufferImageCopy.imageSubresource.mipLevel = 0;
-		bufferImageCopy.imageSubresource.baseArrayLayer = 0;
-		bufferImageCopy.imageSubresource.layerCount = 1;
-		bufferImageCopy.imageOffset = { 0, 0, 0 };
-		bufferImageCopy.imageExtent = { m_Width, m_Height, 1 };
-
-		vkCmdCopyBufferToImage(commandBuffer, buffer, m_Image, m_ImageLayout, 1, &bufferImageCopy);
-
-		result = vkEndCommandBuffer(commandBuffer);
-		ASSERT_VULKAN(result);
-
-		VkSubmitInfo submitInfo;
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.pNext = nullptr;
-		submitInfo.waitSemaphoreCount = 0;
-		submitInfo.pWaitSemaphores = nullptr;
-		submitInfo.pWaitDstStageMask = nullptr;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-		submitInfo.signalSemaphoreCount = 0;
-		submitInfo.pSignalSemaphores = nullptr;
-
-		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		ASSERT_VULKAN(result);
-
-		result = vkQueueWaitIdle(queue);
-		ASSERT_VULKAN(result);
-	}
 }
@@ -2,7 +2,7 @@
 #include <engine/graphics/vulkan/CommandRecorder.hpp>
 #include <engine/graphics/VulkanAPI.hpp>
 #include <engine/graphics/vulkan/CommandPool.hpp>
-#include <engine/graphics/vulkan/Buffer.hpp>
+#include <engine/graphics/vulkan/Uploader.hpp>
 #include <array>
 #include <openvdb/openvdb.h>
 #include <filesystem>
@@ -10,6 +10,15 @@
 namespace en::vk
 {
 	Texture3D Texture3D::FromVDB(const std::string& fileName)
+	{
+		return Texture3D(
+			LoadVDB(fileName),
+			VK_FILTER_NEAREST,
+			VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
+			VK_BORDER_COLOR_INT_OPAQUE_BLACK);
+	}
+
+	std::vector<std::vector<std::vector<float>>> Texture3D::LoadVDB(const std::string& fileName)
 	{
 		// Check if file exists
 		if (!std::filesystem::exists(fileName))
@@ -73,12 +82,7 @@ namespace en::vk
 
 		if (maxVal != 0.0 && maxVal != 1.0) { Log::Error("VDB is not normalized", true); }
 
-		// Return texture
-		return Texture3D(
-			data, 
-			VK_FILTER_NEAREST, 
-			VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER, 
-			VK_BORDER_COLOR_INT_OPAQUE_BLACK);
+		return data;
 	}
 
 	Texture3D::Texture3D(
@@ -95,24 +99,7 @@ namespace en::vk
 	{
 		// TODO: check for homogenous size
 
-		// Copy to linear buffer
-		std::vector<uint8_t> dataArray(m_Width * m_Height * m_Depth * 4);
-		for (uint32_t i = 0; i < m_Width; i++)
-		{
-			for (uint32_t j = 0; j < m_Height; j++)
-			{
-				for (uint32_t k = 0; k < m_Depth; k++)
-				{
-					uint8_t value = static_cast<uint8_t>(data[i][j][k] * 255.0f);
-					uint32_t index = 4 * i + 4 * m_Width * j + 4 * m_Width * m_Height * k;
-					dataArray[index + 0] = value;
-					dataArray[index + 1] = value;
-					dataArray[index + 2] = value;
-					dataArray[index + 3] = 1;
-				}
-			}
-		}
-
+		std::vector<uint8_t> dataArray = PackData(data);
 		LoadToDevice(dataArray.data(), filter, addressMode, borderColor);
 	}
 
@@ -155,12 +142,39 @@ namespace en::vk
 	{
 		VkDevice device = VulkanAPI::GetDevice();
 
-		vkFreeMemory(device, m_DeviceMemory, nullptr);
+		MemoryAllocator::Free(m_DeviceMemory);
 		vkDestroySampler(device, m_Sampler, nullptr);
 		vkDestroyImageView(device, m_ImageView, nullptr);
 		vkDestroyImage(device, m_Image, nullptr);
 	}
 
+	void Texture3D::SetData(const std::vector<std::vector<std::vector<float>>>& data)
+	{
+		if (data.size() != m_Width || data[0].size() != m_Height || data[0][0].size() != m_Depth)
+		{
+			Log::Error("Texture3D::SetData size does not match texture size", true);
+		}
+
+		VkQueue queue = VulkanAPI::GetGraphicsQueue();
+
+		CommandPool commandPool = CommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, VulkanAPI::GetGraphicsQFI());
+		commandPool.AllocateBuffers(1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		VkCommandBuffer commandBuffer = commandPool.GetBuffer(0);
+
+		// Runtime updates stage through the frame arena instead of allocating device memory every time
+		std::vector<uint8_t> dataArray = PackData(data);
+		Buffer stagingBuffer = Buffer::FromFrameArena(GetRealSizeInBytes(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+		stagingBuffer.SetData(GetRealSizeInBytes(), dataArray.data(), 0, 0);
+
+		// The layout transition waits for all previous work on the queue, so frames still reading the texture finish first
+		ChangeLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, commandBuffer, queue);
+		WriteBufferToImage(commandBuffer, queue, stagingBuffer.GetVulkanHandle());
+		ChangeLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer, queue);
+
+		stagingBuffer.Destroy();
+		commandPool.Destroy();
+	}
+
 	uint32_t Texture3D::GetWidth() const
 	{
 		return m_Width;
@@ -196,27 +210,35 @@ namespace en::vk
 		return m_Sampler;
 	}
 
+	std::vector<uint8_t> Texture3D::PackData(const std::vector<std::vector<std::vector<float>>>& data) const
+	{
+		// Copy to linear buffer
+		std::vector<uint8_t> dataArray(m_Width * m_Height * m_Depth * 4);
+		for (uint32_t i = 0; i < m_Width; i++)
+		{
+			for (uint32_t j = 0; j < m_Height; j++)
+			{
+				for (uint32_t k = 0; k < m_Depth; k++)
+				{
+					uint8_t value = static_cast<uint8_t>(data[i][j][k] * 255.0f);
+					uint32_t index = 4 * i + 4 * m_Width * j + 4 * m_Width * m_Height * k;
+					dataArray[index + 0] = value;
+					dataArray[index + 1] = value;
+					dataArray[index + 2] = value;
+					dataArray[index + 3] = 1;
+				}
+			}
+		}
+
+		return dataArray;
+	}
+
 	void Texture3D::LoadToDevice(void* data, VkFilter filter, VkSamplerAddressMode addressMode, VkBorderColor borderColor)
 	{
 		VkDevice device = VulkanAPI::GetDevice();
 		VkDeviceSize size = static_cast<VkDeviceSize>(GetRealSizeInBytes());
-		VkQueue queue = VulkanAPI::GetGraphicsQueue(); // TODO: GetTransferQueue
 		VkResult result;
 
-		// Create image layout transfer commandpool + commandbuffer
-		CommandPool commandPool = CommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, VulkanAPI::GetGraphicsQFI());
-		commandPool.AllocateBuffers(1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-		VkCommandBuffer commandBuffer = commandPool.GetBuffer(0);
-
-		// Staging Buffer
-		Buffer stagingBuffer(
-			GetRealSizeInBytes(),
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			{});
-
-		stagingBuffer.SetData(size, data, 0, 0);
-
 		// Create Image
 		VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
 
@@ -241,35 +263,12 @@ namespace en::vk
 		ASSERT_VULKAN(result);
 
 		// Image Memory
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(device, m_Image, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo;
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.pNext = nullptr;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = VulkanAPI::FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		result = vkAllocateMemory(device, &allocateInfo, nullptr, &m_DeviceMemory);
-		ASSERT_VULKAN(result);
-
-		result = vkBindImageMemory(device, m_Image, m_DeviceMemory, 0);
-		ASSERT_VULKAN(result);
+		m_DeviceMemory = MemoryAllocator::AllocateImage(m_Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Transfer data
-		ChangeLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, commandBuffer, queue);
-
-		WriteBufferToImage(commandBuffer, queue, stagingBuffer.GetVulkanHandle());
-
-		ChangeLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer, queue);
-
-		// Destroy Staging buffer
-		stagingBuffer.Destroy();
-
-		// Destroy CommandBuffer and CommandPool
-		commandPool.Destroy();
+		Uploader::UploadImage(m_Image, { m_Width, m_Height, m_Depth }, data, size, m_ImageLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		Uploader::Flush();
+		m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
 		// Create ImageView
 		VkImageViewCreateInfo imageViewCreateInfo;
@@ -335,6 +334,11 @@ namespace en::vk
 			srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 			dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 		}
+		else if (m_ImageLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+		{
+			srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		}
 		else
 		{
 			Log::Error("Unknown image layout transision in Texture2D", true);
@@ -0,0 +1,62 @@
+#include <engine/util/TileScheduler.hpp>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace en
+{
+	float TileScheduler::GetPixelRelStdError(const float* mean, const float* info, uint32_t minSampleCount)
+	{
+		// Pixels that never scattered only see the env map, which converges with the first sample
+		if (mean[3] == 0.0f) { return 0.0f; }
+
+		const float n = info[0];
+		if (n < static_cast<float>(minSampleCount) || n < 2.0f) { return std::numeric_limits<float>::max(); }
+
+		const float meanSum = mean[0] + mean[1] + mean[2];
+		const float m2Sum = info[1] + info[2] + info[3];
+		const float stdError = std::sqrt(m2Sum / (n * (n - 1.0f)));
+		return stdError / std::max(meanSum, 1e-4f);
+	}
+
+	std::vector<uint32_t> TileScheduler::BuildTileList(
+		const float* mean,
+		const float* info,
+		uint32_t width,
+		uint32_t height,
+		float targetRelStdError,
+		uint32_t minSampleCount,
+		bool reset)
+	{
+		const uint32_t tileCountX = GetTileCount(width, c_TileWidth);
+		const uint32_t tileCountY = GetTileCount(height, c_TileHeight);
+
+		std::vector<uint32_t> tileIndices;
+		for (uint32_t tileY = 0; tileY < tileCountY; tileY++)
+		{
+			for (uint32_t tileX = 0; tileX < tileCountX; tileX++)
+			{
+				float maxRelStdError = reset ? std::numeric_limits<float>::max() : 0.0f;
+				const uint32_t yEnd = std::min((tileY + 1) * c_TileHeight, height);
+				const uint32_t xEnd = std::min((tileX + 1) * c_TileWidth, width);
+				for (uint32_t y = tileY * c_TileHeight; y < yEnd && !reset; y++)
+				{
+					for (uint32_t x = tileX * c_TileWidth; x < xEnd; x++)
+					{
+						const size_t index = (static_cast<size_t>(y) * width + x) * 4;
+						maxRelStdError = std::max(maxRelStdError, GetPixelRelStdError(mean + index, info + index, minSampleCount));
+					}
+				}
+
+				if (maxRelStdError > targetRelStdError) { tileIndices.push_back(tileY * tileCountX + tileX); }
+			}
+		}
+
+		return tileIndices;
+	}
+
+	uint32_t TileScheduler::GetTileCount(uint32_t size, uint32_t tileSize)
+	{
+		return (size + tileSize - 1) / tileSize;
+	}
+}
@@ -0,0 +1,170 @@
+#include <engine/graphics/vulkan/TimestampQueryRing.hpp>
+#include <engine/graphics/VulkanAPI.hpp>
+#include <imgui.h>
+#include <algorithm>
+
+namespace en::vk
+{
+	TimestampQueryRing::TimestampQueryRing(const std::vector<std::string>& passNames) :
+		m_PassNames(passNames),
+		m_TimestampCount(static_cast<uint32_t>(passNames.size()) + 1),
+		m_TimestampPeriodInMS(VulkanAPI::GetTimestampPeriod() * 1e-6f),
+		m_NextSlot(0),
+		m_SampleCount(0)
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		m_PassNames.push_back("Total");
+		m_Samples.resize(m_PassNames.size(), std::vector<float>(c_WindowSize, 0.0f));
+
+		VkQueryPoolCreateInfo queryPoolCI;
+		queryPoolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolCI.pNext = nullptr;
+		queryPoolCI.flags = 0;
+		queryPoolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolCI.queryCount = m_TimestampCount;
+		queryPoolCI.pipelineStatistics = 0;
+
+		for (uint32_t slot = 0; slot < c_RingSize; slot++)
+		{
+			ASSERT_VULKAN(vkCreateQueryPool(device, &queryPoolCI, nullptr, &m_QueryPools[slot]));
+			vkResetQueryPool(device, m_QueryPools[slot], 0, m_TimestampCount);
+			m_Pending[slot] = false;
+		}
+	}
+
+	void TimestampQueryRing::Destroy()
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		for (VkQueryPool queryPool : m_QueryPools)
+		{
+			vkDestroyQueryPool(device, queryPool, nullptr);
+		}
+	}
+
+	void TimestampQueryRing::CmdReset(VkCommandBuffer commandBuffer, uint32_t slot) const
+	{
+		vkCmdResetQueryPool(commandBuffer, m_QueryPools[slot], 0, m_TimestampCount);
+	}
+
+	void TimestampQueryRing::CmdWriteTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage, uint32_t slot, uint32_t index) const
+	{
+		vkCmdWriteTimestamp(commandBuffer, stage, m_QueryPools[slot], index);
+	}
+
+	uint32_t TimestampQueryRing::NextSlot()
+	{
+		Collect();
+
+		// Only happens if more submissions than ring slots are in flight, which the frame pacer prevents
+		const uint32_t slot = m_NextSlot;
+		if (m_Pending[slot]) { ReadSlot(slot, true); }
+
+		m_Pending[slot] = true;
+		m_NextSlot = (m_NextSlot + 1) % c_RingSize;
+		return slot;
+	}
+
+	void TimestampQueryRing::Collect()
+	{
+		// Oldest slot first, so samples stay in submission order
+		for (uint32_t i = 0; i < c_RingSize; i++)
+		{
+			const uint32_t slot = (m_NextSlot + i) % c_RingSize;
+			if (!m_Pending[slot]) { continue; }
+			if (!ReadSlot(slot, false)) { break; }
+		}
+	}
+
+	size_t TimestampQueryRing::GetPassCount() const
+	{
+		return m_PassNames.size();
+	}
+
+	size_t TimestampQueryRing::GetTotalPass() const
+	{
+		return m_PassNames.size() - 1;
+	}
+
+	const std::string& TimestampQueryRing::GetPassName(size_t pass) const
+	{
+		return m_PassNames[pass];
+	}
+
+	float TimestampQueryRing::GetLast(size_t pass) const
+	{
+		if (m_SampleCount == 0) { return 0.0f; }
+		return m_Samples[pass][(m_SampleCount - 1) % c_WindowSize];
+	}
+
+	TimestampQueryRing::Stats TimestampQueryRing::GetStats(size_t pass) const
+	{
+		Stats stats = {};
+		const size_t count = std::min(m_SampleCount, c_WindowSize);
+		if (count == 0) { return stats; }
+
+		std::vector<float> sorted(m_Samples[pass].begin(), m_Samples[pass].begin() + count);
+		std::sort(sorted.begin(), sorted.end());
+
+		double sum = 0.0;
+		for (float sample : sorted) { sum += sample; }
+
+		auto percentile = [&](float p) { return sorted[static_cast<size_t>(p * static_cast<float>(count - 1) + 0.5f)]; };
+
+		stats.last = GetLast(pass);
+		stats.mean = static_cast<float>(sum / static_cast<double>(count));
+		stats.min = sorted.front();
+		stats.max = sorted.back();
+		stats.p50 = percentile(0.50f);
+		stats.p95 = percentile(0.95f);
+		stats.p99 = percentile(0.99f);
+		return stats;
+	}
+
+	void TimestampQueryRing::RenderImGui() const
+	{
+		for (size_t pass = 0; pass < m_PassNames.size(); pass++)
+		{
+			const Stats stats = GetStats(pass);
+			ImGui::Text(
+				"%s %.3f ms (mean %.3f, min %.3f, max %.3f, p50 %.3f, p95 %.3f, p99 %.3f)",
+				m_PassNames[pass].c_str(), stats.last, stats.mean, stats.min, stats.max, stats.p50, stats.p95, stats.p99);
+		}
+
+		const float meanTotal = GetStats(GetTotalPass()).mean;
+		ImGui::Text("Theoretical FPS %f", meanTotal > 0.0f ? 1000.0f / meanTotal : 0.0f);
+	}
+
+	bool TimestampQueryRing::ReadSlot(uint32_t slot, bool wait)
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		std::vector<uint64_t> queryResults(m_TimestampCount);
+		VkResult result = vkGetQueryPoolResults(
+			device,
+			m_QueryPools[slot],
+			0,
+			m_TimestampCount,
+			sizeof(uint64_t) * m_TimestampCount,
+			queryResults.data(),
+			sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | (wait ? VK_QUERY_RESULT_WAIT_BIT : 0));
+		if (result == VK_NOT_READY) { return false; }
+		ASSERT_VULKAN(result);
+
+		// Clears availability, so a slot that is submitted again never returns the old results
+		vkResetQueryPool(device, m_QueryPools[slot], 0, m_TimestampCount);
+		m_Pending[slot] = false;
+
+		const size_t sampleIndex = m_SampleCount % c_WindowSize;
+		for (uint32_t i = 0; i + 1 < m_TimestampCount; i++)
+		{
+			m_Samples[i][sampleIndex] = m_TimestampPeriodInMS * static_cast<float>(queryResults[i + 1] - queryResults[i]);
+		}
+		m_Samples[GetTotalPass()][sampleIndex] = m_TimestampPeriodInMS * static_cast<float>(queryResults[m_TimestampCount - 1] - queryResults[0]);
+		m_SampleCount++;
+
+		return true;
+	}
+}
@@ -0,0 +1,49 @@
+#include <engine/util/TransmittanceCacheBuilder.hpp>
+
+namespace en
+{
+	TransmittanceCacheBuilder::TransmittanceCacheBuilder(const glm::vec3& key) :
+		m_Key(key)
+	{
+	}
+
+	TransmittanceCacheBuilder::~TransmittanceCacheBuilder()
+	{
+		Wait();
+	}
+
+	bool TransmittanceCacheBuilder::Update(const glm::vec3& key, const BuildFn& build, Grid& grid, glm::vec3& builtKey)
+	{
+		bool finished = false;
+		if (m_Future.valid())
+		{
+			if (m_Future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) { return false; }
+			grid = m_Future.get();
+			builtKey = m_Key;
+			finished = true;
+		}
+
+		if (NeedsRebuild(key))
+		{
+			m_Key = key;
+			m_Future = std::async(std::launch::async, build, key);
+		}
+
+		return finished;
+	}
+
+	bool TransmittanceCacheBuilder::NeedsRebuild(const glm::vec3& key) const
+	{
+		return key != m_Key;
+	}
+
+	bool TransmittanceCacheBuilder::IsBuilding() const
+	{
+		return m_Future.valid();
+	}
+
+	void TransmittanceCacheBuilder::Wait()
+	{
+		if (m_Future.valid()) { m_Future.wait(); }
+	}
+}
@@ -0,0 +1,261 @@
+#include <engine/util/TransmittanceGrid.hpp>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+
+namespace en
+{
+	uint32_t TransmittanceGrid::s_ThreadCount = 0;
+
+	TransmittanceGrid::TransmittanceGrid(const std::vector<std::vector<std::vector<float>>>& densityData, float densityFactor, float voxelSize) :
+		m_DensitySize({
+			static_cast<uint32_t>(densityData.size()),
+			static_cast<uint32_t>(densityData[0].size()),
+			static_cast<uint32_t>(densityData[0][0].size()) }),
+		m_DensityFactor(densityFactor),
+		m_VoxelSize(voxelSize)
+	{
+		for (uint32_t i = 0; i < 3; i++) { m_Size[i] = (m_DensitySize[i] + c_CellSize - 1) / c_CellSize; }
+
+		// Flat copy for cache friendly lookups during the sweep
+		m_Density.resize(static_cast<size_t>(m_DensitySize[0]) * m_DensitySize[1] * m_DensitySize[2]);
+		for (uint32_t x = 0; x < m_DensitySize[0]; x++)
+		{
+			for (uint32_t y = 0; y < m_DensitySize[1]; y++)
+			{
+				for (uint32_t z = 0; z < m_DensitySize[2]; z++)
+				{
+					m_Density[x + m_DensitySize[0] * (y + static_cast<size_t>(m_DensitySize[1]) * z)] = densityData[x][y][z];
+				}
+			}
+		}
+	}
+
+	std::vector<std::vector<std::vector<float>>> TransmittanceGrid::Build(const glm::vec3& toLight) const
+	{
+		const glm::vec3 dir = glm::normalize(toLight);
+
+		// Sweep along the dominant axis. One step moves exactly one slice toward the light
+		uint32_t axis = 0;
+		for (uint32_t i = 1; i < 3; i++)
+		{
+			if (std::abs(dir[i]) > std::abs(dir[axis])) { axis = i; }
+		}
+		const uint32_t rowAxis = (axis + 1) % 3;
+		const uint32_t colAxis = (axis + 2) % 3;
+
+		const glm::vec3 cellStep = dir / std::abs(dir[axis]);
+		const float sampleLength = glm::length(cellStep) * m_VoxelSize;
+
+		uint32_t threadCount = s_ThreadCount == 0 ? std::thread::hardware_concurrency() : s_ThreadCount;
+		threadCount = std::max(1u, std::min(threadCount, m_Size[rowAxis]));
+
+		std::vector<float> transmittance(static_cast<size_t>(m_Size[0]) * m_Size[1] * m_Size[2]);
+		for (uint32_t step = 0; step < m_Size[axis]; step++)
+		{
+			const uint32_t slice = dir[axis] > 0.0f ? m_Size[axis] - 1 - step : step;
+
+			// Rows of the slice only read the previous slice, so they are pulled from a shared counter
+			std::atomic<uint32_t> nextRow = 0;
+			auto worker = [&]()
+			{
+				for (uint32_t row = nextRow++; row < m_Size[rowAxis]; row = nextRow++)
+				{
+					for (uint32_t col = 0; col < m_Size[colAxis]; col++)
+					{
+						std::array<uint32_t, 3> cell;
+						cell[axis] = slice;
+						cell[rowAxis] = row;
+						cell[colAxis] = col;
+						const glm::vec3 cellPos = glm::vec3(cell[0], cell[1], cell[2]) + glm::vec3(0.5f);
+
+						// Midpoint rule with one sample per voxel along the step
+						float opticalDepth = 0.0f;
+						for (uint32_t i = 0; i < c_CellSize; i++)
+						{
+							const float t = (static_cast<float>(i) + 0.5f) / static_cast<float>(c_CellSize);
+							opticalDepth += GetDensity((cellPos + (t * cellStep)) * static_cast<float>(c_CellSize));
+						}
+						opticalDepth *= m_DensityFactor * sampleLength;
+
+						transmittance[GetIndex(cell[0], cell[1], cell[2])] =
+							SampleSlice(transmittance, cellPos + cellStep, axis) * std::exp(-opticalDepth);
+					}
+				}
+			};
+
+			std::vector<std::thread> threads;
+			for (uint32_t i = 1; i < threadCount; i++) { threads.emplace_back(worker); }
+			worker();
+			for (std::thread& thread : threads) { thread.join(); }
+		}
+
+		std::vector<std::vector<std::vector<float>>> data(m_Size[0]);
+		for (uint32_t x = 0; x < m_Size[0]; x++)
+		{
+			data[x].resize(m_Size[1]);
+			for (uint32_t y = 0; y < m_Size[1]; y++)
+			{
+				data[x][y].resize(m_Size[2]);
+				for (uint32_t z = 0; z < m_Size[2]; z++)
+				{
+					data[x][y][z] = transmittance[GetIndex(x, y, z)];
+				}
+			}
+		}
+
+		return data;
+	}
+
+	std::vector<std::vector<std::vector<float>>> TransmittanceGrid::BuildRadial(const glm::vec3& lightPos, float maxRadius) const
+	{
+		// Light position in voxel space, the volume is centered at the origin
+		const glm::vec3 halfSize = 0.5f * glm::vec3(m_DensitySize[0], m_DensitySize[1], m_DensitySize[2]);
+		const glm::vec3 lightVoxelPos = (lightPos / m_VoxelSize) + halfSize;
+
+		// Four density samples per voxel of radius keep the midpoint rule error below the 8 bit step of the texture
+		const float shellLength = maxRadius / static_cast<float>(c_RadialSize - 1);
+		const uint32_t shellSampleCount = std::max(1u, static_cast<uint32_t>(std::ceil(4.0f * shellLength / m_VoxelSize)));
+		const float sampleLength = shellLength / static_cast<float>(shellSampleCount);
+
+		uint32_t threadCount = s_ThreadCount == 0 ? std::thread::hardware_concurrency() : s_ThreadCount;
+		threadCount = std::max(1u, std::min(threadCount, c_RadialSize));
+
+		std::vector<std::vector<std::vector<float>>> data(
+			c_RadialSize,
+			std::vector<std::vector<float>>(c_RadialSize, std::vector<float>(c_RadialSize, 1.0f)));
+
+		std::atomic<uint32_t> nextRow = 0;
+		auto worker = [&]()
+		{
+			for (uint32_t v = nextRow++; v < c_RadialSize; v = nextRow++)
+			{
+				for (uint32_t u = 0; u < c_RadialSize; u++)
+				{
+					const glm::vec3 dir = OctahedralToDir(
+						(static_cast<float>(u) + 0.5f) / static_cast<float>(c_RadialSize),
+						(static_cast<float>(v) + 0.5f) / static_cast<float>(c_RadialSize));
+					const glm::vec3 voxelStep = dir * (sampleLength / m_VoxelSize);
+
+					float opticalDepth = 0.0f;
+					uint32_t sampleIndex = 0;
+					for (uint32_t r = 1; r < c_RadialSize; r++)
+					{
+						for (uint32_t i = 0; i < shellSampleCount; i++)
+						{
+							opticalDepth += GetDensity(lightVoxelPos + ((static_cast<float>(sampleIndex) + 0.5f) * voxelStep));
+							sampleIndex++;
+						}
+						data[u][v][r] = std::exp(-opticalDepth * m_DensityFactor * sampleLength);
+					}
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (uint32_t i = 1; i < threadCount; i++) { threads.emplace_back(worker); }
+		worker();
+		for (std::thread& thread : threads) { thread.join(); }
+
+		return data;
+	}
+
+	float TransmittanceGrid::GetMaxRadius(const glm::vec3& lightPos) const
+	{
+		const glm::vec3 halfSize = 0.5f * m_VoxelSize * glm::vec3(m_DensitySize[0], m_DensitySize[1], m_DensitySize[2]);
+
+		float maxRadius = 0.0f;
+		for (uint32_t corner = 0; corner < 8; corner++)
+		{
+			const glm::vec3 cornerPos(
+				(corner & 1) ? halfSize[0] : -halfSize[0],
+				(corner & 2) ? halfSize[1] : -halfSize[1],
+				(corner & 4) ? halfSize[2] : -halfSize[2]);
+			maxRadius = std::max(maxRadius, glm::length(cornerPos - lightPos));
+		}
+
+		return maxRadius;
+	}
+
+	glm::vec3 TransmittanceGrid::OctahedralToDir(float u, float v)
+	{
+		// Inverse of DirToOctahedral in path_trace.glsl
+		const float x = (2.0f * u) - 1.0f;
+		const float y = (2.0f * v) - 1.0f;
+		const float z = 1.0f - std::abs(x) - std::abs(y);
+		const float t = std::max(-z, 0.0f);
+		return glm::normalize(glm::vec3(x >= 0.0f ? x - t : x + t, y >= 0.0f ? y - t : y + t, z));
+	}
+
+	void TransmittanceGrid::SetThreadCount(uint32_t threadCount)
+	{
+		s_ThreadCount = threadCount;
+	}
+
+	float TransmittanceGrid::GetDensity(const glm::vec3& voxelPos) const
+	{
+		// Nearest lookup like the density texture, zero outside the volume
+		std::array<uint32_t, 3> voxel;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			const float v = std::floor(voxelPos[i]);
+			if (v < 0.0f || v >= static_cast<float>(m_DensitySize[i])) { return 0.0f; }
+			voxel[i] = static_cast<uint32_t>(v);
+		}
+
+		return m_Density[voxel[0] + m_DensitySize[0] * (voxel[1] + static_cast<size_t>(m_DensitySize[1]) * voxel[2])];
+	}
+
+	float TransmittanceGrid::SampleSlice(const std::vector<float>& transmittance, const glm::vec3& cellPos, uint32_t axis) const
+	{
+		// Nothing attenuates between the volume bounds and the light
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			if (cellPos[i] < 0.0f || cellPos[i] > static_cast<float>(m_Size[i])) { return 1.0f; }
+		}
+
+		// Bilinear in the slice, cellPos lies exactly in a cell center plane along axis
+		std::array<uint32_t, 3> index0;
+		std::array<uint32_t, 3> index1;
+		std::array<float, 3> weight;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			const float maxIndex = static_cast<float>(m_Size[i] - 1);
+			if (i == axis)
+			{
+				index0[i] = static_cast<uint32_t>(std::min(std::floor(cellPos[i]), maxIndex));
+				index1[i] = index0[i];
+				weight[i] = 0.0f;
+				continue;
+			}
+
+			const float pos = std::clamp(cellPos[i] - 0.5f, 0.0f, maxIndex);
+			index0[i] = static_cast<uint32_t>(pos);
+			index1[i] = std::min(index0[i] + 1, m_Size[i] - 1);
+			weight[i] = pos - static_cast<float>(index0[i]);
+		}
+
+		float result = 0.0f;
+		for (uint32_t corner = 0; corner < 8; corner++)
+		{
+			float cornerWeight = 1.0f;
+			std::array<uint32_t, 3> index;
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				const bool upper = (corner >> i) & 1;
+				index[i] = upper ? index1[i] : index0[i];
+				cornerWeight *= upper ? weight[i] : 1.0f - weight[i];
+			}
+			if (cornerWeight == 0.0f) { continue; }
+			result += cornerWeight * transmittance[GetIndex(index[0], index[1], index[2])];
+		}
+
+		return result;
+	}
+
+	size_t TransmittanceGrid::GetIndex(uint32_t x, uint32_t y, uint32_t z) const
+	{
+		return x + m_Size[0] * (y + static_cast<size_t>(m_Size[1]) * z);
+	}
+}
@@ -0,0 +1,481 @@
+#include <engine/graphics/vulkan/Uploader.hpp>
+#include <engine/graphics/VulkanAPI.hpp>
+#include <cstring>
+#include <algorithm>
+
+namespace en::vk
+{
+	std::mutex Uploader::s_Mutex;
+
+	Buffer* Uploader::s_RingBuffer = nullptr;
+	uint8_t* Uploader::s_RingData = nullptr;
+	uint64_t Uploader::s_RingHead = 0;
+	uint64_t Uploader::s_RingTail = 0;
+
+	VkSemaphore Uploader::s_TimelineSemaphore = VK_NULL_HANDLE;
+	uint64_t Uploader::s_TimelineValue = 0;
+
+	VkCommandPool Uploader::s_TransferCommandPool = VK_NULL_HANDLE;
+	VkCommandPool Uploader::s_GraphicsCommandPool = VK_NULL_HANDLE;
+	std::vector<VkCommandBuffer> Uploader::s_FreeTransferCommandBuffers;
+	std::vector<VkCommandBuffer> Uploader::s_FreeGraphicsCommandBuffers;
+
+	Uploader::Batch Uploader::s_Batch;
+	bool Uploader::s_BatchOpen = false;
+	std::deque<Uploader::Batch> Uploader::s_InFlightBatches;
+
+	void Uploader::Init()
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		// Staging ring
+		s_RingBuffer = new Buffer(
+			c_RingSize,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			{});
+		void* ringData;
+		s_RingBuffer->MapMemory(0, &ringData);
+		s_RingData = static_cast<uint8_t*>(ringData);
+		s_RingHead = 0;
+		s_RingTail = 0;
+
+		// Timeline semaphore
+		VkSemaphoreTypeCreateInfo semaphoreTypeCI;
+		semaphoreTypeCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		semaphoreTypeCI.pNext = nullptr;
+		semaphoreTypeCI.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		semaphoreTypeCI.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreCI;
+		semaphoreCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreCI.pNext = &semaphoreTypeCI;
+		semaphoreCI.flags = 0;
+
+		VkResult result = vkCreateSemaphore(device, &semaphoreCI, nullptr, &s_TimelineSemaphore);
+		ASSERT_VULKAN(result);
+		s_TimelineValue = 0;
+
+		// Command pools
+		VkCommandPoolCreateInfo commandPoolCI;
+		commandPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		commandPoolCI.pNext = nullptr;
+		commandPoolCI.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		commandPoolCI.queueFamilyIndex = VulkanAPI::GetTransferQFI();
+
+		result = vkCreateCommandPool(device, &commandPoolCI, nullptr, &s_TransferCommandPool);
+		ASSERT_VULKAN(result);
+
+		if (IsSeparateTransferQueue())
+		{
+			commandPoolCI.queueFamilyIndex = VulkanAPI::GetGraphicsQFI();
+			result = vkCreateCommandPool(device, &commandPoolCI, nullptr, &s_GraphicsCommandPool);
+			ASSERT_VULKAN(result);
+		}
+
+		s_BatchOpen = false;
+	}
+
+	void Uploader::Shutdown()
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		Wait(Flush());
+		Reclaim(false);
+
+		vkDestroyCommandPool(device, s_TransferCommandPool, nullptr);
+		if (s_GraphicsCommandPool != VK_NULL_HANDLE) { vkDestroyCommandPool(device, s_GraphicsCommandPool, nullptr); }
+		s_TransferCommandPool = VK_NULL_HANDLE;
+		s_GraphicsCommandPool = VK_NULL_HANDLE;
+		s_FreeTransferCommandBuffers.clear();
+		s_FreeGraphicsCommandBuffers.clear();
+
+		vkDestroySemaphore(device, s_TimelineSemaphore, nullptr);
+
+		s_RingBuffer->UnmapMemory();
+		s_RingBuffer->Destroy();
+		delete s_RingBuffer;
+		s_RingBuffer = nullptr;
+	}
+
+	void Uploader::UploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size)
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+
+		// Uploads larger than half the ring are split so the ring never has to be drained completely
+		const VkDeviceSize maxChunkSize = c_RingSize / 2;
+		for (VkDeviceSize chunkOffset = 0; chunkOffset < size; chunkOffset += maxChunkSize)
+		{
+			const VkDeviceSize chunkSize = std::min(maxChunkSize, size - chunkOffset);
+			const VkDeviceSize ringOffset = Reserve(chunkSize);
+			std::memcpy(s_RingData + ringOffset, static_cast<const uint8_t*>(data) + chunkOffset, static_cast<size_t>(chunkSize));
+
+			VkBufferCopy bufferCopy;
+			bufferCopy.srcOffset = ringOffset;
+			bufferCopy.dstOffset = offset + chunkOffset;
+			bufferCopy.size = chunkSize;
+
+			vkCmdCopyBuffer(s_Batch.transferCommandBuffer, s_RingBuffer->GetVulkanHandle(), buffer, 1, &bufferCopy);
+		}
+
+		// Release on the transfer queue and acquire on the graphics queue, or a plain barrier if both are the same family
+		VkBufferMemoryBarrier barrier;
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.pNext = nullptr;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = buffer;
+		barrier.offset = offset;
+		barrier.size = size;
+
+		if (IsSeparateTransferQueue())
+		{
+			barrier.srcQueueFamilyIndex = VulkanAPI::GetTransferQFI();
+			barrier.dstQueueFamilyIndex = VulkanAPI::GetGraphicsQFI();
+
+			barrier.dstAccessMask = VK_ACCESS_NONE;
+			vkCmdPipelineBarrier(
+				s_Batch.transferCommandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+				0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+			barrier.srcAccessMask = VK_ACCESS_NONE;
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+			vkCmdPipelineBarrier(
+				s_Batch.graphicsCommandBuffer,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+				0, 0, nullptr, 1, &barrier, 0, nullptr);
+		}
+		else
+		{
+			vkCmdPipelineBarrier(
+				s_Batch.transferCommandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+				0, 0, nullptr, 1, &barrier, 0, nullptr);
+		}
+	}
+
+	void Uploader::UploadImage(
+		VkImage image,
+		VkExtent3D extent,
+		const void* data,
+		VkDeviceSize size,
+		VkImageLayout oldLayout,
+		VkImageLayout finalLayout)
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+
+		VkImageMemoryBarrier barrier;
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.pNext = nullptr;
+		barrier.srcAccessMask = VK_ACCESS_NONE;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		// Split along the slowest axis into slices that fit into half the ring
+		const VkDeviceSize texelCount = static_cast<VkDeviceSize>(extent.width) * extent.height * extent.depth;
+		const VkDeviceSize texelSize = size / texelCount;
+		uint32_t sliceCount;
+		VkDeviceSize sliceSize;
+		if (extent.depth > 1) { sliceCount = extent.depth; sliceSize = texelSize * extent.width * extent.height; }
+		else if (extent.height > 1) { sliceCount = extent.height; sliceSize = texelSize * extent.width; }
+		else { sliceCount = extent.width; sliceSize = texelSize; }
+
+		const uint32_t maxSlicesPerChunk = static_cast<uint32_t>((c_RingSize / 2) / sliceSize);
+		if (maxSlicesPerChunk == 0) { Log::Error("Uploader image slice does not fit into the staging ring", true); }
+
+		bool firstChunk = true;
+		for (uint32_t slice = 0; slice < sliceCount; slice += maxSlicesPerChunk)
+		{
+			const uint32_t chunkSliceCount = std::min(maxSlicesPerChunk, sliceCount - slice);
+			const VkDeviceSize chunkSize = chunkSliceCount * sliceSize;
+			const VkDeviceSize ringOffset = Reserve(chunkSize);
+			std::memcpy(s_RingData + ringOffset, static_cast<const uint8_t*>(data) + slice * sliceSize, static_cast<size_t>(chunkSize));
+
+			// The layout transition is recorded into the batch that holds the first chunk
+			if (firstChunk)
+			{
+				vkCmdPipelineBarrier(
+					s_Batch.transferCommandBuffer,
+					VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					0, 0, nullptr, 0, nullptr, 1, &barrier);
+				firstChunk = false;
+			}
+
+			VkBufferImageCopy bufferImageCopy;
+			bufferImageCopy.bufferOffset = ringOffset;
+			bufferImageCopy.bufferRowLength = 0;
+			bufferImageCopy.bufferImageHeight = 0;
+			bufferImageCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			bufferImageCopy.imageSubresource.mipLevel = 0;
+			bufferImageCopy.imageSubresource.baseArrayLayer = 0;
+			bufferImageCopy.imageSubresource.layerCount = 1;
+			if (extent.depth > 1)
+			{
+				bufferImageCopy.imageOffset = { 0, 0, static_cast<int32_t>(slice) };
+				bufferImageCopy.imageExtent = { extent.width, extent.height, chunkSliceCount };
+			}
+			else if (extent.height > 1)
+			{
+				bufferImageCopy.imageOffset = { 0, static_cast<int32_t>(slice), 0 };
+				bufferImageCopy.imageExtent = { extent.width, chunkSliceCount, 1 };
+			}
+			else
+			{
+				bufferImageCopy.imageOffset = { static_cast<int32_t>(slice), 0, 0 };
+				bufferImageCopy.imageExtent = { chunkSliceCount, 1, 1 };
+			}
+
+			vkCmdCopyBufferToImage(
+				s_Batch.transferCommandBuffer,
+				s_RingBuffer->GetVulkanHandle(),
+				image,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1,
+				&bufferImageCopy);
+		}
+
+		// Transition to the final layout as part of the queue family ownership transfer
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = finalLayout;
+
+		if (IsSeparateTransferQueue())
+		{
+			barrier.srcQueueFamilyIndex = VulkanAPI::GetTransferQFI();
+			barrier.dstQueueFamilyIndex = VulkanAPI::GetGraphicsQFI();
+
+			barrier.dstAccessMask = VK_ACCESS_NONE;
+			vkCmdPipelineBarrier(
+				s_Batch.transferCommandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+				0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			barrier.srcAccessMask = VK_ACCESS_NONE;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(
+				s_Batch.graphicsCommandBuffer,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+				0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+		else
+		{
+			vkCmdPipelineBarrier(
+				s_Batch.transferCommandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+				0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+	}
+
+	uint64_t Uploader::Flush()
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		return s_BatchOpen ? SubmitBatch() : s_TimelineValue;
+	}
+
+	void Uploader::Wait(uint64_t value)
+	{
+		VkSemaphoreWaitInfo waitInfo;
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.pNext = nullptr;
+		waitInfo.flags = 0;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &s_TimelineSemaphore;
+		waitInfo.pValues = &value;
+
+		VkResult result = vkWaitSemaphores(VulkanAPI::GetDevice(), &waitInfo, UINT64_MAX);
+		ASSERT_VULKAN(result);
+	}
+
+	bool Uploader::IsComplete(uint64_t value)
+	{
+		uint64_t currentValue;
+		VkResult result = vkGetSemaphoreCounterValue(VulkanAPI::GetDevice(), s_TimelineSemaphore, &currentValue);
+		ASSERT_VULKAN(result);
+		return currentValue >= value;
+	}
+
+	bool Uploader::IsSeparateTransferQueue()
+	{
+		return VulkanAPI::GetTransferQFI() != VulkanAPI::GetGraphicsQFI();
+	}
+
+	void Uploader::BeginBatch()
+	{
+		Reclaim(false);
+
+		VkCommandBufferBeginInfo beginInfo;
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.pNext = nullptr;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = nullptr;
+
+		s_Batch.transferCommandBuffer = GetCommandBuffer(s_TransferCommandPool, s_FreeTransferCommandBuffers);
+		VkResult result = vkBeginCommandBuffer(s_Batch.transferCommandBuffer, &beginInfo);
+		ASSERT_VULKAN(result);
+
+		s_Batch.graphicsCommandBuffer = VK_NULL_HANDLE;
+		if (IsSeparateTransferQueue())
+		{
+			s_Batch.graphicsCommandBuffer = GetCommandBuffer(s_GraphicsCommandPool, s_FreeGraphicsCommandBuffers);
+			result = vkBeginCommandBuffer(s_Batch.graphicsCommandBuffer, &beginInfo);
+			ASSERT_VULKAN(result);
+		}
+
+		s_BatchOpen = true;
+	}
+
+	uint64_t Uploader::SubmitBatch()
+	{
+		VkResult result = vkEndCommandBuffer(s_Batch.transferCommandBuffer);
+		ASSERT_VULKAN(result);
+
+		// The transfer submission signals the first value, the graphics acquire waits for it and signals the second
+		const uint64_t transferValue = ++s_TimelineValue;
+
+		VkTimelineSemaphoreSubmitInfo transferTimelineInfo;
+		transferTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		transferTimelineInfo.pNext = nullptr;
+		transferTimelineInfo.waitSemaphoreValueCount = 0;
+		transferTimelineInfo.pWaitSemaphoreValues = nullptr;
+		transferTimelineInfo.signalSemaphoreValueCount = 1;
+		transferTimelineInfo.pSignalSemaphoreValues = &transferValue;
+
+		VkSubmitInfo submitInfo;
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &transferTimelineInfo;
+		submitInfo.waitSemaphoreCount = 0;
+		submitInfo.pWaitSemaphores = nullptr;
+		submitInfo.pWaitDstStageMask = nullptr;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &s_Batch.transferCommandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &s_TimelineSemaphore;
+
+		result = vkQueueSubmit(VulkanAPI::GetTransferQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+		ASSERT_VULKAN(result);
+
+		if (IsSeparateTransferQueue())
+		{
+			result = vkEndCommandBuffer(s_Batch.graphicsCommandBuffer);
+			ASSERT_VULKAN(result);
+
+			const uint64_t graphicsValue = ++s_TimelineValue;
+			const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+			VkTimelineSemaphoreSubmitInfo graphicsTimelineInfo;
+			graphicsTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+			graphicsTimelineInfo.pNext = nullptr;
+			graphicsTimelineInfo.waitSemaphoreValueCount = 1;
+			graphicsTimelineInfo.pWaitSemaphoreValues = &transferValue;
+			graphicsTimelineInfo.signalSemaphoreValueCount = 1;
+			graphicsTimelineInfo.pSignalSemaphoreValues = &graphicsValue;
+
+			submitInfo.pNext = &graphicsTimelineInfo;
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &s_TimelineSemaphore;
+			submitInfo.pWaitDstStageMask = &waitStage;
+			submitInfo.pCommandBuffers = &s_Batch.graphicsCommandBuffer;
+
+			result = vkQueueSubmit(VulkanAPI::GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+			ASSERT_VULKAN(result);
+		}
+
+		s_Batch.ringEnd = s_RingHead;
+		s_Batch.value = s_TimelineValue;
+		s_InFlightBatches.push_back(s_Batch);
+		s_BatchOpen = false;
+
+		return s_TimelineValue;
+	}
+
+	void Uploader::Reclaim(bool wait)
+	{
+		while (!s_InFlightBatches.empty())
+		{
+			const Batch& batch = s_InFlightBatches.front();
+			if (wait) { Wait(batch.value); }
+			else if (!IsComplete(batch.value)) { break; }
+
+			s_RingTail = batch.ringEnd;
+			s_FreeTransferCommandBuffers.push_back(batch.transferCommandBuffer);
+			if (batch.graphicsCommandBuffer != VK_NULL_HANDLE)
+			{
+				s_FreeGraphicsCommandBuffers.push_back(batch.graphicsCommandBuffer);
+			}
+			s_InFlightBatches.pop_front();
+
+			// Waiting for the oldest batch is enough to make room
+			wait = false;
+		}
+	}
+
+	VkDeviceSize Uploader::Reserve(VkDeviceSize size)
+	{
+		// Allocations never wrap, the rest of the ring is skipped instead
+		uint64_t start = (s_RingHead + c_RingAlignment - 1) / c_RingAlignment * c_RingAlignment;
+		if (start % c_RingSize + size > c_RingSize) { start = (start / c_RingSize + 1) * c_RingSize; }
+
+		if (start + size - s_RingTail > c_RingSize)
+		{
+			// The open batch may hold the space that is needed, so it is submitted before waiting
+			if (s_BatchOpen) { SubmitBatch(); }
+			while (start + size - s_RingTail > c_RingSize && !s_InFlightBatches.empty()) { Reclaim(true); }
+
+			// An idle ring restarts at the beginning
+			if (s_InFlightBatches.empty())
+			{
+				s_RingHead = 0;
+				s_RingTail = 0;
+				start = 0;
+			}
+		}
+
+		if (!s_BatchOpen) { BeginBatch(); }
+
+		s_RingHead = start + size;
+		return start % c_RingSize;
+	}
+
+	VkCommandBuffer Uploader::GetCommandBuffer(VkCommandPool commandPool, std::vector<VkCommandBuffer>& freeCommandBuffers)
+	{
+		if (!freeCommandBuffers.empty())
+		{
+			VkCommandBuffer commandBuffer = freeCommandBuffers.back();
+			freeCommandBuffers.pop_back();
+			return commandBuffer;
+		}
+
+		VkCommandBufferAllocateInfo allocateInfo;
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.pNext = nullptr;
+		allocateInfo.commandPool = commandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		VkResult result = vkAllocateCommandBuffers(VulkanAPI::GetDevice(), &allocateInfo, &commandBuffer);
+		ASSERT_VULKAN(result);
+
+		return commandBuffer;
+	}
+}
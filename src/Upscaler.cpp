@@ -0,0 +1,360 @@
+#include <engine/graphics/renderer/Upscaler.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
+#include <engine/graphics/vulkan/CommandRecorder.hpp>
+#include <engine/graphics/vulkan/ShaderCompiler.hpp>
+#include <engine/graphics/VulkanAPI.hpp>
+#include <engine/util/Log.hpp>
+#include <array>
+
+namespace en
+{
+	VkDescriptorSetLayout Upscaler::s_DescSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool Upscaler::s_DescPool = VK_NULL_HANDLE;
+
+	// input, output
+	static const uint32_t c_StorageImageCount = 2;
+
+	void Upscaler::Init(VkDevice device)
+	{
+		vk::ShaderCompiler::Precompile({ "upscale/upscale.comp" });
+
+		// Create desc set layout
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		for (uint32_t i = 0; i < c_StorageImageCount; i++)
+		{
+			VkDescriptorSetLayoutBinding storageImageBinding;
+			storageImageBinding.binding = i;
+			storageImageBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			storageImageBinding.descriptorCount = 1;
+			storageImageBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			storageImageBinding.pImmutableSamplers = nullptr;
+			bindings.push_back(storageImageBinding);
+		}
+
+		VkDescriptorSetLayoutCreateInfo layoutCI;
+		layoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutCI.pNext = nullptr;
+		layoutCI.flags = 0;
+		layoutCI.bindingCount = bindings.size();
+		layoutCI.pBindings = bindings.data();
+
+		VkResult result = vkCreateDescriptorSetLayout(device, &layoutCI, nullptr, &s_DescSetLayout);
+		ASSERT_VULKAN(result);
+
+		// Create desc pool
+		const uint32_t maxSets = 4;
+
+		VkDescriptorPoolSize storageImagePS;
+		storageImagePS.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		storageImagePS.descriptorCount = maxSets * c_StorageImageCount;
+
+		VkDescriptorPoolCreateInfo poolCI;
+		poolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolCI.pNext = nullptr;
+		poolCI.flags = 0;
+		poolCI.maxSets = maxSets;
+		poolCI.poolSizeCount = 1;
+		poolCI.pPoolSizes = &storageImagePS;
+
+		result = vkCreateDescriptorPool(device, &poolCI, nullptr, &s_DescPool);
+		ASSERT_VULKAN(result);
+	}
+
+	void Upscaler::Shutdown(VkDevice device)
+	{
+		vkDestroyDescriptorPool(device, s_DescPool, nullptr);
+		vkDestroyDescriptorSetLayout(device, s_DescSetLayout, nullptr);
+	}
+
+	Upscaler::Upscaler(uint32_t width, uint32_t height) :
+		m_Sizes({ width, height, width, height }),
+		m_Shader("upscale/upscale.comp", false),
+		m_CommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, VulkanAPI::GetGraphicsQFI())
+	{
+		Log::Info("Create Upscaler");
+
+		// Init components
+		VkDevice device = VulkanAPI::GetDevice();
+
+		m_CommandPool.AllocateBuffers(2, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		m_CommandBuffer = m_CommandPool.GetBuffer(0);
+		m_RandomTasksCmdBuf = m_CommandPool.GetBuffer(1);
+
+		CreatePipelineLayout(device);
+		CreatePipeline(device);
+		CreateOutputImage(device);
+
+		// The command buffer is recorded once an input is set
+		AllocateDescriptorSet(device);
+	}
+
+	void Upscaler::Upscale(VkQueue queue)
+	{
+		if (m_InputImageView == VK_NULL_HANDLE) { Log::Error("Upscaler has no input", true); }
+
+		VkSubmitInfo submitInfo;
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = nullptr;
+		submitInfo.waitSemaphoreCount = 0;
+		submitInfo.pWaitSemaphores = nullptr;
+		submitInfo.pWaitDstStageMask = nullptr;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &m_CommandBuffer;
+		submitInfo.signalSemaphoreCount = 0;
+		submitInfo.pSignalSemaphores = nullptr;
+
+		vk::FramePacer::Submit(queue, submitInfo, VK_NULL_HANDLE);
+	}
+
+	void Upscaler::Destroy()
+	{
+		VkDevice device = VulkanAPI::GetDevice();
+
+		m_CommandPool.Destroy();
+
+		vkDestroyImageView(device, m_OutputImageView, nullptr);
+		vk::MemoryAllocator::Free(m_OutputImageMemory);
+		vkDestroyImage(device, m_OutputImage, nullptr);
+
+		vkDestroyPipeline(device, m_Pipeline, nullptr);
+		m_Shader.Destroy();
+
+		vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
+	}
+
+	VkImage Upscaler::GetImage() const
+	{
+		return m_OutputImage;
+	}
+
+	VkImageView Upscaler::GetImageView() const
+	{
+		return m_OutputImageView;
+	}
+
+	void Upscaler::SetInput(VkImageView imageView, uint32_t width, uint32_t height)
+	{
+		// The descriptor set and command buffer must not be in use by a frame in flight
+		vk::FramePacer::WaitIdle();
+
+		m_InputImageView = imageView;
+		m_Sizes.inputWidth = width;
+		m_Sizes.inputHeight = height;
+
+		UpdateDescriptorSet(VulkanAPI::GetDevice());
+		RecordCommandBuffer();
+	}
+
+	void Upscaler::CreatePipelineLayout(VkDevice device)
+	{
+		VkPushConstantRange sizesRange;
+		sizesRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		sizesRange.offset = 0;
+		sizesRange.size = sizeof(PushConstants);
+
+		VkPipelineLayoutCreateInfo layoutCreateInfo;
+		layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutCreateInfo.pNext = nullptr;
+		layoutCreateInfo.flags = 0;
+		layoutCreateInfo.setLayoutCount = 1;
+		layoutCreateInfo.pSetLayouts = &s_DescSetLayout;
+		layoutCreateInfo.pushConstantRangeCount = 1;
+		layoutCreateInfo.pPushConstantRanges = &sizesRange;
+
+		VkResult result = vkCreatePipelineLayout(device, &layoutCreateInfo, nullptr, &m_PipelineLayout);
+		ASSERT_VULKAN(result);
+	}
+
+	void Upscaler::CreatePipeline(VkDevice device)
+	{
+		VkPipelineShaderStageCreateInfo shaderStage;
+		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStage.pNext = nullptr;
+		shaderStage.flags = 0;
+		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		shaderStage.module = m_Shader.GetVulkanModule();
+		shaderStage.pName = "main";
+		shaderStage.pSpecializationInfo = nullptr;
+
+		VkComputePipelineCreateInfo pipelineCI;
+		pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineCI.pNext = nullptr;
+		pipelineCI.flags = 0;
+		pipelineCI.stage = shaderStage;
+		pipelineCI.layout = m_PipelineLayout;
+		pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineCI.basePipelineIndex = 0;
+
+		VkResult result = VulkanAPI::CreateComputePipeline(pipelineCI, &m_Pipeline);
+		ASSERT_VULKAN(result);
+	}
+
+	void Upscaler::CreateOutputImage(VkDevice device)
+	{
+		VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT;
+
+		// Create Image
+		VkImageCreateInfo imageCI;
+		imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageCI.pNext = nullptr;
+		imageCI.flags = 0;
+		imageCI.imageType = VK_IMAGE_TYPE_2D;
+		imageCI.format = format;
+		imageCI.extent = { m_Sizes.outputWidth, m_Sizes.outputHeight, 1 };
+		imageCI.mipLevels = 1;
+		imageCI.arrayLayers = 1;
+		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageCI.queueFamilyIndexCount = 0;
+		imageCI.pQueueFamilyIndices = nullptr;
+		imageCI.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+
+		VkResult result = vkCreateImage(device, &imageCI, nullptr, &m_OutputImage);
+		ASSERT_VULKAN(result);
+
+		// Image Memory
+		m_OutputImageMemory = vk::MemoryAllocator::AllocateImage(m_OutputImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		// Create image view
+		VkImageViewCreateInfo imageViewCI;
+		imageViewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		imageViewCI.pNext = nullptr;
+		imageViewCI.flags = 0;
+		imageViewCI.image = m_OutputImage;
+		imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		imageViewCI.format = format;
+		imageViewCI.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageViewCI.subresourceRange.baseMipLevel = 0;
+		imageViewCI.subresourceRange.levelCount = 1;
+		imageViewCI.subresourceRange.baseArrayLayer = 0;
+		imageViewCI.subresourceRange.layerCount = 1;
+
+		result = vkCreateImageView(device, &imageViewCI, nullptr, &m_OutputImageView);
+		ASSERT_VULKAN(result);
+
+		// Change image layout
+		VkCommandBufferBeginInfo beginInfo;
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.pNext = nullptr;
+		beginInfo.flags = 0;
+		beginInfo.pInheritanceInfo = nullptr;
+
+		result = vkBeginCommandBuffer(m_RandomTasksCmdBuf, &beginInfo);
+		ASSERT_VULKAN(result);
+
+		vk::CommandRecorder::ImageLayoutTransfer(
+			m_RandomTasksCmdBuf,
+			m_OutputImage,
+			VK_IMAGE_LAYOUT_PREINITIALIZED,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_ACCESS_NONE,
+			VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+		result = vkEndCommandBuffer(m_RandomTasksCmdBuf);
+		ASSERT_VULKAN(result);
+
+		VkSubmitInfo submitInfo;
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = nullptr;
+		submitInfo.waitSemaphoreCount = 0;
+		submitInfo.pWaitSemaphores = nullptr;
+		submitInfo.pWaitDstStageMask = nullptr;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &m_RandomTasksCmdBuf;
+		submitInfo.signalSemaphoreCount = 0;
+		submitInfo.pSignalSemaphores = nullptr;
+
+		VkQueue queue = VulkanAPI::GetGraphicsQueue();
+		result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		ASSERT_VULKAN(result);
+		result = vkQueueWaitIdle(queue);
+		ASSERT_VULKAN(result);
+	}
+
+	void Upscaler::AllocateDescriptorSet(VkDevice device)
+	{
+		VkDescriptorSetAllocateInfo descSetAI;
+		descSetAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descSetAI.pNext = nullptr;
+		descSetAI.descriptorPool = s_DescPool;
+		descSetAI.descriptorSetCount = 1;
+		descSetAI.pSetLayouts = &s_DescSetLayout;
+
+		VkResult result = vkAllocateDescriptorSets(device, &descSetAI, &m_DescSet);
+		ASSERT_VULKAN(result);
+	}
+
+	void Upscaler::UpdateDescriptorSet(VkDevice device)
+	{
+		// Storage image writes in binding order
+		const std::array<VkImageView, c_StorageImageCount> storageImageViews = { m_InputImageView, m_OutputImageView };
+
+		std::array<VkDescriptorImageInfo, c_StorageImageCount> storageImageInfos;
+		std::array<VkWriteDescriptorSet, c_StorageImageCount> writes;
+		for (uint32_t i = 0; i < c_StorageImageCount; i++)
+		{
+			storageImageInfos[i].sampler = VK_NULL_HANDLE;
+			storageImageInfos[i].imageView = storageImageViews[i];
+			storageImageInfos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].pNext = nullptr;
+			writes[i].dstSet = m_DescSet;
+			writes[i].dstBinding = i;
+			writes[i].dstArrayElement = 0;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			writes[i].pImageInfo = &storageImageInfos[i];
+			writes[i].pBufferInfo = nullptr;
+			writes[i].pTexelBufferView = nullptr;
+		}
+
+		vkUpdateDescriptorSets(device, writes.size(), writes.data(), 0, nullptr);
+	}
+
+	void Upscaler::RecordCommandBuffer()
+	{
+		// Begin command buffer
+		VkCommandBufferBeginInfo beginInfo;
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.pNext = nullptr;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		beginInfo.pInheritanceInfo = nullptr;
+
+		VkResult result = vkBeginCommandBuffer(m_CommandBuffer, &beginInfo);
+		ASSERT_VULKAN(result);
+
+		// Renderer output must be written before it is read
+		VkMemoryBarrier inputBarrier;
+		inputBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		inputBarrier.pNext = nullptr;
+		inputBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		inputBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(
+			m_CommandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1, &inputBarrier,
+			0, nullptr,
+			0, nullptr);
+
+		// Upscale
+		vkCmdBindDescriptorSets(m_CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &m_DescSet, 0, nullptr);
+		vkCmdPushConstants(m_CommandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &m_Sizes);
+		vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+		vkCmdDispatch(m_CommandBuffer, (m_Sizes.outputWidth + 7) / 8, (m_Sizes.outputHeight + 7) / 8, 1);
+
+		// End command buffer
+		result = vkEndCommandBuffer(m_CommandBuffer);
+		ASSERT_VULKAN(result);
+	}
+}
@@ -1,6 +1,12 @@
 #include <engine/objects/VolumeData.hpp>
 #include <engine/graphics/VulkanAPI.hpp>
+#include <engine/graphics/vulkan/Uploader.hpp>
+#include <engine/util/Log.hpp>
+#include <engine/util/DensityGrid.hpp>
 #include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
 #include <imgui.h>
 
 namespace en
@@ -18,7 +24,21 @@ namespace en
 		densityTexBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 		densityTexBinding.pImmutableSamplers = nullptr;;
 
-		std::vector<VkDescriptorSetLayoutBinding> bindings = { densityTexBinding };
+		VkDescriptorSetLayoutBinding densityGridBinding;
+		densityGridBinding.binding = 1;
+		densityGridBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		densityGridBinding.descriptorCount = 1;
+		densityGridBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+		densityGridBinding.pImmutableSamplers = nullptr;
+
+		VkDescriptorSetLayoutBinding occupancyBinding;
+		occupancyBinding.binding = 2;
+		occupancyBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		occupancyBinding.descriptorCount = 1;
+		occupancyBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+		occupancyBinding.pImmutableSamplers = nullptr;
+
+		std::vector<VkDescriptorSetLayoutBinding> bindings = { densityTexBinding, densityGridBinding, occupancyBinding };
 
 		VkDescriptorSetLayoutCreateInfo layoutCI;
 		layoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -33,9 +53,13 @@ namespace en
 		// Create descriptor pool
 		VkDescriptorPoolSize densityTexPoolSize;
 		densityTexPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		densityTexPoolSize.descriptorCount = 1;
+		densityTexPoolSize.descriptorCount = 4;
 
-		std::vector<VkDescriptorPoolSize> poolSizes = { densityTexPoolSize };
+		VkDescriptorPoolSize occupancyPoolSize;
+		occupancyPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		occupancyPoolSize.descriptorCount = 2;
+
+		std::vector<VkDescriptorPoolSize> poolSizes = { densityTexPoolSize, occupancyPoolSize };
 
 		VkDescriptorPoolCreateInfo poolCI;
 		poolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -60,11 +84,24 @@ namespace en
 		return m_DescriptorSetLayout;
 	}
 
-	VolumeData::VolumeData(const vk::Texture3D* densityTex, float densityFactor, float g) :
+	VolumeData::VolumeData(
+		const vk::Texture3D* densityTex,
+		const std::vector<std::vector<std::vector<float>>>& densityData,
+		float densityFactor,
+		float g,
+		bool residualRatioTracking,
+		bool emptySpaceSkipping)
+		:
 		m_DensityFactor(densityFactor),
 		m_G(g),
-		m_DensityTex(densityTex)
+		m_ResidualRatioTracking(residualRatioTracking),
+		m_EmptySpaceSkipping(emptySpaceSkipping),
+		m_DensityTex(densityTex),
+		m_DensityGridTex(CreateDensityGrid(densityData)),
+		m_OccupancyGrid(densityData)
 	{
+		CreateOccupancyBuffer();
+
 		// Create and update descriptor set
 		VkDescriptorSetAllocateInfo descSetAI;
 		descSetAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -81,6 +118,11 @@ namespace en
 
 	void VolumeData::Destroy()
 	{
+		m_DensityGridTex->Destroy();
+		delete m_DensityGridTex;
+
+		m_OccupancyBuffer->Destroy();
+		delete m_OccupancyBuffer;
 	}
 
 	void VolumeData::RenderImGui()
@@ -88,6 +130,9 @@ namespace en
 		ImGui::Begin("HPM Volume");
 		ImGui::Text("Density Factor %f", m_DensityFactor);
 		ImGui::Text("G %f", m_G);
+		ImGui::Text("Residual ratio tracking %d", m_ResidualRatioTracking);
+		ImGui::Text("Empty space skipping %d", m_EmptySpaceSkipping);
+		ImGui::Text("Occupied bricks %f (coarse %f)", m_OccupancyGrid.GetOccupiedFraction(0), m_OccupancyGrid.GetOccupiedFraction(1));
 		ImGui::End();
 	}
 
@@ -101,6 +146,16 @@ namespace en
 		return m_G;
 	}
 
+	bool VolumeData::UsesResidualRatioTracking() const
+	{
+		return m_ResidualRatioTracking;
+	}
+
+	bool VolumeData::UsesEmptySpaceSkipping() const
+	{
+		return m_EmptySpaceSkipping;
+	}
+
 	VkDescriptorSet VolumeData::GetDescriptorSet() const
 	{
 		return m_DescriptorSet;
@@ -115,6 +170,63 @@ namespace en
 		};
 	}
 
+	vk::Texture3D* VolumeData::CreateDensityGrid(const std::vector<std::vector<std::vector<float>>>& densityData)
+	{
+		const DensityGrid densityGrid(densityData);
+		const glm::ivec3& cellCount = densityGrid.GetCellCount();
+
+		std::array<std::vector<std::vector<std::vector<float>>>, 4> grid;
+		for (std::vector<std::vector<std::vector<float>>>& channel : grid)
+		{
+			channel.resize(cellCount.x);
+			for (std::vector<std::vector<float>>& vvf : channel)
+			{
+				vvf.resize(cellCount.y);
+				for (std::vector<float>& vf : vvf) { vf.resize(cellCount.z, 0.0f); }
+			}
+		}
+
+		// r = control density, g = residual majorant
+		for (int cx = 0; cx < cellCount.x; cx++)
+		{
+			for (int cy = 0; cy < cellCount.y; cy++)
+			{
+				for (int cz = 0; cz < cellCount.z; cz++)
+				{
+					const glm::ivec3 cell(cx, cy, cz);
+
+					// + 0.5 because Texture3D truncates to 8 bit
+					grid[0][cx][cy][cz] = (static_cast<float>(densityGrid.GetControl(cell)) + 0.5f) / 255.0f;
+					grid[1][cx][cy][cz] = (static_cast<float>(densityGrid.GetResidualMajorant(cell)) + 0.5f) / 255.0f;
+				}
+			}
+		}
+
+		Log::Info("Density grid {}x{}x{}", cellCount.x, cellCount.y, cellCount.z);
+
+		return new vk::Texture3D(grid, VK_FILTER_NEAREST, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_BORDER_COLOR_INT_OPAQUE_BLACK);
+	}
+
+	void VolumeData::CreateOccupancyBuffer()
+	{
+		const std::vector<uint32_t>& bits = m_OccupancyGrid.GetBits();
+		const VkDeviceSize size = sizeof(uint32_t) * bits.size();
+
+		m_OccupancyBuffer = new vk::Buffer(
+			size,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			{});
+
+		vk::Uploader::UploadBuffer(m_OccupancyBuffer->GetVulkanHandle(), 0, bits.data(), size);
+		vk::Uploader::Flush();
+
+		Log::Info(
+			"Occupancy grid with {} fine and {} coarse bricks occupied",
+			m_OccupancyGrid.GetOccupiedFraction(0),
+			m_OccupancyGrid.GetOccupiedFraction(1));
+	}
+
 	void VolumeData::UpdateDescriptorSet()
 	{
 		// Density tex
@@ -135,8 +247,44 @@ namespace en
 		densityTexWrite.pBufferInfo = nullptr;
 		densityTexWrite.pTexelBufferView = nullptr;
 
+		// Density grid
+		VkDescriptorImageInfo densityGridImageInfo;
+		densityGridImageInfo.sampler = m_DensityGridTex->GetSampler();
+		densityGridImageInfo.imageView = m_DensityGridTex->GetImageView();
+		densityGridImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkWriteDescriptorSet densityGridWrite;
+		densityGridWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		densityGridWrite.pNext = nullptr;
+		densityGridWrite.dstSet = m_DescriptorSet;
+		densityGridWrite.dstBinding = 1;
+		densityGridWrite.dstArrayElement = 0;
+		densityGridWrite.descriptorCount = 1;
+		densityGridWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		densityGridWrite.pImageInfo = &densityGridImageInfo;
+		densityGridWrite.pBufferInfo = nullptr;
+		densityGridWrite.pTexelBufferView = nullptr;
+
+		// Occupancy
+		VkDescriptorBufferInfo occupancyBufferInfo;
+		occupancyBufferInfo.buffer = m_OccupancyBuffer->GetVulkanHandle();
+		occupancyBufferInfo.offset = 0;
+		occupancyBufferInfo.range = VK_WHOLE_SIZE;
+
+		VkWriteDescriptorSet occupancyWrite;
+		occupancyWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		occupancyWrite.pNext = nullptr;
+		occupancyWrite.dstSet = m_DescriptorSet;
+		occupancyWrite.dstBinding = 2;
+		occupancyWrite.dstArrayElement = 0;
+		occupancyWrite.descriptorCount = 1;
+		occupancyWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		occupancyWrite.pImageInfo = nullptr;
+		occupancyWrite.pBufferInfo = &occupancyBufferInfo;
+		occupancyWrite.pTexelBufferView = nullptr;
+
 		// Update
-		std::vector<VkWriteDescriptorSet> writes = { densityTexWrite };
+		std::vector<VkWriteDescriptorSet> writes = { densityTexWrite, densityGridWrite, occupancyWrite };
 
 		vkUpdateDescriptorSets(VulkanAPI::GetDevice(), writes.size(), writes.data(), 0, nullptr);
 	}
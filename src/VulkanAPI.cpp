@@ -8,15 +8,25 @@
 #include <engine/graphics/Window.hpp>
 #include <engine/graphics/Camera.hpp>
 #include <engine/graphics/vulkan/Texture2D.hpp>
+#include <engine/graphics/vulkan/MemoryAllocator.hpp>
+#include <engine/graphics/vulkan/Uploader.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
+#include <engine/graphics/vulkan/ImageExporter.hpp>
 #include <engine/objects/VolumeData.hpp>
 #include <engine/graphics/DirLight.hpp>
 #include <engine/graphics/renderer/NrcHpmRenderer.hpp>
 #include <engine/graphics/PointLight.hpp>
 #include <engine/graphics/HdrEnvMap.hpp>
 #include <engine/graphics/renderer/McHpmRenderer.hpp>
+#include <engine/graphics/renderer/HpmDenoiser.hpp>
+#include <engine/graphics/renderer/Upscaler.hpp>
 #include <engine/objects/Material.hpp>
 #include <engine/objects/Mesh.hpp>
 #include <engine/objects/Model.hpp>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <cstring>
 
 namespace en
 {
@@ -31,11 +41,18 @@ namespace en
 	uint32_t VulkanAPI::m_GraphicsQFI;
 	uint32_t VulkanAPI::m_ComputeQFI;
 	uint32_t VulkanAPI::m_PresentQFI;
+	uint32_t VulkanAPI::m_TransferQFI;
 
 	VkDevice VulkanAPI::m_Device;
 	VkQueue VulkanAPI::m_GraphicsQueue;
 	VkQueue VulkanAPI::m_ComputeQueue;
 	VkQueue VulkanAPI::m_PresentQueue;
+	VkQueue VulkanAPI::m_TransferQueue;
+
+	const char* VulkanAPI::c_PipelineCachePath = "cache/pipeline_cache.bin";
+	VkPipelineCache VulkanAPI::m_PipelineCache = VK_NULL_HANDLE;
+	uint32_t VulkanAPI::m_PipelineCount = 0;
+	double VulkanAPI::m_PipelineCreationTime = 0.0;
 
 	void VulkanAPI::Init(const std::string& appName)
 	{
@@ -45,6 +62,11 @@ namespace en
 		m_Surface = Window::CreateVulkanSurface(m_Instance.GetVkHandle());
 		PickPhysicalDevice();
 		CreateDevice();
+		CreatePipelineCache();
+		vk::MemoryAllocator::Init();
+		vk::Uploader::Init();
+		vk::FramePacer::Init();
+		vk::ImageExporter::Init();
 
 		Camera::Init();
 		vk::Texture2D::Init();
@@ -54,6 +76,8 @@ namespace en
 		HdrEnvMap::Init(m_Device);
 		NrcHpmRenderer::Init(m_Device);
 		McHpmRenderer::Init(m_Device);
+		HpmDenoiser::Init(m_Device);
+		Upscaler::Init(m_Device);
 		Material::Init();
 		MeshInstance::Init();
 		ModelInstance::Init();
@@ -66,6 +90,8 @@ namespace en
 		ModelInstance::Shutdown();
 		MeshInstance::Shutdown();
 		Material::Shutdown();
+		Upscaler::Shutdown(m_Device);
+		HpmDenoiser::Shutdown(m_Device);
 		McHpmRenderer::Shutdown(m_Device);
 		NrcHpmRenderer::Shutdown(m_Device);
 		HdrEnvMap::Shutdown(m_Device);
@@ -75,6 +101,15 @@ namespace en
 		vk::Texture2D::Shutdown();
 		Camera::Shutdown();
 
+		vk::ImageExporter::Shutdown();
+		vk::FramePacer::Shutdown();
+		vk::Uploader::Shutdown();
+		vk::MemoryAllocator::Shutdown();
+
+		SavePipelineCache();
+		vkDestroyPipelineCache(m_Device, m_PipelineCache, nullptr);
+		m_PipelineCache = VK_NULL_HANDLE;
+
 		vkDestroyDevice(m_Device, nullptr);
 		vkDestroySurfaceKHR(m_Instance.GetVkHandle(), m_Surface, nullptr);
 		m_Instance.Destroy();
@@ -90,6 +125,11 @@ namespace en
 		}
 	}
 
+	VkMemoryPropertyFlags VulkanAPI::GetMemoryTypeProperties(uint32_t memoryTypeIndex)
+	{
+		return m_PhysicalDeviceInfo.memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+	}
+
 	bool VulkanAPI::IsFormatSupported(VkFormat format, VkImageTiling imageTiling, VkFormatFeatureFlags featureFlags)
 	{
 		VkFormatProperties formatProperties;
@@ -160,6 +200,11 @@ namespace en
 		return m_PresentQFI;
 	}
 
+	uint32_t VulkanAPI::GetTransferQFI()
+	{
+		return m_TransferQFI;
+	}
+
 	VkDevice VulkanAPI::GetDevice()
 	{
 		return m_Device;
@@ -180,11 +225,44 @@ namespace en
 		return m_PresentQueue;
 	}
 
+	VkQueue VulkanAPI::GetTransferQueue()
+	{
+		return m_TransferQueue;
+	}
+
 	float VulkanAPI::GetTimestampPeriod()
 	{
 		return m_PhysicalDeviceInfo.properties.limits.timestampPeriod;
 	}
 
+	VkPipelineCache VulkanAPI::GetPipelineCache()
+	{
+		return m_PipelineCache;
+	}
+
+	VkResult VulkanAPI::CreateComputePipeline(const VkComputePipelineCreateInfo& createInfo, VkPipeline* pipeline)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		const VkResult result = vkCreateComputePipelines(m_Device, m_PipelineCache, 1, &createInfo, nullptr, pipeline);
+		m_PipelineCreationTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		m_PipelineCount++;
+		return result;
+	}
+
+	VkResult VulkanAPI::CreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo, VkPipeline* pipeline)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		const VkResult result = vkCreateGraphicsPipelines(m_Device, m_PipelineCache, 1, &createInfo, nullptr, pipeline);
+		m_PipelineCreationTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		m_PipelineCount++;
+		return result;
+	}
+
+	void VulkanAPI::LogPipelineCreationTime()
+	{
+		Log::Info("Created {} pipelines in {} ms", m_PipelineCount, m_PipelineCreationTime);
+	}
+
 	void VulkanAPI::PickPhysicalDevice()
 	{
 		// Enumerate physical devices
@@ -278,6 +356,18 @@ namespace en
 				}
 			}
 
+			// Transfer QFI. A family without graphics and compute maps to the copy engine
+			uint32_t transferQFI = graphicsQFI;
+			for (size_t i = 0; i < queueFamilies.size(); i++)
+			{
+				const VkQueueFlags queueFlags = queueFamilies[i].queueFlags;
+				if ((queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+				{
+					transferQFI = i;
+					break;
+				}
+			}
+
 			// Tensor cores
 			PFN_vkGetPhysicalDeviceCooperativeMatrixPropertiesNV fpVkGetPhysicalDeviceCooperativeMatrixPropertiesNV =
 				(PFN_vkGetPhysicalDeviceCooperativeMatrixPropertiesNV)
@@ -335,12 +425,14 @@ namespace en
 			{
 				Log::Info(
 					"Picking " + std::string(properties.deviceName) +
-					": Graphics QFI(" + std::to_string(graphicsQFI) + ")");
+					": Graphics QFI(" + std::to_string(graphicsQFI) + ")" +
+					", Transfer QFI(" + std::to_string(transferQFI) + ")");
 
 				m_PhysicalDeviceInfo = physicalDeviceInfo;
 				m_GraphicsQFI = graphicsQFI;
 				m_PresentQFI = graphicsQFI;
 				m_ComputeQFI = graphicsQFI;
+				m_TransferQFI = transferQFI;
 
 				m_SurfaceCapabilities = surfaceCapabilities;
 				m_SurfaceFormat = bestFormat;
@@ -354,6 +446,94 @@ namespace en
 			Log::Error("Failed to pick physical device", true);
 	}
 
+	void VulkanAPI::CreatePipelineCache()
+	{
+		m_PipelineCount = 0;
+		m_PipelineCreationTime = 0.0;
+
+		const VkPhysicalDeviceProperties& properties = m_PhysicalDeviceInfo.properties;
+
+		// Load the cache of a previous run if it was written by the same device and driver
+		std::vector<char> data;
+		std::ifstream file(c_PipelineCachePath, std::ios::binary);
+		if (file.is_open())
+		{
+			PipelineCacheFileHeader header = {};
+			file.read(reinterpret_cast<char*>(&header), sizeof(PipelineCacheFileHeader));
+
+			const bool valid =
+				file.good() &&
+				header.magic == c_PipelineCacheMagic &&
+				header.vendorID == properties.vendorID &&
+				header.deviceID == properties.deviceID &&
+				header.driverVersion == properties.driverVersion &&
+				std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+
+			if (valid)
+			{
+				data.resize(header.dataSize);
+				file.read(data.data(), data.size());
+				if (!file.good()) { data.clear(); }
+			}
+
+			if (data.empty()) { Log::Warn("Ignoring pipeline cache " + std::string(c_PipelineCachePath) + " of another device or driver"); }
+		}
+
+		VkPipelineCacheCreateInfo cacheCI;
+		cacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheCI.pNext = nullptr;
+		cacheCI.flags = 0;
+		cacheCI.initialDataSize = data.size();
+		cacheCI.pInitialData = data.empty() ? nullptr : data.data();
+
+		VkResult result = vkCreatePipelineCache(m_Device, &cacheCI, nullptr, &m_PipelineCache);
+		ASSERT_VULKAN(result);
+
+		Log::Info("Pipeline cache loaded with {} bytes", data.size());
+	}
+
+	void VulkanAPI::SavePipelineCache()
+	{
+		size_t dataSize = 0;
+		VkResult result = vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, nullptr);
+		ASSERT_VULKAN(result);
+
+		// Some drivers (e.g. lavapipe) do not serialize their pipelines
+		if (dataSize == 0) { return; }
+
+		std::vector<char> data(dataSize);
+		result = vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, data.data());
+		ASSERT_VULKAN(result);
+
+		const VkPhysicalDeviceProperties& properties = m_PhysicalDeviceInfo.properties;
+		PipelineCacheFileHeader header = {};
+		header.magic = c_PipelineCacheMagic;
+		header.vendorID = properties.vendorID;
+		header.deviceID = properties.deviceID;
+		header.driverVersion = properties.driverVersion;
+		std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.dataSize = dataSize;
+
+		// Write to a temporary file first so an interrupted run never leaves a truncated cache behind
+		const std::filesystem::path path(c_PipelineCachePath);
+		const std::filesystem::path tempPath(path.string() + ".tmp");
+		if (path.has_parent_path()) { std::filesystem::create_directories(path.parent_path()); }
+
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			Log::Warn("Failed to write pipeline cache " + tempPath.string());
+			return;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(PipelineCacheFileHeader));
+		file.write(data.data(), dataSize);
+		file.close();
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, path, error);
+		if (error) { Log::Warn("Failed to write pipeline cache " + path.string() + ": " + error.message()); }
+	}
+
 	void VulkanAPI::CreateDevice()
 	{
 		VkPhysicalDevice physicalDevice = m_PhysicalDeviceInfo.vulkanHandle;
@@ -416,6 +596,15 @@ namespace en
 		queueCreateInfo.queueCount = 2;
 		queueCreateInfo.pQueuePriorities = priorities;
 
+		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos = { queueCreateInfo };
+		if (m_TransferQFI != m_GraphicsQFI)
+		{
+			VkDeviceQueueCreateInfo transferQueueCreateInfo = queueCreateInfo;
+			transferQueueCreateInfo.queueFamilyIndex = m_TransferQFI;
+			transferQueueCreateInfo.queueCount = 1;
+			queueCreateInfos.push_back(transferQueueCreateInfo);
+		}
+
 		// Features 1.0
 		VkPhysicalDeviceFeatures features10{};
 
@@ -450,13 +639,19 @@ namespace en
 		queryResetFeatures.pNext = &atomicFloatFeatures;
 		queryResetFeatures.hostQueryReset = VK_TRUE;
 
+		// Timeline semaphores
+		VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures{};
+		timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		timelineSemaphoreFeatures.pNext = &queryResetFeatures;
+		timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+
 		// Create
 		VkDeviceCreateInfo createInfo;
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-		createInfo.pNext = &queryResetFeatures;
+		createInfo.pNext = &timelineSemaphoreFeatures;
 		createInfo.flags = 0;
-		createInfo.queueCreateInfoCount = 1;
-		createInfo.pQueueCreateInfos = &queueCreateInfo;
+		createInfo.queueCreateInfoCount = queueCreateInfos.size();
+		createInfo.pQueueCreateInfos = queueCreateInfos.data();
 		createInfo.enabledLayerCount = layers.size();
 		createInfo.ppEnabledLayerNames = layers.data();
 		createInfo.enabledExtensionCount = extensions.size();
@@ -471,5 +666,7 @@ namespace en
 		m_PresentQueue = m_GraphicsQueue;
 		//m_ComputeQueue = m_GraphicsQueue;
 		vkGetDeviceQueue(m_Device, m_GraphicsQFI, 1, &m_ComputeQueue);
+		if (m_TransferQFI != m_GraphicsQFI) { vkGetDeviceQueue(m_Device, m_TransferQFI, 0, &m_TransferQueue); }
+		else { m_TransferQueue = m_GraphicsQueue; }
 	}
 }
@@ -6,6 +6,7 @@
 #include <engine/graphics/vulkan/CommandRecorder.hpp>
 #include <engine/graphics/renderer/ImGuiRenderer.hpp>
 #include <engine/graphics/vulkan/Swapchain.hpp>
+#include <engine/graphics/vulkan/FramePacer.hpp>
 #include <imgui.h>
 #include <engine/graphics/renderer/NrcHpmRenderer.hpp>
 #include <engine/graphics/NeuralRadianceCache.hpp>
@@ -15,17 +16,23 @@
 #include <engine/HpmScene.hpp>
 #include <engine/AppConfig.hpp>
 #include <engine/graphics/renderer/McHpmRenderer.hpp>
+#include <engine/graphics/renderer/HpmDenoiser.hpp>
+#include <engine/graphics/renderer/Upscaler.hpp>
 #include <engine/graphics/vulkan/CommandPool.hpp>
 #include <engine/graphics/Reference.hpp>
+#include <engine/graphics/CameraPath.hpp>
 #include <engine/objects/Model.hpp>
 #include <engine/graphics/renderer/SimpleModelRenderer.hpp>
 #include <engine/util/LogFile.hpp>
+#include <engine/util/ResolutionController.hpp>
 #include <openvdb/openvdb.h>
 #include <filesystem>
 
 en::Reference* reference = nullptr;
 en::NrcHpmRenderer* nrcHpmRenderer = nullptr;
 en::McHpmRenderer* mcHpmRenderer = nullptr;
+en::HpmDenoiser* nrcDenoiser = nullptr;
+en::HpmDenoiser* mcDenoiser = nullptr;
 
 void RecordSwapchainCommandBuffer(VkCommandBuffer commandBuffer, VkImage image)
 {
@@ -35,7 +42,7 @@ void RecordSwapchainCommandBuffer(VkCommandBuffer commandBuffer, VkImage image)
 	VkCommandBufferBeginInfo beginInfo;
 	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 	beginInfo.pNext = nullptr;
-	beginInfo.flags = 0;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
 	beginInfo.pInheritanceInfo = nullptr;
 
 	VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
@@ -109,6 +116,8 @@ void SwapchainResizeCallback()
 struct ViewBenchmarkStats
 {
 	float mse;
+	float relMse;
+	float ssim;
 	glm::vec3 bias;
 };
 
@@ -117,44 +126,92 @@ struct BenchmarkStats
 	size_t frameIndex;
 	float frameTimeMS;
 	float loss;
-	std::array<ViewBenchmarkStats, 6> viewStats;
+	std::vector<ViewBenchmarkStats> viewStats;
+};
+
+void Benchmark(
+	const en::Camera* camera,
+	VkQueue queue,
+	size_t frameCount,
+	bool denoise,
+	BenchmarkStats& stats,
+	en::LogFile& logFile,
+	en::LogFile& viewLogFile)
+{
+	en::Log::Info("Frame: {}", frameCount);
+	const std::vector<en::Reference::Result> nrcResults = reference->CompareNrc(*nrcHpmRenderer, camera, queue, denoise ? nrcDenoiser : nullptr);
+	const std::vector<en::Reference::Result> mcResults = reference->CompareMc(*mcHpmRenderer, camera, queue, denoise ? mcDenoiser : nullptr);
 
-	std::string ToString() const
+	stats.viewStats.resize(nrcResults.size());
+	for (size_t i = 0; i < nrcResults.size(); i++)
 	{
-		std::string str = 
-			std::to_string(frameIndex) + " " +
-			std::to_string(frameTimeMS) + " " +
-			std::to_string(loss) + " ";
-		for (size_t i = 0; i < viewStats.size(); i++)
-		{
-			str += std::to_string(viewStats[i].mse) + " " +
-				std::to_string(viewStats[i].bias.x) + " " +
-				std::to_string(viewStats[i].bias.y) + " " +
-				std::to_string(viewStats[i].bias.z) + " ";
-		}
+		const en::Reference::Result& result = nrcResults[i];
+		stats.viewStats[i].mse = static_cast<float>(result.mse);
+		stats.viewStats[i].relMse = static_cast<float>(result.relMse);
+		stats.viewStats[i].ssim = static_cast<float>(result.ssim);
+		stats.viewStats[i].bias = glm::vec3(result.bias[0], result.bias[1], result.bias[2]);
+	}
+
+	// log.txt keeps one line per frame for the first view, which is the single reference camera of older runs
+	const en::Reference::Result& firstResult = nrcResults[0];
+	logFile.WriteLine("{} {} {} {}", frameCount, firstResult.mse, firstResult.GetRelBias(), firstResult.GetCV());
 
-		return str;
+	// views.txt has one line per view, formatted by the log thread
+	for (size_t i = 0; i < stats.viewStats.size(); i++)
+	{
+		const ViewBenchmarkStats& view = stats.viewStats[i];
+		viewLogFile.WriteLine(
+			"{} {} {} {} {} {} {} {} {} {}",
+			stats.frameIndex, stats.frameTimeMS, stats.loss, i,
+			view.mse, view.relMse, view.ssim, view.bias.x, view.bias.y, view.bias.z);
 	}
+}
+
+// Accumulated over the frames of one camera path segment
+struct SegmentStats
+{
+	bool moving = false;
+	uint32_t frameCount = 0;
+	double frameTimeMS = 0.0;
+	double loss = 0.0;
+	uint32_t benchmarkFrameCount = 0;
+	double mse = 0.0;
+	double ssim = 0.0;
+	float firstMse = 0.0f;
+	float lastMse = 0.0f;
 };
 
-void Benchmark(const en::Camera* camera, VkQueue queue, size_t frameCount, BenchmarkStats& stats, en::LogFile& logFile)
+void ReportCameraPathStats(const std::vector<SegmentStats>& segmentStats, en::LogFile& logFile)
 {
-	en::Log::Info("Frame: " + std::to_string(frameCount));
-	en::Reference::Result nrcResult = reference->CompareNrc(*nrcHpmRenderer, camera, queue);
-	en::Reference::Result mcResult = reference->CompareMc(*mcHpmRenderer, camera, queue);
-	logFile.WriteLine(
-		std::to_string(frameCount) + " " + 
-		std::to_string(nrcResult.mse) + " " +
-		std::to_string(nrcResult.GetRelBias()) + " " +
-		std::to_string(nrcResult.GetCV()));
+	// first and last mse of a segment show how far NRC has adapted to the motion before it
+	for (size_t i = 0; i < segmentStats.size(); i++)
+	{
+		const SegmentStats& segment = segmentStats[i];
+		if (segment.frameCount == 0) { continue; }
+
+		const double frameNorm = 1.0 / static_cast<double>(segment.frameCount);
+		const double benchmarkNorm = segment.benchmarkFrameCount > 0 ? 1.0 / static_cast<double>(segment.benchmarkFrameCount) : 0.0;
+		const uint32_t moving = segment.moving ? 1 : 0;
+		en::Log::Info(
+			"Camera path segment {} moving {} frames {} frame time {} ms loss {} mse {} ({} -> {}) ssim {}",
+			i, moving, segment.frameCount, segment.frameTimeMS * frameNorm, segment.loss * frameNorm,
+			segment.mse * benchmarkNorm, segment.firstMse, segment.lastMse, segment.ssim * benchmarkNorm);
+		logFile.WriteLine(
+			"segment {} {} {} {} {} {} {} {} {}",
+			i, moving, segment.frameCount, segment.frameTimeMS * frameNorm, segment.loss * frameNorm,
+			segment.mse * benchmarkNorm, segment.firstMse, segment.lastMse, segment.ssim * benchmarkNorm);
+	}
 }
 
 bool RunAppConfigInstance(const en::AppConfig& appConfig)
 {
 	// Start engine
 	const std::string appName("NRC-HPM-Renderer");
-	uint32_t width = 1920;
-	uint32_t height = 1080;
+
+	// Output size of the window, the upscaler and imgui. It stays fixed, only the resolution controller changes the
+	// render size of MC and NRC
+	const uint32_t width = 1920;
+	const uint32_t height = 1080;
 	en::Log::Info("Starting " + appName);
 
 	en::Window::Init(width, height, false, appName);
@@ -186,8 +243,21 @@ bool RunAppConfigInstance(const en::AppConfig& appConfig)
 		0.1f,
 		100.0f);
 
+	// Dynamic resolution renders MC and NRC below the output size and upscales to it. Render sizes are always aligned
+	// for the renderers, the full scale size is the base size of the reference and the denoisers
+	en::ResolutionController resolutionController(33.3f, 0.5f, 1.0f, 0.125f);
+	bool dynamicResolution = false;
+	uint32_t baseRenderWidth;
+	uint32_t baseRenderHeight;
+	resolutionController.GetRenderSize(width, height, baseRenderWidth, baseRenderHeight);
+	uint32_t renderWidth = baseRenderWidth;
+	uint32_t renderHeight = baseRenderHeight;
+
 	// Init reference
-	if (!hpmScene.IsDynamic()) { reference = new en::Reference(width, height, appConfig, hpmScene, queue); }
+	if (!hpmScene.IsDynamic())
+	{
+		reference = new en::Reference(baseRenderWidth, baseRenderHeight, appConfig, hpmScene, en::Reference::GetDefaultViews(4), queue);
+	}
 
 	// Init rendering pipeline
 	en::Log::Info("Initializing renderers");
@@ -200,27 +270,50 @@ bool RunAppConfigInstance(const en::AppConfig& appConfig)
 
 	en::SimpleModelRenderer modelRenderer(width, height, &camera);
 	
+	// Single view until the first batched benchmark comparison needs the layers of all reference views
 	nrcHpmRenderer = new en::NrcHpmRenderer(
-		width,
-		height,
+		renderWidth,
+		renderHeight,
 		false,
 		&camera,
 		appConfig,
 		hpmScene,
 		nrc);
 
-	mcHpmRenderer = new en::McHpmRenderer(width, height, 32, false, &camera, hpmScene);
+	mcHpmRenderer = new en::McHpmRenderer(renderWidth, renderHeight, 32, false, false, &camera, hpmScene);
 
-	if (en::Window::IsSupported())
+	nrcDenoiser = new en::HpmDenoiser(renderWidth, renderHeight, &camera, nrcHpmRenderer->GetImageView(), nrcHpmRenderer->GetGuideImageView());
+	mcDenoiser = new en::HpmDenoiser(renderWidth, renderHeight, &camera, mcHpmRenderer->GetImageView(), mcHpmRenderer->GetGuideImageView());
+	bool denoise = false;
+
+	en::Upscaler upscaler(width, height);
+
+	auto setBackgroundImageView = [&]()
 	{
-		en::ImGuiRenderer::Init(width, height);
+		const bool upscale = renderWidth != width || renderHeight != height;
 		switch (rendererId)
 		{
 		case 0: // MC
-			en::ImGuiRenderer::SetBackgroundImageView(mcHpmRenderer->GetImageView());
+			if (upscale)
+			{
+				upscaler.SetInput(denoise ? mcDenoiser->GetImageView() : mcHpmRenderer->GetImageView(), renderWidth, renderHeight);
+				en::ImGuiRenderer::SetBackgroundImageView(upscaler.GetImageView());
+			}
+			else
+			{
+				en::ImGuiRenderer::SetBackgroundImageView(denoise ? mcDenoiser->GetImageView() : mcHpmRenderer->GetImageView());
+			}
 			break;
 		case 1: // NRC
-			en::ImGuiRenderer::SetBackgroundImageView(nrcHpmRenderer->GetImageView());
+			if (upscale)
+			{
+				upscaler.SetInput(denoise ? nrcDenoiser->GetImageView() : nrcHpmRenderer->GetImageView(), renderWidth, renderHeight);
+				en::ImGuiRenderer::SetBackgroundImageView(upscaler.GetImageView());
+			}
+			else
+			{
+				en::ImGuiRenderer::SetBackgroundImageView(denoise ? nrcDenoiser->GetImageView() : nrcHpmRenderer->GetImageView());
+			}
 			break;
 		case 2: // Model
 			en::ImGuiRenderer::SetBackgroundImageView(modelRenderer.GetColorImageView());
@@ -229,15 +322,70 @@ bool RunAppConfigInstance(const en::AppConfig& appConfig)
 			en::Log::Error("Renderer ID is invalid", true);
 			break;
 		}
+	};
+
+	// Recreates the size dependent resources of MC, NRC and their denoisers. The camera, scene and network are kept
+	auto applyRenderSize = [&](uint32_t newWidth, uint32_t newHeight)
+	{
+		if (newWidth == renderWidth && newHeight == renderHeight) { return; }
+		en::Log::Info("Render size {}x{}", newWidth, newHeight);
+
+		renderWidth = newWidth;
+		renderHeight = newHeight;
+		mcHpmRenderer->SetRenderSize(queue, renderWidth, renderHeight);
+		nrcHpmRenderer->SetRenderSize(queue, renderWidth, renderHeight);
+		mcDenoiser->SetRenderSize(queue, renderWidth, renderHeight, mcHpmRenderer->GetImageView(), mcHpmRenderer->GetGuideImageView());
+		nrcDenoiser->SetRenderSize(queue, renderWidth, renderHeight, nrcHpmRenderer->GetImageView(), nrcHpmRenderer->GetGuideImageView());
+
+		if (en::ImGuiRenderer::IsInitialized()) { setBackgroundImageView(); }
+	};
+
+	// Resizes MC and NRC to render the reference views as layers of one frame. Their image views change, so the
+	// denoisers and the background are pointed at the new ones
+	auto applyMaxViewCount = [&](uint32_t maxViewCount)
+	{
+		if (nrcHpmRenderer->GetMaxViewCount() == maxViewCount && mcHpmRenderer->GetMaxViewCount() == maxViewCount) { return; }
+		en::Log::Info("Max view count {}", maxViewCount);
+
+		mcHpmRenderer->SetMaxViewCount(queue, maxViewCount);
+		nrcHpmRenderer->SetMaxViewCount(queue, maxViewCount);
+		mcDenoiser->SetRenderSize(queue, renderWidth, renderHeight, mcHpmRenderer->GetImageView(), mcHpmRenderer->GetGuideImageView());
+		nrcDenoiser->SetRenderSize(queue, renderWidth, renderHeight, nrcHpmRenderer->GetImageView(), nrcHpmRenderer->GetGuideImageView());
+
+		if (en::ImGuiRenderer::IsInitialized()) { setBackgroundImageView(); }
+	};
+
+	// GPU time of the last finished frame of the active renderer, including its denoiser
+	auto getFrameTimeMS = [&]()
+	{
+		switch (rendererId)
+		{
+		case 0: // MC
+			return mcHpmRenderer->GetFrameTimeMS() + (denoise ? mcDenoiser->GetTimeMS() : 0.0f);
+		case 1: // NRC
+			return nrcHpmRenderer->GetFrameTimeMS() + (denoise ? nrcDenoiser->GetTimeMS() : 0.0f);
+		default: // Model is not timed
+			return 0.0f;
+		}
+	};
+
+	if (en::Window::IsSupported())
+	{
+		en::ImGuiRenderer::Init(width, height);
+		setBackgroundImageView();
 	}
 
 	// Swapchain rerecording because imgui renderer is now available
 	if (en::Window::IsSupported()) { swapchain->Resize(width, height); }
 
+	en::VulkanAPI::LogPipelineCreationTime();
+
 	// Main loop
 	en::Log::Info("Starting main loop");
 	BenchmarkStats stats;
 	en::LogFile logFile("output/ " + appConfig.GetName() + "/log.txt");
+	en::LogFile viewLogFile("output/ " + appConfig.GetName() + "/views.txt");
+	viewLogFile.WriteLine("frame frameTimeMS loss view mse relMse ssim biasR biasG biasB");
 	VkResult result;
 	size_t frameCount = 0;
 	bool shutdown = false;
@@ -245,8 +393,34 @@ bool RunAppConfigInstance(const en::AppConfig& appConfig)
 	bool benchmark = true;
 	bool continueLoop = en::Window::IsSupported() ? !en::Window::IsClosed() : true;
 	bool pause = false;
+	bool exportFrames = false;
+	const std::string framesDirPath = "output/" + appConfig.GetName() + "/frames/";
+
+	// Camera paths are stored per scene like the reference images. Benchmarks replay the path if one exists
+	en::CameraPath cameraPath;
+	const std::string cameraPathFilePath = "camera_path/" + std::to_string(appConfig.scene.id) + ".bin";
+	bool playCameraPath = false;
+	uint32_t cameraPathFrame = 0;
+	std::vector<SegmentStats> segmentStats;
+
+	auto startCameraPath = [&]()
+	{
+		playCameraPath = true;
+		cameraPathFrame = 0;
+		segmentStats.assign(cameraPath.GetSegmentCount(), SegmentStats());
+		for (uint32_t i = 0; i < segmentStats.size(); i++) { segmentStats[i].moving = cameraPath.IsSegmentMoving(i); }
+	};
+
+	if (cameraPath.Load(cameraPathFilePath) && benchmark && !cameraPath.IsEmpty()) { startCameraPath(); }
+
 	while (continueLoop && !shutdown)
 	{
+		// Waits for the frame that used this slot before, so the host runs at most c_MaxFramesInFlight frames ahead
+		en::vk::FramePacer::BeginFrame();
+
+		// Frame arena users wait for their own copies, so its memory is no longer in use
+		en::vk::MemoryAllocator::ResetFrameArena();
+
 		// Update
 		if (en::Window::IsSupported())
 		{
@@ -255,20 +429,20 @@ bool RunAppConfigInstance(const en::AppConfig& appConfig)
 		}
 		en::Time::Update();
 
-		if (en::Window::IsSupported())
-		{
-			width = en::Window::GetWidth();
-			height = en::Window::GetHeight();
-		}
-
 		float deltaTime = static_cast<float>(en::Time::GetDeltaTime());
 		uint32_t fps = en::Time::GetFps();
 
-		// Physics
-		if (en::Window::IsSupported())
+		// Physics. A playing camera path is driven by its frame index instead of the frame time
+		if (playCameraPath)
+		{
+			cameraPath.Apply(camera, cameraPathFrame);
+			if (en::Window::IsSupported()) { camera.SetAspectRatio(width, height); }
+		}
+		else if (en::Window::IsSupported())
 		{
 			en::Input::HandleUserCamInput(&camera, deltaTime);
 			camera.SetAspectRatio(width, height);
+			if (!pause) { cameraPath.Record(camera); }
 		}
 		camera.UpdateUniformBuffer();
 
@@ -279,24 +453,30 @@ bool RunAppConfigInstance(const en::AppConfig& appConfig)
 			{
 			case 0: // MC
 				mcHpmRenderer->Render(queue);
-				result = vkQueueWaitIdle(queue);
-				ASSERT_VULKAN(result);
-				mcHpmRenderer->EvaluateTimestampQueries();
+				if (denoise) { mcDenoiser->Denoise(queue); }
+				if (renderWidth != width || renderHeight != height) { upscaler.Upscale(queue); }
 				break;
 			case 1: // NRC
 				nrcHpmRenderer->Render(queue, true);
-				result = vkQueueWaitIdle(queue);
-				ASSERT_VULKAN(result);
-				nrcHpmRenderer->EvaluateTimestampQueries();
+				if (denoise) { nrcDenoiser->Denoise(queue); }
+				if (renderWidth != width || renderHeight != height) { upscaler.Upscale(queue); }
 				break;
 			case 2: // Model
 				modelRenderer.Render(queue);
-				ASSERT_VULKAN(vkQueueWaitIdle(queue));
 				break;
 			default: // Error
 				en::Log::Error("Renderer ID is invalid", true);
 				break;
 			}
+
+			// Frames are encoded on worker threads, half float PIZ keeps up with the frame rate
+			if (exportFrames && rendererId != 2)
+			{
+				const std::string framePath = framesDirPath + std::to_string(frameCount) + ".exr";
+				const en::vk::ImageExporter::Compression compression = en::vk::ImageExporter::Compression::Piz;
+				if (rendererId == 0) { mcHpmRenderer->ExportOutputImageToFile(queue, framePath, compression, true); }
+				else { nrcHpmRenderer->ExportOutputImageToFile(queue, framePath, compression, true); }
+			}
 		}
 
 		//
@@ -319,6 +499,35 @@ bool RunAppConfigInstance(const en::AppConfig& appConfig)
 			ImGui::Checkbox("Restart after shutdown", &restartAfterClose);
 			ImGui::Checkbox("Benchmark", &benchmark);
 			ImGui::Checkbox("Pause", &pause);
+			if (ImGui::Checkbox("Export frames", &exportFrames) && exportFrames) { std::filesystem::create_directories(framesDirPath); }
+			if (ImGui::Checkbox("Denoise", &denoise)) { setBackgroundImageView(); }
+
+			if (cameraPath.IsRecording())
+			{
+				if (ImGui::Button("Stop camera path recording"))
+				{
+					cameraPath.StopRecording();
+					cameraPath.Save(cameraPathFilePath);
+				}
+			}
+			else if (playCameraPath)
+			{
+				ImGui::Text("Camera path frame %d / %d", cameraPathFrame, cameraPath.GetFrameCount());
+				if (ImGui::Button("Stop camera path"))
+				{
+					playCameraPath = false;
+					ReportCameraPathStats(segmentStats, logFile);
+				}
+			}
+			else
+			{
+				if (ImGui::Button("Record camera path")) { cameraPath.StartRecording(); }
+				if (!cameraPath.IsEmpty() && ImGui::Button("Play camera path")) { startCameraPath(); }
+			}
+
+			ImGui::Checkbox("Dynamic resolution", &dynamicResolution);
+			ImGui::Text("Render size %dx%d", renderWidth, renderHeight);
+			resolutionController.RenderImGui();
 
 			if (ImGui::BeginCombo("##combo", currentRendererMenuItem))
 			{
@@ -330,21 +539,7 @@ bool RunAppConfigInstance(const en::AppConfig& appConfig)
 						if (i != rendererId)
 						{
 							rendererId = i;
-							switch (rendererId)
-							{
-							case 0: // MC
-								en::ImGuiRenderer::SetBackgroundImageView(mcHpmRenderer->GetImageView());
-								break;
-							case 1: // NRC
-								en::ImGuiRenderer::SetBackgroundImageView(nrcHpmRenderer->GetImageView());
-								break;
-							case 2: // Model
-								en::ImGuiRenderer::SetBackgroundImageView(modelRenderer.GetColorImageView());
-								break;
-							default: // Error
-								en::Log::Error("Renderer ID is invalid", true);
-								break;
-							}
+							setBackgroundImageView();
 						}
 						currentRendererMenuItem = rendererMenuItems[i];
 					};
@@ -357,24 +552,92 @@ bool RunAppConfigInstance(const en::AppConfig& appConfig)
 
 			mcHpmRenderer->RenderImGui();
 			nrcHpmRenderer->RenderImGui();
+			mcDenoiser->RenderImGui("McHpmDenoiser");
+			nrcDenoiser->RenderImGui("NrcHpmDenoiser");
 
 			hpmScene.Update(true, deltaTime);
 
 			appConfig.RenderImGui();
 
 			en::ImGuiRenderer::EndFrame(queue, VK_NULL_HANDLE);
-			result = vkQueueWaitIdle(queue);
-			ASSERT_VULKAN(result);
 		}
 
 		// Display
 		if (!pause && en::Window::IsSupported()) { swapchain->DrawAndPresent(VK_NULL_HANDLE, VK_NULL_HANDLE); }
 
-		// Benchmark
-		stats.frameIndex = frameCount;
-		stats.frameTimeMS = nrcHpmRenderer->GetFrameTimeMS();
-		stats.loss = nrc.GetLoss();
-		if (benchmark && !hpmScene.IsDynamic() && frameCount % 1 == 0) { Benchmark(&camera, queue, frameCount, stats, logFile); }
+		en::vk::FramePacer::EndFrame(queue);
+
+		// Benchmark. The reference comparison renders synchronously, so only benchmark frames drain the queue
+		const bool benchmarkFrame = benchmark && !hpmScene.IsDynamic() && frameCount % 1 == 0;
+		if (benchmarkFrame)
+		{
+			// Renderers collect finished timestamp slots on their own, this picks up the frame that just completed
+			en::vk::FramePacer::WaitIdle();
+			nrcHpmRenderer->EvaluateTimestampQueries();
+			if (denoise) { nrcDenoiser->EvaluateTimestampQueries(); }
+
+			stats.frameIndex = frameCount;
+			stats.frameTimeMS = nrcHpmRenderer->GetFrameTimeMS() + (denoise ? nrcDenoiser->GetTimeMS() : 0.0f);
+			stats.loss = nrc.GetLoss();
+
+			// Denoised comparisons render the views one after another and keep the single view resources.
+			// Interactive frames only render one view, so the layers of the other views are released again
+			if (!denoise) { applyMaxViewCount(reference->GetViewCount()); }
+			Benchmark(&camera, queue, frameCount, denoise, stats, logFile, viewLogFile);
+			applyMaxViewCount(1);
+		}
+
+		// Dynamic resolution. Reference comparisons need the full size, so it is inactive while benchmarking
+		if (dynamicResolution && !benchmark && rendererId != 2)
+		{
+			if (resolutionController.Update(deltaTime * 1000.0f))
+			{
+				uint32_t newWidth;
+				uint32_t newHeight;
+				resolutionController.GetRenderSize(width, height, newWidth, newHeight);
+				applyRenderSize(newWidth, newHeight);
+			}
+		}
+		else
+		{
+			resolutionController.Reset();
+			applyRenderSize(baseRenderWidth, baseRenderHeight);
+		}
+
+		// Camera path stats
+		if (playCameraPath && !pause)
+		{
+			SegmentStats& segment = segmentStats[cameraPath.GetSegmentIndex(cameraPathFrame)];
+			segment.frameCount++;
+			segment.frameTimeMS += getFrameTimeMS();
+			segment.loss += nrcLoss;
+
+			if (benchmarkFrame && !stats.viewStats.empty())
+			{
+				float mse = 0.0f;
+				float ssim = 0.0f;
+				for (const ViewBenchmarkStats& view : stats.viewStats)
+				{
+					mse += view.mse;
+					ssim += view.ssim;
+				}
+				mse /= static_cast<float>(stats.viewStats.size());
+				ssim /= static_cast<float>(stats.viewStats.size());
+
+				if (segment.benchmarkFrameCount == 0) { segment.firstMse = mse; }
+				segment.lastMse = mse;
+				segment.mse += mse;
+				segment.ssim += ssim;
+				segment.benchmarkFrameCount++;
+			}
+
+			cameraPathFrame++;
+			if (cameraPathFrame >= cameraPath.GetFrameCount())
+			{
+				playCameraPath = false;
+				ReportCameraPathStats(segmentStats, logFile);
+			}
+		}
 
 		// Exit if loss is invalid
 		if (std::isnan(nrcLoss) || std::isinf(nrcLoss))
@@ -395,6 +658,14 @@ bool RunAppConfigInstance(const en::AppConfig& appConfig)
 	ASSERT_VULKAN(result);
 
 	// End
+	upscaler.Destroy();
+
+	mcDenoiser->Destroy();
+	delete mcDenoiser;
+
+	nrcDenoiser->Destroy();
+	delete nrcDenoiser;
+
 	mcHpmRenderer->Destroy();
 	delete mcHpmRenderer;
 	
@@ -423,6 +694,9 @@ int main(int argc, char** argv)
 	// Init openvdb
 	openvdb::initialize();
 
+	// Start log thread
+	en::AsyncLog::Init();
+
 	// Read arguments for app config
 	std::vector<char*> myargv(argc);
 	std::memcpy(myargv.data(), argv, sizeof(char*) * argc);
@@ -456,5 +730,6 @@ int main(int argc, char** argv)
 	} while (restartRunConfig);
 
 	// Exit
+	en::AsyncLog::Shutdown();
 	return 0;
 }
@@ -6,6 +6,7 @@
 #include <array>
 #include <cmath>
 #include <cstring>
+#include <algorithm>
 
 namespace en
 {
@@ -136,89 +137,4 @@ namespace en
 
 		return hdrData;
 	}
-
-	std::vector<float> InvertCdf(const std::vector<float>& cdf)
-	{
-		std::vector<float> invCdf(cdf.size());
-
-		size_t p = 0;
-		for (size_t i = 0; i < invCdf.size(); i++)
-		{
-			const float threshold = static_cast<float>(i) / static_cast<float>(invCdf.size());
-			while (cdf[p] < threshold)
-			{
-				p++;
-			}
-			invCdf[i] = static_cast<float>(p) / static_cast<float>(cdf.size());
-		}
-
-		return invCdf;
-	}
-
-	std::array<std::vector<float>, 2> Hdr4fToCdf(const std::vector<float>& hdr4f, size_t width, size_t height)
-	{
-		std::vector<std::vector<float>> cdfX(height);
-		for (std::vector<float>& cdfXgivenY : cdfX)
-		{
-			cdfXgivenY.resize(width);
-		}
-
-		std::vector<float> pdfY(height);
-
-		// Get cdf of x given y
-		for (size_t y = 0; y < height; y++)
-		{
-			float brightnessSum = 0.0f;
-			for (size_t x = 0; x < width; x++)
-			{
-				const float r = hdr4f[(y * width * 4) + (x * 4) + 0];
-				const float g = hdr4f[(y * width * 4) + (x * 4) + 1];
-				const float b = hdr4f[(y * width * 4) + (x * 4) + 2];
-				//const float a = hdr4f[(y * width * 4) + (x * 4) + 3];
-			
-				const float brightness = r + g + b;
-				brightnessSum += brightness;
-
-				cdfX[y][x] = brightnessSum;
-			}
-
-			// Norm
-			for (size_t x = 0; x < width; x++)
-			{
-				cdfX[y][x] /= brightnessSum;
-			}
-
-			// Store pdf unorm of y
-			pdfY[y] = brightnessSum;
-		}
-
-		// Get cdf unorm of y
-		std::vector<float> cdfY(height);
-
-		float brightnessSum = 0.0f;
-		for (size_t y = 0; y < height; y++)
-		{
-			brightnessSum += pdfY[y];
-			cdfY[y] = brightnessSum;
-		}
-
-		// Norm cdf of y
-		for (size_t y = 0; y < height; y++)
-		{
-			cdfY[y] /= cdfY[height - 1];
-		}
-
-		std::vector<float> invCdfX(width * height);
-
-		for (size_t y = 0; y < height; y++)
-		{
-			std::vector<float> invCdfXgivenY = InvertCdf(cdfX[y]);
-			for (size_t x = 0; x < width; x++)
-			{
-				invCdfX[(y * width) + x] = invCdfXgivenY[x];
-			}
-		}
-
-		return { invCdfX, InvertCdf(cdfY) };
-	}
 }
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <engine/util/DenoiseReference.hpp>
+#include <engine/util/Random.hpp>
+
+namespace
+{
+	const uint32_t c_Width = 64;
+	const uint32_t c_Height = 48;
+
+	// Scatter flags and depths vary per pixel, so every edge stopping function produces uneven weights
+	std::vector<float> MakeGuide(uint32_t frameIndex)
+	{
+		std::vector<float> guide(static_cast<size_t>(c_Width) * c_Height * 4, 0.0f);
+		for (uint32_t y = 0; y < c_Height; y++)
+		{
+			for (uint32_t x = 0; x < c_Width; x++)
+			{
+				en::Random random(x, y, frameIndex, 0);
+				random.SetBounce(0);
+				const size_t index = static_cast<size_t>(y) * c_Width + x;
+				guide[index * 4 + 0] = random.NextFloat() < 0.7f ? 1.0f : 0.0f;
+				guide[index * 4 + 1] = 1.0f + random.NextFloat(9.0f);
+			}
+		}
+		return guide;
+	}
+
+	en::DenoiseReference::Frame MakeFrame(const float* color, const float* guide)
+	{
+		en::DenoiseReference::Frame frame;
+		frame.invProjView = glm::mat4(1.0f);
+		frame.prevProjView = glm::mat4(1.0f);
+		frame.camPos = glm::vec3(0.0f, 0.0f, -1.0f);
+		frame.prevCamPos = frame.camPos;
+		frame.color = color;
+		frame.guide = guide;
+		return frame;
+	}
+}
+
+TEST(DenoiseReference, KernelIsNormalized)
+{
+	float weightSum = 0.0f;
+	for (int32_t dy = -2; dy <= 2; dy++)
+	{
+		for (int32_t dx = -2; dx <= 2; dx++)
+		{
+			weightSum += en::DenoiseReference::c_KernelWeights[std::abs(dx)] * en::DenoiseReference::c_KernelWeights[std::abs(dy)];
+		}
+	}
+	EXPECT_FLOAT_EQ(weightSum, 1.0f);
+}
+
+TEST(DenoiseReference, ConstantImagePassesThrough)
+{
+	const glm::vec3 constant(0.3f, 0.6f, 0.9f);
+	std::vector<float> color(static_cast<size_t>(c_Width) * c_Height * 4, 1.0f);
+	for (size_t pixel = 0; pixel < static_cast<size_t>(c_Width) * c_Height; pixel++)
+	{
+		for (uint32_t c = 0; c < 3; c++) { color[pixel * 4 + c] = constant[c]; }
+	}
+
+	// Spatial variance on the first frames, temporal variance once the history is long enough
+	en::DenoiseReference denoiser(c_Width, c_Height, en::DenoiseReference::Params());
+	std::vector<float> output(color.size());
+	for (uint32_t frameIndex = 0; frameIndex < en::DenoiseReference::c_MinTemporalVarianceHistory + 2; frameIndex++)
+	{
+		const std::vector<float> guide = MakeGuide(frameIndex);
+		denoiser.Denoise(MakeFrame(color.data(), guide.data()), output.data());
+
+		for (size_t pixel = 0; pixel < static_cast<size_t>(c_Width) * c_Height; pixel++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				ASSERT_NEAR(output[pixel * 4 + c], constant[c], 1e-5f) << "frame " << frameIndex << " pixel " << pixel;
+			}
+		}
+	}
+}
+
+TEST(DenoiseReference, OutputIsConvexCombination)
+{
+	// A weight sum other than one would move pixels out of the input range
+	const float minValue = 0.5f;
+	const float maxValue = 1.0f;
+	std::vector<float> color(static_cast<size_t>(c_Width) * c_Height * 4, 1.0f);
+	for (uint32_t y = 0; y < c_Height; y++)
+	{
+		for (uint32_t x = 0; x < c_Width; x++)
+		{
+			en::Random random(x, y, 0, 1);
+			random.SetBounce(0);
+			const size_t index = static_cast<size_t>(y) * c_Width + x;
+			for (uint32_t c = 0; c < 3; c++) { color[index * 4 + c] = minValue + random.NextFloat(maxValue - minValue); }
+		}
+	}
+
+	en::DenoiseReference::Params params;
+	params.temporal = false;
+	en::DenoiseReference denoiser(c_Width, c_Height, params);
+	const std::vector<float> guide = MakeGuide(0);
+	std::vector<float> output(color.size());
+	denoiser.Denoise(MakeFrame(color.data(), guide.data()), output.data());
+
+	for (size_t pixel = 0; pixel < static_cast<size_t>(c_Width) * c_Height; pixel++)
+	{
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			ASSERT_GE(output[pixel * 4 + c], minValue - 1e-5f) << "pixel " << pixel;
+			ASSERT_LE(output[pixel * 4 + c], maxValue + 1e-5f) << "pixel " << pixel;
+		}
+	}
+}
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include <engine/util/DensityGrid.hpp>
+#include <cmath>
+#include <functional>
+#include <iostream>
+
+namespace
+{
+	// Long along x, so a ray along the volume crosses more cells than the old shared lookup cap of 128
+	const uint32_t c_SizeX = 2600;
+	const uint32_t c_SizeYZ = 4;
+	const glm::vec3 c_BoxSize(26.0f, 0.04f, 0.04f);
+	const float c_DensityFactor = 0.2f;
+
+	std::vector<std::vector<std::vector<float>>> MakeDensity()
+	{
+		return std::vector<std::vector<std::vector<float>>>(
+			c_SizeX,
+			std::vector<std::vector<float>>(c_SizeYZ, std::vector<float>(c_SizeYZ, 0.0f)));
+	}
+
+	std::vector<std::vector<std::vector<float>>> MakeDensityX(const std::function<float(uint32_t)>& densityAtX)
+	{
+		std::vector<std::vector<std::vector<float>>> density = MakeDensity();
+		for (uint32_t x = 0; x < c_SizeX; x++)
+		{
+			for (std::vector<float>& column : density[x])
+			{
+				std::fill(column.begin(), column.end(), densityAtX(x));
+			}
+		}
+		return density;
+	}
+
+	// 8 bit value the density texture stores, scaled like getDensity
+	float StoredDensity(float density)
+	{
+		return static_cast<float>(static_cast<uint8_t>(density * 255.0f)) * c_DensityFactor / 255.0f;
+	}
+
+	struct Estimate
+	{
+		double mean;
+		double stdError;
+		double variance;
+		double lookupCount; // Mean density lookups per estimate
+	};
+
+	Estimate EstimateTransmittance(
+		const en::DensityGrid& grid,
+		const glm::vec3& start,
+		const glm::vec3& end,
+		uint32_t sampleCount,
+		bool residual = true)
+	{
+		double sum = 0.0;
+		double sumSq = 0.0;
+		uint64_t lookupSum = 0;
+		for (uint32_t s = 0; s < sampleCount; s++)
+		{
+			en::Random random(s % 1024, s / 1024, 0, 0);
+			random.SetBounce(0);
+			uint32_t lookupCount;
+			const double value = residual
+				? grid.ResidualRatioTrack(c_BoxSize, c_DensityFactor, start, end, random, &lookupCount)
+				: grid.RatioTrack(c_BoxSize, c_DensityFactor, start, end, random, &lookupCount);
+			sum += value;
+			sumSq += value * value;
+			lookupSum += lookupCount;
+		}
+
+		const double mean = sum / sampleCount;
+		const double variance = std::max((sumSq / sampleCount) - (mean * mean), 0.0);
+		return { mean, std::sqrt(variance / sampleCount), variance, static_cast<double>(lookupSum) / sampleCount };
+	}
+
+	double OpticalDepthX(const std::function<float(uint32_t)>& densityAtX, uint32_t beginX, uint32_t endX)
+	{
+		double opticalDepth = 0.0;
+		const double voxelLength = c_BoxSize.x / c_SizeX;
+		for (uint32_t x = beginX; x < endX; x++) { opticalDepth += StoredDensity(densityAtX(x)) * voxelLength; }
+		return opticalDepth;
+	}
+}
+
+TEST(DensityGridTest, ControlAndMajorant)
+{
+	const en::DensityGrid grid(MakeDensityX([](uint32_t x) { return x < 1300 ? 0.2f : 0.8f; }));
+	EXPECT_EQ(grid.GetCellCount(), glm::ivec3(163, 1, 1));
+
+	// Cell 81 covers voxels 1296 to 1311 and holds the step
+	const uint8_t low = static_cast<uint8_t>(0.2f * 255.0f);
+	const uint8_t high = static_cast<uint8_t>(0.8f * 255.0f);
+	EXPECT_EQ(grid.GetControl(glm::ivec3(0, 0, 0)), low);
+	EXPECT_EQ(grid.GetResidualMajorant(glm::ivec3(0, 0, 0)), 0);
+	EXPECT_EQ(grid.GetControl(glm::ivec3(162, 0, 0)), high);
+	EXPECT_GT(grid.GetResidualMajorant(glm::ivec3(81, 0, 0)), 0);
+	EXPECT_GE(grid.GetControl(glm::ivec3(81, 0, 0)) + grid.GetResidualMajorant(glm::ivec3(81, 0, 0)), high);
+	EXPECT_LE(grid.GetControl(glm::ivec3(81, 0, 0)) - grid.GetResidualMajorant(glm::ivec3(81, 0, 0)), low);
+}
+
+TEST(DensityGridTest, HomogeneousMatchesAnalytic)
+{
+	const en::DensityGrid grid(MakeDensityX([](uint32_t) { return 0.1f; }));
+	en::Random random(0, 0, 0, 0);
+	random.SetBounce(0);
+
+	// Through all 163 cells. Zero residual, so the estimate is exact
+	const glm::vec3 start(-20.0f, 0.0f, 0.0f);
+	const glm::vec3 end(20.0f, 0.0f, 0.0f);
+	const float expected = std::exp(-StoredDensity(0.1f) * c_BoxSize.x);
+	EXPECT_NEAR(grid.ResidualRatioTrack(c_BoxSize, c_DensityFactor, start, end, random), expected, 1e-4f);
+
+	// Segment ending inside the volume
+	const glm::vec3 inside(1.5f, 0.0f, 0.0f);
+	EXPECT_NEAR(grid.ResidualRatioTrack(c_BoxSize, c_DensityFactor, start, inside, random), std::exp(-StoredDensity(0.1f) * 14.5f), 1e-4f);
+
+	// Missing the volume
+	EXPECT_EQ(grid.ResidualRatioTrack(c_BoxSize, c_DensityFactor, glm::vec3(-20.0f, 1.0f, 0.0f), glm::vec3(20.0f, 1.0f, 0.0f), random), 1.0f);
+}
+
+TEST(DensityGridTest, StepMatchesAnalytic)
+{
+	// The steps do not line up with the 16 voxel cells, so those cells are ratio tracked
+	const auto densityAtX = [](uint32_t x) { return (x / 150) % 2 == 0 ? 0.05f : 0.3f; };
+	const en::DensityGrid grid(MakeDensityX(densityAtX));
+
+	const double expected = std::exp(-OpticalDepthX(densityAtX, 0, c_SizeX));
+
+	const Estimate estimate = EstimateTransmittance(grid, glm::vec3(-20.0f, 0.0f, 0.0f), glm::vec3(20.0f, 0.0f, 0.0f), 1 << 16);
+	EXPECT_GT(estimate.stdError, 0.0);
+	EXPECT_NEAR(estimate.mean, expected, 4.0 * estimate.stdError);
+
+	// Oblique through a few cells
+	const glm::vec3 start(-2.0f, -0.02f, 0.0f);
+	const glm::vec3 end(2.0f, 0.02f, 0.0f);
+	const double obliqueDepth = OpticalDepthX(densityAtX, 1100, 1500) * glm::distance(start, end) / 4.0;
+	const Estimate oblique = EstimateTransmittance(grid, start, end, 1 << 16);
+	EXPECT_NEAR(oblique.mean, std::exp(-obliqueDepth), 4.0 * oblique.stdError + 1e-4);
+}
+
+// Residual ratio tracking against plain ratio tracking with the global majorant (RatioTrack with
+// RESIDUAL_RATIO_TRACKING off), both unbiased, compared by variance and density lookups per estimate
+TEST(DensityGridTest, ResidualBeatsRatioTracking)
+{
+	const std::vector<std::function<float(uint32_t)>> fields = {
+		[](uint32_t x) { return (x / 150) % 2 == 0 ? 0.05f : 0.3f; },
+		[](uint32_t x) { return 0.5f + (0.4f * std::sin(static_cast<float>(x) * 0.01f)); } };
+
+	// From face to face, like the entry and exit points the shaders track between
+	const glm::vec3 start(-c_BoxSize.x / 2.0f, 0.0f, 0.0f);
+	const glm::vec3 end(c_BoxSize.x / 2.0f, 0.0f, 0.0f);
+	for (size_t i = 0; i < fields.size(); i++)
+	{
+		const en::DensityGrid grid(MakeDensityX(fields[i]));
+		const double expected = std::exp(-OpticalDepthX(fields[i], 0, c_SizeX));
+
+		const Estimate residual = EstimateTransmittance(grid, start, end, 1 << 16, true);
+		const Estimate ratio = EstimateTransmittance(grid, start, end, 1 << 16, false);
+		std::cout
+			<< "field " << i << " expected " << expected
+			<< " | residual mean " << residual.mean << " variance " << residual.variance << " lookups " << residual.lookupCount
+			<< " | ratio mean " << ratio.mean << " variance " << ratio.variance << " lookups " << ratio.lookupCount << std::endl;
+
+		EXPECT_NEAR(residual.mean, expected, 4.0 * residual.stdError + 1e-4);
+		EXPECT_NEAR(ratio.mean, expected, 4.0 * ratio.stdError + 1e-4);
+
+		EXPECT_LT(residual.variance, ratio.variance) << "field " << i;
+		EXPECT_LT(residual.lookupCount, ratio.lookupCount) << "field " << i;
+	}
+}
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include <engine/util/EnvMapDistribution.hpp>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	const float c_Pi = 3.14159265f;
+
+	// Deterministic bright spots on a dim gradient
+	std::vector<float> MakeEnvMap(uint32_t width, uint32_t height)
+	{
+		std::vector<float> hdr4f(width * height * 4);
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				float value = 0.05f + (0.01f * static_cast<float>(x % 7)) + (0.02f * static_cast<float>(y));
+				if (x == 5 && y == 11) { value = 500.0f; }
+				if (x == 40 && y == 2) { value = 50.0f; }
+				if (y == 6) { value = 0.0f; }
+				for (uint32_t c = 0; c < 3; c++) { hdr4f[((y * width) + x) * 4 + c] = value; }
+				hdr4f[((y * width) + x) * 4 + 3] = 1.0f;
+			}
+		}
+		return hdr4f;
+	}
+
+	// Mirror of hg_phase_func in dir_gen.glsl divided by 2 pi, the solid angle pdf of NewRayDir(dir, true)
+	float HgPdf(float cosTheta, float g)
+	{
+		const float g2 = g * g;
+		return 0.5f * (1.0f - g2) / std::pow(1.0f + g2 - (2.0f * g * cosTheta), 1.5f) / (2.0f * c_Pi);
+	}
+
+	// Nearest texel of the env map, the test maps are gray
+	float EnvMapRadiance(const std::vector<float>& hdr4f, uint32_t width, uint32_t height, const glm::vec3& dir)
+	{
+		const glm::vec2 uv = en::EnvMapDistribution::DirToUv(dir);
+		const uint32_t x = std::min(static_cast<uint32_t>(std::max(uv.x * static_cast<float>(width), 0.0f)), width - 1);
+		const uint32_t y = std::min(static_cast<uint32_t>(std::max(uv.y * static_cast<float>(height), 0.0f)), height - 1);
+		return hdr4f[((y * width) + x) * 4];
+	}
+
+	// HG distributed direction around dir, same cosTheta as NewRayDir(dir, true) in dir_gen.glsl
+	glm::vec3 SampleHg(const glm::vec3& dir, float g, en::Random& random)
+	{
+		const float sqrTerm = (1.0f - (g * g)) / (1.0f - g + (2.0f * g * random.NextFloat()));
+		const float cosTheta = (1.0f + (g * g) - (sqrTerm * sqrTerm)) / (2.0f * g);
+		const float sinTheta = std::sqrt(std::max(1.0f - (cosTheta * cosTheta), 0.0f));
+		const float phi = random.NextFloat(2.0f * c_Pi);
+
+		const glm::vec3 orthoDir = glm::normalize(dir.z < dir.x ? glm::vec3(dir.y, -dir.x, 0.0f) : glm::vec3(0.0f, -dir.z, dir.y));
+		const glm::vec3 bitangent = glm::cross(dir, orthoDir);
+		return glm::normalize((cosTheta * dir) + (sinTheta * ((std::cos(phi) * orthoDir) + (std::sin(phi) * bitangent))));
+	}
+
+	struct EstimatorStats
+	{
+		double mean;
+		double variance;
+	};
+
+	template<typename F>
+	EstimatorStats RunEstimator(F sample, uint32_t sampleCount)
+	{
+		double sum = 0.0;
+		double sqrSum = 0.0;
+		for (uint32_t i = 0; i < sampleCount; i++)
+		{
+			en::Random random(i, 0, 0, 5);
+			random.SetBounce(0);
+			const double value = sample(random);
+			sum += value;
+			sqrSum += value * value;
+		}
+
+		const double mean = sum / sampleCount;
+		return { mean, (sqrSum / sampleCount) - (mean * mean) };
+	}
+
+	// Midpoint rule over latitude and azimuth. The solid angle of a cell is cos(latitude) dLatitude dPhi
+	template<typename F>
+	double IntegrateSphere(F f, uint32_t phiCount, uint32_t latCount)
+	{
+		const double dPhi = 2.0 * c_Pi / phiCount;
+		const double dLat = c_Pi / latCount;
+		double sum = 0.0;
+		for (uint32_t i = 0; i < latCount; i++)
+		{
+			const float lat = -0.5f * c_Pi + (c_Pi * (static_cast<float>(i) + 0.5f) / static_cast<float>(latCount));
+			const double cellSolidAngle = std::cos(lat) * dLat * dPhi;
+			for (uint32_t j = 0; j < phiCount; j++)
+			{
+				const float phi = 2.0f * c_Pi * (static_cast<float>(j) + 0.5f) / static_cast<float>(phiCount);
+				sum += f(glm::vec3(std::cos(lat) * std::cos(phi), std::sin(lat), std::cos(lat) * std::sin(phi))) * cellSolidAngle;
+			}
+		}
+		return sum;
+	}
+}
+
+TEST(EnvMapDistributionTest, CdfsEndAtOne)
+{
+	const uint32_t width = 64;
+	const uint32_t height = 16;
+	const en::EnvMapDistribution distribution(MakeEnvMap(width, height), width, height);
+
+	EXPECT_NEAR(distribution.GetCdfY().back(), 1.0f, 1e-6f);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		EXPECT_NEAR(distribution.GetCdfX()[(y * width) + width - 1], 1.0f, 1e-6f);
+	}
+}
+
+TEST(EnvMapDistributionTest, PdfIntegratesToOne)
+{
+	const uint32_t width = 64;
+	const uint32_t height = 16;
+	const en::EnvMapDistribution distribution(MakeEnvMap(width, height), width, height);
+
+	const double integral = IntegrateSphere([&](const glm::vec3& dir) { return distribution.Pdf(dir); }, 2048, 2048);
+	EXPECT_NEAR(integral, 1.0, 2e-3);
+}
+
+TEST(EnvMapDistributionTest, BlackMapFallsBackToUniform)
+{
+	const uint32_t width = 8;
+	const uint32_t height = 4;
+	const en::EnvMapDistribution distribution(std::vector<float>(width * height * 4, 0.0f), width, height);
+
+	const double integral = IntegrateSphere([&](const glm::vec3& dir) { return distribution.Pdf(dir); }, 512, 512);
+	EXPECT_NEAR(integral, 1.0, 2e-3);
+}
+
+// One sample MIS in SampleHdrEnvMap picks either strategy with probability 1/2 and divides by misPdf = (pEnv + pPhase) / 2
+TEST(EnvMapDistributionTest, MisWeightsSumToOne)
+{
+	const uint32_t width = 64;
+	const uint32_t height = 16;
+	const en::EnvMapDistribution distribution(MakeEnvMap(width, height), width, height);
+	const glm::vec3 viewDir = glm::normalize(glm::vec3(0.3f, -0.5f, 0.8f));
+	const float g = 0.8f;
+
+	EXPECT_NEAR(IntegrateSphere([&](const glm::vec3& dir) { return HgPdf(glm::dot(dir, viewDir), g); }, 2048, 2048), 1.0, 2e-3);
+
+	// Directions with misPdf == 0 are skipped by the shader and would bias the estimate
+	double maxWeightError = 0.0;
+	const double coveredSolidAngle = IntegrateSphere([&](const glm::vec3& lightDir)
+		{
+			const float envPdf = distribution.Pdf(lightDir);
+			const float phasePdf = HgPdf(glm::dot(lightDir, viewDir), g);
+			const float misPdf = 0.5f * (envPdf + phasePdf);
+			if (misPdf <= 0.0f) { return 0.0f; }
+
+			const double envWeight = 0.5 * envPdf / misPdf;
+			const double phaseWeight = 0.5 * phasePdf / misPdf;
+			maxWeightError = std::max(maxWeightError, std::abs(envWeight + phaseWeight - 1.0));
+			return 1.0f;
+		}, 1024, 1024);
+
+	EXPECT_LT(maxWeightError, 1e-6);
+	EXPECT_NEAR(coveredSolidAngle, 4.0 * c_Pi, 1e-3);
+}
+
+TEST(EnvMapDistributionTest, SampleDirFollowsPdf)
+{
+	const uint32_t width = 64;
+	const uint32_t height = 16;
+	const std::vector<float> hdr4f = MakeEnvMap(width, height);
+	const en::EnvMapDistribution distribution(hdr4f, width, height);
+
+	// E[f / pdf] over env map samples is the integral of f for any f that is zero where the pdf is zero
+	const EstimatorStats stats = RunEstimator([&](en::Random& random)
+		{
+			const glm::vec3 dir = distribution.SampleDir(random);
+			return EnvMapRadiance(hdr4f, width, height, dir) / distribution.Pdf(dir);
+		}, 1 << 16);
+	const double integral = IntegrateSphere([&](const glm::vec3& dir) { return EnvMapRadiance(hdr4f, width, height, dir); }, 2048, 2048);
+
+	EXPECT_NEAR(stats.mean, integral, (5.0 * std::sqrt(stats.variance / (1 << 16))) + (1e-3 * integral));
+}
+
+// Variance per sample of the env map in-scattering estimator of SampleHdrEnvMap against uniform sphere sampling at the
+// same scale (phase * radiance / (4 pi pdf)). Visibility is left out, so the expected value is known by quadrature
+TEST(EnvMapDistributionTest, MisReducesVariancePerSample)
+{
+	const uint32_t width = 64;
+	const uint32_t height = 16;
+	const std::vector<float> hdr4f = MakeEnvMap(width, height);
+	const en::EnvMapDistribution distribution(hdr4f, width, height);
+	const glm::vec3 viewDir = glm::normalize(glm::vec3(0.3f, -0.5f, 0.8f));
+	const uint32_t sampleCount = 1 << 18;
+
+	for (const float g : { 0.2f, 0.8f })
+	{
+		const auto phase = [&](const glm::vec3& lightDir) { return 2.0f * c_Pi * HgPdf(glm::dot(lightDir, viewDir), g); };
+
+		const EstimatorStats uniform = RunEstimator([&](en::Random& random)
+			{
+				const float cosTheta = 1.0f - (2.0f * random.NextFloat());
+				const float sinTheta = std::sqrt(std::max(1.0f - (cosTheta * cosTheta), 0.0f));
+				const float phi = random.NextFloat(2.0f * c_Pi);
+				const glm::vec3 lightDir(sinTheta * std::cos(phi), cosTheta, sinTheta * std::sin(phi));
+				return EnvMapRadiance(hdr4f, width, height, lightDir) * phase(lightDir);
+			}, sampleCount);
+
+		const EstimatorStats mis = RunEstimator([&](en::Random& random)
+			{
+				const glm::vec3 lightDir = random.NextFloat() < 0.5f ? distribution.SampleDir(random) : SampleHg(viewDir, g, random);
+				const float misPdf = 0.5f * (distribution.Pdf(lightDir) + HgPdf(glm::dot(lightDir, viewDir), g));
+				if (misPdf <= 0.0f) { return 0.0f; }
+				return EnvMapRadiance(hdr4f, width, height, lightDir) * phase(lightDir) / (4.0f * c_Pi * misPdf);
+			}, sampleCount);
+
+		const double expected = IntegrateSphere(
+			[&](const glm::vec3& lightDir) { return EnvMapRadiance(hdr4f, width, height, lightDir) * phase(lightDir) / (4.0f * c_Pi); },
+			2048,
+			2048);
+
+		std::cout
+			<< "g " << g << " expected " << expected << " | uniform mean " << uniform.mean << " variance " << uniform.variance
+			<< " | MIS mean " << mis.mean << " variance " << mis.variance << std::endl;
+
+		// Both are unbiased within 5 standard errors (plus the quadrature error of the reference)
+		EXPECT_NEAR(uniform.mean, expected, (5.0 * std::sqrt(uniform.variance / sampleCount)) + (1e-3 * expected));
+		EXPECT_NEAR(mis.mean, expected, (5.0 * std::sqrt(mis.variance / sampleCount)) + (1e-3 * expected));
+
+		// Both estimators cost one visibility ray per sample, so variance per sample decides
+		EXPECT_LT(mis.variance, 0.1 * uniform.variance) << "g " << g;
+	}
+}
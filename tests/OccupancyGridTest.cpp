@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+#include <engine/util/OccupancyGrid.hpp>
+#include <engine/util/RayBox.hpp>
+#include <engine/util/Random.hpp>
+#include <array>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// 0.1 voxels, neither side is a multiple of the coarse brick size
+	const uint32_t c_SizeX = 72;
+	const uint32_t c_SizeY = 48;
+	const uint32_t c_SizeZ = 40;
+	const glm::vec3 c_BoxSize(7.2f, 4.8f, 4.0f);
+
+	// Tentative collisions per unit length of the majorant, two per voxel on average
+	const float c_MaxDensity = 20.0f;
+	const uint32_t c_RayCount = 4096;
+
+	// A few noisy blobs, so both levels contain empty bricks. Some voxels are below the 8 bit step and read as 0
+	std::vector<std::vector<std::vector<float>>> MakeDensity()
+	{
+		const std::array<glm::vec4, 4> blobs = {
+			glm::vec4(12.0f, 10.0f, 9.0f, 7.0f),
+			glm::vec4(50.0f, 30.0f, 20.0f, 9.0f),
+			glm::vec4(30.0f, 40.0f, 33.0f, 5.0f),
+			glm::vec4(66.0f, 8.0f, 36.0f, 4.0f) };
+
+		std::vector<std::vector<std::vector<float>>> density(
+			c_SizeX,
+			std::vector<std::vector<float>>(c_SizeY, std::vector<float>(c_SizeZ, 0.0f)));
+		for (uint32_t x = 0; x < c_SizeX; x++)
+		{
+			for (uint32_t y = 0; y < c_SizeY; y++)
+			{
+				for (uint32_t z = 0; z < c_SizeZ; z++)
+				{
+					bool inside = false;
+					for (const glm::vec4& blob : blobs)
+					{
+						inside |= glm::distance(glm::vec3(x, y, z), glm::vec3(blob.x, blob.y, blob.z)) < blob.w;
+					}
+					if (!inside) { continue; }
+
+					en::Random random(x, y, z, 0);
+					random.SetBounce(0);
+					const float value = random.NextFloat();
+					if (value < 0.4f) { continue; }
+					density[x][y][z] = value < 0.5f ? 0.5f / 255.0f : value;
+				}
+			}
+		}
+		return density;
+	}
+
+	// Nearest lookup of the 8 bit density texture with a black border
+	float GetDensity(const std::vector<std::vector<std::vector<float>>>& density, const glm::vec3& pos)
+	{
+		const glm::vec3 voxelPos = (pos + (c_BoxSize / 2.0f)) * (glm::vec3(c_SizeX, c_SizeY, c_SizeZ) / c_BoxSize);
+		const glm::vec3 voxel = glm::floor(voxelPos);
+		if (voxel.x < 0.0f || voxel.y < 0.0f || voxel.z < 0.0f) { return 0.0f; }
+		if (voxel.x >= c_SizeX || voxel.y >= c_SizeY || voxel.z >= c_SizeZ) { return 0.0f; }
+
+		const float value = density[static_cast<uint32_t>(voxel.x)][static_cast<uint32_t>(voxel.y)][static_cast<uint32_t>(voxel.z)];
+		return static_cast<float>(static_cast<uint8_t>(value * 255.0f)) / 255.0f;
+	}
+
+	// Fixed tentative collisions (distance, acceptance sample) of the majorant along one ray. Delta tracking draws
+	// them on the fly, fixing them makes the dense and the skipping tracker comparable collision by collision
+	std::vector<glm::vec2> MakeTentativeCollisions(uint32_t rayIndex, float tMax)
+	{
+		en::Random random(rayIndex, 0, 0, 2);
+		random.SetBounce(0);
+
+		std::vector<glm::vec2> collisions;
+		float t = 0.0f;
+		while (true)
+		{
+			t -= std::log(1.0f - random.NextFloat()) / c_MaxDensity;
+			if (t >= tMax) { break; }
+			collisions.push_back(glm::vec2(t, random.NextFloat()));
+		}
+		return collisions;
+	}
+
+	// Index of the accepted collision or collisions.size() if the ray leaves the volume. Same loop as DeltaTrack in
+	// path_trace.glsl over a common list of tentative collisions, the occupancy grid restarts the search behind empty
+	// space. Only checks that skipping never jumps over an occupied voxel
+	size_t Track(
+		const std::vector<std::vector<std::vector<float>>>& density,
+		const en::OccupancyGrid* grid,
+		const glm::vec3& ro,
+		const glm::vec3& rd,
+		float tMax,
+		const std::vector<glm::vec2>& collisions,
+		uint32_t& lookupCount)
+	{
+		float t = 0.0f;
+		size_t next = 0;
+		while (true)
+		{
+			if (grid != nullptr) { t = grid->SkipEmptySpace(c_BoxSize, ro, rd, t, tMax); }
+			while (next < collisions.size() && collisions[next].x < t) { next++; }
+			if (next == collisions.size()) { return next; }
+
+			t = collisions[next].x;
+			lookupCount++;
+			if (GetDensity(density, ro + (t * rd)) > collisions[next].y) { return next; }
+			next++;
+		}
+	}
+
+	// DeltaTrack of path_trace.glsl with the same use of random numbers. Skipping draws the next free flight behind
+	// the empty space instead of the tentative collisions inside it, so both variants only agree in distribution.
+	// Returns the collision distance or tMax if the ray leaves the volume
+	float DeltaTrack(
+		const std::vector<std::vector<std::vector<float>>>& density,
+		const en::OccupancyGrid* grid,
+		float maxDensity,
+		const glm::vec3& ro,
+		const glm::vec3& rd,
+		float tMax,
+		en::Random& random,
+		uint32_t& lookupCount)
+	{
+		const float invMaxDensity = 1.0f / maxDensity;
+		float t = 0.0f;
+		for (uint32_t i = 0; i < 128; i++)
+		{
+			if (grid != nullptr) { t = grid->SkipEmptySpace(c_BoxSize, ro, rd, t, tMax); }
+			t -= std::log(1.0f - random.NextFloat()) * invMaxDensity;
+			if (t >= tMax) { return tMax; }
+			lookupCount++;
+			if (GetDensity(density, ro + (t * rd)) > random.NextFloat()) { return t; }
+		}
+		return random.NextFloat(tMax);
+	}
+
+	// Transmittance from the ray origin to each of stepCount + 1 evenly spaced distances up to tMax, midpoint rule
+	std::vector<double> IntegrateTransmittance(
+		const std::vector<std::vector<std::vector<float>>>& density,
+		float maxDensity,
+		const glm::vec3& ro,
+		const glm::vec3& rd,
+		float tMax,
+		uint32_t stepCount)
+	{
+		std::vector<double> transmittance(stepCount + 1, 1.0);
+		const double dt = tMax / stepCount;
+		double opticalDepth = 0.0;
+		for (uint32_t i = 0; i < stepCount; i++)
+		{
+			const float t = static_cast<float>((i + 0.5) * dt);
+			opticalDepth += maxDensity * GetDensity(density, ro + (t * rd)) * dt;
+			transmittance[i + 1] = std::exp(-opticalDepth);
+		}
+		return transmittance;
+	}
+}
+
+TEST(OccupancyGridTest, SkippingFindsDenseCollisions)
+{
+	const std::vector<std::vector<std::vector<float>>> density = MakeDensity();
+	const en::OccupancyGrid grid(density);
+	ASSERT_GT(grid.GetOccupiedFraction(0), 0.05f);
+	ASSERT_LT(grid.GetOccupiedFraction(0), 0.6f);
+	ASSERT_LT(grid.GetOccupiedFraction(1), 1.0f);
+
+	uint32_t denseLookupCount = 0;
+	uint32_t skipLookupCount = 0;
+	uint32_t collisionCount = 0;
+	for (uint32_t rayIndex = 0; rayIndex < c_RayCount; rayIndex++)
+	{
+		en::Random random(rayIndex, 0, 0, 3);
+		random.SetBounce(0);
+
+		// Origins outside and inside the volume, every eighth ray is axis parallel
+		const glm::vec3 target = (glm::vec3(random.NextFloat(), random.NextFloat(), random.NextFloat()) - glm::vec3(0.5f)) * c_BoxSize;
+		glm::vec3 ro = (glm::vec3(random.NextFloat(), random.NextFloat(), random.NextFloat()) - glm::vec3(0.5f)) * c_BoxSize * 3.0f;
+		if (rayIndex % 8 == 0) { ro = target - glm::vec3(0.0f, 0.0f, c_BoxSize.z); }
+		const glm::vec3 rd = glm::normalize(target - ro);
+
+		glm::vec2 tBox;
+		if (!en::RayBox::Intersect(glm::vec3(0.0f), c_BoxSize, ro, rd, tBox)) { continue; }
+
+		const std::vector<glm::vec2> collisions = MakeTentativeCollisions(rayIndex, tBox.y);
+		const size_t dense = Track(density, nullptr, ro, rd, tBox.y, collisions, denseLookupCount);
+		const size_t skip = Track(density, &grid, ro, rd, tBox.y, collisions, skipLookupCount);
+		ASSERT_EQ(skip, dense) << "ray " << rayIndex;
+		if (dense < collisions.size()) { collisionCount++; }
+	}
+
+	// The test is only meaningful if rays collide and skipping saves work
+	EXPECT_GT(collisionCount, c_RayCount / 8);
+	EXPECT_LT(skipLookupCount, denseLookupCount / 2);
+}
+
+// The shader DeltaTrack with and without skipping, each against the exact free flight distribution along fixed rays:
+// escape probability T(tMax) and the collision distance cdf (1 - T(t)) / (1 - T(tMax)) by a Kolmogorov-Smirnov test
+TEST(OccupancyGridTest, SkippingKeepsCollisionDistribution)
+{
+	const std::vector<std::vector<std::vector<float>>> density = MakeDensity();
+	const en::OccupancyGrid grid(density);
+
+	// Few enough tentative collisions per ray that the 128 step limit of DeltaTrack is never reached
+	const float maxDensity = 4.0f;
+	const uint32_t rayCount = 16;
+	const uint32_t sampleCount = 8192;
+	const uint32_t stepCount = 8192;
+
+	uint32_t denseLookupCount = 0;
+	uint32_t skipLookupCount = 0;
+	for (uint32_t rayIndex = 0; rayIndex < rayCount; rayIndex++)
+	{
+		// Through the blob centers, so every ray crosses empty and occupied space
+		const glm::vec3 voxelSize = c_BoxSize / glm::vec3(c_SizeX, c_SizeY, c_SizeZ);
+		const glm::vec3 blobA = (glm::vec3(12.5f, 10.5f, 9.5f) * voxelSize) - (c_BoxSize / 2.0f);
+		const glm::vec3 blobB = (glm::vec3(50.5f, 30.5f, 20.5f) * voxelSize) - (c_BoxSize / 2.0f);
+		en::Random rayRandom(rayIndex, 0, 0, 8);
+		rayRandom.SetBounce(0);
+		const glm::vec3 jitter = (glm::vec3(rayRandom.NextFloat(), rayRandom.NextFloat(), rayRandom.NextFloat()) - glm::vec3(0.5f)) * 0.6f;
+		const glm::vec3 rd = glm::normalize(blobB - blobA + jitter);
+		const glm::vec3 ro = blobA - (rd * glm::length(c_BoxSize));
+
+		glm::vec2 tBox;
+		ASSERT_TRUE(en::RayBox::Intersect(glm::vec3(0.0f), c_BoxSize, ro, rd, tBox));
+		const std::vector<double> transmittance = IntegrateTransmittance(density, maxDensity, ro, rd, tBox.y, stepCount);
+		const double escape = transmittance.back();
+		ASSERT_LT(escape, 0.9) << "ray " << rayIndex;
+
+		for (const en::OccupancyGrid* trackGrid : { static_cast<const en::OccupancyGrid*>(nullptr), &grid })
+		{
+			std::vector<float> collisions;
+			uint32_t& lookupCount = trackGrid == nullptr ? denseLookupCount : skipLookupCount;
+			for (uint32_t sampleIndex = 0; sampleIndex < sampleCount; sampleIndex++)
+			{
+				en::Random random(rayIndex, sampleIndex, 0, 9);
+				random.SetBounce(0);
+				const float t = DeltaTrack(density, trackGrid, maxDensity, ro, rd, tBox.y, random, lookupCount);
+				if (t < tBox.y) { collisions.push_back(t); }
+			}
+
+			const char* name = trackGrid == nullptr ? "dense" : "skipping";
+			const double escapeFraction = 1.0 - (static_cast<double>(collisions.size()) / sampleCount);
+			EXPECT_NEAR(escapeFraction, escape, 5.0 * std::sqrt(escape * (1.0 - escape) / sampleCount)) << name << " ray " << rayIndex;
+
+			std::sort(collisions.begin(), collisions.end());
+			double maxCdfError = 0.0;
+			for (size_t i = 0; i < collisions.size(); i++)
+			{
+				const double stepPos = collisions[i] / tBox.y * stepCount;
+				const size_t step = std::min(static_cast<size_t>(stepPos), static_cast<size_t>(stepCount - 1));
+				const double tr = transmittance[step] + ((transmittance[step + 1] - transmittance[step]) * (stepPos - step));
+				const double cdf = (1.0 - tr) / (1.0 - escape);
+				maxCdfError = std::max(maxCdfError, std::max(
+					std::abs(cdf - (static_cast<double>(i) / collisions.size())),
+					std::abs(cdf - (static_cast<double>(i + 1) / collisions.size()))));
+			}
+
+			// Critical value for a significance level of about 1e-4
+			EXPECT_LT(maxCdfError, 2.2 / std::sqrt(static_cast<double>(collisions.size()))) << name << " ray " << rayIndex;
+		}
+	}
+
+	EXPECT_LT(skipLookupCount, denseLookupCount);
+}
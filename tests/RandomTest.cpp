@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <engine/util/Random.hpp>
+
+// Known answers for pcg4d in data/shader/include/random.glsl. Changing the hash or the key layout breaks
+// reproducibility against stored reference images, so these values must only change deliberately.
+
+TEST(RandomTest, Pcg4dKnownAnswers)
+{
+	const std::array<uint32_t, 4> zero = en::Random::Pcg4d({ 0u, 0u, 0u, 0u });
+	EXPECT_EQ(zero, (std::array<uint32_t, 4>{ 0x0F02F829u, 0x2D568769u, 0x32B0C43Bu, 0xD32548EAu }));
+
+	const std::array<uint32_t, 4> seq = en::Random::Pcg4d({ 1u, 2u, 3u, 4u });
+	EXPECT_EQ(seq, (std::array<uint32_t, 4>{ 0x3622CD16u, 0xF11471D8u, 0xE1109B3Fu, 0x02B94C2Fu }));
+
+	const std::array<uint32_t, 4> ones = en::Random::Pcg4d({ 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu });
+	EXPECT_EQ(ones, (std::array<uint32_t, 4>{ 0x974ED892u, 0xC015DC67u, 0x9F955760u, 0xA1BBA208u }));
+}
+
+// Key layout is ((y << 16) | x, frame, (view << 24) | (sample << 16) | bounce, dim)
+TEST(RandomTest, KeyLayout)
+{
+	en::Random first(17, 42, 3, 1);
+	first.SetBounce(0);
+	EXPECT_EQ(first.NextUint(), en::Random::Pcg4d({ 0x002A0011u, 3u, 0x00010000u, 0u })[0]);
+	EXPECT_EQ(first.NextUint(), en::Random::Pcg4d({ 0x002A0011u, 3u, 0x00010000u, 1u })[0]);
+
+	en::Random bounce(17, 42, 3, 1);
+	bounce.SetBounce(0);
+	EXPECT_EQ(bounce.NextUint(), 0xA8885C59u);
+	bounce.SetBounce(2);
+	for (uint32_t dim = 0; dim < 5; dim++) { bounce.NextUint(); }
+	EXPECT_EQ(bounce.NextUint(), 0x7DA85D11u);
+
+	en::Random corner(1919, 1079, 1000, 7);
+	corner.SetBounce(4);
+	corner.NextUint();
+	EXPECT_EQ(corner.NextUint(), 0xD28EBE4Cu);
+
+	// Views of a multi view frame get their own streams, view 0 keeps the single view key
+	en::Random view(17, 42, 3, 1, 2);
+	view.SetBounce(0);
+	EXPECT_EQ(view.NextUint(), en::Random::Pcg4d({ 0x002A0011u, 3u, 0x02010000u, 0u })[0]);
+	EXPECT_EQ(en::Random(17, 42, 3, 1, 0).NextUint(), en::Random(17, 42, 3, 1).NextUint());
+}
+
+TEST(RandomTest, SetBounceRestartsDimensions)
+{
+	en::Random a(5, 6, 7, 0);
+	a.SetBounce(1);
+	const uint32_t firstPass = a.NextUint();
+	a.NextUint();
+	a.SetBounce(1);
+	EXPECT_EQ(a.NextUint(), firstPass);
+}
+
+TEST(RandomTest, UnitFloatRange)
+{
+	EXPECT_EQ(en::Random::UintToUnitFloat(0u), 0.0f);
+	EXPECT_LT(en::Random::UintToUnitFloat(0xFFFFFFFFu), 1.0f);
+	EXPECT_GE(en::Random::UintToUnitFloat(0xFFFFFFFFu), 0.99f);
+
+	en::Random random(0, 0, 0, 0);
+	random.SetBounce(0);
+	for (int i = 0; i < 1000; i++)
+	{
+		const float f = random.NextFloat(4.0f);
+		EXPECT_GE(f, 0.0f);
+		EXPECT_LT(f, 4.0f);
+	}
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <engine/util/RayBox.hpp>
+#include <engine/util/Random.hpp>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+	// Unit cube around the origin
+	const glm::vec3 c_BoxPos(0.0f);
+	const glm::vec3 c_BoxSize(1.0f);
+
+	// Volume of the cloud scenes and the ray distance limits of nrc-constants.glsl
+	const glm::vec3 c_CloudSize = glm::vec3(125.0f, 85.0f, 153.0f) / 2.0f;
+	const float c_MaxRayDistance = 100000.0f;
+	const float c_MinRayDistance = 0.125f;
+
+	float SkySdf(const glm::vec3& pos)
+	{
+		const glm::vec3 d = glm::abs(pos) - (c_CloudSize / 2.0f);
+		return glm::length(glm::max(d, glm::vec3(0.0f))) + glm::min(glm::max(d.x, glm::max(d.y, d.z)), 0.0f);
+	}
+
+	// find_entry_exit of volume.glsl before the slab test, sphere traces sky_sdf from both sides. Returns the number
+	// of sky_sdf evaluations
+	uint32_t SphereTraceEntryExit(glm::vec3 ro, glm::vec3 rd, glm::vec3& entry, glm::vec3& exit)
+	{
+		uint32_t sdfCount = 0;
+		float dist;
+		do
+		{
+			dist = SkySdf(ro);
+			ro += dist * rd;
+			sdfCount++;
+		} while (dist > c_MinRayDistance && dist < c_MaxRayDistance);
+		entry = ro;
+
+		ro += rd * glm::length(2.0f * c_CloudSize);
+		rd *= -1.0f;
+		do
+		{
+			dist = SkySdf(ro);
+			ro += dist * rd;
+			sdfCount++;
+		} while (dist > c_MinRayDistance && dist < c_MaxRayDistance);
+		exit = ro;
+
+		return sdfCount;
+	}
+}
+
+TEST(RayBoxTest, FrontalHit)
+{
+	glm::vec2 t;
+	ASSERT_TRUE(en::RayBox::Intersect(c_BoxPos, c_BoxSize, glm::vec3(-2.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), t));
+	EXPECT_FLOAT_EQ(t.x, 1.5f);
+	EXPECT_FLOAT_EQ(t.y, 2.5f);
+}
+
+TEST(RayBoxTest, OriginInside)
+{
+	glm::vec2 t;
+	ASSERT_TRUE(en::RayBox::Intersect(c_BoxPos, c_BoxSize, glm::vec3(0.25f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), t));
+	EXPECT_FLOAT_EQ(t.x, 0.0f);
+	EXPECT_FLOAT_EQ(t.y, 0.75f);
+}
+
+TEST(RayBoxTest, PointingAway)
+{
+	glm::vec2 t(-7.0f, -7.0f);
+	EXPECT_FALSE(en::RayBox::Intersect(c_BoxPos, c_BoxSize, glm::vec3(-2.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), t));
+	EXPECT_FALSE(en::RayBox::Intersect(c_BoxPos, c_BoxSize, glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), t));
+	EXPECT_FALSE(en::RayBox::Intersect(c_BoxPos, c_BoxSize, glm::vec3(2.0f, 2.0f, 2.0f), glm::normalize(glm::vec3(1.0f, 1.0f, 1.0f)), t));
+
+	// A miss must not write a segment callers could mistake for a hit
+	EXPECT_EQ(t, glm::vec2(-7.0f, -7.0f));
+}
+
+TEST(RayBoxTest, AxisParallelZeroComponents)
+{
+	glm::vec2 t;
+
+	// Zero y and z components inside those slabs
+	ASSERT_TRUE(en::RayBox::Intersect(c_BoxPos, c_BoxSize, glm::vec3(-1.0f, 0.3f, -0.2f), glm::vec3(1.0f, 0.0f, 0.0f), t));
+	EXPECT_FLOAT_EQ(t.x, 0.5f);
+	EXPECT_FLOAT_EQ(t.y, 1.5f);
+
+	// Zero y component outside the y slab
+	EXPECT_FALSE(en::RayBox::Intersect(c_BoxPos, c_BoxSize, glm::vec3(-1.0f, 0.6f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), t));
+	EXPECT_FALSE(en::RayBox::Intersect(c_BoxPos, c_BoxSize, glm::vec3(-1.0f, -0.6f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), t));
+
+	// Negative zero behaves like zero
+	ASSERT_TRUE(en::RayBox::Intersect(c_BoxPos, c_BoxSize, glm::vec3(0.0f, 0.0f, 2.0f), glm::vec3(-0.0f, -0.0f, -1.0f), t));
+	EXPECT_FLOAT_EQ(t.x, 1.5f);
+	EXPECT_FLOAT_EQ(t.y, 2.5f);
+}
+
+TEST(RayBoxTest, Grazing)
+{
+	glm::vec2 t;
+
+	// Along a face, the faces belong to the box
+	ASSERT_TRUE(en::RayBox::Intersect(c_BoxPos, c_BoxSize, glm::vec3(-1.0f, 0.5f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), t));
+	EXPECT_FLOAT_EQ(t.x, 0.5f);
+	EXPECT_FLOAT_EQ(t.y, 1.5f);
+
+	// Along an edge
+	ASSERT_TRUE(en::RayBox::Intersect(c_BoxPos, c_BoxSize, glm::vec3(-1.0f, 0.5f, -0.5f), glm::vec3(1.0f, 0.0f, 0.0f), t));
+	EXPECT_FLOAT_EQ(t.y - t.x, 1.0f);
+
+	// Touching a single edge, entry and exit coincide
+	ASSERT_TRUE(en::RayBox::Intersect(c_BoxPos, c_BoxSize, glm::vec3(-1.5f, -0.5f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f), t));
+	EXPECT_FLOAT_EQ(t.x, 1.0f);
+	EXPECT_FLOAT_EQ(t.y, 1.0f);
+
+	// Slightly past that edge
+	EXPECT_FALSE(en::RayBox::Intersect(c_BoxPos, c_BoxSize, glm::vec3(-1.5f, -0.49f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f), t));
+}
+
+TEST(RayBoxTest, OffsetBox)
+{
+	glm::vec2 t;
+	ASSERT_TRUE(en::RayBox::Intersect(glm::vec3(10.0f, 0.0f, 0.0f), glm::vec3(2.0f, 4.0f, 2.0f), glm::vec3(10.0f, -5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), t));
+	EXPECT_FLOAT_EQ(t.x, 3.0f);
+	EXPECT_FLOAT_EQ(t.y, 7.0f);
+}
+
+// Micro benchmark of the closed form slab test against the sphere tracing it replaced. Camera rays from an orbit
+// around the cloud, aimed at points around it so that some miss or graze it
+TEST(RayBoxTest, SlabTestCostAgainstSphereTracing)
+{
+	const uint32_t rayCount = 1 << 16;
+	std::vector<glm::vec3> origins(rayCount);
+	std::vector<glm::vec3> dirs(rayCount);
+	for (uint32_t i = 0; i < rayCount; i++)
+	{
+		en::Random random(i, 0, 0, 4);
+		random.SetBounce(0);
+
+		const float phi = random.NextFloat(6.2831853f);
+		const float cosTheta = (2.0f * random.NextFloat()) - 1.0f;
+		const float sinTheta = std::sqrt(1.0f - (cosTheta * cosTheta));
+		origins[i] = glm::vec3(sinTheta * std::cos(phi), cosTheta, sinTheta * std::sin(phi)) * 1.5f * glm::length(c_CloudSize);
+
+		const glm::vec3 target = (glm::vec3(random.NextFloat(), random.NextFloat(), random.NextFloat()) - glm::vec3(0.5f)) * c_CloudSize * 1.5f;
+		dirs[i] = glm::normalize(target - origins[i]);
+	}
+
+	// Checksums keep the compiler from dropping either loop
+	uint32_t hitCount = 0;
+	float slabChecksum = 0.0f;
+	const auto slabStart = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < rayCount; i++)
+	{
+		glm::vec2 t;
+		if (en::RayBox::Intersect(glm::vec3(0.0f), c_CloudSize, origins[i], dirs[i], t))
+		{
+			hitCount++;
+			slabChecksum += t.y - t.x;
+		}
+	}
+	const double slabNs = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - slabStart).count();
+
+	uint64_t sdfCount = 0;
+	float sphereChecksum = 0.0f;
+	const auto sphereStart = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < rayCount; i++)
+	{
+		glm::vec3 entry;
+		glm::vec3 exit;
+		sdfCount += SphereTraceEntryExit(origins[i], dirs[i], entry, exit);
+		sphereChecksum += glm::distance(entry, exit);
+	}
+	const double sphereNs = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - sphereStart).count();
+
+	const double sdfPerRay = static_cast<double>(sdfCount) / rayCount;
+	std::cout
+		<< "slab test " << slabNs / rayCount << " ns/ray, sphere tracing " << sphereNs / rayCount << " ns/ray with "
+		<< sdfPerRay << " sky_sdf evaluations per ray (checksums " << slabChecksum << " " << sphereChecksum << ")"
+		<< std::endl;
+	RecordProperty("SlabNsPerRay", std::to_string(slabNs / rayCount));
+	RecordProperty("SphereTraceNsPerRay", std::to_string(sphereNs / rayCount));
+	RecordProperty("SdfEvaluationsPerRay", std::to_string(sdfPerRay));
+
+	// Both mixes must be present for the comparison to mean anything
+	EXPECT_GT(hitCount, rayCount / 4);
+	EXPECT_LT(hitCount, rayCount - (rayCount / 16));
+
+	// A sky_sdf evaluation alone costs about as much as the whole slab test, sphere tracing needs several per side
+	EXPECT_GT(sdfPerRay, 4.0);
+	EXPECT_LT(slabNs, sphereNs);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <engine/util/RussianRoulette.hpp>
+#include <cmath>
+
+namespace
+{
+	const uint32_t c_PathLength = 24;
+
+	// Light gathered at each vertex, before the path factor
+	float VertexLight(uint32_t bounce)
+	{
+		return 1.0f + static_cast<float>(bounce % 3);
+	}
+
+	// Same loop as TracePath in mc/render.comp. Every vertex halves factor
+	float TracePath(en::Random* random)
+	{
+		float factor = 1.0f;
+		float light = 0.0f;
+		for (uint32_t i = 0; i < c_PathLength; i++)
+		{
+			factor *= 0.5f;
+			light += VertexLight(i) * factor;
+			if (random != nullptr && !en::RussianRoulette::Continue(i, factor, *random)) { break; }
+		}
+		return light;
+	}
+}
+
+TEST(RussianRouletteTest, MinBouncesAlwaysSurvive)
+{
+	en::Random random(0, 0, 0, 0);
+	random.SetBounce(0);
+	for (uint32_t bounce = 0; bounce < en::RussianRoulette::c_MinBounces; bounce++)
+	{
+		float factor = 1e-6f;
+		EXPECT_TRUE(en::RussianRoulette::Continue(bounce, factor, random));
+		EXPECT_EQ(factor, 1e-6f);
+	}
+}
+
+TEST(RussianRouletteTest, HighThroughputIsUnchanged)
+{
+	en::Random random(0, 0, 0, 0);
+	random.SetBounce(0);
+	for (int i = 0; i < 100; i++)
+	{
+		float factor = 0.25f;
+		EXPECT_TRUE(en::RussianRoulette::Continue(5, factor, random));
+		EXPECT_EQ(factor, 0.25f);
+	}
+}
+
+TEST(RussianRouletteTest, MeanMatchesFullPath)
+{
+	const double reference = TracePath(nullptr);
+
+	const uint32_t sampleCount = 1 << 18;
+	double sum = 0.0;
+	double sumSq = 0.0;
+	for (uint32_t s = 0; s < sampleCount; s++)
+	{
+		en::Random random(s % 1024, s / 1024, 0, 0);
+		random.SetBounce(0);
+		const double value = TracePath(&random);
+		sum += value;
+		sumSq += value * value;
+	}
+
+	const double mean = sum / sampleCount;
+	const double variance = (sumSq / sampleCount) - (mean * mean);
+	const double stdError = std::sqrt(variance / sampleCount);
+
+	EXPECT_GT(stdError, 0.0);
+	EXPECT_NEAR(mean, reference, 4.0 * stdError);
+}
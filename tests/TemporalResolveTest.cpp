@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include <engine/util/TemporalResolve.hpp>
+#include <engine/util/Random.hpp>
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+	const uint32_t c_Width = 32;
+	const uint32_t c_Height = 16;
+
+	// Identity matrices with the camera behind the z = 0 plane. First scatter points on that plane project back onto
+	// the pixel they were traced from
+	en::TemporalResolve::Frame MakeFrame(const float* current, const float* depth, const float* history)
+	{
+		en::TemporalResolve::Frame frame;
+		frame.width = c_Width;
+		frame.height = c_Height;
+		frame.invProjView = glm::mat4(1.0f);
+		frame.prevProjView = glm::mat4(1.0f);
+		frame.camPos = glm::vec3(0.0f, 0.0f, -1.0f);
+		frame.current = current;
+		frame.depth = depth;
+		frame.history = history;
+		return frame;
+	}
+
+	std::vector<float> MakePlaneDepth()
+	{
+		std::vector<float> depth(static_cast<size_t>(c_Width) * c_Height);
+		for (uint32_t y = 0; y < c_Height; y++)
+		{
+			for (uint32_t x = 0; x < c_Width; x++)
+			{
+				const glm::vec2 ndc = (glm::vec2(static_cast<float>(x) / c_Width, static_cast<float>(y) / c_Height) * 2.0f) - glm::vec2(1.0f);
+				depth[static_cast<size_t>(y) * c_Width + x] = glm::length(glm::vec3(ndc.x, ndc.y, 1.0f));
+			}
+		}
+		return depth;
+	}
+
+	std::vector<float> MakeNoise(uint32_t frameIndex)
+	{
+		std::vector<float> image(static_cast<size_t>(c_Width) * c_Height * 4, 1.0f);
+		for (uint32_t y = 0; y < c_Height; y++)
+		{
+			for (uint32_t x = 0; x < c_Width; x++)
+			{
+				en::Random random(x, y, frameIndex, 6);
+				random.SetBounce(0);
+				const size_t index = static_cast<size_t>(y) * c_Width + x;
+				for (uint32_t c = 0; c < 3; c++) { image[index * 4 + c] = random.NextFloat(); }
+			}
+		}
+		return image;
+	}
+
+	glm::vec4 GetPixel(const std::vector<float>& image, uint32_t x, uint32_t y)
+	{
+		const float* p = image.data() + (static_cast<size_t>(y) * c_Width + x) * 4;
+		return glm::vec4(p[0], p[1], p[2], p[3]);
+	}
+}
+
+TEST(TemporalResolveTest, StaticCameraIsRunningMean)
+{
+	const std::vector<float> depth = MakePlaneDepth();
+	const uint32_t frameCount = 40;
+
+	std::vector<float> history(static_cast<size_t>(c_Width) * c_Height * 4, 0.0f);
+	std::vector<double> sum(history.size(), 0.0);
+	for (uint32_t frameIndex = 0; frameIndex < frameCount; frameIndex++)
+	{
+		const std::vector<float> current = MakeNoise(frameIndex);
+		for (size_t i = 0; i < sum.size(); i++) { sum[i] += current[i]; }
+
+		// The first frame after a reset ignores whatever the history holds
+		std::vector<float> output(history.size());
+		en::TemporalResolve::ResolveImage(MakeFrame(current.data(), depth.data(), history.data()), frameIndex == 0, false, output.data());
+		history = output;
+	}
+
+	// A resting camera accumulates beyond the moving history limit
+	for (uint32_t y = 0; y < c_Height; y++)
+	{
+		for (uint32_t x = 0; x < c_Width; x++)
+		{
+			const glm::vec4 resolved = GetPixel(history, x, y);
+			const size_t index = static_cast<size_t>(y) * c_Width + x;
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				ASSERT_NEAR(resolved[c], sum[index * 4 + c] / frameCount, 1e-5) << "pixel " << x << " " << y;
+			}
+			ASSERT_EQ(resolved.w, static_cast<float>(frameCount));
+		}
+	}
+}
+
+TEST(TemporalResolveTest, HistoryIsClampedToNeighborhood)
+{
+	const std::vector<float> depth = MakePlaneDepth();
+	const std::vector<float> current = MakeNoise(0);
+
+	// Far outside the [0, 1] current colors, with a sample count above the moving limit
+	const float historyCount = 100.0f;
+	std::vector<float> history(current.size());
+	for (size_t pixel = 0; pixel < static_cast<size_t>(c_Width) * c_Height; pixel++)
+	{
+		history[pixel * 4 + 0] = 10.0f;
+		history[pixel * 4 + 1] = -10.0f;
+		history[pixel * 4 + 2] = 0.5f;
+		history[pixel * 4 + 3] = historyCount;
+	}
+
+	std::vector<float> output(current.size());
+	en::TemporalResolve::ResolveImage(MakeFrame(current.data(), depth.data(), history.data()), false, true, output.data());
+
+	const float sampleCount = static_cast<float>(en::TemporalResolve::c_MaxMovingHistory) + 1.0f;
+	for (uint32_t y = 0; y < c_Height; y++)
+	{
+		for (uint32_t x = 0; x < c_Width; x++)
+		{
+			glm::vec3 minColor(1e30f);
+			glm::vec3 maxColor(-1e30f);
+			for (uint32_t ny = (y == 0 ? 0 : y - 1); ny <= std::min(y + 1, c_Height - 1); ny++)
+			{
+				for (uint32_t nx = (x == 0 ? 0 : x - 1); nx <= std::min(x + 1, c_Width - 1); nx++)
+				{
+					minColor = glm::min(minColor, glm::vec3(GetPixel(current, nx, ny)));
+					maxColor = glm::max(maxColor, glm::vec3(GetPixel(current, nx, ny)));
+				}
+			}
+
+			const glm::vec3 clampedHistory = glm::clamp(glm::vec3(GetPixel(history, x, y)), minColor, maxColor);
+			const glm::vec3 expected = glm::mix(clampedHistory, glm::vec3(GetPixel(current, x, y)), 1.0f / sampleCount);
+			const glm::vec4 resolved = GetPixel(output, x, y);
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				ASSERT_NEAR(resolved[c], expected[c], 1e-5f) << "pixel " << x << " " << y;
+				ASSERT_GE(resolved[c], minColor[c] - 1e-5f);
+				ASSERT_LE(resolved[c], maxColor[c] + 1e-5f);
+			}
+			ASSERT_EQ(resolved.w, sampleCount);
+		}
+	}
+}
+
+TEST(TemporalResolveTest, DisocclusionResetsHistory)
+{
+	const std::vector<float> depth = MakePlaneDepth();
+
+	// Constant color, so clamping leaves the history alone. The history sample count encodes the pixel column
+	const glm::vec3 color(0.25f, 0.5f, 0.75f);
+	std::vector<float> current(static_cast<size_t>(c_Width) * c_Height * 4);
+	std::vector<float> history(current.size());
+	for (uint32_t y = 0; y < c_Height; y++)
+	{
+		for (uint32_t x = 0; x < c_Width; x++)
+		{
+			const size_t index = static_cast<size_t>(y) * c_Width + x;
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				current[index * 4 + c] = color[c];
+				history[index * 4 + c] = color[c];
+			}
+			current[index * 4 + 3] = 1.0f;
+			history[index * 4 + 3] = static_cast<float>(x);
+		}
+	}
+
+	// Last frame the scene sat two pixels further right, so the two right columns were not visible
+	const uint32_t shift = 2;
+	en::TemporalResolve::Frame frame = MakeFrame(current.data(), depth.data(), history.data());
+	frame.prevProjView[3] = glm::vec4(2.0f * shift / c_Width, 0.0f, 0.0f, 1.0f);
+
+	std::vector<float> output(current.size());
+	en::TemporalResolve::ResolveImage(frame, false, true, output.data());
+	for (uint32_t y = 0; y < c_Height; y++)
+	{
+		for (uint32_t x = 0; x < c_Width; x++)
+		{
+			const glm::vec4 resolved = GetPixel(output, x, y);
+			const float expectedCount = x + shift < c_Width
+				? std::min(static_cast<float>(x + shift), static_cast<float>(en::TemporalResolve::c_MaxMovingHistory)) + 1.0f
+				: 1.0f;
+			ASSERT_NEAR(resolved.w, expectedCount, 1e-3f) << "pixel " << x << " " << y;
+			for (uint32_t c = 0; c < 3; c++) { ASSERT_NEAR(resolved[c], color[c], 1e-6f); }
+		}
+	}
+
+	// Points behind last frames camera have no history either
+	frame.prevProjView = glm::mat4(1.0f);
+	frame.prevProjView[3][3] = -1.0f;
+	en::TemporalResolve::ResolveImage(frame, false, true, output.data());
+	for (size_t pixel = 0; pixel < static_cast<size_t>(c_Width) * c_Height; pixel++)
+	{
+		ASSERT_EQ(output[pixel * 4 + 3], 1.0f) << "pixel " << pixel;
+	}
+}
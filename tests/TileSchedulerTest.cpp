@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+#include <engine/util/TileScheduler.hpp>
+
+namespace
+{
+	// Neither side is a multiple of the tile size, so the right and bottom tiles are partial
+	const uint32_t c_Width = 40;
+	const uint32_t c_Height = 10;
+
+	// Scattering pixels with many samples and no variance are converged
+	void MakeConvergedImages(std::vector<float>& mean, std::vector<float>& info)
+	{
+		mean.assign(static_cast<size_t>(c_Width) * c_Height * 4, 1.0f);
+		info.assign(static_cast<size_t>(c_Width) * c_Height * 4, 0.0f);
+		for (size_t pixel = 0; pixel < static_cast<size_t>(c_Width) * c_Height; pixel++) { info[pixel * 4] = 64.0f; }
+	}
+}
+
+TEST(TileScheduler, TileCountRoundsUp)
+{
+	EXPECT_EQ(en::TileScheduler::GetTileCount(64, 32), 2u);
+	EXPECT_EQ(en::TileScheduler::GetTileCount(65, 32), 3u);
+	EXPECT_EQ(en::TileScheduler::GetTileCount(7, 8), 1u);
+}
+
+TEST(TileScheduler, ResetListsPartialTiles)
+{
+	std::vector<float> mean;
+	std::vector<float> info;
+	MakeConvergedImages(mean, info);
+
+	const std::vector<uint32_t> tiles = en::TileScheduler::BuildTileList(
+		mean.data(), info.data(), c_Width, c_Height, 0.01f, en::TileScheduler::c_DefaultMinSampleCount, true);
+	EXPECT_EQ(tiles, std::vector<uint32_t>({ 0, 1, 2, 3 }));
+}
+
+TEST(TileScheduler, FindsUnconvergedBorderPixel)
+{
+	std::vector<float> mean;
+	std::vector<float> info;
+	MakeConvergedImages(mean, info);
+
+	// Last pixel of the image lies in the partial tile at the bottom right
+	info[(static_cast<size_t>(c_Width) * c_Height - 1) * 4] = 1.0f;
+
+	const std::vector<uint32_t> tiles = en::TileScheduler::BuildTileList(
+		mean.data(), info.data(), c_Width, c_Height, 0.01f, en::TileScheduler::c_DefaultMinSampleCount, false);
+	EXPECT_EQ(tiles, std::vector<uint32_t>({ 3 }));
+}
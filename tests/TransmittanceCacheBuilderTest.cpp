@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <engine/util/TransmittanceCacheBuilder.hpp>
+#include <atomic>
+
+namespace
+{
+	// Grid holding the x component of the key it was built for
+	en::TransmittanceCacheBuilder::Grid MakeGrid(const glm::vec3& key)
+	{
+		return en::TransmittanceCacheBuilder::Grid(1, std::vector<std::vector<float>>(1, std::vector<float>(1, key.x)));
+	}
+}
+
+TEST(TransmittanceCacheBuilderTest, MovingLightFlagsRebuild)
+{
+	const glm::vec3 initialPos(1.0f, 2.0f, 3.0f);
+	const glm::vec3 movedPos(1.5f, 2.0f, 3.0f);
+	en::TransmittanceCacheBuilder builder(initialPos);
+
+	std::atomic<uint32_t> buildCount = 0;
+	const en::TransmittanceCacheBuilder::BuildFn build = [&](const glm::vec3& key)
+	{
+		buildCount++;
+		return MakeGrid(key);
+	};
+
+	en::TransmittanceCacheBuilder::Grid grid;
+	glm::vec3 builtKey(0.0f);
+
+	// A light that stays put keeps its grid
+	EXPECT_FALSE(builder.NeedsRebuild(initialPos));
+	EXPECT_FALSE(builder.Update(initialPos, build, grid, builtKey));
+	EXPECT_FALSE(builder.IsBuilding());
+
+	// Moving it starts exactly one build
+	EXPECT_TRUE(builder.NeedsRebuild(movedPos));
+	EXPECT_FALSE(builder.Update(movedPos, build, grid, builtKey));
+	EXPECT_TRUE(builder.IsBuilding());
+	EXPECT_FALSE(builder.NeedsRebuild(movedPos));
+
+	builder.Wait();
+	ASSERT_TRUE(builder.Update(movedPos, build, grid, builtKey));
+	EXPECT_EQ(builtKey, movedPos);
+	EXPECT_EQ(grid[0][0][0], movedPos.x);
+	EXPECT_FALSE(builder.IsBuilding());
+	EXPECT_EQ(buildCount, 1u);
+}
+
+TEST(TransmittanceCacheBuilderTest, LightMovedDuringBuild)
+{
+	en::TransmittanceCacheBuilder builder(glm::vec3(0.0f));
+
+	// The first build waits until the light has moved on twice
+	std::promise<void> release;
+	std::shared_future<void> released = release.get_future().share();
+	std::atomic<uint32_t> buildCount = 0;
+	const en::TransmittanceCacheBuilder::BuildFn build = [&](const glm::vec3& key)
+	{
+		if (buildCount++ == 0) { released.wait(); }
+		return MakeGrid(key);
+	};
+
+	en::TransmittanceCacheBuilder::Grid grid;
+	glm::vec3 builtKey(0.0f);
+	EXPECT_FALSE(builder.Update(glm::vec3(1.0f), build, grid, builtKey));
+	EXPECT_FALSE(builder.Update(glm::vec3(2.0f), build, grid, builtKey));
+	EXPECT_FALSE(builder.Update(glm::vec3(3.0f), build, grid, builtKey));
+	release.set_value();
+	builder.Wait();
+
+	// The finished grid belongs to the first move, the latest position is built next
+	ASSERT_TRUE(builder.Update(glm::vec3(3.0f), build, grid, builtKey));
+	EXPECT_EQ(builtKey, glm::vec3(1.0f));
+	EXPECT_EQ(grid[0][0][0], 1.0f);
+	EXPECT_TRUE(builder.IsBuilding());
+
+	builder.Wait();
+	ASSERT_TRUE(builder.Update(glm::vec3(3.0f), build, grid, builtKey));
+	EXPECT_EQ(builtKey, glm::vec3(3.0f));
+	EXPECT_EQ(buildCount, 2u);
+}
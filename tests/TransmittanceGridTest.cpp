@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <engine/util/TransmittanceGrid.hpp>
+#include <cmath>
+
+namespace
+{
+	const uint32_t c_Size = 48;
+	const float c_VoxelSize = 0.1f;
+	const float c_DensityFactor = 8.0f;
+
+	// Smooth blob, so one sample per voxel stays well below the 8 bit step
+	std::vector<std::vector<std::vector<float>>> MakeDensity()
+	{
+		std::vector<std::vector<std::vector<float>>> density(
+			c_Size,
+			std::vector<std::vector<float>>(c_Size, std::vector<float>(c_Size, 0.0f)));
+		const glm::vec3 center(20.0f, 26.0f, 23.0f);
+		for (uint32_t x = 0; x < c_Size; x++)
+		{
+			for (uint32_t y = 0; y < c_Size; y++)
+			{
+				for (uint32_t z = 0; z < c_Size; z++)
+				{
+					const glm::vec3 offset = glm::vec3(x, y, z) + glm::vec3(0.5f) - center;
+					density[x][y][z] = 0.8f * std::exp(-glm::dot(offset, offset) / (2.0f * 10.0f * 10.0f));
+				}
+			}
+		}
+		return density;
+	}
+
+	// Dense midpoint march in voxel space with the nearest voxel lookup of the density texture. Cell centers lie on voxel
+	// faces, so start must be computed exactly like the builder does to pick the same voxels there
+	float MarchTransmittance(const std::vector<std::vector<std::vector<float>>>& density, const glm::vec3& voxelStart, const glm::vec3& dir, float voxelLength)
+	{
+		const uint32_t sampleCount = std::max(1u, static_cast<uint32_t>(std::ceil(voxelLength * 32.0f)));
+		const float sampleLength = voxelLength / static_cast<float>(sampleCount);
+		double opticalDepth = 0.0;
+		for (uint32_t i = 0; i < sampleCount; i++)
+		{
+			const glm::vec3 voxel = glm::floor(voxelStart + ((static_cast<float>(i) + 0.5f) * sampleLength * dir));
+			if (voxel.x < 0.0f || voxel.y < 0.0f || voxel.z < 0.0f || voxel.x >= c_Size || voxel.y >= c_Size || voxel.z >= c_Size) { continue; }
+			opticalDepth += density[static_cast<uint32_t>(voxel.x)][static_cast<uint32_t>(voxel.y)][static_cast<uint32_t>(voxel.z)];
+		}
+		return static_cast<float>(std::exp(-opticalDepth * c_DensityFactor * sampleLength * c_VoxelSize));
+	}
+
+	// Texture3D stores R8 unorm by truncation
+	float Quantize(float value)
+	{
+		return static_cast<float>(static_cast<uint8_t>(value * 255.0f)) / 255.0f;
+	}
+
+	// The cache may add less error than the 8 bit texture it is stored in
+	const float c_QuantizationBound = 1.0f / 255.0f;
+
+	void ExpectWithinQuantization(float cached, float reference, float& maxError)
+	{
+		maxError = std::max(maxError, std::abs(cached - reference));
+
+		// What the shader reads
+		const float stored = Quantize(cached);
+		EXPECT_LE(stored, reference + c_QuantizationBound);
+		EXPECT_GT(stored, reference - (2.0f * c_QuantizationBound));
+	}
+}
+
+TEST(TransmittanceGridTest, OctahedralRoundTrip)
+{
+	for (uint32_t v = 0; v < 16; v++)
+	{
+		for (uint32_t u = 0; u < 16; u++)
+		{
+			const glm::vec3 dir = en::TransmittanceGrid::OctahedralToDir((u + 0.5f) / 16.0f, (v + 0.5f) / 16.0f);
+			EXPECT_NEAR(glm::length(dir), 1.0f, 1e-5f);
+		}
+	}
+}
+
+TEST(TransmittanceGridTest, DirLightMatchesMarching)
+{
+	const std::vector<std::vector<std::vector<float>>> density = MakeDensity();
+	const en::TransmittanceGrid grid(density, c_DensityFactor, c_VoxelSize);
+
+	// Axis aligned, so the sweep never interpolates between cells
+	const glm::vec3 toLight(0.0f, 1.0f, 0.0f);
+	const std::vector<std::vector<std::vector<float>>> cache = grid.Build(toLight);
+	const uint32_t cellCount = c_Size / en::TransmittanceGrid::c_CellSize;
+	ASSERT_EQ(cache.size(), cellCount);
+
+	float maxError = 0.0f;
+	for (uint32_t x = 0; x < cellCount; x++)
+	{
+		for (uint32_t y = 0; y < cellCount; y++)
+		{
+			for (uint32_t z = 0; z < cellCount; z++)
+			{
+				const glm::vec3 cellCenter = (glm::vec3(x, y, z) + glm::vec3(0.5f)) * static_cast<float>(en::TransmittanceGrid::c_CellSize);
+				const float reference = MarchTransmittance(density, cellCenter, toLight, static_cast<float>(c_Size) - cellCenter.y);
+				ExpectWithinQuantization(cache[x][y][z], reference, maxError);
+			}
+		}
+	}
+
+	EXPECT_LT(maxError, c_QuantizationBound);
+}
+
+TEST(TransmittanceGridTest, PointLightMatchesMarching)
+{
+	const std::vector<std::vector<std::vector<float>>> density = MakeDensity();
+	const en::TransmittanceGrid grid(density, c_DensityFactor, c_VoxelSize);
+
+	const glm::vec3 lightPos(0.7f, -0.4f, 0.2f);
+	const float maxRadius = grid.GetMaxRadius(lightPos);
+	const std::vector<std::vector<std::vector<float>>> cache = grid.BuildRadial(lightPos, maxRadius);
+	const uint32_t size = en::TransmittanceGrid::c_RadialSize;
+	ASSERT_EQ(cache.size(), size);
+
+	// Radial samples lie at texel centers, the first one at the light
+	const glm::vec3 lightVoxelPos = (lightPos / c_VoxelSize) + glm::vec3(0.5f * c_Size);
+	float maxError = 0.0f;
+	for (uint32_t v = 0; v < size; v += 7)
+	{
+		for (uint32_t u = 0; u < size; u += 7)
+		{
+			const glm::vec3 dir = en::TransmittanceGrid::OctahedralToDir((u + 0.5f) / size, (v + 0.5f) / size);
+			for (uint32_t r = 0; r < size; r += 5)
+			{
+				const float radius = maxRadius * static_cast<float>(r) / static_cast<float>(size - 1);
+				const float reference = MarchTransmittance(density, lightVoxelPos, dir, radius / c_VoxelSize);
+				ExpectWithinQuantization(cache[u][v][r], reference, maxError);
+			}
+		}
+	}
+
+	EXPECT_LT(maxError, c_QuantizationBound);
+}